@@ -1,5 +1,21 @@
 #include <stdio.h>  // Standard input/output library for printf
+#include <stdlib.h> // strtod() for the setpoint
+#include <string.h> // strcmp() for the command line
 #include <math.h>   // Math library for mathematical functions
+#include "config_runtime.h"  // Live commissioning parameters (../common)
+#include "profiler.h"  // Hot-path profiler shared by all projects (../common)
+#include "term_input.h"  // Keyboard and loop timer for --live (../common)
+
+// Commissioning parameters the controller follows, in config_keys order
+enum { CONFIG_P_GAIN, CONFIG_I_GAIN, CONFIG_D_GAIN, CONFIG_SPEED };
+
+// Defaults are the example gains used before the commissioning file was read
+static const config_key_t config_keys[] = {
+    {"pid_p_gain", 1.0, 0.0, 100.0},
+    {"pid_i_gain", 0.1, 0.0, 100.0},
+    {"pid_d_gain", 0.05, 0.0, 100.0},
+    {"motor_speed_rpm", 100.0, 0.0, 3000.0},
+};
 
 // PID Controller structure to hold gains and state variables
 typedef struct {
@@ -21,6 +37,7 @@ void initPID(PIDController *pid, double kp, double ki, double kd) {
 
 // Calculate PID output based on setpoint, current value, and time step
 double calculatePID(PIDController *pid, double setpoint, double current_value, double dt) {
+    PROFILE_SCOPE("calculatePID");                    // Timed when PROFILE_OUTPUT is set
     double error = setpoint - current_value;          // Calculate error
     pid->integral += error * dt;                       // Update integral sum
     double derivative = (error - pid->previous_error) / dt;  // Calculate derivative
@@ -35,30 +52,98 @@ double updatePlant(double current_speed, double input, double load, double inert
     return current_speed + acceleration * dt;         // Update speed based on acceleration and time step
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    const char* config_path = CONFIG_RUNTIME_DEFAULT_PATH;
+    int live = 0;                      // Run in real time until 'q' instead of 100 steps
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            config_path = argv[++i];
+        } else if (strcmp(argv[i], "--live") == 0) {
+            live = 1;
+        } else {
+            printf("Usage: %s [--config FILE] [--live]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    profiler_start_from_env();         // Enable profiling if PROFILE_OUTPUT names a trace file
+
+    // Gains and the default setpoint come from the commissioning file and
+    // follow it while the simulation runs
+    config_runtime_t config;
+    config_reader_t reader;
+    if (config_runtime_open(&config, config_path, config_keys, sizeof(config_keys) / sizeof(config_keys[0])) != 0) {
+        printf("Error: Cannot read the configuration\n");
+        return 1;
+    }
+    config_runtime_register(&config, &reader);
+    const config_snapshot_t* cfg = config_runtime_read(&config, &reader);
+
     PIDController pid;                 // Declare PID controller instance
-    initPID(&pid, 1.0, 0.1, 0.05);    // Initialize PID with example gains
+    initPID(&pid, cfg->values[CONFIG_P_GAIN], cfg->values[CONFIG_I_GAIN], cfg->values[CONFIG_D_GAIN]);
 
     double inertia = 1.0;              // Motor inertia
     double load = 0.5;                 // Constant load on motor
     double dt = 0.1;                   // Time step for simulation
 
+    char line[64];
+    char* end;
     double setpoint;                    // Desired motor speed (RPM)
-    printf("Enter desired motor speed (RPM): ");
-    scanf("%lf", &setpoint);           // Read user input for setpoint
+    int follow_config = 0;             // Setpoint tracks motor_speed_rpm
+    printf("Enter desired motor speed (RPM), or press Enter for motor_speed_rpm (%.0f): ",
+           cfg->values[CONFIG_SPEED]);
+    fflush(stdout);
+    if (fgets(line, sizeof(line), stdin) == NULL) {
+        line[0] = '\0';
+    }
+    setpoint = strtod(line, &end);     // Read user input for setpoint
+    if (end == line) {
+        setpoint = cfg->values[CONFIG_SPEED];
+        follow_config = 1;
+    }
     double current_speed = 0.0;        // Initial motor speed
     int steps = 100;                   // Number of simulation steps
 
     printf("PID Controller Simulation for Motor Speed Control\n");
     printf("Setpoint: %.2f RPM\n", setpoint);
+    printf("Gains: Kp %.3f, Ki %.3f, Kd %.3f\n", pid.Kp, pid.Ki, pid.Kd);
+    if (live) {
+        printf("Running in real time; edit %s to retune, 'q' to quit\n", config_path);
+        term_input_open();
+    }
     printf("Time\tSpeed\tPID Output\n");
 
-    for (int i = 0; i < steps; i++) {
+    term_ticker_t ticker;
+    term_ticker_start(&ticker, (uint32_t)(dt * 1000000));
+    for (int i = 0; live || i < steps; i++) {
+        // Pick up retuned gains between steps; the state carries over
+        cfg = config_runtime_read(&config, &reader);
+        pid.Kp = cfg->values[CONFIG_P_GAIN];
+        pid.Ki = cfg->values[CONFIG_I_GAIN];
+        pid.Kd = cfg->values[CONFIG_D_GAIN];
+        if (follow_config) {
+            setpoint = cfg->values[CONFIG_SPEED];
+        }
+
         double pid_output = calculatePID(&pid, setpoint, current_speed, dt);  // Calculate PID output
         current_speed = updatePlant(current_speed, pid_output, load, inertia, dt);  // Update motor speed
 
         printf("%.1f\t%.2f\t%.2f\n", i * dt, current_speed, pid_output);    // Print time, speed, and PID output
+
+        if (live) {
+            fflush(stdout);
+            int key;
+            while ((key = term_input_wait(&ticker)) != TERM_INPUT_TICK) {
+                if (key == 'q' || key == 'Q') {
+                    live = 0;
+                    steps = 0;          // Leave the loop after this step
+                }
+            }
+        }
     }
 
+    config_runtime_unregister(&config, &reader);
+    config_runtime_close(&config);
     return 0;   // End of program
-}
\ No newline at end of file
+}
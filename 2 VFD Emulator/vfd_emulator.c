@@ -1,21 +1,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
-#include <conio.h>
-#ifdef _WIN32
-#include <windows.h>
-#define usleep(x) Sleep((x) / 1000)  // Windows-compatible usleep
-#else
-#include <unistd.h>
-#endif
+#include <string.h>
+#include "config_runtime.h"   // Live commissioning parameters
+#include "profiler.h"
+#include "term_input.h"   // Non-blocking keys (conio.h on Windows)
 
 // VFD Emulator Constants
-#define MAX_FREQUENCY 60.0f      // Maximum allowable frequency in Hz
+#define MAX_FREQUENCY 60.0f      // Default maximum allowable frequency in Hz
 #define MIN_FREQUENCY 0.0f       // Minimum frequency (off) in Hz
 #define NOMINAL_VOLTAGE 480.0f   // Nominal motor voltage in Volts
 #define MOTOR_INERTIA 0.5f       // Simulated motor inertia (not used in this simplified model)
-#define RAMP_RATE 10.0f          // Frequency ramp rate in Hz per second
+#define RAMP_RATE 10.0f          // Default frequency ramp rate in Hz per second
 #define SIMULATION_STEP 0.1f     // Simulation time step in seconds
+#define SIMULATION_STEP_US 100000 // Real time between simulation steps (us)
 
 // VFD Operating States enumeration
 typedef enum {
@@ -34,42 +32,88 @@ typedef struct {
     float motor_speed;          // Simulated motor speed in RPM
     float motor_torque;         // Simulated motor torque in Nm
     float ramp_time;            // Time spent ramping (not used in this simplified model)
+    float ramp_rate;            // Frequency ramp rate in Hz per second (vfd_ramp_rate)
+    float max_frequency;        // Maximum allowable frequency in Hz (vfd_max_frequency)
 } vfd_t;
 
+// Commissioning parameters the drive follows, in config_keys order
+enum { CONFIG_RAMP_RATE, CONFIG_MAX_FREQUENCY };
+
+static const config_key_t config_keys[] = {
+    {"vfd_ramp_rate", RAMP_RATE, 0.1, 100.0},
+    {"vfd_max_frequency", MAX_FREQUENCY, 1.0, 400.0},
+};
+
 // Function Prototypes
 void vfd_init(vfd_t* vfd);
 void vfd_set_frequency(vfd_t* vfd, float frequency);
 void vfd_start(vfd_t* vfd);
 void vfd_stop(vfd_t* vfd);
+void vfd_configure(vfd_t* vfd, const config_snapshot_t* cfg);
 void vfd_update(vfd_t* vfd, float dt);
 void vfd_display_status(vfd_t* vfd);
-float calculate_voltage(float frequency);
+float calculate_voltage(float frequency, float max_frequency);
 float simulate_motor_torque(float frequency, float speed);
 
-int main() {
+int main(int argc, char* argv[]) {
+    const char* config_path = CONFIG_RUNTIME_DEFAULT_PATH;
+    config_runtime_t config;   // Ramp rate and maximum frequency, reloaded when the file changes
+    config_reader_t reader;
     vfd_t vfd;                 // Declare VFD instance
-    char command;              // User input command
+    term_ticker_t ticker;      // Paces the simulation steps
+    int command;               // User input command
+    char line[32];             // Frequency line typed by user
+    char* end;
     float target_freq;         // Frequency input by user
 
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            config_path = argv[++i];
+        } else {
+            printf("Usage: %s [--config FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    profiler_start_from_env(); // Enable profiling if PROFILE_OUTPUT names a trace file
+
     printf("VFD (Variable Frequency Drive) Emulator\n");
     printf("=======================================\n\n");
 
+    if (config_runtime_open(&config, config_path, config_keys, sizeof(config_keys) / sizeof(config_keys[0])) != 0) {
+        printf("Error: Cannot read the configuration\n");
+        return 1;
+    }
+    config_runtime_register(&config, &reader);
+
     vfd_init(&vfd);            // Initialize VFD to default state
+    vfd_configure(&vfd, config_runtime_read(&config, &reader));
 
     // Display available commands to user
     printf("Commands:\n");
     printf("s - Start VFD\n");
     printf("x - Stop VFD\n");
-    printf("f <freq> - Set frequency (0-60 Hz)\n");
+    printf("f <freq> - Set frequency (0-%.0f Hz)\n", vfd.max_frequency);
     printf("q - Quit\n\n");
 
+    // Read keys unbuffered for the whole run; the terminal is restored at exit
+    term_input_open();
+
     // Main simulation loop - runs continuously until quit
+    term_ticker_start(&ticker, SIMULATION_STEP_US);
     while (1) {
-        // Check for keyboard input without blocking
-        if (_kbhit()) {
-            char command = _getch();
+        // Take the latest commissioning values, then update VFD state and motor simulation
+        vfd_configure(&vfd, config_runtime_read(&config, &reader));
+        vfd_update(&vfd, SIMULATION_STEP);
+        // Display current status
+        vfd_display_status(&vfd);
+
+        // Handle keys as they arrive until the next step is due (100ms)
+        while ((command = term_input_wait(&ticker)) != TERM_INPUT_TICK) {
             if (command == 'q') {
                 printf("Exiting...\n");
+                config_runtime_unregister(&config, &reader);
+                config_runtime_close(&config);
                 return 0;
             } else if (command == 's') {
                 vfd_start(&vfd);  // Start the VFD
@@ -77,24 +121,20 @@ int main() {
                 vfd_stop(&vfd);   // Stop the VFD
             } else if (command == 'f') {
                 // Prompt user for frequency input
-                printf("Enter frequency (0-60 Hz): ");
-                scanf("%f", &target_freq);
-                if (target_freq >= MIN_FREQUENCY && target_freq <= MAX_FREQUENCY) {
+                printf("Enter frequency (0-%.0f Hz): ", vfd.max_frequency);
+                if (term_input_read_line(line, sizeof(line)) < 0) {
+                    continue;
+                }
+                target_freq = strtof(line, &end);
+                if (end != line && target_freq >= MIN_FREQUENCY && target_freq <= vfd.max_frequency) {
                     vfd_set_frequency(&vfd, target_freq);  // Set new frequency
                 } else {
-                    printf("Invalid frequency! Must be between 0-60 Hz\n");
+                    printf("Invalid frequency! Must be between 0-%.0f Hz\n", vfd.max_frequency);
                 }
-            } else {
+            } else if (command != '\n' && command != '\r') {
                 printf("Invalid command!\n");
             }
         }
-
-        // Update VFD state and motor simulation
-        vfd_update(&vfd, SIMULATION_STEP);
-        // Display current status
-        vfd_display_status(&vfd);
-        // Delay for real-time simulation (100ms)
-        usleep(100000);
     }
 
     return 0;
@@ -109,6 +149,18 @@ void vfd_init(vfd_t* vfd) {
     vfd->motor_speed = 0.0f;
     vfd->motor_torque = 0.0f;
     vfd->ramp_time = 0.0f;
+    vfd->ramp_rate = RAMP_RATE;
+    vfd->max_frequency = MAX_FREQUENCY;
+}
+
+// Apply the commissioning values; a lower maximum also lowers the target,
+// so the drive ramps down to it
+void vfd_configure(vfd_t* vfd, const config_snapshot_t* cfg) {
+    vfd->ramp_rate = (float)cfg->values[CONFIG_RAMP_RATE];
+    vfd->max_frequency = (float)cfg->values[CONFIG_MAX_FREQUENCY];
+    if (vfd->target_frequency > vfd->max_frequency) {
+        vfd->target_frequency = vfd->max_frequency;
+    }
 }
 
 // Set the target frequency if VFD is running
@@ -146,15 +198,16 @@ void vfd_stop(vfd_t* vfd) {
 // Update the VFD state and simulate motor response over time step dt
 // This function implements the state machine and physics simulation
 void vfd_update(vfd_t* vfd, float dt) {
+    PROFILE_SCOPE("vfd_update");
     float freq_diff;        // Difference between target and current frequency
     float ramp_increment;   // Amount to change frequency per time step
 
     // State machine implementation
     switch (vfd->state) {
         case STATE_STARTING:
-            // Ramp up frequency towards target frequency at RAMP_RATE Hz/s
+            // Ramp up frequency towards target frequency at ramp_rate Hz/s
             freq_diff = vfd->target_frequency - vfd->current_frequency;
-            ramp_increment = RAMP_RATE * dt;
+            ramp_increment = vfd->ramp_rate * dt;
 
             if (fabs(freq_diff) < ramp_increment) {
                 // Close enough to target, snap to exact value and change state
@@ -170,7 +223,7 @@ void vfd_update(vfd_t* vfd, float dt) {
         case STATE_RUNNING:
             // Maintain or adjust frequency towards new target if changed
             freq_diff = vfd->target_frequency - vfd->current_frequency;
-            ramp_increment = RAMP_RATE * dt;
+            ramp_increment = vfd->ramp_rate * dt;
 
             if (fabs(freq_diff) > ramp_increment) {
                 // Still ramping to new frequency
@@ -184,7 +237,7 @@ void vfd_update(vfd_t* vfd, float dt) {
         case STATE_STOPPING:
             // Ramp down frequency to zero
             freq_diff = 0.0f - vfd->current_frequency;
-            ramp_increment = RAMP_RATE * dt;
+            ramp_increment = vfd->ramp_rate * dt;
 
             if (fabs(vfd->current_frequency) < ramp_increment) {
                 // Close to zero, set to zero and turn off
@@ -205,7 +258,7 @@ void vfd_update(vfd_t* vfd, float dt) {
     }
 
     // Calculate output voltage using constant V/F (Volts per Hz) ratio
-    vfd->output_voltage = calculate_voltage(vfd->current_frequency);
+    vfd->output_voltage = calculate_voltage(vfd->current_frequency, vfd->max_frequency);
 
     // Simulate motor speed: synchronous speed = frequency * 60 / poles
     // Actual speed includes slip (motor can't reach synchronous speed)
@@ -228,9 +281,9 @@ void vfd_display_status(vfd_t* vfd) {
 }
 
 // Calculate output voltage based on frequency using constant V/F ratio
-float calculate_voltage(float frequency) {
+float calculate_voltage(float frequency, float max_frequency) {
     if (frequency <= 0.0f) return 0.0f;
-    return (frequency / MAX_FREQUENCY) * NOMINAL_VOLTAGE;
+    return (frequency / max_frequency) * NOMINAL_VOLTAGE;
 }
 
 // Simulate motor torque based on slip
@@ -0,0 +1,425 @@
+/*
+ * Hardware Abstraction Layer backends
+ * ===================================
+ *
+ * Implements the sim, replay and shm backends declared in hal.h.
+ */
+
+// Expose shm_open(), ftruncate(), mmap() and usleep() when building with -std=c99
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hal.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define DAC_VREF 5.0f            // Must match the simulator's DAC reference
+#define REPLAY_MAX_LINE 128      // Longest trace line accepted
+#define SHM_ATTACH_TIMEOUT_MS 1000   // How long an attacher waits for the creator to size the segment
+
+// Backend selected by hal_open(); the sim backend is active until then
+const hal_backend_t* hal_active = &hal_sim_backend;
+
+/* ------------------------------------------------------------------------- */
+/* Simulated backend                                                          */
+/* ------------------------------------------------------------------------- */
+
+static uint16_t sim_digital_inputs = 0;
+static float sim_inputs[HAL_MAX_CHANNELS];   // Driven input level (fraction of full scale)
+static uint16_t sim_driven = 0;              // Bit per channel: input driven by a plant model
+
+static int hal_sim_init(const char* arg) {
+    (void)arg;
+    sim_digital_inputs = 0;
+    sim_driven = 0;
+    return 0;
+}
+
+/*
+ * Drive a simulated ADC input with a known signal (e.g. from a plant model).
+ * Driven channels convert that signal with ±1 LSB noise instead of returning
+ * random readings.
+ *
+ * @param channel: ADC channel number
+ * @param fraction: Input level as a fraction of full scale (0-1)
+ */
+void hal_sim_set_input(uint8_t channel, float fraction) {
+    channel %= HAL_MAX_CHANNELS;
+    sim_inputs[channel] = fraction;
+    sim_driven |= (uint16_t)(1u << channel);
+}
+
+static void hal_sim_shutdown(void) {
+}
+
+void hal_sim_begin_scan(void) {
+}
+
+/*
+ * Simulate ADC reading from a specified channel.
+ * In real hardware, this would read from an analog-to-digital converter.
+ * Here we simulate realistic ADC behavior with noise and random variation.
+ *
+ * @param channel: ADC channel number (0-2 for our sensors)
+ * @return: 12-bit ADC value (0-4095)
+ */
+uint16_t hal_sim_adc_read(uint8_t channel) {
+    // Driven channel: quantize the known signal with a little conversion noise
+    if (sim_driven & (1u << (channel % HAL_MAX_CHANNELS))) {
+        float code = sim_inputs[channel % HAL_MAX_CHANNELS] * 4095.0f +
+                     ((float)rand() / RAND_MAX - 0.5f) * 2.0f + 0.5f;
+        return (uint16_t)(code < 0.0f ? 0.0f : (code > 4095.0f ? 4095.0f : code));
+    }
+
+    // Generate random base value between 0 and 1
+    float base_value = (float)rand() / RAND_MAX;
+
+    // Add realistic noise (±5%) to simulate real-world ADC imperfections
+    float noise = ((float)rand() / RAND_MAX - 0.5f) * 0.1f;
+
+    // Calculate final ADC value with 12-bit resolution (0-4095)
+    uint16_t adc_value = (uint16_t)(base_value * 4095.0f * (1.0f + noise));
+
+    return adc_value;
+}
+
+/*
+ * Simulate DAC writing to a specified channel.
+ * In real hardware, this would set the output voltage of a digital-to-analog converter.
+ * Here we calculate and display the resulting voltage.
+ *
+ * @param channel: DAC channel number (0-2 for our actuators)
+ * @param value: 8-bit DAC value (0-255)
+ */
+void hal_sim_dac_write(uint8_t channel, uint16_t value) {
+    // Calculate output voltage: value/255 * 5.0V reference
+    float voltage = (float)value / 255.0f * DAC_VREF;
+
+    // Display the DAC output voltage (simulating hardware behavior)
+    printf("DAC Channel %d: Set to %.2fV\n", channel, voltage);
+}
+
+void hal_sim_digital_write(uint16_t outputs) {
+    // Simulated output pins have no external effect
+    (void)outputs;
+}
+
+uint16_t hal_sim_digital_read(void) {
+    return sim_digital_inputs;
+}
+
+const hal_backend_t hal_sim_backend = {
+    "sim", hal_sim_init, hal_sim_shutdown, hal_sim_begin_scan,
+    hal_sim_adc_read, hal_sim_dac_write, hal_sim_digital_write, hal_sim_digital_read
+};
+
+/* ------------------------------------------------------------------------- */
+/* Trace-replay backend                                                       */
+/* ------------------------------------------------------------------------- */
+
+/*
+ * Trace file format (CSV, one sensor scan per line, '#' starts a comment):
+ *   adc0,adc1,...,adcN[;digital_inputs]
+ * ADC codes are decimal; digital_inputs may be decimal or 0x-prefixed hex.
+ * The trace is loaded into memory at init and loops when it runs out.
+ * DAC writes are captured to "<trace>.out" as "scan,channel,value" lines.
+ */
+typedef struct {
+    uint16_t adc[HAL_MAX_CHANNELS];
+    uint16_t digital_inputs;
+} replay_row_t;
+
+static replay_row_t* replay_rows = NULL;
+static size_t replay_count = 0;
+static size_t replay_index = 0;
+static unsigned long replay_scan = 0;
+static FILE* replay_capture = NULL;
+
+static int hal_replay_init(const char* arg) {
+    char line[REPLAY_MAX_LINE];
+    char capture_path[256];
+    size_t capacity = 0;
+    FILE* file;
+
+    if (arg == NULL || *arg == '\0') {
+        printf("Error: replay backend needs a trace file (replay:<trace.csv>)\n");
+        return -1;
+    }
+    file = fopen(arg, "r");
+    if (file == NULL) {
+        printf("Error: Cannot open trace file '%s'\n", arg);
+        return -1;
+    }
+
+    replay_count = 0;
+    while (fgets(line, sizeof(line), file)) {
+        replay_row_t row;
+        char* cursor = line;
+        int field = 0;
+
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue;
+
+        memset(&row, 0, sizeof(row));
+        while (field < HAL_MAX_CHANNELS) {
+            char* end;
+            unsigned long value = strtoul(cursor, &end, 10);
+            if (end == cursor) break;
+            row.adc[field++] = (uint16_t)value;
+            if (*end != ',') {
+                cursor = end;
+                break;
+            }
+            cursor = end + 1;
+        }
+        if (field == 0) continue;
+        cursor = strchr(cursor, ';');
+        if (cursor != NULL) {
+            row.digital_inputs = (uint16_t)strtoul(cursor + 1, NULL, 0);
+        }
+
+        if (replay_count == capacity) {
+            size_t new_capacity = capacity ? capacity * 2 : 64;
+            replay_row_t* grown = realloc(replay_rows, new_capacity * sizeof(*grown));
+            if (grown == NULL) {
+                fclose(file);
+                printf("Error: Out of memory loading trace\n");
+                return -1;
+            }
+            replay_rows = grown;
+            capacity = new_capacity;
+        }
+        replay_rows[replay_count++] = row;
+    }
+    fclose(file);
+
+    if (replay_count == 0) {
+        printf("Error: Trace file '%s' contains no scans\n", arg);
+        return -1;
+    }
+
+    // Capture DAC outputs next to the trace for offline comparison
+    snprintf(capture_path, sizeof(capture_path), "%s.out", arg);
+    replay_capture = fopen(capture_path, "w");
+    replay_index = 0;
+    replay_scan = 0;
+    printf("Replaying %lu scans from '%s'\n", (unsigned long)replay_count, arg);
+    return 0;
+}
+
+static void hal_replay_shutdown(void) {
+    if (replay_capture != NULL) {
+        fclose(replay_capture);
+        replay_capture = NULL;
+    }
+    free(replay_rows);
+    replay_rows = NULL;
+    replay_count = 0;
+}
+
+void hal_replay_begin_scan(void) {
+    // First scan uses row 0, each later scan advances one row
+    if (replay_scan++ > 0) {
+        replay_index = (replay_index + 1 < replay_count) ? replay_index + 1 : 0;
+    }
+}
+
+uint16_t hal_replay_adc_read(uint8_t channel) {
+    return replay_rows[replay_index].adc[channel % HAL_MAX_CHANNELS];
+}
+
+void hal_replay_dac_write(uint8_t channel, uint16_t value) {
+    if (replay_capture != NULL) {
+        fprintf(replay_capture, "%lu,%u,%u\n", replay_scan, channel, value);
+    }
+}
+
+void hal_replay_digital_write(uint16_t outputs) {
+    (void)outputs;
+}
+
+uint16_t hal_replay_digital_read(void) {
+    return replay_rows[replay_index].digital_inputs;
+}
+
+const hal_backend_t hal_replay_backend = {
+    "replay", hal_replay_init, hal_replay_shutdown, hal_replay_begin_scan,
+    hal_replay_adc_read, hal_replay_dac_write, hal_replay_digital_write, hal_replay_digital_read
+};
+
+/* ------------------------------------------------------------------------- */
+/* Shared-memory backend                                                      */
+/* ------------------------------------------------------------------------- */
+
+static hal_shm_region_t* shm_region = NULL;
+static char shm_name[64];
+static int shm_created = 0;
+
+#ifndef _WIN32
+static int hal_shm_init(const char* arg) {
+    const char* name = (arg != NULL && *arg != '\0') ? arg : HAL_SHM_DEFAULT_NAME;
+    int waited_ms = 0;
+    int fd;
+
+    snprintf(shm_name, sizeof(shm_name), "%s", name);
+
+    // Create the segment if nobody has yet; otherwise attach to the existing one
+    fd = shm_open(shm_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    shm_created = (fd >= 0);
+    if (fd < 0 && errno == EEXIST) {
+        fd = shm_open(shm_name, O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        printf("Error: shm_open('%s') failed: %s\n", shm_name, strerror(errno));
+        return -1;
+    }
+    if (shm_created && ftruncate(fd, sizeof(hal_shm_region_t)) != 0) {
+        printf("Error: Cannot size shared memory: %s\n", strerror(errno));
+        close(fd);
+        shm_unlink(shm_name);
+        return -1;
+    }
+    if (!shm_created) {
+        // Wait for the creator to size the segment; touching an unsized mapping raises SIGBUS
+        struct stat st;
+        while (fstat(fd, &st) == 0 && (size_t)st.st_size < sizeof(hal_shm_region_t)) {
+            if (waited_ms++ >= SHM_ATTACH_TIMEOUT_MS) {
+                printf("Error: Shared memory '%s' was never sized\n", shm_name);
+                close(fd);
+                return -1;
+            }
+            usleep(1000);
+        }
+    }
+
+    shm_region = mmap(NULL, sizeof(hal_shm_region_t), PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+    close(fd);  // The mapping stays valid after the descriptor is closed
+    if (shm_region == MAP_FAILED) {
+        shm_region = NULL;
+        printf("Error: Cannot map shared memory: %s\n", strerror(errno));
+        return -1;
+    }
+
+    if (__atomic_load_n(&shm_region->magic, __ATOMIC_ACQUIRE) != HAL_SHM_MAGIC) {
+        memset(shm_region, 0, sizeof(*shm_region));
+        __atomic_store_n(&shm_region->magic, HAL_SHM_MAGIC, __ATOMIC_RELEASE);
+    }
+    printf("Shared-memory I/O attached at %s\n", shm_name);
+    return 0;
+}
+
+static void hal_shm_shutdown(void) {
+    if (shm_region != NULL) {
+        munmap(shm_region, sizeof(hal_shm_region_t));
+        shm_region = NULL;
+    }
+    if (shm_created) {
+        shm_unlink(shm_name);
+        shm_created = 0;
+    }
+}
+#else
+static int hal_shm_init(const char* arg) {
+    (void)arg;
+    printf("Error: shm backend requires POSIX shared memory\n");
+    return -1;
+}
+
+static void hal_shm_shutdown(void) {
+}
+#endif
+
+void hal_shm_begin_scan(void) {
+    __atomic_add_fetch(&shm_region->scan_count, 1, __ATOMIC_RELEASE);
+}
+
+uint16_t hal_shm_adc_read(uint8_t channel) {
+    return __atomic_load_n(&shm_region->adc[channel % HAL_MAX_CHANNELS], __ATOMIC_RELAXED);
+}
+
+void hal_shm_dac_write(uint8_t channel, uint16_t value) {
+    __atomic_store_n(&shm_region->dac[channel % HAL_MAX_CHANNELS], value, __ATOMIC_RELAXED);
+}
+
+void hal_shm_digital_write(uint16_t outputs) {
+    __atomic_store_n(&shm_region->digital_outputs, outputs, __ATOMIC_RELAXED);
+}
+
+uint16_t hal_shm_digital_read(void) {
+    return __atomic_load_n(&shm_region->digital_inputs, __ATOMIC_RELAXED);
+}
+
+const hal_backend_t hal_shm_backend = {
+    "shm", hal_shm_init, hal_shm_shutdown, hal_shm_begin_scan,
+    hal_shm_adc_read, hal_shm_dac_write, hal_shm_digital_write, hal_shm_digital_read
+};
+
+/* ------------------------------------------------------------------------- */
+/* Backend selection                                                          */
+/* ------------------------------------------------------------------------- */
+
+/*
+ * Look up a backend by name (the part of a spec before any ':').
+ */
+const hal_backend_t* hal_find_backend(const char* name) {
+    static const hal_backend_t* const backends[] = {
+        &hal_sim_backend, &hal_replay_backend, &hal_shm_backend
+    };
+    size_t len = strcspn(name, ":");
+
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+        if (strlen(backends[i]->name) == len && strncmp(backends[i]->name, name, len) == 0) {
+            return backends[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Initialize and activate a backend from a "name[:arg]" spec.
+ * When the backend is fixed at compile time only that backend may be opened.
+ *
+ * @return: 0 on success, -1 on unknown backend or init failure
+ */
+int hal_open(const char* spec) {
+    const hal_backend_t* backend = hal_find_backend(spec);
+    const char* arg = strchr(spec, ':');
+
+    if (backend == NULL) {
+        printf("Error: Unknown HAL backend '%s' (available: sim, replay, shm)\n", spec);
+        return -1;
+    }
+#if HAL_BACKEND == HAL_BACKEND_SIM
+    if (backend != &hal_sim_backend) backend = NULL;
+#elif HAL_BACKEND == HAL_BACKEND_REPLAY
+    if (backend != &hal_replay_backend) backend = NULL;
+#elif HAL_BACKEND == HAL_BACKEND_SHM
+    if (backend != &hal_shm_backend) backend = NULL;
+#endif
+    if (backend == NULL) {
+        printf("Error: This build has its HAL backend fixed at compile time\n");
+        return -1;
+    }
+
+    if (backend->init(arg ? arg + 1 : NULL) != 0) {
+        return -1;
+    }
+    hal_active = backend;
+    return 0;
+}
+
+/*
+ * Shut down the active backend and fall back to the simulated one.
+ */
+void hal_close(void) {
+    hal_active->shutdown();
+    hal_active = &hal_sim_backend;
+}
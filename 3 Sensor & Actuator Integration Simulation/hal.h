@@ -0,0 +1,129 @@
+/*
+ * Hardware Abstraction Layer (HAL)
+ * ================================
+ *
+ * The simulator talks to "hardware" only through the functions in this header,
+ * so the same control code can run against different I/O backends:
+ * - sim:    random ADC readings and printed DAC writes (the original behavior)
+ * - replay: ADC/digital inputs replayed from a recorded trace file
+ * - shm:    I/O registers in a POSIX shared-memory segment driven by another process
+ *
+ * Dispatch is selected at compile time with HAL_BACKEND:
+ * - HAL_BACKEND_DYNAMIC (default): backend chosen at runtime, calls go through a vtable
+ * - HAL_BACKEND_SIM / _REPLAY / _SHM: backend fixed, calls are direct (no indirection)
+ */
+
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+
+// Compile-time backend selection
+#define HAL_BACKEND_DYNAMIC 0
+#define HAL_BACKEND_SIM 1
+#define HAL_BACKEND_REPLAY 2
+#define HAL_BACKEND_SHM 3
+
+#ifndef HAL_BACKEND
+#define HAL_BACKEND HAL_BACKEND_DYNAMIC
+#endif
+
+// Backend opened when none is given: the compiled-in one, if it is fixed
+#if HAL_BACKEND == HAL_BACKEND_REPLAY
+#define HAL_DEFAULT_SPEC "replay"
+#elif HAL_BACKEND == HAL_BACKEND_SHM
+#define HAL_DEFAULT_SPEC "shm"
+#else
+#define HAL_DEFAULT_SPEC "sim"
+#endif
+
+#define HAL_MAX_CHANNELS 8               // ADC/DAC channels exposed by every backend
+#define HAL_SHM_DEFAULT_NAME "/sensor_actuator_hal"
+#define HAL_SHM_MAGIC 0x48414C31u        // "HAL1": segment has been initialized
+
+/*
+ * Backend operations table
+ * begin_scan() is called once per sensor scan so backends can latch a new
+ * set of inputs (replay advances one trace row, shm could take a snapshot).
+ */
+typedef struct {
+    const char* name;
+    int (*init)(const char* arg);        // arg: backend-specific (trace path, shm name)
+    void (*shutdown)(void);
+    void (*begin_scan)(void);
+    uint16_t (*adc_read)(uint8_t channel);
+    void (*dac_write)(uint8_t channel, uint16_t value);
+    void (*digital_write)(uint16_t outputs);  // Push the whole output register
+    uint16_t (*digital_read)(void);           // Pull the whole input register
+} hal_backend_t;
+
+/*
+ * Shared-memory register layout for the shm backend
+ * The external process writes adc[] and digital_inputs; the simulator writes
+ * dac[], digital_outputs and scan_count. Every field is a single aligned word
+ * accessed atomically, so no locking is needed between the two processes.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t scan_count;                 // Incremented by the simulator every scan
+    uint16_t adc[HAL_MAX_CHANNELS];      // 12-bit ADC codes (written by driver)
+    uint16_t dac[HAL_MAX_CHANNELS];      // 8-bit DAC codes (written by simulator)
+    uint16_t digital_inputs;             // Input register (written by driver)
+    uint16_t digital_outputs;            // Output register (written by simulator)
+} hal_shm_region_t;
+
+// Available backends
+extern const hal_backend_t hal_sim_backend;
+extern const hal_backend_t hal_replay_backend;
+extern const hal_backend_t hal_shm_backend;
+
+// Backend lookup and activation ("sim", "replay:<trace.csv>", "shm[:<name>]")
+const hal_backend_t* hal_find_backend(const char* name);
+int hal_open(const char* spec);
+void hal_close(void);
+
+// Direct entry points of each backend (used by static dispatch)
+uint16_t hal_sim_adc_read(uint8_t channel);
+void hal_sim_dac_write(uint8_t channel, uint16_t value);
+void hal_sim_digital_write(uint16_t outputs);
+uint16_t hal_sim_digital_read(void);
+void hal_sim_begin_scan(void);
+void hal_sim_set_input(uint8_t channel, float fraction);
+
+uint16_t hal_replay_adc_read(uint8_t channel);
+void hal_replay_dac_write(uint8_t channel, uint16_t value);
+void hal_replay_digital_write(uint16_t outputs);
+uint16_t hal_replay_digital_read(void);
+void hal_replay_begin_scan(void);
+
+uint16_t hal_shm_adc_read(uint8_t channel);
+void hal_shm_dac_write(uint8_t channel, uint16_t value);
+void hal_shm_digital_write(uint16_t outputs);
+uint16_t hal_shm_digital_read(void);
+void hal_shm_begin_scan(void);
+
+// Dispatch macros used by the simulator's I/O functions
+#if HAL_BACKEND == HAL_BACKEND_SIM
+#define HAL_PREFIX(op) hal_sim_##op
+#elif HAL_BACKEND == HAL_BACKEND_REPLAY
+#define HAL_PREFIX(op) hal_replay_##op
+#elif HAL_BACKEND == HAL_BACKEND_SHM
+#define HAL_PREFIX(op) hal_shm_##op
+#endif
+
+#ifdef HAL_PREFIX
+#define hal_adc_read(ch) HAL_PREFIX(adc_read)(ch)
+#define hal_dac_write(ch, v) HAL_PREFIX(dac_write)(ch, v)
+#define hal_digital_write(outputs) HAL_PREFIX(digital_write)(outputs)
+#define hal_digital_read() HAL_PREFIX(digital_read)()
+#define hal_begin_scan() HAL_PREFIX(begin_scan)()
+#else
+extern const hal_backend_t* hal_active;
+#define hal_adc_read(ch) hal_active->adc_read(ch)
+#define hal_dac_write(ch, v) hal_active->dac_write(ch, v)
+#define hal_digital_write(outputs) hal_active->digital_write(outputs)
+#define hal_digital_read() hal_active->digital_read()
+#define hal_begin_scan() hal_active->begin_scan()
+#endif
+
+#endif // HAL_H
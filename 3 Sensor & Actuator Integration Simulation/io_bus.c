@@ -0,0 +1,269 @@
+/*
+ * Shared-Memory I/O Bus
+ * =====================
+ *
+ * Segment management, frame exchange and the stand-alone peer processes
+ * declared in io_bus.h.
+ */
+
+// Expose shm_open(), ftruncate(), mmap() and usleep() when building with -std=c99
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include "io_bus.h"
+#include "seqlock.h"
+#include "plant.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Compile-time check that both frames fit in a slot
+typedef char io_bus_sensor_frame_fits[(sizeof(io_sensor_frame_t) <= sizeof(uint32_t) * IO_BUS_SLOT_WORDS) ? 1 : -1];
+typedef char io_bus_actuator_frame_fits[(sizeof(io_actuator_frame_t) <= sizeof(uint32_t) * IO_BUS_SLOT_WORDS) ? 1 : -1];
+
+#define IO_BUS_ATTACH_TIMEOUT_MS 1000    // How long an attacher waits for the creator
+#define PEER_STEP_US 1000                // Stand-alone plant integration step
+
+#ifndef _WIN32
+/*
+ * Create or attach to the bus segment.
+ * The first process to open a name creates and initializes the segment;
+ * later processes attach and wait until it has been initialized.
+ *
+ * @return: 0 on success, -1 on failure
+ */
+int io_bus_open(io_bus_t* bus, const char* name) {
+    int fd;
+    int waited_ms = 0;
+
+    memset(bus, 0, sizeof(*bus));
+    snprintf(bus->name, sizeof(bus->name), "%s", name ? name : IO_BUS_DEFAULT_NAME);
+
+    fd = shm_open(bus->name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    bus->created = (fd >= 0);
+    if (fd < 0 && errno == EEXIST) {
+        fd = shm_open(bus->name, O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        printf("Error: shm_open('%s') failed: %s\n", bus->name, strerror(errno));
+        return -1;
+    }
+
+    if (bus->created) {
+        if (ftruncate(fd, sizeof(io_bus_region_t)) != 0) {
+            printf("Error: Cannot size shared memory: %s\n", strerror(errno));
+            close(fd);
+            shm_unlink(bus->name);
+            return -1;
+        }
+    } else {
+        // Wait for the creator to size the segment before mapping it
+        struct stat st;
+        while (fstat(fd, &st) == 0 && (size_t)st.st_size < sizeof(io_bus_region_t)) {
+            if (waited_ms++ >= IO_BUS_ATTACH_TIMEOUT_MS) {
+                printf("Error: Bus '%s' was never initialized\n", bus->name);
+                close(fd);
+                return -1;
+            }
+            usleep(1000);
+        }
+    }
+
+    bus->region = mmap(NULL, sizeof(io_bus_region_t), PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd, 0);
+    close(fd);  // The mapping stays valid after the descriptor is closed
+    if (bus->region == MAP_FAILED) {
+        bus->region = NULL;
+        printf("Error: Cannot map shared memory: %s\n", strerror(errno));
+        if (bus->created) shm_unlink(bus->name);
+        return -1;
+    }
+
+    if (bus->created) {
+        memset(bus->region, 0, sizeof(*bus->region));
+        bus->region->sensors.seq = SEQLOCK_INIT;
+        bus->region->actuators.seq = SEQLOCK_INIT;
+        bus->region->running = 1;
+        __atomic_store_n(&bus->region->magic, IO_BUS_MAGIC, __ATOMIC_RELEASE);
+    } else {
+        while (__atomic_load_n(&bus->region->magic, __ATOMIC_ACQUIRE) != IO_BUS_MAGIC) {
+            if (waited_ms++ >= IO_BUS_ATTACH_TIMEOUT_MS) {
+                printf("Error: Bus '%s' was never initialized\n", bus->name);
+                io_bus_close(bus);
+                return -1;
+            }
+            usleep(1000);
+        }
+    }
+    return 0;
+}
+
+/*
+ * Detach from the bus; the creating process also removes the segment name.
+ */
+void io_bus_close(io_bus_t* bus) {
+    if (bus->region != NULL) {
+        munmap(bus->region, sizeof(io_bus_region_t));
+        bus->region = NULL;
+    }
+    if (bus->created) {
+        shm_unlink(bus->name);
+        bus->created = 0;
+    }
+}
+#else
+int io_bus_open(io_bus_t* bus, const char* name) {
+    (void)name;
+    memset(bus, 0, sizeof(*bus));
+    printf("Error: The I/O bus requires POSIX shared memory\n");
+    return -1;
+}
+
+void io_bus_close(io_bus_t* bus) {
+    bus->region = NULL;
+}
+#endif
+
+/*
+ * Frame exchange
+ * Frames are staged through a word buffer so the seqlock only ever touches
+ * 32-bit words, whatever the frame's field types are.
+ */
+void io_bus_publish_sensors(io_bus_t* bus, const io_sensor_frame_t* frame) {
+    uint32_t words[IO_BUS_SLOT_WORDS] = {0};
+
+    memcpy(words, frame, sizeof(*frame));
+    seqlock_write(&bus->region->sensors.seq, bus->region->sensors.words, words, IO_BUS_SLOT_WORDS);
+}
+
+uint32_t io_bus_read_sensors(const io_bus_t* bus, io_sensor_frame_t* frame) {
+    uint32_t words[IO_BUS_SLOT_WORDS];
+    uint32_t seq = seqlock_read(&bus->region->sensors.seq, bus->region->sensors.words,
+                                words, IO_BUS_SLOT_WORDS);
+
+    memcpy(frame, words, sizeof(*frame));
+    return seq;
+}
+
+void io_bus_publish_actuators(io_bus_t* bus, const io_actuator_frame_t* frame) {
+    uint32_t words[IO_BUS_SLOT_WORDS] = {0};
+
+    memcpy(words, frame, sizeof(*frame));
+    seqlock_write(&bus->region->actuators.seq, bus->region->actuators.words, words, IO_BUS_SLOT_WORDS);
+}
+
+uint32_t io_bus_read_actuators(const io_bus_t* bus, io_actuator_frame_t* frame) {
+    uint32_t words[IO_BUS_SLOT_WORDS];
+    uint32_t seq = seqlock_read(&bus->region->actuators.seq, bus->region->actuators.words,
+                                words, IO_BUS_SLOT_WORDS);
+
+    memcpy(frame, words, sizeof(*frame));
+    return seq;
+}
+
+/*
+ * Stand-alone plant process
+ * Integrates one skid of the plant model (plant.h) every millisecond from
+ * the latest actuator frame and publishes the resulting sensor frame.
+ * Runs until the controller closes the bus.
+ */
+int io_bus_run_peer(const char* name) {
+    io_bus_t bus;
+    io_sensor_frame_t sensors;
+    io_actuator_frame_t actuators;
+    plant_t plant;
+    const float dt = PEER_STEP_US * 1e-6f;
+
+    if (plant_init(&plant, 1) != 0) {
+        printf("Error: Cannot allocate plant model\n");
+        return 1;
+    }
+    if (io_bus_open(&bus, name) != 0) {
+        plant_free(&plant);
+        return 1;
+    }
+    printf("Plant peer attached to %s\n", bus.name);
+
+    memset(&sensors, 0, sizeof(sensors));
+    while (__atomic_load_n(&bus.region->running, __ATOMIC_ACQUIRE)) {
+        io_bus_read_actuators(&bus, &actuators);
+
+        // The motor relay gates the fan; the valve follows its analog position
+        float motor = (actuators.state_mask & 1u) ? actuators.setpoint[0] / 100.0f : 0.0f;
+        float valve = actuators.setpoint[1] / 100.0f;
+        plant_step(&plant, &motor, &valve, dt);
+
+        sensors.cycle++;
+        sensors.values[0] = plant.temperature[0];
+        sensors.values[1] = plant.pressure[0];
+        sensors.values[2] = plant.level[0];
+        io_bus_publish_sensors(&bus, &sensors);
+#ifdef _WIN32
+        Sleep(PEER_STEP_US / 1000);
+#else
+        usleep(PEER_STEP_US);
+#endif
+    }
+
+    printf("Plant peer detached\n");
+    io_bus_close(&bus);
+    plant_free(&plant);
+    return 0;
+}
+
+/*
+ * Echo peer used by the two-process round-trip test.
+ * Every new actuator frame k must carry setpoint[i] == k + i, state_mask == k & 7
+ * and digital_outputs == k & 0xFFFF; the peer checks that invariant (a torn
+ * snapshot would break it) and answers with sensor frame k carrying
+ * values[i] == 2k + i and digital_inputs == ~k & 0xFFFF.
+ *
+ * @return: Number of inconsistent actuator frames observed (0 = pass)
+ */
+int io_bus_run_echo_peer(const char* name) {
+    io_bus_t bus;
+    io_sensor_frame_t reply;
+    io_actuator_frame_t request;
+    uint32_t last_seq = 0;
+    unsigned spins = 0;
+    int torn = 0;
+
+    if (io_bus_open(&bus, name) != 0) {
+        return 1;
+    }
+
+    memset(&reply, 0, sizeof(reply));
+    while (__atomic_load_n(&bus.region->running, __ATOMIC_ACQUIRE)) {
+        uint32_t seq = io_bus_read_actuators(&bus, &request);
+
+        if (seq == last_seq || request.cycle == 0) {
+            if (++spins % SEQLOCK_SPINS_BEFORE_YIELD == 0) {
+                seqlock_yield();
+            }
+            continue;
+        }
+        last_seq = seq;
+
+        uint32_t k = request.cycle;
+        for (int i = 0; i < IO_BUS_ACTUATORS; i++) {
+            if (request.setpoint[i] != (float)(k + (uint32_t)i)) torn++;
+        }
+        if (request.state_mask != (k & 7u) || request.digital_outputs != (k & 0xFFFFu)) torn++;
+
+        reply.cycle = k;
+        reply.digital_inputs = ~k & 0xFFFFu;
+        for (int i = 0; i < IO_BUS_SENSORS; i++) {
+            reply.values[i] = (float)(2 * k + (uint32_t)i);
+        }
+        io_bus_publish_sensors(&bus, &reply);
+    }
+
+    io_bus_close(&bus);
+    return torn > 255 ? 255 : torn;
+}
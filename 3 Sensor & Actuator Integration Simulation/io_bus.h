@@ -0,0 +1,74 @@
+/*
+ * Shared-Memory I/O Bus
+ * =====================
+ *
+ * Maps the simulator's sensor values and actuator outputs into a POSIX
+ * shared-memory segment so an external process (e.g. a plant model) can close
+ * the loop without sockets. Each direction is one seqlock-protected frame on
+ * its own cache line:
+ * - sensors:   written by the plant process, read by the controller
+ * - actuators: written by the controller, read by the plant process
+ *
+ * After io_bus_open() no system calls are needed to exchange frames.
+ */
+
+#ifndef IO_BUS_H
+#define IO_BUS_H
+
+#include <stdint.h>
+
+#define IO_BUS_DEFAULT_NAME "/sensor_actuator_bus"
+#define IO_BUS_MAGIC 0x494F4231u         // "IOB1": segment has been initialized
+#define IO_BUS_SENSORS 3                 // Same order as system_t.sensors
+#define IO_BUS_ACTUATORS 3               // Same order as system_t.actuators
+#define IO_BUS_SLOT_WORDS 15             // Payload words per 64-byte slot
+
+// Sensor frame: one consistent scan of every sensor (engineering units)
+typedef struct {
+    uint32_t cycle;                      // Plant cycle that produced this frame
+    uint32_t digital_inputs;             // Digital input register
+    float values[IO_BUS_SENSORS];        // Temperature (C), pressure (bar), level (%)
+} io_sensor_frame_t;
+
+// Actuator frame: one consistent set of controller outputs
+typedef struct {
+    uint32_t cycle;                      // Controller cycle that produced this frame
+    uint32_t digital_outputs;            // Digital output register
+    uint32_t state_mask;                 // Bit i set = actuator i ON
+    float setpoint[IO_BUS_ACTUATORS];    // Output level in percent
+} io_actuator_frame_t;
+
+// One seqlock-protected frame, padded to a cache line
+typedef struct {
+    uint32_t seq;
+    uint32_t words[IO_BUS_SLOT_WORDS];
+} io_bus_slot_t;
+
+// Shared-memory segment layout
+typedef struct {
+    uint32_t magic;
+    uint32_t running;                    // Cleared by the controller to stop the peer
+    uint32_t reserved[14];
+    io_bus_slot_t sensors;
+    io_bus_slot_t actuators;
+} io_bus_region_t;
+
+// Handle to an attached bus
+typedef struct {
+    io_bus_region_t* region;
+    char name[64];
+    int created;                         // This process created (and will unlink) the segment
+} io_bus_t;
+
+int io_bus_open(io_bus_t* bus, const char* name);
+void io_bus_close(io_bus_t* bus);
+
+void io_bus_publish_sensors(io_bus_t* bus, const io_sensor_frame_t* frame);
+uint32_t io_bus_read_sensors(const io_bus_t* bus, io_sensor_frame_t* frame);
+void io_bus_publish_actuators(io_bus_t* bus, const io_actuator_frame_t* frame);
+uint32_t io_bus_read_actuators(const io_bus_t* bus, io_actuator_frame_t* frame);
+
+int io_bus_run_peer(const char* name);
+int io_bus_run_echo_peer(const char* name);
+
+#endif // IO_BUS_H
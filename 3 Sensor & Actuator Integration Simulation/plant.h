@@ -0,0 +1,51 @@
+/*
+ * Lumped-Parameter Process Plant
+ * ==============================
+ *
+ * Models the process the sensors measure, so actuator outputs feed back into
+ * later readings. Each "skid" has three lumped states:
+ * - Temperature: constant process heat, lost to ambient; the motor-driven fan
+ *   increases the heat-transfer coefficient
+ *     dT/dt = heat_input - (k_ambient + k_fan * motor) * (T - T_ambient)
+ * - Pressure: a feed pump builds pressure, the valve relieves it
+ *     dP/dt = pump_rate - k_relief * valve * P
+ * - Level: constant inflow, gravity drain through the valve
+ *     dL/dt = inflow - k_outflow * valve * L
+ *
+ * States are stored as structure-of-arrays so plant_step() integrates any
+ * number of identical skids in one vectorizable pass.
+ */
+
+#ifndef PLANT_H
+#define PLANT_H
+
+#include <stddef.h>
+
+// Physical parameters shared by every skid
+typedef struct {
+    float ambient_temp;       // °C
+    float heat_input;         // °C/s process heating
+    float k_ambient;          // 1/s natural heat loss
+    float k_fan;              // 1/s extra heat loss at full fan speed
+    float pump_rate;          // bar/s feed pump pressure build-up
+    float k_relief;           // 1/s pressure relief at a fully open valve
+    float inflow;             // %/s tank inflow
+    float k_outflow;          // 1/s tank drain rate at a fully open valve
+    float max_pressure;       // bar, relief limit
+} plant_params_t;
+
+// State of `count` identical skids
+typedef struct {
+    size_t count;
+    float* temperature;       // °C
+    float* pressure;          // bar
+    float* level;             // % full
+    plant_params_t params;
+} plant_t;
+
+void plant_default_params(plant_params_t* params);
+int plant_init(plant_t* plant, size_t count);
+void plant_free(plant_t* plant);
+void plant_step(plant_t* plant, const float* motor, const float* valve, float dt);
+
+#endif // PLANT_H
@@ -12,27 +12,43 @@
  * Skills demonstrated: structs, arrays, bitwise operations, functions, embedded programming
  */
 
+// Expose clock_gettime() when building with -std=c99
+#define _DEFAULT_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <math.h>
 #include <time.h>
 #include <string.h>
+#include "config_runtime.h"
+#include "hal.h"
+#include "io_bus.h"
+#include "seqlock.h"
+#include "plant.h"
+#include "profiler.h"
+#include "term_input.h"
 
 // Cross-platform compatibility for Windows and Unix-like systems
 #ifdef _WIN32
 #include <windows.h>
-#include <conio.h>
-// Define usleep for Windows (Sleep takes milliseconds)
-#define usleep(x) Sleep((x) / 1000)
 #else
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
 #endif
 
 // Simulated ADC/DAC Constants
 // ADC: Analog-to-Digital Converter simulation
 #define ADC_RESOLUTION 12        // 12-bit ADC (0-4095 range)
 #define ADC_VREF 3.3f           // 3.3V reference voltage for ADC
+#define ADC_MAX_CODE 4095       // Full-scale code for ADC_RESOLUTION bits
+#define ADC_CHANNELS 3          // Number of analog input channels in use
+
+// Burst acquisition: each channel is oversampled and then decimated.
+// Averaging 4^n samples gains n bits when the input carries >= 1 LSB of noise.
+#define ADC_MAX_OVERSAMPLE 256  // Largest burst per channel (gains 4 bits)
+#define ADC_NOISE_LSB 1.0f      // Peak triangular input noise in LSBs (acts as dither)
 
 // DAC: Digital-to-Analog Converter simulation
 #define DAC_RESOLUTION 8        // 8-bit DAC (0-255 range)
@@ -47,6 +63,39 @@
 #define PIN_VALVE_SOLENOID 4    // Pin for valve solenoid control
 #define PIN_LED_INDICATOR 5     // Pin for LED indicator
 
+// Control Logic Thresholds and Outputs (thresholds are defaults for the
+// commissioning parameters in config_keys)
+#define TEMP_MOTOR_ON 50.0f        // Motor runs above this temperature (°C)
+#define MOTOR_SPEED_ON 75.0f       // Motor speed when on (%)
+#define MOTOR_SPEED_OFF 25.0f      // Motor speed setpoint when off (%)
+#define PRESSURE_VALVE_OPEN 6.0f   // Valve opens above this pressure (bar)
+#define VALVE_OPEN 80.0f           // Valve position when open (%)
+#define VALVE_CLOSED 20.0f         // Valve position when closed (%)
+#define LEVEL_LED_ON 20.0f         // LED lights below this level (%)
+
+// Commissioning parameters the control logic follows, in config_keys order
+enum { CONFIG_MOTOR_ON_TEMPERATURE, CONFIG_VALVE_OPEN_PRESSURE, CONFIG_LEVEL_ALARM_PERCENT };
+
+static const config_key_t config_keys[] = {
+    {"motor_on_temperature", TEMP_MOTOR_ON, 0.0, 100.0},
+    {"valve_open_pressure", PRESSURE_VALVE_OPEN, 0.0, 10.0},
+    {"level_alarm_percent", LEVEL_LED_ON, 0.0, 100.0},
+};
+
+/*
+ * A control threshold from the configuration snapshot, or its built-in value
+ * when there is no snapshot
+ *
+ * @return: The threshold in the key's engineering unit
+ */
+static inline float control_threshold(const config_snapshot_t* cfg, int key) {
+    return (float)(cfg != NULL ? cfg->values[key] : config_keys[key].default_value);
+}
+
+// Closed-loop simulation
+#define SCAN_PERIOD_S 0.5f         // Plant time advanced per sensor scan (s)
+#define SCAN_PERIOD_US 500000      // Real time between automatic scans (us)
+
 // Sensor Types
 typedef enum {
     SENSOR_TEMPERATURE = 0,
@@ -83,6 +132,18 @@ typedef struct {
     uint8_t state;            // On/Off state
 } actuator_t;
 
+// Burst Acquisition Structure
+// Samples are stored channel-major so each channel's burst is one contiguous run
+// that the acquisition and decimation loops can process with SIMD instructions.
+typedef struct {
+    uint16_t oversample;      // Samples per channel per burst (1 = single conversion)
+    uint8_t extra_bits;       // Resolution gained by decimation: log2(oversample) / 2
+    uint8_t shift;            // Right shift applied to the burst sum
+    uint32_t sequence;        // Noise generator position, advanced every burst
+    uint16_t samples[ADC_CHANNELS][ADC_MAX_OVERSAMPLE]; // Preallocated burst buffer
+    uint32_t result[ADC_CHANNELS];  // Decimated codes, ADC_RESOLUTION + extra_bits wide
+} adc_burst_t;
+
 // System Structure
 typedef struct {
     sensor_t sensors[3];
@@ -90,19 +151,40 @@ typedef struct {
     uint16_t digital_inputs;  // 16-bit digital input register
     uint16_t digital_outputs; // 16-bit digital output register
     float system_voltage;
+    adc_burst_t burst;        // Oversampled acquisition state (used when oversample > 1)
+    io_bus_t* bus;            // Shared-memory bus to an external plant (NULL = use the HAL)
+    uint32_t bus_cycle;       // Actuator frames published on the bus
+    plant_t plant;            // Local process model (one skid)
+    uint8_t closed_loop;      // 1 = sensors measure the plant, 0 = independent random readings
+    config_runtime_t* config; // Live control thresholds (NULL = built-in defaults)
+    config_reader_t config_reader;  // The control loop's registration with config
 } system_t;
 
 // Function Prototypes
 void system_init(system_t* sys);
 uint16_t adc_read(uint8_t channel);
+int adc_burst_init(adc_burst_t* burst, uint16_t oversample);
+void adc_burst_acquire(adc_burst_t* burst, const float* analog_volts);
+void adc_burst_decimate(adc_burst_t* burst);
+float adc_burst_voltage(const adc_burst_t* burst, uint8_t channel);
 void dac_write(uint8_t channel, uint16_t value);
 void digital_write(system_t* sys, uint8_t pin, uint8_t state);
 uint8_t digital_read(system_t* sys, uint8_t pin);
 float simulate_sensor_reading(sensor_type_t type);
+float process_value(system_t* sys, int index);
+void step_plant(system_t* sys);
 void update_sensors(system_t* sys);
 void update_actuators(system_t* sys);
 void control_logic(system_t* sys);
+void control_logic_batch(const plant_t* plant, const config_snapshot_t* cfg, float* motor, float* valve);
 void display_status(system_t* sys);
+double monotonic_seconds(void);
+void benchmark_adc_burst(void);
+void benchmark_hal_dispatch(void);
+int benchmark_io_bus(void);
+int benchmark_plant(size_t skids, const char* config_path);
+int benchmark_config(void);
+int run_benchmark(const char* name, const char* config_path);
 
 /*
  * Main function - Program entry point
@@ -110,9 +192,62 @@ void display_status(system_t* sys);
  * This function initializes the system and runs the main simulation loop.
  * It handles both automatic operation and manual user commands.
  */
-int main() {
+int main(int argc, char* argv[]) {
     system_t sys;        // Main system structure containing all sensors and actuators
-    char command;        // Variable to store user keyboard input
+    term_ticker_t scan_ticker;  // Paces the automatic scans
+    int command;         // Variable to store user keyboard input
+    int oversample = 1;  // Samples per channel per scan (1 = single conversion)
+    const char* hal_spec = HAL_DEFAULT_SPEC;  // I/O backend specification
+    const char* config_path = CONFIG_RUNTIME_DEFAULT_PATH;  // Commissioning file for the thresholds
+    config_runtime_t config;
+    io_bus_t bus;                  // Shared-memory bus (only used with --bus)
+    int use_bus = 0;
+    int open_loop = 0;             // Keep the independent random sensor readings
+    const char* bench = NULL;      // Benchmark to run instead of the simulation
+
+    // Command-line options: benchmarks run headless and exit
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            bench = argv[++i];
+        } else if (strcmp(argv[i], "--oversample") == 0 && i + 1 < argc) {
+            char* end;
+            long value = strtol(argv[++i], &end, 10);
+            if (end == argv[i] || *end != '\0' || value < 1 || value > ADC_MAX_OVERSAMPLE) {
+                printf("Error: oversample must be between 1 and %d\n", ADC_MAX_OVERSAMPLE);
+                return 1;
+            }
+            oversample = (int)value;
+        } else if (strcmp(argv[i], "--hal") == 0 && i + 1 < argc) {
+            hal_spec = argv[++i];
+        } else if (strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            config_path = argv[++i];
+        } else if (strcmp(argv[i], "--open-loop") == 0) {
+            open_loop = 1;
+        } else if (strcmp(argv[i], "--bus") == 0) {
+            use_bus = 1;
+        } else if (strcmp(argv[i], "--bus-peer") == 0) {
+            return io_bus_run_peer(IO_BUS_DEFAULT_NAME);
+        } else {
+            printf("Usage: %s [--hal sim|replay:<trace>|shm[:<name>]] [--oversample N] [--config FILE]"
+                   " [--open-loop] [--bus | --bus-peer] [--bench adc|hal|bus|plant|config|all]\n",
+                   argv[0]);
+            return 1;
+        }
+    }
+
+    // Benchmarks read the same commissioning file, so --config may come in any position
+    if (bench != NULL) {
+        return run_benchmark(bench, config_path);
+    }
+
+    // The burst is acquired from the simulated analog signals, which only the sim backend has
+    if (oversample > 1 && (use_bus || strcmp(hal_spec, "sim") != 0)) {
+        printf("Error: --oversample needs the sim HAL backend and no --bus\n");
+        return 1;
+    }
+
+    // Time the scan functions when PROFILE_OUTPUT names a trace file
+    profiler_start_from_env();
 
     // Display program header
     printf("Sensor & Actuator Integration Simulation\n");
@@ -122,22 +257,81 @@ int main() {
     // This ensures different sensor readings each time the program runs
     srand(time(NULL));
 
+    // Attach the I/O backend before touching any hardware
+    if (hal_open(hal_spec) != 0) {
+        return 1;
+    }
+
     // Initialize all sensors and actuators with default values
     system_init(&sys);
 
+    // Control thresholds from the commissioning file, reloaded when it changes
+    if (config_runtime_open(&config, config_path, config_keys, sizeof(config_keys) / sizeof(config_keys[0])) != 0) {
+        printf("Error: Cannot read the configuration\n");
+        return 1;
+    }
+    sys.config = &config;
+    config_runtime_register(&config, &sys.config_reader);
+
+    // Close the loop through the local plant when the sensors are simulated
+    if (!open_loop && !use_bus && strcmp(hal_spec, "sim") == 0) {
+        if (plant_init(&sys.plant, 1) != 0) {
+            printf("Error: Cannot allocate plant model\n");
+            return 1;
+        }
+        sys.closed_loop = 1;
+        printf("Closed-loop plant model active (%.1f s per scan)\n", SCAN_PERIOD_S);
+    }
+
+    // Exchange sensor and actuator frames with an external plant process
+    if (use_bus) {
+        if (io_bus_open(&bus, IO_BUS_DEFAULT_NAME) != 0) {
+            return 1;
+        }
+        sys.bus = &bus;
+        printf("Sensor/actuator I/O mapped to shared-memory bus %s\n", bus.name);
+    }
+    if (adc_burst_init(&sys.burst, (uint16_t)oversample) != 0) {
+        printf("Error: oversample must be between 1 and %d\n", ADC_MAX_OVERSAMPLE);
+        return 1;
+    }
+    if (oversample > 1) {
+        printf("Burst acquisition: %dx oversampling, %d-bit decimated output\n",
+               oversample, ADC_RESOLUTION + sys.burst.extra_bits);
+    }
+
     // Display initialization complete message and command instructions
     printf("System initialized. Starting simulation...\n\n");
     printf("Commands: r (read sensors), c (run control), q (quit)\n\n");
 
+    // Raw keyboard mode for the whole run, restored at exit
+    if (term_input_open() != 0) {
+        printf("Warning: Cannot set terminal mode, keys need Enter\n");
+    }
+
     // Main program loop - runs indefinitely until user quits
+    term_ticker_start(&scan_ticker, SCAN_PERIOD_US);
     while (1) {
-        // Check for keyboard input (non-blocking)
-        if (_kbhit()) {
-            command = _getch();  // Get the pressed key
+        // Continuous automatic simulation loop
+        // This runs every 500ms regardless of user input
+        update_sensors(&sys);     // Read all sensor values
+        control_logic(&sys);      // Execute control algorithms
+        display_status(&sys);     // Show current system state
 
+        // Handle keys as they arrive until the next scan is due
+        while ((command = term_input_wait(&scan_ticker)) != TERM_INPUT_TICK) {
             if (command == 'q') {
                 // User wants to quit
                 printf("Exiting simulation...\n");
+                if (sys.bus != NULL) {
+                    // Tell the plant process to stop before detaching
+                    __atomic_store_n(&sys.bus->region->running, 0, __ATOMIC_RELEASE);
+                    io_bus_close(sys.bus);
+                }
+                hal_close();
+                plant_free(&sys.plant);
+                config_runtime_unregister(sys.config, &sys.config_reader);
+                config_runtime_close(sys.config);
                 return 0;
             } else if (command == 'r') {
                 // Manual sensor reading command
@@ -149,13 +343,6 @@ int main() {
                 display_status(&sys);
             }
         }
-
-        // Continuous automatic simulation loop
-        // This runs every 500ms regardless of user input
-        update_sensors(&sys);     // Read all sensor values
-        control_logic(&sys);      // Execute control algorithms
-        display_status(&sys);     // Show current system state
-        usleep(500000);           // Wait 500 milliseconds (0.5 seconds)
     }
 
     return 0;
@@ -213,43 +400,152 @@ void system_init(system_t* sys) {
     sys->digital_inputs = 0;
     sys->digital_outputs = 0;
     sys->system_voltage = 24.0f;
+
+    // Single conversion per scan until burst acquisition is configured
+    adc_burst_init(&sys->burst, 1);
+
+    // Hardware I/O through the HAL until a bus is attached
+    sys->bus = NULL;
+    sys->bus_cycle = 0;
+
+    // Open loop until a plant model is attached
+    memset(&sys->plant, 0, sizeof(sys->plant));
+    sys->closed_loop = 0;
+
+    // Built-in thresholds until a configuration is attached
+    sys->config = NULL;
+    sys->config_reader.seen = 0;
 }
 
 /*
- * Simulate ADC reading from a specified channel.
- * In real hardware, this would read from an analog-to-digital converter.
- * Here we simulate realistic ADC behavior with noise and random variation.
+ * Read an ADC channel through the hardware abstraction layer.
+ * The active backend decides where the conversion comes from (simulated
+ * noise, a replayed trace, or a shared-memory register written by another process).
  *
  * @param channel: ADC channel number (0-2 for our sensors)
  * @return: 12-bit ADC value (0-4095)
  */
 uint16_t adc_read(uint8_t channel) {
-    // Generate random base value between 0 and 1
-    float base_value = (float)rand() / RAND_MAX;
+    return hal_adc_read(channel);
+}
+
+/*
+ * Configure burst acquisition for a given oversampling ratio.
+ * Decimating by averaging gains half a bit per doubling of the sample count,
+ * so the burst sum is shifted right by log2(N) - extra_bits to keep the
+ * gained bits while dropping the ones that are pure noise.
+ *
+ * @param burst: Burst acquisition state
+ * @param oversample: Samples per channel per burst (1 to ADC_MAX_OVERSAMPLE)
+ * @return: 0 on success, -1 if the ratio is out of range
+ */
+int adc_burst_init(adc_burst_t* burst, uint16_t oversample) {
+    uint8_t log2_n = 0;
+
+    if (oversample < 1 || oversample > ADC_MAX_OVERSAMPLE) {
+        return -1;
+    }
+    while ((1u << (log2_n + 1)) <= oversample) {
+        log2_n++;
+    }
+
+    memset(burst, 0, sizeof(*burst));
+    burst->oversample = oversample;
+    burst->extra_bits = log2_n / 2;
+    burst->shift = log2_n - burst->extra_bits;
+    burst->sequence = (uint32_t)rand();
+    return 0;
+}
+
+/*
+ * Integer hash used as a counter-based noise generator.
+ * Unlike rand(), every sample's noise depends only on its index, so the
+ * acquisition loop has no serial dependency and can be vectorized.
+ */
+static inline uint32_t noise_hash(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+/*
+ * Acquire one burst of samples on every channel into the preallocated buffer.
+ * Each sample is the channel's analog input plus triangular noise, quantized
+ * to ADC_RESOLUTION bits exactly as a single adc_read() conversion would be.
+ *
+ * @param burst: Burst acquisition state (oversample samples per channel)
+ * @param analog_volts: Input voltage for each of the ADC_CHANNELS channels
+ */
+void adc_burst_acquire(adc_burst_t* burst, const float* analog_volts) {
+    const uint32_t n = burst->oversample;
+    const float scale = 1.0f / 16777216.0f;  // 24-bit hash fraction to [0, 1)
+
+    for (int c = 0; c < ADC_CHANNELS; c++) {
+        uint16_t* restrict out = burst->samples[c];
+        const float code = analog_volts[c] / ADC_VREF * (float)ADC_MAX_CODE + 0.5f;
+        const uint32_t base = burst->sequence + (uint32_t)c * 0x9E3779B9U;
+
+        for (uint32_t s = 0; s < n; s++) {
+            // Sum of two uniforms gives triangular noise in (-1, 1)
+            // (signed conversions keep the loop in SIMD-friendly int32/float lanes)
+            float u1 = (float)(int32_t)(noise_hash(base + 2 * s) >> 8) * scale;
+            float u2 = (float)(int32_t)(noise_hash(base + 2 * s + 1) >> 8) * scale;
+            float v = code + (u1 + u2 - 1.0f) * ADC_NOISE_LSB;
+
+            v = v < 0.0f ? 0.0f : v;
+            v = v > (float)ADC_MAX_CODE ? (float)ADC_MAX_CODE : v;
+            out[s] = (uint16_t)(int32_t)v;
+        }
+    }
+    burst->sequence += 2 * n;
+}
+
+/*
+ * Decimate the current burst into one extended-resolution code per channel.
+ * Summing the burst is a first-order CIC (boxcar) filter; the rounded shift
+ * then scales the sum to ADC_RESOLUTION + extra_bits bits.
+ *
+ * @param burst: Burst acquisition state holding a completed burst
+ */
+void adc_burst_decimate(adc_burst_t* burst) {
+    const uint32_t n = burst->oversample;
+    const uint32_t round = burst->shift ? 1u << (burst->shift - 1) : 0;
 
-    // Add realistic noise (±5%) to simulate real-world ADC imperfections
-    float noise = ((float)rand() / RAND_MAX - 0.5f) * 0.1f;
+    for (int c = 0; c < ADC_CHANNELS; c++) {
+        const uint16_t* restrict in = burst->samples[c];
+        uint32_t sum = round;
 
-    // Calculate final ADC value with 12-bit resolution (0-4095)
-    uint16_t adc_value = (uint16_t)(base_value * 4095.0f * (1.0f + noise));
+        for (uint32_t s = 0; s < n; s++) {
+            sum += in[s];
+        }
+        burst->result[c] = sum >> burst->shift;
+    }
+}
 
-    return adc_value;
+/*
+ * Convert a decimated code back to the voltage at the ADC input.
+ *
+ * @param burst: Burst acquisition state holding decimated results
+ * @param channel: ADC channel number
+ * @return: Input voltage estimate in volts
+ */
+float adc_burst_voltage(const adc_burst_t* burst, uint8_t channel) {
+    float full_scale = (float)((uint32_t)ADC_MAX_CODE << burst->extra_bits);
+    return (float)burst->result[channel] / full_scale * ADC_VREF;
 }
 
 /*
- * Simulate DAC writing to a specified channel.
+ * Write a DAC channel through the hardware abstraction layer.
  * In real hardware, this would set the output voltage of a digital-to-analog converter.
- * Here we calculate and display the resulting voltage.
  *
  * @param channel: DAC channel number (0-2 for our actuators)
  * @param value: 8-bit DAC value (0-255)
  */
 void dac_write(uint8_t channel, uint16_t value) {
-    // Calculate output voltage: value/255 * 5.0V reference
-    float voltage = (float)value / 255.0f * DAC_VREF;
-
-    // Display the DAC output voltage (simulating hardware behavior)
-    printf("DAC Channel %d: Set to %.2fV\n", channel, voltage);
+    hal_dac_write(channel, value);
 }
 
 /*
@@ -269,6 +565,9 @@ void digital_write(system_t* sys, uint8_t pin, uint8_t state) {
         // Clear the bit: AND with ~(1 << pin) to turn pin OFF
         sys->digital_outputs &= ~(1 << pin);
     }
+
+    // Drive the physical output register through the HAL
+    hal_digital_write(sys->digital_outputs);
 }
 
 /*
@@ -281,6 +580,9 @@ void digital_write(system_t* sys, uint8_t pin, uint8_t state) {
  * @return: Pin state (0 = LOW, 1 = HIGH)
  */
 uint8_t digital_read(system_t* sys, uint8_t pin) {
+    // Latch the physical input register through the HAL
+    sys->digital_inputs = hal_digital_read();
+
     // Check if bit is set: AND with (1 << pin), return 1 if set, 0 if clear
     return (sys->digital_inputs & (1 << pin)) ? 1 : 0;
 }
@@ -316,25 +618,115 @@ float simulate_sensor_reading(sensor_type_t type) {
     return base_value;
 }
 
+/*
+ * Physical value currently presented to a sensor.
+ * In closed-loop mode this is the plant state; otherwise an independent
+ * random reading is drawn for the sensor type.
+ *
+ * @param sys: Pointer to system structure
+ * @param index: Sensor index (0 = temperature, 1 = pressure, 2 = level)
+ * @return: Value in the sensor's engineering units
+ */
+float process_value(system_t* sys, int index) {
+    if (!sys->closed_loop) {
+        return simulate_sensor_reading(sys->sensors[index].type);
+    }
+    switch (sys->sensors[index].type) {
+        case SENSOR_TEMPERATURE: return sys->plant.temperature[0];
+        case SENSOR_PRESSURE: return sys->plant.pressure[0];
+        case SENSOR_LEVEL: return sys->plant.level[0];
+        default: return 0.0f;
+    }
+}
+
+/*
+ * Advance the plant by one scan period using the current actuator outputs.
+ * The motor relay gates the fan; the valve follows its analog position.
+ *
+ * @param sys: Pointer to system structure
+ */
+void step_plant(system_t* sys) {
+    float motor = sys->actuators[0].state ? sys->actuators[0].current_value / 100.0f : 0.0f;
+    float valve = sys->actuators[1].current_value / 100.0f;
+
+    plant_step(&sys->plant, &motor, &valve, SCAN_PERIOD_S);
+}
+
 /*
  * Update all sensor readings in the system.
  * This function simulates the complete sensor data acquisition process:
  * 1. Read ADC values from each sensor channel
  * 2. Convert ADC values to voltages
- * 3. Generate realistic sensor readings based on sensor type
+ * 3. Scale voltages to engineering units using each sensor's range
+ * In closed-loop mode the plant is advanced first and drives the ADC inputs.
+ * In burst mode the sensor signals are oversampled instead, and with a bus
+ * attached the values come straight from the external plant.
  *
  * @param sys: Pointer to system structure
  */
 void update_sensors(system_t* sys) {
+    PROFILE_SCOPE("update_sensors");
+
+    // With an external plant attached, take one consistent snapshot from the bus
+    if (sys->bus != NULL) {
+        io_sensor_frame_t frame;
+        io_bus_read_sensors(sys->bus, &frame);
+        for (int i = 0; i < IO_BUS_SENSORS; i++) {
+            sys->sensors[i].value = frame.values[i];
+        }
+        sys->digital_inputs = (uint16_t)frame.digital_inputs;
+        return;
+    }
+
+    // Time moves on: the process responds to the last actuator outputs
+    if (sys->closed_loop) {
+        step_plant(sys);
+        for (int i = 0; i < 3; i++) {
+            sensor_t* s = &sys->sensors[i];
+            hal_sim_set_input(s->adc_channel,
+                              (process_value(sys, i) - s->min_range) / (s->max_range - s->min_range));
+        }
+    }
+
+    // Let the HAL backend latch a new set of inputs for this scan
+    hal_begin_scan();
+    sys->digital_inputs = hal_digital_read();
+
+    if (sys->burst.oversample > 1) {
+        float analog_volts[ADC_CHANNELS];
+
+        // Present each sensor's signal to its ADC input as a 0-VREF voltage
+        for (int i = 0; i < 3; i++) {
+            sensor_t* s = &sys->sensors[i];
+            float reading = process_value(sys, i);
+            analog_volts[s->adc_channel] =
+                (reading - s->min_range) / (s->max_range - s->min_range) * ADC_VREF;
+        }
+
+        // Oversample every channel in one burst, then decimate
+        adc_burst_acquire(&sys->burst, analog_volts);
+        adc_burst_decimate(&sys->burst);
+
+        // Scale the extended-resolution voltage back to engineering units
+        for (int i = 0; i < 3; i++) {
+            sensor_t* s = &sys->sensors[i];
+            float volts = adc_burst_voltage(&sys->burst, s->adc_channel);
+            s->value = s->min_range + volts / ADC_VREF * (s->max_range - s->min_range);
+        }
+        return;
+    }
+
     for (int i = 0; i < 3; i++) {
+        sensor_t* s = &sys->sensors[i];
+
         // Step 1: Read raw ADC value from sensor's ADC channel
-        uint16_t adc_value = adc_read(sys->sensors[i].adc_channel);
+        uint16_t adc_value = adc_read(s->adc_channel);
 
-        // Step 2: Convert ADC reading to voltage (though not used in final calculation)
-        float voltage = (float)adc_value / 4095.0f * ADC_VREF;
+        // Step 2: Convert ADC reading to voltage
+        float voltage = (float)adc_value / (float)ADC_MAX_CODE * ADC_VREF;
 
-        // Step 3: Generate realistic sensor reading based on sensor type
-        sys->sensors[i].value = simulate_sensor_reading(sys->sensors[i].type);
+        // Step 3: Scale the 0-VREF signal to the sensor's engineering range
+        s->value = s->min_range + voltage / ADC_VREF * (s->max_range - s->min_range);
     }
 }
 
@@ -345,6 +737,7 @@ void update_sensors(system_t* sys) {
  * 2. Write DAC values to control analog outputs
  * 3. Update digital outputs for on/off control
  * 4. Update current values to match setpoints
+ * 5. Publish the outputs on the shared-memory bus when one is attached
  *
  * @param sys: Pointer to system structure
  */
@@ -362,38 +755,63 @@ void update_actuators(system_t* sys) {
         // Update current value to reflect the setpoint
         sys->actuators[i].current_value = sys->actuators[i].setpoint;
     }
+
+    // Publish the complete output set to the external plant in one frame
+    if (sys->bus != NULL) {
+        io_actuator_frame_t frame;
+        frame.cycle = ++sys->bus_cycle;
+        frame.digital_outputs = sys->digital_outputs;
+        frame.state_mask = 0;
+        for (int i = 0; i < IO_BUS_ACTUATORS; i++) {
+            frame.setpoint[i] = sys->actuators[i].current_value;
+            frame.state_mask |= (uint32_t)(sys->actuators[i].state ? 1u : 0u) << i;
+        }
+        io_bus_publish_actuators(sys->bus, &frame);
+    }
 }
 
 /*
  * Execute control logic based on current sensor readings.
- * This implements a simple PID-like control system:
+ * This implements a simple PID-like control system (default thresholds):
  * - Temperature > 50°C: Turn on motor at 75% speed
  * - Pressure > 6 bar: Open valve at 80% position
  * - Level < 20%: Turn on LED indicator at 100% brightness
+ * The thresholds are read from the configuration snapshot on every scan, so
+ * edits to the commissioning file apply from the next scan without a lock.
  *
  * @param sys: Pointer to system structure
  */
 void control_logic(system_t* sys) {
+    PROFILE_SCOPE("control_logic");
+    const config_snapshot_t* cfg = NULL;
+
+    if (sys->config != NULL) {
+        cfg = config_runtime_read(sys->config, &sys->config_reader);
+    }
+    float motor_on = control_threshold(cfg, CONFIG_MOTOR_ON_TEMPERATURE);
+    float valve_open = control_threshold(cfg, CONFIG_VALVE_OPEN_PRESSURE);
+    float led_on = control_threshold(cfg, CONFIG_LEVEL_ALARM_PERCENT);
+
     // Temperature control logic
-    if (sys->sensors[0].value > 50.0f) {
+    if (sys->sensors[0].value > motor_on) {
         sys->actuators[0].state = 1;        // Turn motor ON
-        sys->actuators[0].setpoint = 75.0f; // Set to 75% speed
+        sys->actuators[0].setpoint = MOTOR_SPEED_ON; // Set to 75% speed
     } else {
         sys->actuators[0].state = 0;        // Turn motor OFF
-        sys->actuators[0].setpoint = 25.0f; // Set to 25% speed when off
+        sys->actuators[0].setpoint = MOTOR_SPEED_OFF; // Set to 25% speed when off
     }
 
     // Pressure control logic
-    if (sys->sensors[1].value > 6.0f) {
+    if (sys->sensors[1].value > valve_open) {
         sys->actuators[1].state = 1;        // Open valve
-        sys->actuators[1].setpoint = 80.0f; // Set to 80% open
+        sys->actuators[1].setpoint = VALVE_OPEN; // Set to 80% open
     } else {
         sys->actuators[1].state = 0;        // Close valve
-        sys->actuators[1].setpoint = 20.0f; // Set to 20% open when closed
+        sys->actuators[1].setpoint = VALVE_CLOSED; // Set to 20% open when closed
     }
 
     // Level control logic
-    if (sys->sensors[2].value < 20.0f) {
+    if (sys->sensors[2].value < led_on) {
         sys->actuators[2].state = 1;         // Turn LED ON
         sys->actuators[2].setpoint = 100.0f; // Set to 100% brightness
     } else {
@@ -405,6 +823,30 @@ void control_logic(system_t* sys) {
     update_actuators(sys);
 }
 
+/*
+ * Control logic for many skids at once, reading the plant state directly.
+ * Applies control_logic()'s thresholds from the same configuration snapshot
+ * as branch-free selects over arrays so it vectorizes alongside plant_step().
+ *
+ * @param plant: Plant state for every skid
+ * @param cfg: Configuration snapshot (NULL for the built-in thresholds)
+ * @param motor: Output fan speed per skid (0-1)
+ * @param valve: Output valve opening per skid (0-1)
+ */
+void control_logic_batch(const plant_t* plant, const config_snapshot_t* cfg, float* motor, float* valve) {
+    const float motor_on = control_threshold(cfg, CONFIG_MOTOR_ON_TEMPERATURE);
+    const float valve_open = control_threshold(cfg, CONFIG_VALVE_OPEN_PRESSURE);
+    const float* restrict temperature = plant->temperature;
+    const float* restrict pressure = plant->pressure;
+    float* restrict fan = motor;
+    float* restrict opening = valve;
+
+    for (size_t i = 0; i < plant->count; i++) {
+        fan[i] = temperature[i] > motor_on ? MOTOR_SPEED_ON / 100.0f : 0.0f;
+        opening[i] = pressure[i] > valve_open ? VALVE_OPEN / 100.0f : VALVE_CLOSED / 100.0f;
+    }
+}
+
 /*
  * Display comprehensive system status information.
  * Shows current readings for all sensors and actuators,
@@ -439,3 +881,475 @@ void display_status(system_t* sys) {
            sys->digital_inputs, sys->digital_outputs);
     printf("System Voltage: %.1fV\n", sys->system_voltage);
 }
+
+/*
+ * Read a monotonic clock in seconds for benchmarking.
+ */
+double monotonic_seconds(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+/*
+ * Benchmark burst acquisition and report throughput and effective bits.
+ * Throughput counts raw conversions per second through acquire + decimate.
+ * Effective bits come from the RMS error of the decimated result against a
+ * known DC input: ENOB = log2(VREF / (rms_error * sqrt(12))).
+ */
+void benchmark_adc_burst(void) {
+    static adc_burst_t burst;
+    const uint16_t ratios[] = {1, 4, 16, 64, 256};
+    const float test_volts[ADC_CHANNELS] = {1.23456f, 2.71828f, 0.31416f};
+    const int accuracy_bursts = 4000;
+    volatile uint32_t sink = 0;
+
+    printf("Burst ADC acquisition benchmark (%d channels, %d-bit ADC)\n",
+           ADC_CHANNELS, ADC_RESOLUTION);
+    printf("%-10s %-12s %-14s %-14s %s\n",
+           "Oversample", "Bursts/s", "Samples/s", "RMS err (uV)", "ENOB (bits)");
+
+    for (size_t r = 0; r < sizeof(ratios) / sizeof(ratios[0]); r++) {
+        double sq_error = 0.0;
+        long iterations = 0;
+        double start, elapsed;
+
+        adc_burst_init(&burst, ratios[r]);
+
+        // Accuracy: decimated result versus the true DC input
+        for (int b = 0; b < accuracy_bursts; b++) {
+            adc_burst_acquire(&burst, test_volts);
+            adc_burst_decimate(&burst);
+            for (int c = 0; c < ADC_CHANNELS; c++) {
+                double err = adc_burst_voltage(&burst, (uint8_t)c) - test_volts[c];
+                sq_error += err * err;
+            }
+        }
+        double rms = sqrt(sq_error / (accuracy_bursts * ADC_CHANNELS));
+        double enob = log2(ADC_VREF / (rms * sqrt(12.0)));
+
+        // Throughput: run for at least 0.2 s
+        start = monotonic_seconds();
+        do {
+            for (int k = 0; k < 1000; k++) {
+                adc_burst_acquire(&burst, test_volts);
+                adc_burst_decimate(&burst);
+                sink += burst.result[0];
+            }
+            iterations += 1000;
+            elapsed = monotonic_seconds() - start;
+        } while (elapsed < 0.2);
+
+        printf("%-10u %-12.0f %-14.3e %-14.1f %.2f\n",
+               ratios[r], iterations / elapsed,
+               (double)iterations * ratios[r] * ADC_CHANNELS / elapsed,
+               rms * 1e6, enob);
+    }
+    (void)sink;
+}
+
+// Time `count` calls of an ADC read expression and store ns per call
+#define TIME_ADC_READS(ns_out, count, read_fn) \
+    do { \
+        uint32_t acc_ = 0; \
+        double t0_ = monotonic_seconds(); \
+        for (long k_ = 0; k_ < (count); k_++) { \
+            acc_ += read_fn((uint8_t)(k_ & 3)); \
+        } \
+        (ns_out) = (monotonic_seconds() - t0_) * 1e9 / (double)(count); \
+        sink += acc_; \
+    } while (0)
+
+/*
+ * Benchmark HAL dispatch styles for every backend.
+ * "static" calls the backend's function by name, as a build with HAL_BACKEND
+ * fixed at compile time does; "vtable" loads the function pointer from the
+ * backend table on every sample, as the default runtime-selectable build does.
+ */
+void benchmark_hal_dispatch(void) {
+    const char* trace_path = "hal_bench_trace.csv";
+    const long count = 20000000;
+    volatile uint32_t sink = 0;
+    const hal_backend_t* volatile table;
+    double direct_ns, vtable_ns;
+    FILE* trace;
+
+    printf("HAL dispatch benchmark (%ld adc_read calls per style)\n", count);
+    printf("%-8s %-14s %-14s %s\n", "Backend", "Static (ns)", "Vtable (ns)", "Overhead (ns)");
+
+    // Simulated backend: rand()-based conversions
+    table = &hal_sim_backend;
+    TIME_ADC_READS(direct_ns, count / 10, hal_sim_adc_read);
+    TIME_ADC_READS(vtable_ns, count / 10, table->adc_read);
+    printf("%-8s %-14.2f %-14.2f %.2f\n", "sim", direct_ns, vtable_ns, vtable_ns - direct_ns);
+
+    // Replay backend: a short generated trace held in memory
+    trace = fopen(trace_path, "w");
+    if (trace != NULL) {
+        for (int row = 0; row < 64; row++) {
+            fprintf(trace, "%d,%d,%d;0x%04X\n", row * 64, 4095 - row * 64, 2048, row);
+        }
+        fclose(trace);
+        if (hal_replay_backend.init(trace_path) == 0) {
+            table = &hal_replay_backend;
+            TIME_ADC_READS(direct_ns, count, hal_replay_adc_read);
+            TIME_ADC_READS(vtable_ns, count, table->adc_read);
+            printf("%-8s %-14.2f %-14.2f %.2f\n", "replay", direct_ns, vtable_ns,
+                   vtable_ns - direct_ns);
+            hal_replay_backend.shutdown();
+        }
+        remove(trace_path);
+        remove("hal_bench_trace.csv.out");
+    }
+
+    // Shared-memory backend: atomic loads from a private segment
+    if (hal_shm_backend.init("/sensor_actuator_hal_bench") == 0) {
+        table = &hal_shm_backend;
+        TIME_ADC_READS(direct_ns, count, hal_shm_adc_read);
+        TIME_ADC_READS(vtable_ns, count, table->adc_read);
+        printf("%-8s %-14.2f %-14.2f %.2f\n", "shm", direct_ns, vtable_ns,
+               vtable_ns - direct_ns);
+        hal_shm_backend.shutdown();
+    }
+    (void)sink;
+}
+
+/*
+ * Two-process round-trip test and latency benchmark for the shared-memory bus.
+ * A forked echo peer answers every actuator frame with a sensor frame; the
+ * controller paces requests at 10 kHz and measures the time from publishing
+ * frame k until sensor frame k is visible. Both sides check that every frame
+ * they read is internally consistent, so a torn snapshot fails the test.
+ *
+ * @return: 0 if every frame was consistent, 1 otherwise
+ */
+int benchmark_io_bus(void) {
+#ifdef _WIN32
+    printf("Bus benchmark requires POSIX shared memory and fork()\n");
+    return 0;
+#else
+    const char* name = "/sensor_actuator_bus_bench";
+    const int cycles = 20000;             // 2 seconds at 10 kHz
+    const double period = 1.0 / 10000.0;
+    static double latency_us[20000];
+    io_bus_t bus;
+    io_sensor_frame_t reply;
+    int torn = 0, status = 0;
+    pid_t peer;
+
+    shm_unlink(name);                     // Discard a segment left by an aborted run
+    if (io_bus_open(&bus, name) != 0) {
+        return 1;
+    }
+    fflush(stdout);
+    peer = fork();
+    if (peer == 0) {
+        _exit(io_bus_run_echo_peer(name));
+    }
+    if (peer < 0) {
+        printf("Error: fork() failed\n");
+        io_bus_close(&bus);
+        return 1;
+    }
+
+    printf("Shared-memory bus round trip (%d frames at 10 kHz, 2 processes)\n", cycles);
+    double start = monotonic_seconds();
+    double deadline = start;
+    for (int k = 1; k <= cycles; k++) {
+        io_actuator_frame_t request;
+        unsigned spins = 0;
+
+        // Pace requests on a fixed 100 us schedule
+        deadline += period;
+        while (monotonic_seconds() < deadline) {
+            if (++spins % SEQLOCK_SPINS_BEFORE_YIELD == 0) seqlock_yield();
+        }
+
+        request.cycle = (uint32_t)k;
+        request.digital_outputs = (uint32_t)k & 0xFFFFu;
+        request.state_mask = (uint32_t)k & 7u;
+        for (int i = 0; i < IO_BUS_ACTUATORS; i++) {
+            request.setpoint[i] = (float)(k + i);
+        }
+
+        double t0 = monotonic_seconds();
+        io_bus_publish_actuators(&bus, &request);
+        do {
+            io_bus_read_sensors(&bus, &reply);
+            if (reply.cycle != (uint32_t)k && ++spins % SEQLOCK_SPINS_BEFORE_YIELD == 0) {
+                seqlock_yield();
+            }
+        } while (reply.cycle != (uint32_t)k);
+        latency_us[k - 1] = (monotonic_seconds() - t0) * 1e6;
+
+        for (int i = 0; i < IO_BUS_SENSORS; i++) {
+            if (reply.values[i] != (float)(2 * k + i)) torn++;
+        }
+        if (reply.digital_inputs != (~(uint32_t)k & 0xFFFFu)) torn++;
+    }
+    double elapsed = monotonic_seconds() - start;
+
+    __atomic_store_n(&bus.region->running, 0, __ATOMIC_RELEASE);
+    waitpid(peer, &status, 0);
+    io_bus_close(&bus);
+
+    // Latency percentiles (insertion sort is fine for a one-off report)
+    for (int i = 1; i < cycles; i++) {
+        double v = latency_us[i];
+        int j = i - 1;
+        while (j >= 0 && latency_us[j] > v) {
+            latency_us[j + 1] = latency_us[j];
+            j--;
+        }
+        latency_us[j + 1] = v;
+    }
+    int peer_torn = WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+    printf("  Achieved rate: %.0f exchanges/s\n", cycles / elapsed);
+    printf("  Round trip: p50 %.2f us, p99 %.2f us, max %.2f us\n",
+           latency_us[cycles / 2], latency_us[cycles * 99 / 100], latency_us[cycles - 1]);
+    printf("  Inconsistent frames: controller %d, peer %d -> %s\n",
+           torn, peer_torn, (torn == 0 && peer_torn == 0) ? "PASS" : "FAIL");
+    return (torn == 0 && peer_torn == 0) ? 0 : 1;
+#endif
+}
+
+/*
+ * Run thousands of closed-loop skids in parallel for controller validation.
+ * Each skid starts from a different operating point; every step runs the
+ * batch controller and integrates the plant, both vectorized across skids.
+ * Reports throughput and how well the controller held the process limits
+ * over the second half of the run (after start-up transients). The batch
+ * controller reads its thresholds from the commissioning file every step,
+ * as control_logic() does every scan.
+ *
+ * @param skids: Number of independent skids to simulate
+ * @param config_path: Commissioning file for the thresholds
+ * @return: 0 on success, 1 if allocation fails or the file cannot be read
+ */
+int benchmark_plant(size_t skids, const char* config_path) {
+    const int steps = 2000;                  // 1000 s of plant time per skid
+    config_runtime_t config;
+    config_reader_t reader;
+    const config_snapshot_t* cfg;
+    plant_t plant;
+    float* motor;
+    float* valve;
+    double temp_sum = 0.0;
+    float temp_max = 0.0f, pressure_max = 0.0f, level_min = 100.0f;
+    long temp_samples = 0;
+
+    motor = malloc(2 * skids * sizeof(float));
+    if (motor == NULL || plant_init(&plant, skids) != 0) {
+        printf("Error: Cannot allocate %lu skids\n", (unsigned long)skids);
+        free(motor);
+        return 1;
+    }
+    if (config_runtime_open(&config, config_path, config_keys, sizeof(config_keys) / sizeof(config_keys[0])) != 0) {
+        printf("Error: Cannot read the configuration\n");
+        plant_free(&plant);
+        free(motor);
+        return 1;
+    }
+    config_runtime_register(&config, &reader);
+    valve = motor + skids;
+
+    // Spread the initial conditions so every skid follows its own trajectory
+    for (size_t i = 0; i < skids; i++) {
+        plant.temperature[i] = 20.0f + (float)(i % 61);
+        plant.pressure[i] = (float)(i % 9);
+        plant.level[i] = (float)(i % 101);
+    }
+
+    printf("Closed-loop plant benchmark (%lu skids x %d steps of %.1f s)\n",
+           (unsigned long)skids, steps, SCAN_PERIOD_S);
+    double start = monotonic_seconds();
+    for (int step = 0; step < steps; step++) {
+        cfg = config_runtime_read(&config, &reader);
+        control_logic_batch(&plant, cfg, motor, valve);
+        plant_step(&plant, motor, valve, SCAN_PERIOD_S);
+
+        if (step >= steps / 2 && step % 10 == 0) {
+            for (size_t i = 0; i < skids; i++) {
+                temp_sum += plant.temperature[i];
+                temp_max = plant.temperature[i] > temp_max ? plant.temperature[i] : temp_max;
+                pressure_max = plant.pressure[i] > pressure_max ? plant.pressure[i] : pressure_max;
+                level_min = plant.level[i] < level_min ? plant.level[i] : level_min;
+            }
+            temp_samples += (long)skids;
+        }
+    }
+    double elapsed = monotonic_seconds() - start;
+
+    printf("  Throughput: %.3e skid-steps/s (%.2f ns per skid-step)\n",
+           (double)skids * steps / elapsed, elapsed * 1e9 / ((double)skids * steps));
+    printf("  Settled temperature: mean %.1f C, max %.1f C (motor threshold %.0f C)\n",
+           temp_sum / (double)temp_samples, temp_max, control_threshold(cfg, CONFIG_MOTOR_ON_TEMPERATURE));
+    printf("  Settled pressure max: %.2f bar (valve threshold %.1f bar)\n",
+           pressure_max, control_threshold(cfg, CONFIG_VALVE_OPEN_PRESSURE));
+    printf("  Settled level min: %.1f %%\n", level_min);
+
+    config_runtime_unregister(&config, &reader);
+    config_runtime_close(&config);
+    plant_free(&plant);
+    free(motor);
+    return 0;
+}
+
+/*
+ * Write a commissioning file the way project 5 saves one: to a temp file,
+ * then renamed over the old one
+ *
+ * @return: 0 on success, -1 if the file cannot be written
+ */
+static int write_bench_config(const char* path, float motor_on) {
+    char temp[256];
+    FILE* file;
+
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    file = fopen(temp, "w");
+    if (file == NULL) {
+        return -1;
+    }
+    fprintf(file, "Parameter,Value,Unit,Description,Valid\n");
+    fprintf(file, "motor_on_temperature,%.1f,Celsius,Benchmark value,true\n", motor_on);
+    fprintf(file, "valve_open_pressure,6.0,bar,Benchmark value,true\n");
+    fprintf(file, "level_alarm_percent,20,%%,Benchmark value,true\n");
+    fclose(file);
+    return rename(temp, path) == 0 ? 0 : -1;
+}
+
+/*
+ * Benchmark live configuration. Compares what the control loop pays per scan
+ * to read its thresholds - one snapshot load with no lock - with copying them
+ * under a mutex, then measures how long a saved change takes to reach the
+ * loop: from the rename of a new file until the loop reads the new version.
+ *
+ * @return: 0 if every change arrived, 1 otherwise
+ */
+int benchmark_config(void) {
+    const char* path = "config_bench.csv";
+    const long reads = 20000000;
+    const int changes = 20;
+    config_runtime_t config;
+    config_reader_t reader;
+    volatile float sink = 0.0f;
+    double latency_ms[20];
+    int missed = 0;
+
+    if (write_bench_config(path, TEMP_MOTOR_ON) != 0 ||
+        config_runtime_open(&config, path, config_keys, sizeof(config_keys) / sizeof(config_keys[0])) != 0) {
+        printf("Error: Cannot create %s\n", path);
+        remove(path);
+        return 1;
+    }
+    config_runtime_register(&config, &reader);
+    config.quiet = 1;
+
+    printf("Live configuration benchmark (%ld reads of 3 thresholds)\n", reads);
+    double start = monotonic_seconds();
+    for (long k = 0; k < reads; k++) {
+        const config_snapshot_t* cfg = config_runtime_read(&config, &reader);
+        sink += (float)(cfg->values[0] + cfg->values[1] + cfg->values[2]);
+    }
+    double snapshot_ns = (monotonic_seconds() - start) * 1e9 / reads;
+    printf("  Snapshot read: %.2f ns per scan\n", snapshot_ns);
+#ifndef _WIN32
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    double copy[3];
+    start = monotonic_seconds();
+    for (long k = 0; k < reads; k++) {
+        pthread_mutex_lock(&lock);
+        memcpy(copy, config.current->values, sizeof(copy));
+        pthread_mutex_unlock(&lock);
+        sink += (float)(copy[0] + copy[1] + copy[2]);
+    }
+    double mutex_ns = (monotonic_seconds() - start) * 1e9 / reads;
+    printf("  Mutex copy:    %.2f ns per scan (uncontended)\n", mutex_ns);
+#endif
+
+    // Reload latency through the watcher
+    for (int c = 0; c < changes; c++) {
+        uint64_t version = config_runtime_read(&config, &reader)->version;
+        double t0 = monotonic_seconds();
+        if (write_bench_config(path, 40.0f + (float)(c % 2) * 5.0f) != 0) {
+            missed++;
+            continue;
+        }
+        const config_snapshot_t* cfg;
+        do {
+            cfg = config_runtime_read(&config, &reader);
+            if (cfg->version == version) {
+                seqlock_yield();
+            }
+        } while (cfg->version == version && monotonic_seconds() - t0 < 2.0);
+        latency_ms[c] = (monotonic_seconds() - t0) * 1e3;
+        if (cfg->version == version) {
+            missed++;
+        }
+    }
+    double sum = 0.0, worst = 0.0;
+    for (int c = 0; c < changes; c++) {
+        sum += latency_ms[c];
+        worst = latency_ms[c] > worst ? latency_ms[c] : worst;
+    }
+    printf("  Save to loop: mean %.2f ms, max %.2f ms over %d saves\n", sum / changes, worst, changes);
+
+    // Cost of the reload itself: read, parse and publish
+    start = monotonic_seconds();
+    for (int c = 0; c < changes; c++) {
+        write_bench_config(path, 40.0f + (float)(c % 2) * 5.0f);
+        config_runtime_reload(&config);
+    }
+    printf("  Reload: %.1f us per changed file (write included)\n",
+           (monotonic_seconds() - start) * 1e6 / changes);
+    printf("  Changes seen: %d of %d -> %s\n", changes - missed, changes, missed == 0 ? "PASS" : "FAIL");
+
+    config_runtime_unregister(&config, &reader);
+    config_runtime_close(&config);
+    remove(path);
+    (void)sink;
+    return missed == 0 ? 0 : 1;
+}
+
+/*
+ * Run a named benchmark and return the process exit code.
+ */
+int run_benchmark(const char* name, const char* config_path) {
+    int all = strcmp(name, "all") == 0;
+    int found = 0;
+    int result = 0;
+
+    if (all || strcmp(name, "adc") == 0) {
+        benchmark_adc_burst();
+        found = 1;
+    }
+    if (all || strcmp(name, "hal") == 0) {
+        benchmark_hal_dispatch();
+        found = 1;
+    }
+    if (all || strcmp(name, "bus") == 0) {
+        result |= benchmark_io_bus();
+        found = 1;
+    }
+    if (all || strcmp(name, "plant") == 0) {
+        result |= benchmark_plant(4096, config_path);
+        found = 1;
+    }
+    if (all || strcmp(name, "config") == 0) {
+        result |= benchmark_config();
+        found = 1;
+    }
+
+    if (!found) {
+        printf("Unknown benchmark '%s' (available: adc, hal, bus, plant, config, all)\n", name);
+        return 1;
+    }
+    return result;
+}
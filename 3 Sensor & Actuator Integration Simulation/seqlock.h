@@ -0,0 +1,86 @@
+/*
+ * Sequence Lock (seqlock)
+ * =======================
+ *
+ * Single-writer, multi-reader synchronization for small blocks of 32-bit words
+ * shared between threads or processes (e.g. through shared memory).
+ * - The writer makes the sequence counter odd, stores the payload, then makes it even
+ * - A reader copies the payload and retries if the counter was odd or changed
+ *
+ * Readers never block the writer and never observe a half-written (torn) block,
+ * and neither side makes a system call in the common case.
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#define seqlock_yield() SwitchToThread()
+#else
+#include <sched.h>
+#define seqlock_yield() sched_yield()
+#endif
+
+#define SEQLOCK_SPINS_BEFORE_YIELD 128  // Busy retries before giving up the CPU
+#define SEQLOCK_INIT 2u                 // Initial (even, non-zero) sequence of a new block
+
+/*
+ * Publish a new payload.
+ * Only one writer may update a given block at a time.
+ */
+static inline void seqlock_write(uint32_t* seq, uint32_t* dst, const uint32_t* src, size_t words) {
+    uint32_t s = __atomic_load_n(seq, __ATOMIC_RELAXED);
+    uint32_t next = (s + 2 != 0) ? s + 2 : SEQLOCK_INIT;  // Skip 0 on wrap-around
+
+    __atomic_store_n(seq, s + 1, __ATOMIC_RELAXED);   // Odd: update in progress
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (size_t i = 0; i < words; i++) {
+        __atomic_store_n(&dst[i], src[i], __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(seq, next, __ATOMIC_RELEASE);    // Even: payload consistent
+}
+
+/*
+ * Attempt one consistent copy of the payload.
+ *
+ * @return: Sequence number of the copied snapshot, or 0 if the copy was torn
+ *          (blocks start at SEQLOCK_INIT, so a valid sequence is never 0)
+ */
+static inline uint32_t seqlock_try_read(const uint32_t* seq, const uint32_t* src,
+                                        uint32_t* dst, size_t words) {
+    uint32_t s1 = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+
+    if (s1 & 1u) {
+        return 0;
+    }
+    for (size_t i = 0; i < words; i++) {
+        dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return (__atomic_load_n(seq, __ATOMIC_RELAXED) == s1) ? s1 : 0;
+}
+
+/*
+ * Copy a consistent snapshot, retrying until the writer is not mid-update.
+ *
+ * @return: Sequence number of the snapshot
+ */
+static inline uint32_t seqlock_read(const uint32_t* seq, const uint32_t* src,
+                                    uint32_t* dst, size_t words) {
+    unsigned spins = 0;
+    uint32_t s;
+
+    while ((s = seqlock_try_read(seq, src, dst, words)) == 0) {
+        // A preempted writer leaves the counter odd; let it run
+        if (++spins % SEQLOCK_SPINS_BEFORE_YIELD == 0) {
+            seqlock_yield();
+        }
+    }
+    return s;
+}
+
+#endif // SEQLOCK_H
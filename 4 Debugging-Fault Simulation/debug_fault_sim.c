@@ -14,6 +14,9 @@
  * Skills demonstrated: error handling, logging, state machines, file I/O, debugging techniques
  */
 
+// Expose usleep() and clock_gettime() when building with -std=c99
+#define _DEFAULT_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -21,70 +24,40 @@
 #include <time.h>
 #include <assert.h>
 #include <errno.h>
+#include <stdarg.h>
+#include "log_format.h"
+#include "log_writer.h"
+#include "proc_metrics.h"
+#include "watchdog.h"
+#include "fault_store.h"
+#include "profiler.h"
+#include "term_input.h"
 
 // Cross-platform compatibility
 #ifdef _WIN32
 #include <windows.h>
-#include <conio.h>
 #define usleep(x) Sleep((x) / 1000)
-#define kbhit _kbhit
-#define getch _getch
 #else
 #include <unistd.h>
 #include <termios.h>
 #include <fcntl.h>
-
-// Unix-compatible kbhit and getch implementations
-int kbhit(void) {
-    struct termios oldt, newt;
-    int ch;
-    int oldf;
-
-    tcgetattr(STDIN_FILENO, &oldt);
-    newt = oldt;
-    newt.c_lflag &= ~(ICANON | ECHO);
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-    oldf = fcntl(STDIN_FILENO, F_GETFL, 0);
-    fcntl(STDIN_FILENO, F_SETFL, oldf | O_NONBLOCK);
-
-    ch = getchar();
-
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-    fcntl(STDIN_FILENO, F_SETFL, oldf);
-
-    if (ch != EOF) {
-        ungetc(ch, stdin);
-        return 1;
-    }
-
-    return 0;
-}
-
-int getch(void) {
-    struct termios oldt, newt;
-    int ch;
-
-    tcgetattr(STDIN_FILENO, &oldt);
-    newt = oldt;
-    newt.c_lflag &= ~(ICANON | ECHO);
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-
-    ch = getchar();
-
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-
-    return ch;
-}
-
-#define usleep(x) usleep(x)
+#include <sys/resource.h>
+#include <pthread.h>
+#include <pty.h>
 #endif
 
 // Configuration Constants
 #define MAX_LOG_ENTRIES 1000
-#define LOG_FILE_PATH "system_debug.log"
-#define MAX_FAULT_HISTORY 50
-#define WATCHDOG_TIMEOUT_MS 5000
+#define LOG_FILE_PATH "system_debug.bin"   // Binary log; view with ./log_decode
+#define FAULT_EVENTS_PATH "fault_events.bin"  // Fault history; summarize with --fault-report
+#define WATCHDOG_TIMEOUT_MS 500              // Control loop heartbeat deadline (5 cycles)
 #define SYSTEM_HEALTH_CHECK_INTERVAL_MS 1000
+#define HEALTH_HEARTBEAT_DEADLINE_MS 5000    // Health sample heartbeat (samples are 1 s apart)
+#define CONTROL_LOOP_BUDGET_US 50000       // Busy time allowed per 100 ms control cycle
+#define CONTROL_CYCLE_US 100000            // Control loop period
+#define RECOVERY_QUIESCE_MS 500            // Recovery stage durations (2 s in all)
+#define RECOVERY_RESET_MS 1000
+#define RECOVERY_VERIFY_MS 500
 
 // Error Codes
 typedef enum {
@@ -109,6 +82,16 @@ typedef enum {
     LOG_CRITICAL = 4
 } log_level_t;
 
+// Log Modules: each has its own runtime log level
+typedef enum {
+    LOG_MODULE_CORE = 0,        // Initialization, shutdown, logging, diagnostics
+    LOG_MODULE_HEALTH = 1,      // System health checks
+    LOG_MODULE_FAULT = 2,       // Fault injection and fault simulation
+    LOG_MODULE_RECOVERY = 3,    // Fault recovery
+    LOG_MODULE_IO = 4,          // Simulated sensors, actuators, communication, power
+    LOG_MODULE_COUNT
+} log_module_t;
+
 // System States
 typedef enum {
     STATE_INIT = 0,
@@ -128,66 +111,176 @@ typedef enum {
     FAULT_MEMORY_LEAK = 5
 } fault_type_t;
 
-// Log Entry Structure
+// Subsystems that fail and recover independently
+typedef enum {
+    SUBSYSTEM_SENSORS = 0,
+    SUBSYSTEM_ACTUATORS = 1,
+    SUBSYSTEM_COMMS = 2,
+    SUBSYSTEM_POWER = 3,
+    SUBSYSTEM_MEMORY = 4,
+    SUBSYSTEM_CONTROL = 5,      // Watchdog, overload and other control loop faults
+    SUBSYSTEM_COUNT
+} subsystem_t;
+
+// Recovery stages, advanced once per control cycle by recovery_tick()
+typedef enum {
+    RECOVERY_IDLE = 0,          // In service
+    RECOVERY_QUIESCE = 1,       // Out of service, injected fault withdrawn
+    RECOVERY_RESET = 2,         // Reinitializing
+    RECOVERY_VERIFY = 3,        // Watching for the fault to return
+    RECOVERY_RESUME = 4         // Back in service, its faults resolved
+} recovery_stage_t;
+
+// Recovery progress of one subsystem
 typedef struct {
-    time_t timestamp;
-    log_level_t level;
-    error_code_t error_code;
-    char message[256];
-    char function[64];
-    int line_number;
-} log_entry_t;
+    recovery_stage_t stage;
+    double stage_start;         // monitor_now() when the stage began
+    uint32_t errors;            // Errors logged against the subsystem
+    uint32_t errors_at_reset;   // ... when its reset finished
+} subsystem_recovery_t;
 
-// Fault History Structure
-typedef struct {
-    time_t timestamp;
-    fault_type_t fault_type;
-    error_code_t error_code;
-    uint8_t resolved;
-    char description[128];
-} fault_record_t;
+// Compile-time check that fault types and subsystems fit the fault store's indexes
+typedef char fault_types_fit_store[FAULT_MEMORY_LEAK < FAULT_STORE_TYPES ? 1 : -1];
+typedef char subsystems_fit_store[SUBSYSTEM_COUNT <= FAULT_STORE_SUBSYSTEMS ? 1 : -1];
+
+static const char* fault_type_names[FAULT_MEMORY_LEAK + 1] = {
+    "none", "sensor noise", "actuator fail", "comm break", "power spike", "memory leak"
+};
+
+// Fault store tag of a watchdog miss: task index, and whether it resumed
+#define WATCHDOG_TAG_RESUMED 0x80
 
 // System Health Structure
+// CPU, memory and context switches are sampled from the process itself
+// (proc_metrics.h) every SYSTEM_HEALTH_CHECK_INTERVAL_MS.
 typedef struct {
     system_state_t current_state;
-    uint32_t uptime_seconds;
+    uint32_t uptime_seconds;          // Since debug_init()
     uint16_t fault_count;
     uint16_t recovery_count;
-    float cpu_usage_percent;
-    float memory_usage_percent;
+    float cpu_usage_percent;          // Of one CPU over the last sample interval
+    float memory_usage_percent;       // Resident memory as a share of physical memory
+    uint32_t rss_kb;
+    uint64_t voluntary_switches;      // Context switches since start
+    uint64_t involuntary_switches;
+    uint32_t loop_period_us;          // Time between the last two control cycles
+    uint32_t loop_period_max_us;
+    uint32_t recovery_period_max_us;  // Longest loop period during the last recovery
+    uint32_t loop_work_us;            // Busy time of the last control cycle
+    uint32_t loop_work_max_us;
     uint32_t last_health_check;
 } system_health_t;
 
 // Debug Monitor Structure
+// log_buffer is a ring: log_head is the oldest entry and log_count entries
+// follow it, so a full buffer overwrites the oldest entry instead of shifting.
+// Entries are binary records (log_format.h); text is rendered on display.
 typedef struct {
-    log_entry_t log_buffer[MAX_LOG_ENTRIES];
+    log_record_t log_buffer[MAX_LOG_ENTRIES];
+    int log_head;
     int log_count;
-    fault_record_t fault_history[MAX_FAULT_HISTORY];
-    int fault_count;
+    uint32_t log_sequence;      // Records logged this session
+    uint16_t log_sites_sent;    // Call sites already defined in the log file
+    fault_store_t faults;       // Every fault raised, indexed by type and status
+    uint64_t wall_start_ns;     // Wall clock at debug_init(): fault times are wall clock
     system_health_t health;
-    FILE* log_file;
+    proc_metrics_t metrics;     // Cached /proc descriptors and previous CPU sample
+    double start_time;          // Monotonic time of debug_init()
+    double last_metrics_sample;
+    double last_cycle_start;
+    watchdog_t watchdog;        // Heartbeat monitor thread
+    int loop_heartbeat;         // Fed once per control cycle
+    int health_heartbeat;       // Fed once per process metrics sample
+    log_writer_t log_writer;    // Background writer for LOG_FILE_PATH
     uint8_t fault_injection_enabled;
     fault_type_t active_fault;
+    uint32_t fault_cycles;      // Control cycles run with fault injection enabled
+    uint32_t fault_sim_calls[FAULT_MEMORY_LEAK + 1];   // Simulation passes per fault type
+    int sensor_failures;        // Consecutive failed sensor readings
+    uint32_t faulted_subsystems; // Bit per subsystem with an error not yet recovered
+    subsystem_recovery_t recovery[SUBSYSTEM_COUNT];
+    uint32_t rng_state;         // This instance's random sequence (random_next())
+
+    // Headless instances (fault campaign) run on a simulated clock with no
+    // log file, watchdog thread, process metrics or console output
+    uint8_t headless;
+    double sim_time;            // Simulated monotonic time in seconds
 } debug_monitor_t;
 
 // Function Prototypes
-void debug_init(debug_monitor_t* monitor);
+void debug_init(debug_monitor_t* monitor, log_fsync_t fsync_policy);
+void debug_init_headless(debug_monitor_t* monitor, uint32_t seed);
 void debug_shutdown(debug_monitor_t* monitor);
-void log_message(debug_monitor_t* monitor, log_level_t level, error_code_t error,
-                const char* message, const char* function, int line);
+void log_message(debug_monitor_t* monitor, log_site_t* site, error_code_t error,
+                 const char* format, ...)
+#ifdef __GNUC__
+    __attribute__((format(printf, 4, 5)))   // Check arguments against the format at compile time
+#endif
+    ;
+log_record_t* log_entry_at(debug_monitor_t* monitor, int index);
+int render_log_message(const log_record_t* record, char* out, size_t size);
+uint64_t log_timestamp_ns(void);
+log_session_meta_t log_session_marker(log_meta_kind_t kind);
 void inject_fault(debug_monitor_t* monitor, fault_type_t fault);
 void check_system_health(debug_monitor_t* monitor);
+void record_watchdog_miss(debug_monitor_t* monitor, const watchdog_miss_t* miss);
 void attempt_fault_recovery(debug_monitor_t* monitor);
+void recovery_tick(debug_monitor_t* monitor);
+subsystem_t subsystem_of_error(error_code_t error);
+subsystem_t subsystem_of_fault(fault_type_t fault);
 void save_log_to_file(debug_monitor_t* monitor);
 void display_debug_info(debug_monitor_t* monitor);
+void describe_fault_event(const fault_event_t* event, const watchdog_t* watchdog, char* out, size_t size);
+void print_fault_summary(const fault_store_t* faults, uint64_t from_ns, uint64_t to_ns);
+int run_fault_report(const char* path);
 void assert_system_state(debug_monitor_t* monitor, system_state_t expected_state);
 
-// Macro for easy logging
-#define LOG_DEBUG(monitor, msg) log_message(monitor, LOG_DEBUG, ERR_NONE, msg, __func__, __LINE__)
-#define LOG_INFO(monitor, msg) log_message(monitor, LOG_INFO, ERR_NONE, msg, __func__, __LINE__)
-#define LOG_WARNING(monitor, error, msg) log_message(monitor, LOG_WARNING, error, msg, __func__, __LINE__)
-#define LOG_ERROR(monitor, error, msg) log_message(monitor, LOG_ERROR, error, msg, __func__, __LINE__)
-#define LOG_CRITICAL(monitor, error, msg) log_message(monitor, LOG_CRITICAL, error, msg, __func__, __LINE__)
+// Runtime log levels and their command-line handling
+extern uint8_t log_module_levels[LOG_MODULE_COUNT];
+int log_set_level(const char* spec);
+
+// Compile-time minimum log level: 0 = debug (default), 1 = info, 2 = warning.
+// Macros below it compile to nothing. Errors and criticals drive the fault
+// state, so they can never be filtered out.
+#ifndef LOG_COMPILE_MIN_LEVEL
+#define LOG_COMPILE_MIN_LEVEL 0
+#endif
+#if LOG_COMPILE_MIN_LEVEL < 0 || LOG_COMPILE_MIN_LEVEL > 2
+#error "LOG_COMPILE_MIN_LEVEL must be 0 (debug), 1 (info) or 2 (warning)"
+#endif
+
+// Module of the log calls that follow; redefined ahead of each group of functions
+#define LOG_MODULE LOG_MODULE_CORE
+
+// Macros for easy logging: LOG_INFO(monitor, "format", args...)
+// The level test is one load and compare against the module's runtime level,
+// made before any argument is evaluated. Each call site gets a static
+// descriptor holding its level, format string, function and line; only the
+// raw arguments are recorded per call.
+#define LOG_FORMAT_OF(...) LOG_FORMAT_OF_(__VA_ARGS__, "")
+#define LOG_FORMAT_OF_(format, ...) format
+#define LOG_AT(monitor, level, error, ...) \
+    do { \
+        if ((level) >= log_module_levels[LOG_MODULE]) { \
+            static log_site_t log_site_ = {0, level, 0, __LINE__, __func__, LOG_FORMAT_OF(__VA_ARGS__), {0}}; \
+            log_message(monitor, &log_site_, error, __VA_ARGS__); \
+        } \
+    } while (0)
+#define LOG_COMPILED_OUT(monitor) do { (void)(monitor); } while (0)
+
+#if LOG_COMPILE_MIN_LEVEL <= 0
+#define LOG_DEBUG(monitor, ...) LOG_AT(monitor, LOG_DEBUG, ERR_NONE, __VA_ARGS__)
+#else
+#define LOG_DEBUG(monitor, ...) LOG_COMPILED_OUT(monitor)
+#endif
+#if LOG_COMPILE_MIN_LEVEL <= 1
+#define LOG_INFO(monitor, ...) LOG_AT(monitor, LOG_INFO, ERR_NONE, __VA_ARGS__)
+#else
+#define LOG_INFO(monitor, ...) LOG_COMPILED_OUT(monitor)
+#endif
+#define LOG_WARNING(monitor, error, ...) LOG_AT(monitor, LOG_WARNING, error, __VA_ARGS__)
+#define LOG_ERROR(monitor, error, ...) LOG_AT(monitor, LOG_ERROR, error, __VA_ARGS__)
+#define LOG_CRITICAL(monitor, error, ...) LOG_AT(monitor, LOG_CRITICAL, error, __VA_ARGS__)
 
 // Assertion macro with logging
 #define ASSERT_STATE(monitor, condition, error, msg) \
@@ -198,6 +291,18 @@ void assert_system_state(debug_monitor_t* monitor, system_state_t expected_state
         } \
     } while(0)
 
+// One pass of the control loop: health check, fault simulation, normal operations
+void run_control_cycle(debug_monitor_t* monitor);
+
+// Monitor clock, hold and random sequence (simulated for headless instances)
+double monitor_now(debug_monitor_t* monitor);
+uint64_t fault_time_ns(debug_monitor_t* monitor);
+void monitor_hold(debug_monitor_t* monitor, uint32_t hold_us);
+uint32_t random_next(uint32_t* state);
+
+// Headless fault-injection campaign
+int run_fault_campaign(int instances, uint32_t seed, int threads);
+
 // Simulated system components that can fail
 int simulate_sensor_reading(debug_monitor_t* monitor);
 int simulate_actuator_control(debug_monitor_t* monitor, int command);
@@ -211,65 +316,92 @@ void simulate_communication_break(debug_monitor_t* monitor);
 void simulate_power_fluctuation(debug_monitor_t* monitor);
 void simulate_memory_corruption(debug_monitor_t* monitor);
 
+// Benchmarks
+double monotonic_seconds(void);
+void benchmark_log_buffer(void);
+void benchmark_log_writer(void);
+void benchmark_log_levels(void);
+void benchmark_health_sampling(void);
+void benchmark_watchdog(void);
+void benchmark_profiler(void);
+void benchmark_recovery(void);
+void benchmark_input(void);
+void benchmark_fault_store(void);
+int run_benchmark(const char* name);
+
 /*
  * Main function - Program entry point
  * ===================================
  * Demonstrates comprehensive debugging and fault simulation system
  */
-int main() {
+int main(int argc, char* argv[]) {
     debug_monitor_t monitor;
-    char command;
+    term_ticker_t ticker;
+    int command;
     int simulation_running = 1;
+    log_fsync_t fsync_policy = LOG_FSYNC_PERIODIC;
+    int campaign_instances = 0;
+    uint32_t campaign_seed = 1;
+    int campaign_threads = 0;   // 0 = one per online CPU
+
+    // Command-line options: benchmarks run headless and exit
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            return run_benchmark(argv[++i]);
+        } else if (strcmp(argv[i], "--fsync") == 0 && i + 1 < argc &&
+                   log_writer_parse_fsync(argv[i + 1], &fsync_policy) == 0) {
+            i++;
+        } else if (strcmp(argv[i], "--log-level") == 0 && i + 1 < argc &&
+                   log_set_level(argv[i + 1]) == 0) {
+            i++;
+        } else if (strcmp(argv[i], "--campaign") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            campaign_instances = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            campaign_seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            campaign_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--fault-report") == 0) {
+            return run_fault_report(i + 1 < argc ? argv[i + 1] : FAULT_EVENTS_PATH);
+        } else {
+            printf("Usage: %s [--fsync none|batch|periodic] [--log-level [module=]debug|info|warn]...\n"
+                   "       [--bench log|writer|levels|health|watchdog|profiler|recovery|input|faults|all]\n"
+                   "       [--campaign INSTANCES [--seed N] [--threads N]] [--fault-report [FILE]]\n", argv[0]);
+            printf("Modules: core, health, fault, recovery, io\n");
+            return 1;
+        }
+    }
+
+    // Headless fault-injection campaign: runs and exits
+    if (campaign_instances > 0) {
+        return run_fault_campaign(campaign_instances, campaign_seed, campaign_threads);
+    }
+
+    // Time log_message() when PROFILE_OUTPUT names a trace file
+    profiler_start_from_env();
 
     printf("Debugging & Fault Simulation System\n");
     printf("===================================\n\n");
 
     // Initialize debug monitoring system
-    debug_init(&monitor);
+    debug_init(&monitor, fsync_policy);
     LOG_INFO(&monitor, "System initialization started");
 
     printf("System initialized. Starting fault simulation...\n\n");
-    printf("Commands: f (inject fault), r (attempt recovery), d (debug info), q (quit)\n\n");
+    printf("Commands: f (inject fault), w (stall control loop), r (attempt recovery), d (debug info), q (quit)\n\n");
 
-    // Main simulation loop
+    // Raw keyboard mode for the whole run, restored at exit
+    if (term_input_open() != 0) {
+        printf("Warning: Cannot set terminal mode, keys need Enter\n");
+    }
+
+    // Main simulation loop: one control cycle per tick, keys handled as they arrive
+    term_ticker_start(&ticker, CONTROL_CYCLE_US);
     while (simulation_running) {
-        // Periodic health check
-        check_system_health(&monitor);
-
-        // Simulate system operations with potential faults (controlled frequency)
-        if (monitor.fault_injection_enabled) {
-            static int fault_call_count = 0;
-            static int last_fault_trigger = 0;
-            fault_call_count++;
-
-            // Only trigger fault simulation every 4th call for faster response
-            if (fault_call_count % 4 == 0 && fault_call_count != last_fault_trigger) {
-                last_fault_trigger = fault_call_count;
-                switch (monitor.active_fault) {
-                    case FAULT_SENSOR_NOISE:
-                        simulate_sensor_noise(&monitor);
-                        break;
-                    case FAULT_ACTUATOR_FAIL:
-                        simulate_actuator_failure(&monitor);
-                        break;
-                    case FAULT_COMM_BREAK:
-                        simulate_communication_break(&monitor);
-                        break;
-                    case FAULT_POWER_SPIKE:
-                        simulate_power_fluctuation(&monitor);
-                        break;
-                    case FAULT_MEMORY_LEAK:
-                        simulate_memory_corruption(&monitor);
-                        break;
-                    default:
-                        break;
-                }
-            }
-        }
+        // Health check, fault simulation and normal system operations
+        run_control_cycle(&monitor);
 
-        // Check for user input
-        if (kbhit()) {
-            command = getch();
+        // Wait for the next cycle, handling user input meanwhile
+        while (simulation_running && (command = term_input_wait(&ticker)) != TERM_INPUT_TICK) {
             switch (command) {
                 case 'q':
                     LOG_INFO(&monitor, "User requested system shutdown");
@@ -277,7 +409,12 @@ int main() {
                     break;
                 case 'f':
                     // Inject a random fault for testing
-                    inject_fault(&monitor, rand() % 5 + 1);
+                    inject_fault(&monitor, random_next(&monitor.rng_state) % 5 + 1);
+                    break;
+                case 'w':
+                    // Hold the control loop past its heartbeat deadline
+                    LOG_WARNING(&monitor, ERR_NONE, "Stalling control loop for %d ms", 2 * WATCHDOG_TIMEOUT_MS);
+                    usleep(2 * WATCHDOG_TIMEOUT_MS * 1000);
                     break;
                 case 'r':
                     // Attempt fault recovery
@@ -287,18 +424,13 @@ int main() {
                     // Display debug information
                     display_debug_info(&monitor);
                     break;
+                case '\n':
+                case '\r':
+                    break;   // Enter after a key when stdin is not a terminal
                 default:
-                    printf("Unknown command. Use: f, r, d, q\n");
+                    printf("Unknown command. Use: f, w, r, d, q\n");
             }
         }
-
-        // Simulate normal system operations
-        simulate_sensor_reading(&monitor);
-        simulate_actuator_control(&monitor, rand() % 100);
-        simulate_communication(&monitor);
-        simulate_power_monitoring(&monitor);
-
-        usleep(100000); // 0.1 second delay for better responsiveness
     }
 
     // Cleanup and shutdown
@@ -308,17 +440,89 @@ int main() {
     return 0;
 }
 
+/*
+ * Run one pass of the control loop
+ * Periodic health check, injected fault simulation and normal operations
+ */
+void run_control_cycle(debug_monitor_t* monitor) {
+    double cycle_start = monitor_now(monitor);
+
+    // Loop period: time since the previous cycle started
+    if (monitor->last_cycle_start > 0.0) {
+        monitor->health.loop_period_us = (uint32_t)((cycle_start - monitor->last_cycle_start) * 1e6);
+        if (monitor->health.loop_period_us > monitor->health.loop_period_max_us) {
+            monitor->health.loop_period_max_us = monitor->health.loop_period_us;
+        }
+    }
+    monitor->last_cycle_start = cycle_start;
+    watchdog_feed(&monitor->watchdog, monitor->loop_heartbeat);
+
+    // Periodic health check
+    check_system_health(monitor);
+
+    // Advance any subsystem recovery by one step
+    recovery_tick(monitor);
+
+    // Simulate system operations with potential faults (controlled frequency)
+    if (monitor->fault_injection_enabled) {
+        // Simulate the fault every 4th cycle, or every cycle in a headless
+        // campaign so detection is timed by the monitor and not by this pacing
+        if (++monitor->fault_cycles % 4 == 0 || monitor->headless) {
+            switch (monitor->active_fault) {
+                case FAULT_SENSOR_NOISE:
+                    simulate_sensor_noise(monitor);
+                    break;
+                case FAULT_ACTUATOR_FAIL:
+                    simulate_actuator_failure(monitor);
+                    break;
+                case FAULT_COMM_BREAK:
+                    simulate_communication_break(monitor);
+                    break;
+                case FAULT_POWER_SPIKE:
+                    simulate_power_fluctuation(monitor);
+                    break;
+                case FAULT_MEMORY_LEAK:
+                    simulate_memory_corruption(monitor);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    // Simulate normal system operations (subsystems under recovery are out of service)
+    if (monitor->recovery[SUBSYSTEM_SENSORS].stage == RECOVERY_IDLE) {
+        simulate_sensor_reading(monitor);
+    }
+    if (monitor->recovery[SUBSYSTEM_ACTUATORS].stage == RECOVERY_IDLE) {
+        simulate_actuator_control(monitor, (int)(random_next(&monitor->rng_state) % 100));
+    }
+    if (monitor->recovery[SUBSYSTEM_COMMS].stage == RECOVERY_IDLE) {
+        simulate_communication(monitor);
+    }
+    if (monitor->recovery[SUBSYSTEM_POWER].stage == RECOVERY_IDLE) {
+        simulate_power_monitoring(monitor);
+    }
+
+    // Busy time of this cycle, checked against the budget by the next health check
+    monitor->health.loop_work_us = (uint32_t)((monitor_now(monitor) - cycle_start) * 1e6);
+    if (monitor->health.loop_work_us > monitor->health.loop_work_max_us) {
+        monitor->health.loop_work_max_us = monitor->health.loop_work_us;
+    }
+}
+
 /*
  * Initialize the debug monitoring system
  * Sets up logging, fault tracking, and system health monitoring
  */
-void debug_init(debug_monitor_t* monitor) {
+void debug_init(debug_monitor_t* monitor, log_fsync_t fsync_policy) {
     // Initialize structure
     memset(monitor, 0, sizeof(debug_monitor_t));
 
-    // Open log file
-    monitor->log_file = fopen(LOG_FILE_PATH, "a");
-    if (monitor->log_file == NULL) {
+    // Open log file and start its background writer
+    log_session_meta_t marker = log_session_marker(LOG_META_SESSION_START);
+    if (log_writer_start(&monitor->log_writer, LOG_FILE_PATH, fsync_policy,
+                         &marker, sizeof(marker)) != 0) {
         printf("Warning: Could not open log file: %s\n", strerror(errno));
     }
 
@@ -326,9 +530,30 @@ void debug_init(debug_monitor_t* monitor) {
     monitor->health.current_state = STATE_INIT;
     monitor->health.uptime_seconds = 0;
     monitor->health.last_health_check = time(NULL);
+    monitor->start_time = monotonic_seconds();
+    monitor->wall_start_ns = log_timestamp_ns();
+    monitor->last_metrics_sample = monitor->start_time;  // First CPU sample covers a full interval
+    if (proc_metrics_open(&monitor->metrics) != 0) {
+        printf("Warning: Process metrics unavailable, CPU/memory checks disabled\n");
+    }
+
+    // Fault history, appended to the event file once per health sample
+    if (fault_store_open(&monitor->faults, FAULT_EVENTS_PATH) != 0) {
+        printf("Warning: Could not open fault event file, history kept in memory only: %s\n",
+               strerror(errno));
+    }
+
+    // Start the watchdog and register the heartbeats it checks
+    if (watchdog_start(&monitor->watchdog) != 0) {
+        printf("Warning: Could not start watchdog thread: %s\n", strerror(errno));
+    }
+    monitor->loop_heartbeat = watchdog_register(&monitor->watchdog, "control_loop",
+                                                WATCHDOG_TIMEOUT_MS * 1000);
+    monitor->health_heartbeat = watchdog_register(&monitor->watchdog, "health_sample",
+                                                  HEALTH_HEARTBEAT_DEADLINE_MS * 1000);
 
     // Seed random number generator
-    srand(time(NULL));
+    monitor->rng_state = (uint32_t)time(NULL) | 1;
 
     LOG_INFO(monitor, "Debug monitoring system initialized");
 
@@ -337,6 +562,65 @@ void debug_init(debug_monitor_t* monitor) {
     LOG_INFO(monitor, "System transitioned to RUNNING state");
 }
 
+/*
+ * Initialize a monitor for a headless campaign run: simulated clock, heartbeats
+ * registered but unchecked, no log file, process metrics or console output,
+ * and a random sequence fixed by the seed
+ */
+void debug_init_headless(debug_monitor_t* monitor, uint32_t seed) {
+    memset(monitor, 0, sizeof(debug_monitor_t));
+    monitor->headless = 1;
+    monitor->rng_state = (seed + 1) * 2654435761u | 1;
+    monitor->loop_heartbeat = watchdog_register(&monitor->watchdog, "control_loop",
+                                                WATCHDOG_TIMEOUT_MS * 1000);
+    monitor->health_heartbeat = watchdog_register(&monitor->watchdog, "health_sample",
+                                                  HEALTH_HEARTBEAT_DEADLINE_MS * 1000);
+    monitor->health.current_state = STATE_RUNNING;
+}
+
+/*
+ * Monotonic time in seconds: simulated for headless instances
+ */
+double monitor_now(debug_monitor_t* monitor) {
+    return monitor->headless ? monitor->sim_time : monotonic_seconds();
+}
+
+/*
+ * Time stamp for the fault store: wall clock in nanoseconds, advanced on the
+ * monotonic clock since debug_init() (simulated time for headless instances)
+ */
+uint64_t fault_time_ns(debug_monitor_t* monitor) {
+    return monitor->wall_start_ns + (uint64_t)((monitor_now(monitor) - monitor->start_time) * 1e9 + 0.5);
+}
+
+/*
+ * Hold the control loop, feeding its heartbeat every cycle as a real
+ * routine must; headless instances advance their simulated clock instead
+ */
+void monitor_hold(debug_monitor_t* monitor, uint32_t hold_us) {
+    if (monitor->headless) {
+        monitor->sim_time += hold_us * 1e-6;
+        return;
+    }
+    for (uint32_t held_us = 0; held_us < hold_us; held_us += CONTROL_CYCLE_US) {
+        usleep(CONTROL_CYCLE_US);
+        watchdog_feed(&monitor->watchdog, monitor->loop_heartbeat);
+    }
+}
+
+/*
+ * Next value of a xorshift32 sequence (state must be nonzero). Each monitor
+ * owns its sequence, so campaign instances are reproducible from their seed.
+ */
+uint32_t random_next(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
 /*
  * Shutdown the debug monitoring system
  * Saves logs and cleans up resources
@@ -344,52 +628,131 @@ void debug_init(debug_monitor_t* monitor) {
 void debug_shutdown(debug_monitor_t* monitor) {
     LOG_INFO(monitor, "Shutting down debug monitoring system");
 
-    // Save final log entries
+    // Record misses still open when the watchdog stops
+    watchdog_miss_t miss;
+    watchdog_stop(&monitor->watchdog);
+    while (watchdog_poll(&monitor->watchdog, &miss)) {
+        record_watchdog_miss(monitor, &miss);
+    }
+
+    // Flush queued log entries and close the log file
     save_log_to_file(monitor);
+    proc_metrics_close(&monitor->metrics);
 
-    // Close log file
-    if (monitor->log_file != NULL) {
-        fclose(monitor->log_file);
-        monitor->log_file = NULL;
+    // Append the last faults and resolutions to the event file
+    fault_store_flush(&monitor->faults);
+    if (monitor->faults.write_errors > 0) {
+        printf("Warning: Fault event file write errors: %llu\n",
+               (unsigned long long)monitor->faults.write_errors);
     }
+    fault_store_close(&monitor->faults);
 
     // Final system state check
     ASSERT_STATE(monitor, monitor->health.current_state != STATE_FAULT,
                 ERR_INVALID_STATE, "System shutdown with unresolved faults");
 }
 
+/*
+ * Read the wall clock in nanoseconds since the Unix epoch for log records
+ */
+uint64_t log_timestamp_ns(void) {
+#ifdef _WIN32
+    return (uint64_t)time(NULL) * 1000000000ull;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/*
+ * Build a session start/end entry for the binary log file
+ */
+log_session_meta_t log_session_marker(log_meta_kind_t kind) {
+    log_session_meta_t marker;
+
+    memset(&marker, 0, sizeof(marker));
+    marker.header.kind = (uint8_t)kind;
+    marker.header.length = sizeof(marker);
+    marker.magic = LOG_FORMAT_MAGIC;
+    marker.version = LOG_FORMAT_VERSION;
+    marker.record_size = sizeof(log_record_t);
+    marker.timestamp_ns = log_timestamp_ns();
+    return marker;
+}
+
 /*
  * Log a message with timestamp and context information
+ * Records only the call site's ID and the raw format arguments; the text is
+ * rendered when the entry is displayed or the log file is decoded.
  * Supports different log levels and error codes
  */
-void log_message(debug_monitor_t* monitor, log_level_t level, error_code_t error,
-                const char* message, const char* function, int line) {
+void log_message(debug_monitor_t* monitor, log_site_t* site, error_code_t error,
+                 const char* format, ...) {
+    PROFILE_SCOPE("log_message");
+    log_record_t* entry;
+    va_list args;
+
+    // First call from this site: assign its ID
+    if (__atomic_load_n(&site->id, __ATOMIC_ACQUIRE) == 0 && log_site_register(site) == 0) {
+        return;  // Registry full
+    }
+
     if (monitor->log_count >= MAX_LOG_ENTRIES) {
-        // Log buffer full, remove oldest entries
-        memmove(&monitor->log_buffer[0], &monitor->log_buffer[1],
-                sizeof(log_entry_t) * (MAX_LOG_ENTRIES - 1));
-        monitor->log_count = MAX_LOG_ENTRIES - 1;
+        // Log buffer full, overwrite the oldest entry
+        entry = &monitor->log_buffer[monitor->log_head];
+        if (++monitor->log_head == MAX_LOG_ENTRIES) {
+            monitor->log_head = 0;
+        }
+    } else {
+        entry = log_entry_at(monitor, monitor->log_count++);
     }
 
-    // Create log entry
-    log_entry_t* entry = &monitor->log_buffer[monitor->log_count++];
-    entry->timestamp = time(NULL);
-    entry->level = level;
-    entry->error_code = error;
-    strncpy(entry->message, message, sizeof(entry->message) - 1);
-    strncpy(entry->function, function, sizeof(entry->function) - 1);
-    entry->line_number = line;
+    // Fill in log entry
+    entry->site_id = site->id;
+    entry->error_code = (uint8_t)error;
+    entry->sequence = monitor->log_sequence++;
+    entry->timestamp_ns = log_timestamp_ns();
+    va_start(args, format);
+    entry->arg_length = (uint8_t)log_format_pack(site->arg_kinds, site->arg_count, args,
+                                                 entry->args, sizeof(entry->args));
+    va_end(args);
+
+    // Hand the entry to the writer thread; never waits for the disk
+    if (monitor->log_writer.active) {
+        // Define any call sites registered since the last record
+        while (monitor->log_sites_sent < log_site_count()) {
+            uint8_t definition[LOG_SITE_META_MAX];
+            const log_site_t* pending = log_site_get(monitor->log_sites_sent + 1);
+            size_t length = log_site_encode(pending, definition, sizeof(definition));
+            if (log_writer_submit(&monitor->log_writer, definition, length) != 0) {
+                break;  // Not written: retry with the next record
+            }
+            monitor->log_sites_sent++;
+        }
+        // A record whose site is not defined in the file could not be decoded
+        if (site->id <= monitor->log_sites_sent) {
+            log_writer_submit(&monitor->log_writer, entry, sizeof(*entry));
+        } else {
+            log_writer_drop(&monitor->log_writer);
+        }
+    }
 
     // Immediate console output for important messages
-    if (level >= LOG_WARNING) {
+    if (site->level >= LOG_WARNING && !monitor->headless) {
+        char message[256];
+        render_log_message(entry, message, sizeof(message));
         printf("[%s] %s:%d - %s\n",
-               (level == LOG_WARNING) ? "WARN" :
-               (level == LOG_ERROR) ? "ERROR" : "CRIT",
-               function, line, message);
+               (site->level == LOG_WARNING) ? "WARN" :
+               (site->level == LOG_ERROR) ? "ERROR" : "CRIT",
+               site->function, site->line, message);
     }
 
     // Update system health based on error severity
-    if (level >= LOG_ERROR) {
+    if (site->level >= LOG_ERROR) {
+        subsystem_t subsystem = subsystem_of_error(error);
+        monitor->faulted_subsystems |= 1u << subsystem;
+        monitor->recovery[subsystem].errors++;
         monitor->health.fault_count++;
         if (monitor->health.current_state == STATE_RUNNING) {
             monitor->health.current_state = STATE_FAULT;
@@ -398,6 +761,82 @@ void log_message(debug_monitor_t* monitor, log_level_t level, error_code_t error
     }
 }
 
+/*
+ * Return the log entry at position index, where 0 is the oldest entry
+ * still in the buffer and log_count - 1 the newest
+ */
+log_record_t* log_entry_at(debug_monitor_t* monitor, int index) {
+    int slot = monitor->log_head + index;
+
+    if (slot >= MAX_LOG_ENTRIES) {
+        slot -= MAX_LOG_ENTRIES;
+    }
+    return &monitor->log_buffer[slot];
+}
+
+/*
+ * Render the message text of a log record from its call site's format
+ *
+ * @return: Length of the message
+ */
+int render_log_message(const log_record_t* record, char* out, size_t size) {
+    const log_site_t* site = log_site_get(record->site_id);
+
+    if (site == NULL) {
+        return snprintf(out, size, "<unknown site %u>", record->site_id);
+    }
+    return log_format_render(site->format, site->arg_kinds, site->arg_count,
+                             record->args, record->arg_length, out, size);
+}
+
+// Runtime log level per module; debug output is off unless requested
+uint8_t log_module_levels[LOG_MODULE_COUNT] = {
+    LOG_INFO, LOG_INFO, LOG_INFO, LOG_INFO, LOG_INFO
+};
+
+/*
+ * Set runtime log levels from "level" (every module) or "module=level".
+ * Levels above warning are refused: errors and criticals are always logged.
+ *
+ * @return: 0 on success, -1 for an unknown module or level
+ */
+int log_set_level(const char* spec) {
+    static const char* modules[LOG_MODULE_COUNT] = {"core", "health", "fault", "recovery", "io"};
+    static const char* levels[] = {"debug", "info", "warn"};
+    const char* equals = strchr(spec, '=');
+    const char* level_name = equals ? equals + 1 : spec;
+    int first = 0, last = LOG_MODULE_COUNT - 1;
+    int level = -1;
+
+    for (int l = 0; l < (int)(sizeof(levels) / sizeof(levels[0])); l++) {
+        if (strcmp(level_name, levels[l]) == 0) level = l;
+    }
+    if (level < 0) {
+        return -1;
+    }
+
+    if (equals != NULL) {
+        first = -1;
+        for (int m = 0; m < LOG_MODULE_COUNT; m++) {
+            if (strncmp(spec, modules[m], (size_t)(equals - spec)) == 0 &&
+                modules[m][equals - spec] == '\0') {
+                first = last = m;
+            }
+        }
+        if (first < 0) {
+            return -1;
+        }
+    }
+
+    for (int m = first; m <= last; m++) {
+        log_module_levels[m] = (uint8_t)level;
+    }
+    return 0;
+}
+
+#undef LOG_MODULE
+#define LOG_MODULE LOG_MODULE_FAULT
+
 /*
  * Inject a specific fault type for testing purposes
  * Demonstrates controlled fault simulation
@@ -407,127 +846,304 @@ void inject_fault(debug_monitor_t* monitor, fault_type_t fault) {
     monitor->active_fault = fault;
 
     // Record fault in history
-    if (monitor->fault_count < MAX_FAULT_HISTORY) {
-        fault_record_t* record = &monitor->fault_history[monitor->fault_count++];
-        record->timestamp = time(NULL);
-        record->fault_type = fault;
-        record->resolved = 0;
-        snprintf(record->description, sizeof(record->description),
-                "Injected fault: %d", fault);
-    }
+    fault_store_append(&monitor->faults, fault_time_ns(monitor), fault, subsystem_of_fault(fault),
+                       ERR_NONE, 0, 0);
 
     LOG_WARNING(monitor, ERR_NONE, "Fault injection activated");
 }
 
+#undef LOG_MODULE
+#define LOG_MODULE LOG_MODULE_HEALTH
+
 /*
  * Perform comprehensive system health check
  * Monitors various system parameters and detects anomalies
  */
 void check_system_health(debug_monitor_t* monitor) {
     time_t current_time = time(NULL);
+    double now = monitor_now(monitor);
+    watchdog_miss_t miss;
 
     // Update uptime
-    monitor->health.uptime_seconds = current_time - monitor->health.last_health_check;
+    monitor->health.uptime_seconds = (uint32_t)(now - monitor->start_time);
+
+    // Sample process CPU, memory and context switches once per interval
+    // (headless instances share the process, so its metrics are not theirs)
+    if (!monitor->headless && now - monitor->last_metrics_sample >= SYSTEM_HEALTH_CHECK_INTERVAL_MS / 1000.0) {
+        proc_sample_t sample;
+
+        monitor->last_metrics_sample = now;
+        watchdog_feed(&monitor->watchdog, monitor->health_heartbeat);
+        fault_store_flush(&monitor->faults);
+        if (proc_metrics_sample(&monitor->metrics, &sample) == 0) {
+            monitor->health.cpu_usage_percent = sample.cpu_percent;
+            monitor->health.memory_usage_percent = sample.memory_percent;
+            monitor->health.rss_kb = sample.rss_kb;
+            monitor->health.voluntary_switches = sample.voluntary_switches;
+            monitor->health.involuntary_switches = sample.involuntary_switches;
+            LOG_DEBUG(monitor, "Health: CPU %.1f%%, memory %.1f%%",
+                      monitor->health.cpu_usage_percent, monitor->health.memory_usage_percent);
+
+            // Check for system overload
+            if (monitor->health.cpu_usage_percent > 90.0f) {
+                LOG_ERROR(monitor, ERR_SYSTEM_OVERLOAD, "CPU usage critical: %.1f%%",
+                          monitor->health.cpu_usage_percent);
+            }
 
-    // Simulate CPU and memory usage monitoring
-    monitor->health.cpu_usage_percent = 10.0f + (rand() % 40); // 10-50%
-    monitor->health.memory_usage_percent = 20.0f + (rand() % 60); // 20-80%
+            if (monitor->health.memory_usage_percent > 85.0f) {
+                LOG_ERROR(monitor, ERR_MEMORY_CORRUPTION, "Memory usage critical: %u kB",
+                          monitor->health.rss_kb);
+            }
+        }
+    }
 
-    // Check for system overload
-    if (monitor->health.cpu_usage_percent > 90.0f) {
-        LOG_ERROR(monitor, ERR_SYSTEM_OVERLOAD, "CPU usage critical");
+    // A control cycle that overruns its budget starves the next one
+    if (monitor->health.loop_work_us > CONTROL_LOOP_BUDGET_US) {
+        LOG_ERROR(monitor, ERR_SYSTEM_OVERLOAD, "Control cycle overrun: %u us",
+                  monitor->health.loop_work_us);
     }
 
-    if (monitor->health.memory_usage_percent > 85.0f) {
-        LOG_ERROR(monitor, ERR_MEMORY_CORRUPTION, "Memory usage critical");
+    // Heartbeat deadlines missed since the last check
+    while (watchdog_poll(&monitor->watchdog, &miss)) {
+        record_watchdog_miss(monitor, &miss);
     }
 
-    // Watchdog simulation - only trigger once every 5 seconds
-    static time_t last_watchdog_feed = 0;
-    static int watchdog_logged = 0;
+    monitor->health.last_health_check = current_time;
+}
 
-    if (last_watchdog_feed == 0) {
-        last_watchdog_feed = current_time;
-        watchdog_logged = 0;
-    } else if (current_time - last_watchdog_feed >= 5) {  // 5 seconds
-        if (!watchdog_logged) {
-            LOG_CRITICAL(monitor, ERR_WATCHDOG_TIMEOUT, "Watchdog timeout detected");
-            watchdog_logged = 1;
-        }
-        // Reset timer for next 5-second interval
-        last_watchdog_feed = current_time;
+/*
+ * Record a missed heartbeat deadline in the fault history
+ * The lateness is measured by the watchdog thread on the monotonic clock
+ */
+void record_watchdog_miss(debug_monitor_t* monitor, const watchdog_miss_t* miss) {
+    uint64_t late_us = miss->lateness_ns / 1000;
+
+    // Stamped when the heartbeat was due (the store keeps events in time order)
+    uint64_t age_ns = monitor->headless ? 0 : watchdog_now_ns() - miss->due_ns;
+    uint64_t now_ns = fault_time_ns(monitor);
+    fault_store_append(&monitor->faults, age_ns < now_ns ? now_ns - age_ns : 0, FAULT_NONE,
+                       subsystem_of_error(ERR_WATCHDOG_TIMEOUT), ERR_WATCHDOG_TIMEOUT,
+                       (uint32_t)(late_us > UINT32_MAX ? UINT32_MAX : late_us),
+                       (uint8_t)(miss->task | (miss->resumed ? WATCHDOG_TAG_RESUMED : 0)));
+
+    // Task index rather than name: the record's argument area holds 16 bytes
+    LOG_CRITICAL(monitor, ERR_WATCHDOG_TIMEOUT, "Watchdog: heartbeat %d late by %u us",
+                 miss->task, (unsigned)(late_us > UINT32_MAX ? UINT32_MAX : late_us));
+}
+
+#undef LOG_MODULE
+#define LOG_MODULE LOG_MODULE_RECOVERY
+
+static const char* subsystem_names[SUBSYSTEM_COUNT] = {
+    "sensors", "actuators", "comms", "power", "memory", "control"
+};
+
+/*
+ * Subsystem an error is raised against
+ */
+subsystem_t subsystem_of_error(error_code_t error) {
+    switch (error) {
+        case ERR_SENSOR_FAILURE: return SUBSYSTEM_SENSORS;
+        case ERR_ACTUATOR_STUCK: return SUBSYSTEM_ACTUATORS;
+        case ERR_COMMUNICATION_LOST: return SUBSYSTEM_COMMS;
+        case ERR_POWER_FLUCTUATION: return SUBSYSTEM_POWER;
+        case ERR_MEMORY_CORRUPTION: return SUBSYSTEM_MEMORY;
+        default: return SUBSYSTEM_CONTROL;
     }
+}
 
-    monitor->health.last_health_check = current_time;
+/*
+ * Subsystem an injected fault acts on
+ */
+subsystem_t subsystem_of_fault(fault_type_t fault) {
+    switch (fault) {
+        case FAULT_SENSOR_NOISE: return SUBSYSTEM_SENSORS;
+        case FAULT_ACTUATOR_FAIL: return SUBSYSTEM_ACTUATORS;
+        case FAULT_COMM_BREAK: return SUBSYSTEM_COMMS;
+        case FAULT_POWER_SPIKE: return SUBSYSTEM_POWER;
+        case FAULT_MEMORY_LEAK: return SUBSYSTEM_MEMORY;
+        default: return SUBSYSTEM_CONTROL;
+    }
+}
+
+/*
+ * Put a subsystem into the first recovery stage
+ */
+static void recovery_start(debug_monitor_t* monitor, subsystem_t subsystem, double now) {
+    subsystem_recovery_t* recovery = &monitor->recovery[subsystem];
+
+    if (recovery->stage != RECOVERY_IDLE) {
+        return;
+    }
+    recovery->stage = RECOVERY_QUIESCE;
+    recovery->stage_start = now;
+
+    // Withdraw an injected fault acting on this subsystem
+    if (monitor->fault_injection_enabled && subsystem_of_fault(monitor->active_fault) == subsystem) {
+        monitor->fault_injection_enabled = 0;
+        monitor->active_fault = FAULT_NONE;
+    }
+    LOG_INFO(monitor, "Recovery: quiescing %s", subsystem_names[subsystem]);
 }
 
 /*
  * Attempt to recover from detected faults
- * Implements various recovery strategies
+ * Starts a staged recovery (quiesce, reset, verify, resume) of every subsystem
+ * with an open fault and returns at once; recovery_tick() advances it each
+ * control cycle, so the loop keeps its period while subsystems recover.
  */
 void attempt_fault_recovery(debug_monitor_t* monitor) {
+    double now = monitor_now(monitor);
+
+    if (monitor->health.current_state == STATE_RECOVERY) {
+        LOG_INFO(monitor, "Recovery already in progress");
+        return;
+    }
     if (monitor->health.current_state != STATE_FAULT) {
         LOG_INFO(monitor, "No faults to recover from");
         return;
     }
 
     LOG_INFO(monitor, "Attempting fault recovery");
-
-    // Reset fault injection
-    monitor->fault_injection_enabled = 0;
-    monitor->active_fault = FAULT_NONE;
-
-    // Reset system state
     monitor->health.current_state = STATE_RECOVERY;
     monitor->health.recovery_count++;
+    monitor->health.recovery_period_max_us = 0;
 
-    // Clear recent fault records
-    for (int i = 0; i < monitor->fault_count; i++) {
-        if (!monitor->fault_history[i].resolved) {
-            monitor->fault_history[i].resolved = 1;
-            LOG_INFO(monitor, "Fault resolved in recovery attempt");
+    // Every subsystem with an error, an open fault record or the injected fault
+    for (int s = 0; s < SUBSYSTEM_COUNT; s++) {
+        if (monitor->faulted_subsystems & (1u << s)) {
+            recovery_start(monitor, (subsystem_t)s, now);
         }
     }
-
-    // Simulate recovery time
-    usleep(2000000); // 2 seconds
-
-    // Recovery is now more reliable - always succeed unless critical system failure
-    // In real embedded systems, recovery would involve hardware resets, watchdog feeds, etc.
-    monitor->health.current_state = STATE_RUNNING;
-    LOG_INFO(monitor, "Fault recovery successful");
-
-    // Reset CPU/memory to normal levels after recovery
-    monitor->health.cpu_usage_percent = 15.0f + (rand() % 20); // 15-35%
-    monitor->health.memory_usage_percent = 25.0f + (rand() % 25); // 25-50%
+    for (int s = 0; s < SUBSYSTEM_COUNT; s++) {
+        if (monitor->faults.open_count[s] > 0) {
+            recovery_start(monitor, (subsystem_t)s, now);
+        }
+    }
+    if (monitor->fault_injection_enabled) {
+        recovery_start(monitor, subsystem_of_fault(monitor->active_fault), now);
+    }
 }
 
 /*
- * Save log entries to file for persistent storage
- * Demonstrates file I/O error handling
+ * Advance every subsystem's recovery by at most one stage per control cycle.
+ * Errors raised while recovering bring their subsystem into the recovery; a
+ * subsystem whose fault returns during verification starts over. The system
+ * returns to RUNNING once every subsystem is back in service.
  */
-void save_log_to_file(debug_monitor_t* monitor) {
-    if (monitor->log_file == NULL) {
-        LOG_ERROR(monitor, ERR_FILE_IO_ERROR, "Log file not available");
+void recovery_tick(debug_monitor_t* monitor) {
+    double now = monitor_now(monitor);
+    int recovering = 0;
+
+    if (monitor->health.current_state != STATE_RECOVERY) {
         return;
     }
-
-    fprintf(monitor->log_file, "\n=== Log Session End ===\n");
-    fflush(monitor->log_file);
-
-    // Check for file I/O errors
-    if (ferror(monitor->log_file)) {
-        LOG_ERROR(monitor, ERR_FILE_IO_ERROR, "Error writing to log file");
-        clearerr(monitor->log_file);
+    if (monitor->health.loop_period_us > monitor->health.recovery_period_max_us) {
+        monitor->health.recovery_period_max_us = monitor->health.loop_period_us;
     }
-}
 
-/*
- * Display comprehensive debug information
- * Shows system state, fault history, and performance metrics
- */
-void display_debug_info(debug_monitor_t* monitor) {
-    printf("\n=== Debug Information ===\n");
+    for (int s = 0; s < SUBSYSTEM_COUNT; s++) {
+        subsystem_recovery_t* recovery = &monitor->recovery[s];
+        uint32_t elapsed_us;
+
+        if (recovery->stage == RECOVERY_IDLE && (monitor->faulted_subsystems & (1u << s))) {
+            recovery_start(monitor, (subsystem_t)s, now);
+        }
+        elapsed_us = (uint32_t)((now - recovery->stage_start) * 1e6 + 0.5);  // Rounded: simulated ticks add up inexactly
+
+        switch (recovery->stage) {
+            case RECOVERY_QUIESCE:
+                if (elapsed_us >= RECOVERY_QUIESCE_MS * 1000) {
+                    recovery->stage = RECOVERY_RESET;
+                    recovery->stage_start = now;
+                    LOG_DEBUG(monitor, "Recovery: resetting %s", subsystem_names[s]);
+                }
+                break;
+            case RECOVERY_RESET:
+                if (elapsed_us >= RECOVERY_RESET_MS * 1000) {
+                    if (s == SUBSYSTEM_SENSORS) {
+                        monitor->sensor_failures = 0;
+                    }
+                    recovery->errors_at_reset = recovery->errors;
+                    recovery->stage = RECOVERY_VERIFY;
+                    recovery->stage_start = now;
+                    LOG_DEBUG(monitor, "Recovery: verifying %s", subsystem_names[s]);
+                }
+                break;
+            case RECOVERY_VERIFY:
+                if (recovery->errors != recovery->errors_at_reset) {
+                    LOG_WARNING(monitor, ERR_NONE, "Recovery: %s fault returned, restarting", subsystem_names[s]);
+                    recovery->stage = RECOVERY_QUIESCE;
+                    recovery->stage_start = now;
+                    break;
+                }
+                if (elapsed_us < RECOVERY_VERIFY_MS * 1000) {
+                    break;
+                }
+                recovery->stage = RECOVERY_RESUME;
+                // fall through
+            case RECOVERY_RESUME: {
+                uint32_t resolved = fault_store_resolve_subsystem(&monitor->faults, s, fault_time_ns(monitor));
+                if (resolved > 0) {
+                    LOG_INFO(monitor, "Recovery: %u faults resolved", resolved);
+                }
+                monitor->faulted_subsystems &= ~(1u << s);
+                recovery->stage = RECOVERY_IDLE;
+                LOG_INFO(monitor, "Recovery: %s back in service", subsystem_names[s]);
+                break;
+            }
+            default:
+                break;
+        }
+        if (recovery->stage != RECOVERY_IDLE) {
+            recovering = 1;
+        }
+    }
+
+    if (!recovering) {
+        // Recovery is now more reliable - always succeed unless critical system failure
+        // In real embedded systems, recovery would involve hardware resets, etc.
+        monitor->health.current_state = STATE_RUNNING;
+        LOG_INFO(monitor, "Fault recovery successful (worst loop period %u us)",
+                 monitor->health.recovery_period_max_us);
+    }
+}
+
+#undef LOG_MODULE
+#define LOG_MODULE LOG_MODULE_CORE
+
+/*
+ * Save log entries to file for persistent storage
+ * Demonstrates file I/O error handling
+ */
+void save_log_to_file(debug_monitor_t* monitor) {
+    log_writer_t* writer = &monitor->log_writer;
+
+    if (!writer->active) {
+        LOG_ERROR(monitor, ERR_FILE_IO_ERROR, "Log file not available");
+        return;
+    }
+
+    // Drains every queued entry, then appends the session end marker
+    log_session_meta_t marker = log_session_marker(LOG_META_SESSION_END);
+    log_writer_stop(writer, &marker, sizeof(marker));
+
+    // Check for file I/O errors
+    if (writer->write_errors > 0) {
+        LOG_ERROR(monitor, ERR_FILE_IO_ERROR, "Error writing to log file");
+    }
+    if (writer->dropped > 0) {
+        printf("Warning: %llu log entries dropped (log queue full)\n",
+               (unsigned long long)writer->dropped);
+    }
+}
+
+/*
+ * Display comprehensive debug information
+ * Shows system state, fault history, and performance metrics
+ */
+void display_debug_info(debug_monitor_t* monitor) {
+    printf("\n=== Debug Information ===\n");
     printf("System State: %s\n",
            monitor->health.current_state == STATE_INIT ? "INIT" :
            monitor->health.current_state == STATE_RUNNING ? "RUNNING" :
@@ -538,61 +1154,167 @@ void display_debug_info(debug_monitor_t* monitor) {
     printf("Fault Count: %u\n", monitor->health.fault_count);
     printf("Recovery Count: %u\n", monitor->health.recovery_count);
     printf("CPU Usage: %.1f%%\n", monitor->health.cpu_usage_percent);
-    printf("Memory Usage: %.1f%%\n", monitor->health.memory_usage_percent);
+    printf("Memory Usage: %.1f%% (%u kB resident)\n", monitor->health.memory_usage_percent,
+           monitor->health.rss_kb);
+    printf("Context Switches: %llu voluntary, %llu involuntary\n",
+           (unsigned long long)monitor->health.voluntary_switches,
+           (unsigned long long)monitor->health.involuntary_switches);
+    printf("Control Loop: period %u us (max %u us), busy %u us (max %u us)\n",
+           monitor->health.loop_period_us, monitor->health.loop_period_max_us,
+           monitor->health.loop_work_us, monitor->health.loop_work_max_us);
+    printf("Recovery: worst loop period %u us during the last recovery\n",
+           monitor->health.recovery_period_max_us);
+    for (int s = 0; s < SUBSYSTEM_COUNT; s++) {
+        static const char* stages[] = {"in service", "quiesce", "reset", "verify", "resume"};
+        if (monitor->recovery[s].stage != RECOVERY_IDLE) {
+            printf("  %-10s %s\n", subsystem_names[s], stages[monitor->recovery[s].stage]);
+        }
+    }
+    printf("Log File: %llu written, %llu dropped (fsync %s)\n",
+           (unsigned long long)__atomic_load_n(&monitor->log_writer.written, __ATOMIC_RELAXED),
+           (unsigned long long)__atomic_load_n(&monitor->log_writer.dropped, __ATOMIC_RELAXED),
+           log_writer_fsync_name(monitor->log_writer.fsync_policy));
+    printf("Watchdog: %s, worst detection delay %llu us\n",
+           monitor->watchdog.active ? "running" : "stopped",
+           (unsigned long long)(__atomic_load_n(&monitor->watchdog.worst_detection_ns, __ATOMIC_RELAXED) / 1000));
+    for (int i = 0; i < monitor->watchdog.task_count; i++) {
+        const watchdog_task_t* task = &monitor->watchdog.tasks[i];
+        printf("  %-14s deadline %llu ms, %u misses, worst %llu us late\n", task->name,
+               (unsigned long long)(task->deadline_ns / 1000000),
+               __atomic_load_n(&task->misses, __ATOMIC_RELAXED),
+               (unsigned long long)(__atomic_load_n(&task->worst_lateness_ns, __ATOMIC_RELAXED) / 1000));
+    }
 
     printf("\nRecent Log Entries:\n");
     int start = monitor->log_count > 5 ? monitor->log_count - 5 : 0;
     for (int i = start; i < monitor->log_count; i++) {
-        log_entry_t* entry = &monitor->log_buffer[i];
+        log_record_t* entry = log_entry_at(monitor, i);
+        const log_site_t* site = log_site_get(entry->site_id);
+        char message[256];
+        render_log_message(entry, message, sizeof(message));
         printf("  [%s] %s\n",
-               entry->level == LOG_DEBUG ? "DBG" :
-               entry->level == LOG_INFO ? "INF" :
-               entry->level == LOG_WARNING ? "WRN" :
-               entry->level == LOG_ERROR ? "ERR" : "CRT",
-               entry->message);
+               site->level == LOG_DEBUG ? "DBG" :
+               site->level == LOG_INFO ? "INF" :
+               site->level == LOG_WARNING ? "WRN" :
+               site->level == LOG_ERROR ? "ERR" : "CRT",
+               message);
     }
 
-    printf("\nFault History:\n");
-    for (int i = 0; i < monitor->fault_count; i++) {
-        fault_record_t* record = &monitor->fault_history[i];
-        printf("  %s: %s\n",
-               record->resolved ? "RESOLVED" : "ACTIVE",
-               record->description);
+    printf("\nFault History: %u faults, %u open\n", monitor->faults.count, monitor->faults.open_total);
+    print_fault_summary(&monitor->faults, 0, UINT64_MAX);
+    uint32_t first = monitor->faults.count > 10 ? monitor->faults.count - 10 : 0;
+    for (uint32_t id = first; id < monitor->faults.count; id++) {
+        const fault_event_t* event = fault_store_get(&monitor->faults, id);
+        char description[128];
+        describe_fault_event(event, &monitor->watchdog, description, sizeof(description));
+        printf("  %s: %s\n", event->resolved ? "RESOLVED" : "ACTIVE", description);
     }
     printf("\n");
 }
 
+/*
+ * Render a fault event as text; watchdog task names come from watchdog when
+ * it is given and has the task registered
+ */
+void describe_fault_event(const fault_event_t* event, const watchdog_t* watchdog, char* out, size_t size) {
+    if (event->error_code == ERR_WATCHDOG_TIMEOUT) {
+        int task = event->tag & ~WATCHDOG_TAG_RESUMED;
+        const char* resumed = (event->tag & WATCHDOG_TAG_RESUMED) ? "" : " (still missing)";
+
+        if (watchdog != NULL && task < watchdog->task_count) {
+            snprintf(out, size, "Watchdog: %s missed its %llu ms deadline by %u us%s",
+                     watchdog->tasks[task].name, (unsigned long long)(watchdog->tasks[task].deadline_ns / 1000000),
+                     event->detail, resumed);
+        } else {
+            snprintf(out, size, "Watchdog: task %d missed its deadline by %u us%s", task, event->detail, resumed);
+        }
+    } else {
+        snprintf(out, size, "Injected fault: %d (%s)", event->type,
+                 event->type <= FAULT_MEMORY_LEAK ? fault_type_names[event->type] : "unknown");
+    }
+}
+
+/*
+ * Print count, open count, MTBF and MTTR per fault type for the faults
+ * raised in [from_ns, to_ns)
+ */
+void print_fault_summary(const fault_store_t* faults, uint64_t from_ns, uint64_t to_ns) {
+    for (int type = FAULT_NONE; type <= FAULT_MEMORY_LEAK; type++) {
+        fault_stats_t stats;
+
+        fault_store_stats(faults, type, from_ns, to_ns, &stats);
+        if (stats.count > 0) {
+            printf("  %-14s %8u raised %8u open   MTBF %10.1f s   MTTR %8.2f s\n",
+                   type == FAULT_NONE ? "watchdog" : fault_type_names[type],
+                   stats.count, stats.open, stats.mtbf_s, stats.mttr_s);
+        }
+    }
+}
+
+/*
+ * Summarize a fault event file: every session replayed into one store, then
+ * count, MTBF and MTTR per fault type over the whole history and its last hour
+ *
+ * @return: Process exit code
+ */
+int run_fault_report(const char* path) {
+    fault_store_t faults;
+    uint64_t last_hour_ns = 3600ull * 1000000000ull;
+
+    memset(&faults, 0, sizeof(faults));
+    double start = monotonic_seconds();
+    if (fault_store_load(&faults, path) != 0) {
+        printf("Error: Cannot read fault event file %s\n", path);
+        return 1;
+    }
+    printf("Fault report: %s, %u faults, %u open (loaded in %.3f s)\n",
+           path, faults.count, faults.open_total, monotonic_seconds() - start);
+
+    if (faults.count > 0) {
+        uint64_t first_ns = fault_store_get(&faults, 0)->time_ns;
+        uint64_t last_ns = faults.last_time_ns;
+
+        printf("\nWhole history (%.2f hours):\n", (double)(last_ns - first_ns) / 3.6e12);
+        print_fault_summary(&faults, 0, UINT64_MAX);
+        printf("\nLast hour:\n");
+        print_fault_summary(&faults, last_ns > last_hour_ns ? last_ns - last_hour_ns : 0, UINT64_MAX);
+    }
+    fault_store_close(&faults);
+    return 0;
+}
+
 /*
  * Assert system state with detailed logging
  * Enhanced assertion that provides debugging context
  */
 void assert_system_state(debug_monitor_t* monitor, system_state_t expected_state) {
     if (monitor->health.current_state != expected_state) {
-        char msg[128];
-        snprintf(msg, sizeof(msg), "Expected state %d, got %d",
-                expected_state, monitor->health.current_state);
-        LOG_CRITICAL(monitor, ERR_INVALID_STATE, msg);
+        LOG_CRITICAL(monitor, ERR_INVALID_STATE, "Expected state %d, got %d",
+                     expected_state, monitor->health.current_state);
         assert(monitor->health.current_state == expected_state);
     }
 }
 
+#undef LOG_MODULE
+#define LOG_MODULE LOG_MODULE_IO
+
 // Simulated component functions with fault detection
 
 int simulate_sensor_reading(debug_monitor_t* monitor) {
-    static int consecutive_failures = 0;
-    int reading = rand() % 100;
+    int reading = (int)(random_next(&monitor->rng_state) % 100);
 
     // Simulate occasional sensor failures
-    if (rand() % 100 < 5) { // 5% failure rate
-        consecutive_failures++;
-        if (consecutive_failures > 3) {
+    if (random_next(&monitor->rng_state) % 100 < 5) { // 5% failure rate
+        monitor->sensor_failures++;
+        if (monitor->sensor_failures > 3) {
             LOG_ERROR(monitor, ERR_SENSOR_FAILURE, "Sensor failure detected");
             return -1;
         }
     } else {
-        consecutive_failures = 0;
+        monitor->sensor_failures = 0;
     }
 
+    LOG_DEBUG(monitor, "Sensor reading %d (%d consecutive failures)", reading, monitor->sensor_failures);
     return reading;
 }
 
@@ -604,67 +1326,1227 @@ int simulate_actuator_control(debug_monitor_t* monitor, int command) {
     }
 
     // Normal operation - no random failures, only fail during explicit fault injection
+    LOG_DEBUG(monitor, "Actuator command %d%%", command);
     return command;
 }
 
 int simulate_communication(debug_monitor_t* monitor) {
     // Normal operation - no random failures, only fail during explicit fault injection
+    LOG_DEBUG(monitor, "Communication cycle complete");
     return 0;
 }
 
 float simulate_power_monitoring(debug_monitor_t* monitor) {
-    float voltage = 24.0f + ((rand() % 200 - 100) / 100.0f); // 23.0-25.0V
+    float voltage = 24.0f + (((int)(random_next(&monitor->rng_state) % 200) - 100) / 100.0f); // 23.0-25.0V
 
     if (voltage < 22.0f || voltage > 26.0f) {
         LOG_WARNING(monitor, ERR_POWER_FLUCTUATION, "Power fluctuation detected");
     }
 
+    LOG_DEBUG(monitor, "Supply voltage %.2f V", voltage);
     return voltage;
 }
 
+#undef LOG_MODULE
+#define LOG_MODULE LOG_MODULE_FAULT
+
 // Fault simulation implementations
 
+/*
+ * @return: 1 if this fault simulation pass logs: every 5th pass to keep the
+ *          console readable, every pass in a headless campaign
+ */
+static int fault_sim_logs(debug_monitor_t* monitor, fault_type_t fault) {
+    return ++monitor->fault_sim_calls[fault] % 5 == 0 || monitor->headless;
+}
+
 void simulate_sensor_noise(debug_monitor_t* monitor) {
-    static int noise_count = 0;
-    noise_count++;
-    if (noise_count % 5 == 0) {  // Only log every 5th call to reduce spam
+    if (fault_sim_logs(monitor, FAULT_SENSOR_NOISE)) {
         LOG_WARNING(monitor, ERR_SENSOR_FAILURE, "Sensor noise simulation active");
     }
     // Additional noise simulation logic would go here
 }
 
 void simulate_actuator_failure(debug_monitor_t* monitor) {
-    static int actuator_count = 0;
-    actuator_count++;
-    if (actuator_count % 5 == 0) {  // Only log every 5th call to reduce spam
+    if (fault_sim_logs(monitor, FAULT_ACTUATOR_FAIL)) {
         LOG_ERROR(monitor, ERR_ACTUATOR_STUCK, "Actuator failure simulation active");
     }
     // Additional failure simulation logic would go here
 }
 
 void simulate_communication_break(debug_monitor_t* monitor) {
-    static int comm_count = 0;
-    comm_count++;
-    if (comm_count % 5 == 0) {  // Only log every 5th call to reduce spam
+    if (fault_sim_logs(monitor, FAULT_COMM_BREAK)) {
         LOG_ERROR(monitor, ERR_COMMUNICATION_LOST, "Communication break simulation active");
     }
     // Additional communication failure logic would go here
 }
 
 void simulate_power_fluctuation(debug_monitor_t* monitor) {
-    static int power_count = 0;
-    power_count++;
-    if (power_count % 5 == 0) {  // Only log every 5th call to reduce spam
+    if (fault_sim_logs(monitor, FAULT_POWER_SPIKE)) {
         LOG_WARNING(monitor, ERR_POWER_FLUCTUATION, "Power fluctuation simulation active");
     }
     // Additional power simulation logic would go here
 }
 
 void simulate_memory_corruption(debug_monitor_t* monitor) {
-    static int memory_count = 0;
-    memory_count++;
-    if (memory_count % 5 == 0) {  // Only log every 5th call to reduce spam
+    if (fault_sim_logs(monitor, FAULT_MEMORY_LEAK)) {
         LOG_CRITICAL(monitor, ERR_MEMORY_CORRUPTION, "Memory corruption simulation active");
     }
     // Additional memory corruption simulation would go here
 }
+
+#undef LOG_MODULE
+#define LOG_MODULE LOG_MODULE_CORE
+
+/*
+ * Read a monotonic clock in seconds for benchmarking.
+ */
+double monotonic_seconds(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+// Original text log entry and shift-down buffer, kept only so the benchmark
+// can compare them against the binary record ring
+typedef struct {
+    time_t timestamp;
+    log_level_t level;
+    error_code_t error_code;
+    char message[256];
+    char function[64];
+    int line_number;
+} text_log_entry_t;
+
+typedef struct {
+    text_log_entry_t entries[MAX_LOG_ENTRIES];
+    int count;
+} text_log_buffer_t;
+
+static void log_insert_shift(text_log_buffer_t* buffer, log_level_t level,
+                             const char* message, const char* function, int line) {
+    if (buffer->count >= MAX_LOG_ENTRIES) {
+        memmove(&buffer->entries[0], &buffer->entries[1],
+                sizeof(text_log_entry_t) * (MAX_LOG_ENTRIES - 1));
+        buffer->count = MAX_LOG_ENTRIES - 1;
+    }
+
+    text_log_entry_t* entry = &buffer->entries[buffer->count++];
+    entry->timestamp = time(NULL);
+    entry->level = level;
+    entry->error_code = ERR_NONE;
+    strncpy(entry->message, message, sizeof(entry->message) - 1);
+    strncpy(entry->function, function, sizeof(entry->function) - 1);
+    entry->line_number = line;
+}
+
+/*
+ * Benchmark logging at steady state: the buffer is filled first, so every
+ * measured call has to evict the oldest entry. Compares the original
+ * shift-down insert of text entries with the ring of binary records used
+ * by log_message(), with and without format arguments.
+ */
+void benchmark_log_buffer(void) {
+    static text_log_buffer_t text_log;
+    static debug_monitor_t monitor;
+    double rates[3];
+    double start, elapsed;
+    long calls;
+
+    printf("Log buffer benchmark (%d entries, buffer full)\n", MAX_LOG_ENTRIES);
+    printf("Entry size: %zu bytes (text) -> %zu bytes (binary record)\n",
+           sizeof(text_log_entry_t), sizeof(log_record_t));
+
+    // Before: shift the buffer of text entries down on every call
+    memset(&text_log, 0, sizeof(text_log));
+    for (int i = 0; i < MAX_LOG_ENTRIES; i++) {
+        log_insert_shift(&text_log, LOG_INFO, "Benchmark log entry", __func__, __LINE__);
+    }
+    calls = 0;
+    start = monotonic_seconds();
+    do {
+        for (int k = 0; k < 100; k++) {
+            log_insert_shift(&text_log, LOG_INFO, "Benchmark log entry", __func__, __LINE__);
+        }
+        calls += 100;
+        elapsed = monotonic_seconds() - start;
+    } while (elapsed < 0.5);
+    rates[0] = calls / elapsed;
+
+    // After: overwrite the oldest record of the ring
+    for (int variant = 1; variant <= 2; variant++) {
+        memset(&monitor, 0, sizeof(monitor));
+        monitor.health.current_state = STATE_RUNNING;
+        calls = 0;
+        start = monotonic_seconds();
+        do {
+            for (int k = 0; k < 10000; k++) {
+                if (variant == 1) {
+                    LOG_INFO(&monitor, "Benchmark log entry");
+                } else {
+                    LOG_INFO(&monitor, "Benchmark log entry %d of %ld", k, calls);
+                }
+            }
+            calls += 10000;
+            elapsed = monotonic_seconds() - start;
+        } while (elapsed < 0.5);
+        rates[variant] = calls / elapsed;
+    }
+
+    printf("%-28s %-14s %s\n", "Insert", "Logs/s", "ns/log");
+    printf("%-28s %-14.3e %.1f\n", "shift, text entry (old)", rates[0], 1e9 / rates[0]);
+    printf("%-28s %-14.3e %.1f\n", "ring, binary record", rates[1], 1e9 / rates[1]);
+    printf("%-28s %-14.3e %.1f\n", "ring, binary + 2 int args", rates[2], 1e9 / rates[2]);
+    printf("Speedup: %.0fx\n", rates[1] / rates[0]);
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+#define BENCH_PACED_LOGS_PER_S 100000   // Rate of the writer benchmark's paced rows
+
+/*
+ * Benchmark log_message() latency while its output goes to a file. Each
+ * call is timed individually and compared with a synchronous baseline that
+ * write()s every record itself. Every mode runs twice: saturated, with the
+ * producer logging as fast as it can, and paced at BENCH_PACED_LOGS_PER_S. A dropped record skips its write, so a row with
+ * drops did less work than the baseline and is marked as not comparable.
+ */
+void benchmark_log_writer(void) {
+#ifdef _WIN32
+    printf("Writer benchmark requires POSIX threads\n");
+#else
+    static debug_monitor_t monitor;
+    const char* path = "log_writer_bench.bin";
+    const long calls = 200000;
+    double* latency_ns = malloc(sizeof(double) * calls);
+
+    if (latency_ns == NULL) {
+        printf("Error: Cannot allocate latency buffer\n");
+        return;
+    }
+
+    int incomparable = 0;
+
+    printf("Log writer benchmark (%ld log_message() calls per mode)\n", calls);
+    printf("%-27s %-10s %-10s %-10s %-12s %-10s %s\n",
+           "Mode", "p50 (ns)", "p99 (ns)", "Max (us)", "Logs/s", "Written", "Dropped");
+
+    // Rows: synchronous write() baseline, then the async writer with each
+    // fsync policy; saturated and then paced
+    for (int row = 0; row < 2 * (LOG_FSYNC_PERIODIC + 2); row++) {
+        int mode = row % (LOG_FSYNC_PERIODIC + 2) - 1;
+        double interval = row >= LOG_FSYNC_PERIODIC + 2 ? 1.0 / BENCH_PACED_LOGS_PER_S : 0.0;
+        int sync_fd = -1;
+        double start, elapsed;
+
+        remove(path);
+        memset(&monitor, 0, sizeof(monitor));
+        monitor.health.current_state = STATE_RUNNING;
+        if (mode < 0) {
+            sync_fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+        } else if (log_writer_start(&monitor.log_writer, path, (log_fsync_t)mode, NULL, 0) != 0) {
+            printf("Error: Cannot open %s: %s\n", path, strerror(errno));
+            break;
+        }
+
+        start = monotonic_seconds();
+        for (long k = 0; k < calls; k++) {
+            double t0 = monotonic_seconds();
+            while (t0 < start + k * interval) {
+                t0 = monotonic_seconds();
+            }
+            LOG_INFO(&monitor, "Benchmark log entry");
+            if (sync_fd >= 0) {
+                const log_record_t* record = log_entry_at(&monitor, monitor.log_count - 1);
+                if (write(sync_fd, record, sizeof(*record)) != (long)sizeof(*record)) break;
+            }
+            latency_ns[k] = (monotonic_seconds() - t0) * 1e9;
+        }
+        elapsed = monotonic_seconds() - start;
+
+        unsigned long long written = calls, dropped = 0;
+        if (sync_fd >= 0) {
+            close(sync_fd);
+        } else {
+            log_writer_stop(&monitor.log_writer, NULL, 0);
+            written = monitor.log_writer.written - monitor.log_sites_sent;   // Records, not site definitions
+            dropped = monitor.log_writer.dropped;
+        }
+
+        char label[32];
+        snprintf(label, sizeof(label), "%s%s%s",
+                 mode < 0 ? "sync write()" : mode == LOG_FSYNC_NONE ? "async, fsync none" :
+                 mode == LOG_FSYNC_BATCH ? "async, fsync batch" : "async, periodic",
+                 interval > 0.0 ? ", paced" : "", dropped > 0 ? " *" : "");
+        incomparable |= dropped > 0;
+
+        qsort(latency_ns, (size_t)calls, sizeof(double), compare_doubles);
+        printf("%-27s %-10.0f %-10.0f %-10.1f %-12.3e %-10llu %llu\n",
+               label, latency_ns[calls / 2], latency_ns[calls * 99 / 100],
+               latency_ns[calls - 1] / 1e3, calls / elapsed, written, dropped);
+    }
+    printf("Paced rows log %d records/s.\n", BENCH_PACED_LOGS_PER_S);
+    if (incomparable) {
+        printf("* Dropped records skipped their write: latency not comparable with the sync baseline\n");
+    }
+
+    remove(path);
+    free(latency_ns);
+#endif
+}
+
+/*
+ * Benchmark the control loop's per-iteration cost under each debug log
+ * setting available in this build, on a headless monitor so warnings stay
+ * off the console. Records stay in the in-memory ring (no file), and the
+ * records logged per iteration are counted from the log sequence.
+ * Compare against a build with LOG_COMPILE_MIN_LEVEL=1 (make bench-levels)
+ * for the compiled-out row.
+ */
+void benchmark_log_levels(void) {
+    static debug_monitor_t monitor;
+    uint8_t saved_levels[LOG_MODULE_COUNT];
+    const long iterations = 1000000;
+
+    memcpy(saved_levels, log_module_levels, sizeof(saved_levels));
+    printf("Log level benchmark (%ld control loop iterations)\n", iterations);
+    printf("%-26s %-14s %s\n", "Debug logging", "ns/iteration", "Records/iteration");
+
+    for (int enabled = 0; enabled <= 1; enabled++) {
+        const char* label = LOG_COMPILE_MIN_LEVEL > LOG_DEBUG ? "compiled out" :
+                            enabled ? "enabled" : "runtime disabled";
+
+        // A compiled-out build has only one configuration
+        if (LOG_COMPILE_MIN_LEVEL > LOG_DEBUG && enabled) break;
+
+        debug_init_headless(&monitor, 0);
+        log_set_level(enabled ? "debug" : "info");
+
+        double start = monotonic_seconds();
+        for (long k = 0; k < iterations; k++) {
+            run_control_cycle(&monitor);
+            monitor.health.current_state = STATE_RUNNING;  // Keep sensor errors from latching
+        }
+        double elapsed = monotonic_seconds() - start;
+        printf("%-26s %-14.1f %.2f\n", label, elapsed * 1e9 / iterations,
+               (double)monitor.log_sequence / iterations);
+    }
+
+    memcpy(log_module_levels, saved_levels, sizeof(saved_levels));
+}
+
+/*
+ * Benchmark one health sample: cached descriptor + pread() (proc_metrics)
+ * against reopening and parsing /proc/self/statm through stdio each time.
+ */
+void benchmark_health_sampling(void) {
+#ifdef _WIN32
+    printf("Health sampling benchmark requires /proc\n");
+#else
+    proc_metrics_t metrics;
+    proc_sample_t sample;
+    const int samples = 100000;
+    double cached_us, reopen_us;
+    unsigned long resident_pages = 0;
+
+    if (proc_metrics_open(&metrics) != 0) {
+        printf("Error: Process metrics unavailable\n");
+        return;
+    }
+
+    double start = monotonic_seconds();
+    for (int k = 0; k < samples; k++) {
+        proc_metrics_sample(&metrics, &sample);
+    }
+    cached_us = (monotonic_seconds() - start) * 1e6 / samples;
+    proc_metrics_close(&metrics);
+
+    // Baseline: the usual fopen/fscanf/fclose per sample
+    start = monotonic_seconds();
+    for (int k = 0; k < samples; k++) {
+        struct rusage usage;
+        unsigned long size_pages;
+        FILE* statm = fopen("/proc/self/statm", "r");
+
+        getrusage(RUSAGE_SELF, &usage);
+        if (statm != NULL) {
+            if (fscanf(statm, "%lu %lu", &size_pages, &resident_pages) != 2) {
+                resident_pages = 0;
+            }
+            fclose(statm);
+        }
+    }
+    reopen_us = (monotonic_seconds() - start) * 1e6 / samples;
+
+    printf("Health sampling benchmark (%d samples)\n", samples);
+    printf("%-28s %s\n", "Method", "us/sample");
+    printf("%-28s %.2f\n", "cached fd + pread()", cached_us);
+    printf("%-28s %.2f\n", "fopen/fscanf per sample", reopen_us);
+    printf("Last sample: CPU %.1f%%, RSS %u kB (stdio: %lu pages), %llu/%llu context switches\n",
+           sample.cpu_percent, sample.rss_kb, resident_pages,
+           (unsigned long long)sample.voluntary_switches,
+           (unsigned long long)sample.involuntary_switches);
+#endif
+}
+
+/*
+ * Benchmark the watchdog: cost of a feed, and how quickly and accurately
+ * misses are flagged. A 2 ms heartbeat is fed on time WATCHDOG_BENCH_ROUNDS
+ * times, then stalled past its deadline by 0.1-2 ms as many times.
+ */
+#define WATCHDOG_BENCH_ROUNDS 200
+
+void benchmark_watchdog(void) {
+    static watchdog_t watchdog;
+    static double detection_us[WATCHDOG_BENCH_ROUNDS];
+    const uint32_t deadline_us = 2000;
+    const long feeds = 10000000;
+    int detected = 0, late_reports = 0;
+    double lateness_error_us = 0.0;
+    watchdog_miss_t miss;
+
+    if (watchdog_start(&watchdog) != 0) {
+        printf("Error: Could not start watchdog thread\n");
+        return;
+    }
+    int task = watchdog_register(&watchdog, "bench", deadline_us);
+
+    // Feed cost: one clock read and one atomic exchange
+    double start = monotonic_seconds();
+    for (long k = 0; k < feeds; k++) {
+        watchdog_feed(&watchdog, task);
+    }
+    double feed_ns = (monotonic_seconds() - start) * 1e9 / feeds;
+    while (watchdog_poll(&watchdog, &miss)) {
+        // Discard gaps from the process being descheduled mid-loop
+    }
+
+    // On-time feeds: every miss reported here must match a sleep that
+    // really ran past the deadline
+    int overruns = 0;
+    uint64_t previous = __atomic_load_n(&watchdog.tasks[task].last_feed_ns, __ATOMIC_RELAXED);
+    for (int k = 0; k <= WATCHDOG_BENCH_ROUNDS; k++) {
+        watchdog_feed(&watchdog, task);
+        uint64_t fed = __atomic_load_n(&watchdog.tasks[task].last_feed_ns, __ATOMIC_RELAXED);
+        if (fed - previous > deadline_us * 1000ull) overruns++;
+        previous = fed;
+        if (k < WATCHDOG_BENCH_ROUNDS) usleep(deadline_us / 4);
+    }
+    int on_time_reports = 0;
+    while (watchdog_poll(&watchdog, &miss)) {
+        on_time_reports++;
+    }
+
+    // Stalls: feed, sleep past the deadline, feed again, collect the report
+    srand(1);
+    for (int k = 0; k < WATCHDOG_BENCH_ROUNDS; k++) {
+        uint32_t overrun_us = 100 + (uint32_t)(rand() % 1900);
+
+        watchdog_feed(&watchdog, task);
+        uint64_t fed = __atomic_load_n(&watchdog.tasks[task].last_feed_ns, __ATOMIC_RELAXED);
+        usleep(deadline_us + overrun_us);
+        watchdog_feed(&watchdog, task);
+        uint64_t resumed = __atomic_load_n(&watchdog.tasks[task].last_feed_ns, __ATOMIC_RELAXED);
+
+        // The report is published on the monitor's next wake-up; keep feeding
+        // meanwhile and skip reports of any other overrun
+        int reported = 0;
+        for (int wait = 0; wait < 100 && !reported; wait++) {
+            while (!reported && watchdog_poll(&watchdog, &miss)) {
+                reported = miss.due_ns == fed + deadline_us * 1000ull;
+            }
+            if (!reported) {
+                usleep(deadline_us / 4);
+                watchdog_feed(&watchdog, task);
+            }
+        }
+        if (reported) {
+            double expected_us = (double)(resumed - fed) / 1e3 - deadline_us;
+            double error_us = (double)miss.lateness_ns / 1e3 - expected_us;
+
+            detection_us[detected++] = (double)miss.detection_ns / 1e3;
+            if (error_us < 0) error_us = -error_us;
+            if (error_us > lateness_error_us) lateness_error_us = error_us;
+            late_reports++;
+        }
+    }
+    watchdog_stop(&watchdog);
+
+    qsort(detection_us, (size_t)detected, sizeof(double), compare_doubles);
+    printf("Watchdog benchmark (%u us deadline, %d on-time periods, %d stalls of 100-2000 us)\n",
+           deadline_us, WATCHDOG_BENCH_ROUNDS, WATCHDOG_BENCH_ROUNDS);
+    printf("watchdog_feed(): %.1f ns\n", feed_ns);
+    printf("On-time phase: %d misses reported, %d sleeps overran the deadline\n", on_time_reports, overruns);
+    printf("Stalls reported: %d/%d\n", late_reports, WATCHDOG_BENCH_ROUNDS);
+    if (detected > 0) {
+        printf("Detection delay after deadline: p50 %.1f us, p99 %.1f us, max %.1f us\n",
+               detection_us[detected / 2], detection_us[detected * 99 / 100], detection_us[detected - 1]);
+        printf("Reported lateness vs measured stall: max error %.3f us\n", lateness_error_us);
+    }
+}
+
+/*
+ * Call targets for benchmark_profiler(), reached through a pointer so the
+ * scope is not hoisted out of the loop
+ */
+static void profiler_bench_plain(volatile uint32_t* counter) {
+    (*counter)++;
+}
+
+static void profiler_bench_scoped(volatile uint32_t* counter) {
+    PROFILE_SCOPE("profiler_bench_scoped");
+    (*counter)++;
+}
+
+/*
+ * Benchmark the cost of one PROFILE_SCOPE: a call without a scope, with a
+ * disabled scope and with profiling enabled (histogram plus trace event
+ * until the thread's trace buffer is full).
+ */
+void benchmark_profiler(void) {
+    void (*volatile call)(volatile uint32_t*);
+    volatile uint32_t counter = 0;
+    int was_enabled = profiler_enabled;
+    const long iterations = 10000000;
+    double plain_ns, disabled_ns, enabled_ns;
+
+    profiler_enable(0);
+    call = profiler_bench_plain;
+    double start = monotonic_seconds();
+    for (long k = 0; k < iterations; k++) {
+        call(&counter);
+    }
+    plain_ns = (monotonic_seconds() - start) * 1e9 / iterations;
+
+    call = profiler_bench_scoped;
+    start = monotonic_seconds();
+    for (long k = 0; k < iterations; k++) {
+        call(&counter);
+    }
+    disabled_ns = (monotonic_seconds() - start) * 1e9 / iterations;
+
+    profiler_enable(1);
+    start = monotonic_seconds();
+    for (long k = 0; k < iterations; k++) {
+        call(&counter);
+    }
+    enabled_ns = (monotonic_seconds() - start) * 1e9 / iterations;
+    profiler_enable(was_enabled);
+
+    printf("Profiler benchmark (%ld calls)\n", iterations);
+    printf("%-28s %s\n", "Scope", "ns/call");
+    printf("%-28s %.2f\n", "none", plain_ns);
+#ifdef PROFILE_COMPILED_OUT
+    printf("%-28s %.2f (%+.2f)\n", "compiled out", disabled_ns, disabled_ns - plain_ns);
+    printf("%-28s %.2f (%+.2f)\n", "compiled out, enabled", enabled_ns, enabled_ns - plain_ns);
+#else
+    printf("%-28s %.2f (%+.2f)\n", "disabled", disabled_ns, disabled_ns - plain_ns);
+    printf("%-28s %.2f (%+.2f)\n", "enabled", enabled_ns, enabled_ns - plain_ns);
+#endif
+}
+
+/*
+ * Original blocking recovery, kept only so the benchmark can compare it
+ * against the staged recovery: resolves everything, then holds the control
+ * loop for the full 2 seconds
+ */
+static void attempt_fault_recovery_blocking(debug_monitor_t* monitor) {
+    monitor->fault_injection_enabled = 0;
+    monitor->active_fault = FAULT_NONE;
+    monitor->health.current_state = STATE_RECOVERY;
+    monitor->health.recovery_count++;
+    for (int s = 0; s < SUBSYSTEM_COUNT; s++) {
+        fault_store_resolve_subsystem(&monitor->faults, s, fault_time_ns(monitor));
+    }
+    monitor_hold(monitor, 2000000);
+    monitor->faulted_subsystems = 0;
+    monitor->health.current_state = STATE_RUNNING;
+}
+
+/*
+ * Benchmark the control loop's worst-case period while it recovers from an
+ * actuator fault, with the blocking recovery and with the staged one. The
+ * loop runs in real time at CONTROL_CYCLE_US.
+ */
+void benchmark_recovery(void) {
+    static debug_monitor_t monitor;
+    double duration_s[2];
+    uint32_t worst_period_us[2];
+    int cycles_run[2];
+
+    for (int staged = 0; staged <= 1; staged++) {
+        memset(&monitor, 0, sizeof(monitor));
+        monitor.health.current_state = STATE_RUNNING;
+        monitor.rng_state = 1;
+        inject_fault(&monitor, FAULT_ACTUATOR_FAIL);
+        LOG_ERROR(&monitor, ERR_ACTUATOR_STUCK, "Benchmark: actuator fault");
+
+        double start = monotonic_seconds();
+        uint32_t worst_us = 0;
+        int cycles = 0;
+        int started = 0;
+
+        while (!started || monitor.health.current_state != STATE_RUNNING) {
+            run_control_cycle(&monitor);
+            if (cycles > 0 && monitor.health.loop_period_us > worst_us) {
+                worst_us = monitor.health.loop_period_us;
+            }
+            if (!started) {
+                started = 1;
+                if (staged) {
+                    attempt_fault_recovery(&monitor);
+                } else {
+                    attempt_fault_recovery_blocking(&monitor);
+                }
+            }
+            cycles++;
+            usleep(CONTROL_CYCLE_US);
+        }
+        run_control_cycle(&monitor);   // Period of the cycle after recovery
+        if (monitor.health.loop_period_us > worst_us) {
+            worst_us = monitor.health.loop_period_us;
+        }
+
+        duration_s[staged] = monotonic_seconds() - start;
+        worst_period_us[staged] = worst_us;
+        cycles_run[staged] = cycles;
+        fault_store_close(&monitor.faults);
+    }
+
+    printf("\nRecovery benchmark (actuator fault, %d ms control cycle)\n", CONTROL_CYCLE_US / 1000);
+    printf("%-12s %14s %22s %12s\n", "Recovery", "Duration (s)", "Worst loop period (us)", "Cycles run");
+    for (int staged = 0; staged <= 1; staged++) {
+        printf("%-12s %14.2f %22u %12d\n", staged ? "staged" : "blocking",
+               duration_s[staged], worst_period_us[staged], cycles_run[staged]);
+    }
+}
+
+#ifndef _WIN32
+/*
+ * Original per-poll kbhit(), kept only so the benchmark can compare it
+ * against term_input: switches the terminal to raw, non-blocking mode,
+ * tries a read and switches back on every call
+ */
+static int kbhit_termios(void) {
+    struct termios oldt, newt;
+    int ch;
+    int oldf;
+
+    tcgetattr(STDIN_FILENO, &oldt);
+    newt = oldt;
+    newt.c_lflag &= ~(ICANON | ECHO);
+    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
+    oldf = fcntl(STDIN_FILENO, F_GETFL, 0);
+    fcntl(STDIN_FILENO, F_SETFL, oldf | O_NONBLOCK);
+
+    ch = getchar();
+
+    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
+    fcntl(STDIN_FILENO, F_SETFL, oldf);
+
+    if (ch != EOF) {
+        ungetc(ch, stdin);
+        return 1;
+    }
+    clearerr(stdin);
+    return 0;
+}
+#endif
+
+/*
+ * Benchmark keyboard polling with the old per-poll kbhit() and term_input,
+ * with stdin on a pseudo-terminal and no key pressed: the cost of one check,
+ * and the period a 1 ms loop achieves when it checks for a key and sleeps
+ * (old) or waits on the ticker (new).
+ */
+void benchmark_input(void) {
+#ifdef _WIN32
+    printf("Input benchmark needs a pseudo-terminal (not available on Windows)\n");
+#else
+    const long polls = 20000;
+    const int cycles = 2000;
+    const uint32_t period_us = 1000;
+    int master, slave;
+    int saved_stdin;
+    double poll_ns[2], mean_period_us[2], max_period_us[2];
+
+    if (openpty(&master, &slave, NULL, NULL, NULL) != 0) {
+        printf("Error: Cannot open a pseudo-terminal for the input benchmark\n");
+        return;
+    }
+    saved_stdin = dup(STDIN_FILENO);
+    dup2(slave, STDIN_FILENO);
+
+    // Cost of one "is a key waiting?" check
+    double start = monotonic_seconds();
+    for (long k = 0; k < polls; k++) {
+        kbhit_termios();
+    }
+    poll_ns[0] = (monotonic_seconds() - start) * 1e9 / polls;
+
+    term_input_open();
+    start = monotonic_seconds();
+    for (long k = 0; k < polls; k++) {
+        term_input_kbhit();
+    }
+    poll_ns[1] = (monotonic_seconds() - start) * 1e9 / polls;
+    term_input_close();
+
+    // Achieved loop period
+    for (int mode = 0; mode <= 1; mode++) {
+        term_ticker_t ticker;
+        double previous, max_us = 0;
+
+        if (mode == 1) {
+            term_input_open();
+            term_ticker_start(&ticker, period_us);
+        }
+        start = previous = monotonic_seconds();
+        for (int k = 0; k < cycles; k++) {
+            if (mode == 0) {
+                kbhit_termios();
+                usleep(period_us);
+            } else {
+                while (term_input_wait(&ticker) != TERM_INPUT_TICK) {
+                }
+            }
+            double now = monotonic_seconds();
+            if ((now - previous) * 1e6 > max_us) {
+                max_us = (now - previous) * 1e6;
+            }
+            previous = now;
+        }
+        mean_period_us[mode] = (monotonic_seconds() - start) * 1e6 / cycles;
+        max_period_us[mode] = max_us;
+        if (mode == 1) {
+            term_input_close();
+        }
+    }
+
+    dup2(saved_stdin, STDIN_FILENO);
+    close(saved_stdin);
+    close(slave);
+    close(master);
+
+    // System calls per check, counted from each code path
+    printf("Input benchmark (stdin on a pseudo-terminal, no key pressed)\n");
+    printf("%-18s %14s %10s %20s %19s\n", "Input", "Syscalls/poll", "ns/poll",
+           "1 ms loop mean (us)", "1 ms loop max (us)");
+    printf("%-18s %14d %10.0f %20.1f %19.1f\n", "kbhit() per poll", 7,
+           poll_ns[0], mean_period_us[0], max_period_us[0]);
+    printf("%-18s %14d %10.0f %20.1f %19.1f\n", "term_input", 1,
+           poll_ns[1], mean_period_us[1], max_period_us[1]);
+#endif
+}
+
+/*
+ * Reference for benchmark_fault_store(): the statistics of a window by
+ * scanning every event, as a flat fault history has to
+ */
+static void fault_stats_scan(const fault_store_t* faults, int type, uint64_t from_ns, uint64_t to_ns,
+                             fault_stats_t* stats) {
+    uint64_t first_ns = 0, last_ns = 0, repair_ns = 0;
+    uint32_t resolved = 0;
+
+    memset(stats, 0, sizeof(*stats));
+    for (uint32_t id = 0; id < faults->count; id++) {
+        const fault_event_t* event = fault_store_get(faults, id);
+        if (event->type != type || event->time_ns < from_ns || event->time_ns >= to_ns) {
+            continue;
+        }
+        if (stats->count++ == 0) first_ns = event->time_ns;
+        last_ns = event->time_ns;
+        if (event->resolved) {
+            resolved++;
+            repair_ns += event->resolved_ns - event->time_ns;
+        }
+    }
+    stats->open = stats->count - resolved;
+    if (stats->count > 1) stats->mtbf_s = (double)(last_ns - first_ns) / 1e9 / (stats->count - 1);
+    if (resolved > 0) stats->mttr_s = (double)repair_ns / 1e9 / resolved;
+}
+
+/*
+ * Benchmark the fault store with two million faults over about a year:
+ * append and resolve cost, window queries against a full scan, finding a
+ * subsystem's open faults, and writing and replaying the event file
+ */
+void benchmark_fault_store(void) {
+    const uint32_t events = 2000000;
+    const int queries = 20000;
+    const int scans = 10;
+    const char* path = "fault_store_bench.bin";
+    static fault_store_t faults, loaded;
+    uint32_t rng = 12345;
+    uint64_t time_ns = 1000000000ull;
+    double append_ns, resolve_ns, query_ns, scan_ns, open_ns, open_scan_ns, flush_s, load_s;
+    uint32_t mismatches = 0;
+    volatile uint32_t sink = 0;
+
+    remove(path);
+    if (fault_store_open(&faults, path) != 0) {
+        printf("Error: Cannot create %s\n", path);
+        return;
+    }
+
+    // One fault every 0-30 s of a random type
+    double start = monotonic_seconds();
+    for (uint32_t k = 0; k < events; k++) {
+        fault_type_t type = (fault_type_t)(random_next(&rng) % (FAULT_MEMORY_LEAK + 1));
+        time_ns += (uint64_t)(random_next(&rng) % 30000) * 1000000ull;
+        fault_store_append(&faults, time_ns, type,
+                           type == FAULT_NONE ? subsystem_of_error(ERR_WATCHDOG_TIMEOUT) : subsystem_of_fault(type),
+                           ERR_NONE, 0, 0);
+    }
+    append_ns = (monotonic_seconds() - start) * 1e9 / events;
+
+    // Resolve all but the last 1% after 0.5-60 s
+    uint32_t to_resolve = events - events / 100;
+    start = monotonic_seconds();
+    for (uint32_t id = 0; id < to_resolve; id++) {
+        uint64_t raised_ns = fault_store_get(&faults, id)->time_ns;
+        fault_store_resolve(&faults, id, raised_ns + 500000000ull + (uint64_t)(random_next(&rng) % 59500) * 1000000ull);
+    }
+    resolve_ns = (monotonic_seconds() - start) * 1e9 / to_resolve;
+
+    // Random windows of one hour to 30 days, checked against a scan
+    uint64_t span_ns = faults.last_time_ns;
+    fault_stats_t indexed, scanned;
+    start = monotonic_seconds();
+    for (int q = 0; q < queries; q++) {
+        int type = (int)(random_next(&rng) % (FAULT_MEMORY_LEAK + 1));
+        uint64_t length_ns = (1 + random_next(&rng) % 720) * 3600ull * 1000000000ull;
+        uint64_t from_ns = ((uint64_t)random_next(&rng) << 32 | random_next(&rng)) % span_ns;
+        fault_store_stats(&faults, type, from_ns, from_ns + length_ns, &indexed);
+        sink += indexed.count;
+    }
+    query_ns = (monotonic_seconds() - start) * 1e9 / queries;
+
+    scan_ns = 0;
+    for (int q = 0; q < scans; q++) {
+        int type = (int)(random_next(&rng) % (FAULT_MEMORY_LEAK + 1));
+        uint64_t length_ns = (1 + random_next(&rng) % 720) * 3600ull * 1000000000ull;
+        uint64_t from_ns = ((uint64_t)random_next(&rng) << 32 | random_next(&rng)) % span_ns;
+        fault_store_stats(&faults, type, from_ns, from_ns + length_ns, &indexed);
+        start = monotonic_seconds();
+        fault_stats_scan(&faults, type, from_ns, from_ns + length_ns, &scanned);
+        scan_ns += (monotonic_seconds() - start) * 1e9 / scans;
+        if (indexed.count != scanned.count || indexed.open != scanned.open ||
+            indexed.mttr_s != scanned.mttr_s || indexed.mtbf_s != scanned.mtbf_s) {   // Same integer sums
+            mismatches++;
+        }
+    }
+
+    // Which subsystems have open faults: counters against a scan for unresolved records
+    start = monotonic_seconds();
+    for (int q = 0; q < queries; q++) {
+        for (int s = 0; s < SUBSYSTEM_COUNT; s++) {
+            sink += faults.open_count[s] > 0;
+        }
+    }
+    open_ns = (monotonic_seconds() - start) * 1e9 / queries;
+    start = monotonic_seconds();
+    for (int q = 0; q < scans; q++) {
+        uint32_t open_mask = 0;
+        for (uint32_t id = 0; id < faults.count; id++) {
+            const fault_event_t* event = fault_store_get(&faults, id);
+            if (!event->resolved) open_mask |= 1u << event->subsystem;
+        }
+        sink += open_mask;
+    }
+    open_scan_ns = (monotonic_seconds() - start) * 1e9 / scans;
+
+    // Append everything to the event file, then replay it
+    start = monotonic_seconds();
+    fault_store_flush(&faults);
+    flush_s = monotonic_seconds() - start;
+    start = monotonic_seconds();
+    if (fault_store_load(&loaded, path) != 0) {
+        mismatches++;
+    }
+    load_s = monotonic_seconds() - start;
+    for (int type = FAULT_NONE; type <= FAULT_MEMORY_LEAK; type++) {
+        fault_store_stats(&faults, type, 0, UINT64_MAX, &indexed);
+        fault_store_stats(&loaded, type, 0, UINT64_MAX, &scanned);
+        if (indexed.count != scanned.count || indexed.open != scanned.open || indexed.mttr_s != scanned.mttr_s) {
+            mismatches++;
+        }
+    }
+    fault_store_close(&faults);
+    fault_store_close(&loaded);
+
+    FILE* file = fopen(path, "rb");
+    long file_size = 0;
+    if (file != NULL) {
+        fseek(file, 0, SEEK_END);
+        file_size = ftell(file);
+        fclose(file);
+    }
+    remove(path);
+
+    printf("Fault store benchmark (%u faults over %.0f days, %d window queries)\n",
+           events, (double)span_ns / 86.4e12, queries);
+    printf("Append: %.0f ns/fault, resolve: %.0f ns/fault\n", append_ns, resolve_ns);
+    printf("%-34s %14s %14s\n", "Query", "Indexed (ns)", "Scan (ns)");
+    printf("%-34s %14.0f %14.0f\n", "Count/open/MTBF/MTTR in a window", query_ns, scan_ns);
+    printf("%-34s %14.1f %14.0f\n", "Subsystems with open faults", open_ns, open_scan_ns);
+    printf("Event file: %.1f MB written in %.3f s, replayed in %.3f s\n",
+           file_size / 1e6, flush_s, load_s);
+    printf("Indexed results differing from the scan or the replay: %u\n", mismatches);
+}
+
+/*
+ * Run a named benchmark and return the process exit code.
+ */
+int run_benchmark(const char* name) {
+    int all = strcmp(name, "all") == 0;
+    int found = 0;
+
+    if (all || strcmp(name, "log") == 0) {
+        benchmark_log_buffer();
+        found = 1;
+    }
+    if (all || strcmp(name, "writer") == 0) {
+        benchmark_log_writer();
+        found = 1;
+    }
+    if (all || strcmp(name, "levels") == 0) {
+        benchmark_log_levels();
+        found = 1;
+    }
+    if (all || strcmp(name, "health") == 0) {
+        benchmark_health_sampling();
+        found = 1;
+    }
+    if (all || strcmp(name, "watchdog") == 0) {
+        benchmark_watchdog();
+        found = 1;
+    }
+    if (all || strcmp(name, "profiler") == 0) {
+        benchmark_profiler();
+        found = 1;
+    }
+    if (all || strcmp(name, "recovery") == 0) {
+        benchmark_recovery();
+        found = 1;
+    }
+    if (all || strcmp(name, "input") == 0) {
+        benchmark_input();
+        found = 1;
+    }
+    if (all || strcmp(name, "faults") == 0) {
+        benchmark_fault_store();
+        found = 1;
+    }
+
+    if (!found) {
+        printf("Unknown benchmark '%s' (available: log, writer, levels, health, watchdog, profiler, recovery, input, faults, all)\n", name);
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Fault-Injection Campaign
+ * ========================
+ *
+ * Runs many independent headless monitors, each on a simulated 100 ms
+ * control cycle with its own seeded fault schedule. While an instance is
+ * healthy, a fault of random type arrives with probability
+ * 1 / CAMPAIGN_FAULT_INTERVAL per cycle, and is simulated on every cycle. A
+ * fault is detected when the monitor logs its error code at the fault's
+ * level: an error, or a warning for the types whose simulation only warns
+ * (they never put the monitor in a fault state, so they are withdrawn once
+ * warned and have no recovery). Recovery of a detected error starts at once
+ * (as the 'r' command would) and is timed until the monitor is back to
+ * RUNNING; a fault still undetected after CAMPAIGN_DETECTION_WINDOW cycles
+ * counts as missed and is withdrawn.
+ *
+ * Instance i always uses seed + i, so results do not depend on the thread
+ * count.
+ */
+#define CAMPAIGN_CYCLES 3000               // Simulated cycles per instance (5 minutes)
+#define CAMPAIGN_FAULT_INTERVAL 150        // Mean healthy cycles between faults
+#define CAMPAIGN_DETECTION_WINDOW 100      // Cycles before an undetected fault counts as missed
+#define CAMPAIGN_MAX_THREADS 64
+
+// Error code that identifies each fault type when it is detected
+static const error_code_t campaign_fault_errors[FAULT_MEMORY_LEAK + 1] = {
+    ERR_NONE, ERR_SENSOR_FAILURE, ERR_ACTUATOR_STUCK, ERR_COMMUNICATION_LOST,
+    ERR_POWER_FLUCTUATION, ERR_MEMORY_CORRUPTION
+};
+
+// Log level at which each fault type is reported by its simulation
+static const log_level_t campaign_fault_levels[FAULT_MEMORY_LEAK + 1] = {
+    LOG_ERROR, LOG_WARNING, LOG_ERROR, LOG_ERROR, LOG_WARNING, LOG_ERROR
+};
+
+// Outcomes of one fault type
+typedef struct {
+    uint32_t injected;               // Faults that were detected or missed (open at the end: not counted)
+    uint32_t detected;
+    uint32_t missed;
+    uint32_t missed_warned;          // Missed, but logged a warning with the fault's error code
+    uint32_t recovered;              // Detected faults timed back to RUNNING
+    uint32_t detection_cycles[CAMPAIGN_DETECTION_WINDOW + 1];   // Detection latency histogram
+    double recovery_total_s;         // From detection back to RUNNING
+    double recovery_max_s;
+} campaign_fault_stats_t;
+
+typedef struct {
+    campaign_fault_stats_t faults[FAULT_MEMORY_LEAK + 1];
+    uint32_t spurious;               // Fault states entered with no matching injected fault
+    uint64_t cycles;
+} campaign_stats_t;
+
+// One worker thread and the instances it runs
+typedef struct {
+    int first_instance;
+    int instance_count;
+    uint32_t seed;
+    campaign_stats_t stats;
+#ifndef _WIN32
+    pthread_t thread;
+#endif
+} campaign_worker_t;
+
+/*
+ * Run one instance's schedule to completion and add its outcomes to stats
+ */
+static void campaign_run_instance(debug_monitor_t* monitor, uint32_t seed, campaign_stats_t* stats) {
+    uint32_t schedule = (seed ^ 0xA5A5A5A5u) * 2246822519u | 1;  // Independent of the monitor's sequence
+    fault_type_t fault = FAULT_NONE;
+    fault_type_t recovering = FAULT_NONE;   // Detected fault whose recovery is running
+    double detected_at = 0.0;
+    uint32_t injected_cycle = 0;
+    int warned = 0, identified = 0;
+
+    debug_init_headless(monitor, seed);
+    uint32_t seen_sequence = monitor->log_sequence;
+
+    for (uint32_t cycle = 0; cycle < CAMPAIGN_CYCLES; cycle++) {
+        if (fault == FAULT_NONE && monitor->health.current_state == STATE_RUNNING &&
+            random_next(&schedule) % CAMPAIGN_FAULT_INTERVAL == 0) {
+            fault = (fault_type_t)(random_next(&schedule) % FAULT_MEMORY_LEAK + 1);
+            injected_cycle = cycle;
+            warned = identified = 0;
+            inject_fault(monitor, fault);
+        }
+
+        run_control_cycle(monitor);
+        monitor->sim_time += CONTROL_CYCLE_US * 1e-6;
+
+        // Look through this cycle's records for the fault's error code
+        uint32_t fresh = monitor->log_sequence - seen_sequence;
+        if (fresh > (uint32_t)monitor->log_count) fresh = (uint32_t)monitor->log_count;
+        for (int k = monitor->log_count - (int)fresh; k < monitor->log_count; k++) {
+            const log_record_t* record = log_entry_at(monitor, k);
+            const log_site_t* site = log_site_get(record->site_id);
+            if (fault != FAULT_NONE && site != NULL && record->error_code == campaign_fault_errors[fault]) {
+                if (site->level >= campaign_fault_levels[fault]) identified = 1;
+                else warned = 1;
+            }
+        }
+        seen_sequence = monitor->log_sequence;
+
+        // A fault that only warns is detected by its warning and then withdrawn
+        if (fault != FAULT_NONE && identified && campaign_fault_levels[fault] < LOG_ERROR &&
+            monitor->health.current_state != STATE_FAULT) {
+            campaign_fault_stats_t* outcome = &stats->faults[fault];
+            uint32_t latency = cycle - injected_cycle + 1;
+            outcome->injected++;
+            outcome->detected++;
+            outcome->detection_cycles[latency < CAMPAIGN_DETECTION_WINDOW ? latency : CAMPAIGN_DETECTION_WINDOW]++;
+            monitor->fault_injection_enabled = 0;
+            monitor->active_fault = FAULT_NONE;
+            fault = FAULT_NONE;
+        }
+
+        // Recovery runs over the following cycles
+        if (recovering != FAULT_NONE && monitor->health.current_state == STATE_RUNNING) {
+            campaign_fault_stats_t* outcome = &stats->faults[recovering];
+            double recovery_s = monitor->sim_time - detected_at;
+            outcome->recovered++;
+            outcome->recovery_total_s += recovery_s;
+            if (recovery_s > outcome->recovery_max_s) outcome->recovery_max_s = recovery_s;
+            recovering = FAULT_NONE;
+        }
+
+        if (monitor->health.current_state == STATE_FAULT) {
+            campaign_fault_stats_t* outcome = &stats->faults[fault];
+
+            if (fault != FAULT_NONE && identified) {
+                uint32_t latency = cycle - injected_cycle + 1;
+                outcome->injected++;
+                outcome->detected++;
+                outcome->detection_cycles[latency < CAMPAIGN_DETECTION_WINDOW ? latency : CAMPAIGN_DETECTION_WINDOW]++;
+            } else {
+                stats->spurious++;
+                if (fault != FAULT_NONE) {
+                    // Cleared by a recovery it did not cause
+                    outcome->injected++;
+                    outcome->missed++;
+                    outcome->missed_warned += (uint32_t)warned;
+                }
+            }
+
+            attempt_fault_recovery(monitor);
+            detected_at = monitor->sim_time;
+            recovering = identified ? fault : FAULT_NONE;
+            fault = FAULT_NONE;
+        } else if (fault != FAULT_NONE && cycle - injected_cycle + 1 >= CAMPAIGN_DETECTION_WINDOW) {
+            // Never detected: withdraw the fault
+            campaign_fault_stats_t* outcome = &stats->faults[fault];
+            outcome->injected++;
+            outcome->missed++;
+            outcome->missed_warned += (uint32_t)warned;
+            monitor->fault_injection_enabled = 0;
+            monitor->active_fault = FAULT_NONE;
+            fault = FAULT_NONE;
+        }
+    }
+    stats->cycles += CAMPAIGN_CYCLES;
+    fault_store_close(&monitor->faults);
+}
+
+/*
+ * Worker thread: run a contiguous block of instances on one monitor
+ */
+static void* campaign_worker(void* arg) {
+    campaign_worker_t* worker = arg;
+    debug_monitor_t* monitor = malloc(sizeof(debug_monitor_t));
+
+    if (monitor == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < worker->instance_count; i++) {
+        campaign_run_instance(monitor, worker->seed + (uint32_t)(worker->first_instance + i), &worker->stats);
+    }
+    free(monitor);
+    return NULL;
+}
+
+/*
+ * Bucket index at quantile q of a latency histogram
+ */
+static int campaign_percentile(const uint32_t* histogram, uint32_t count, double q) {
+    uint32_t rank = (uint32_t)(q * (count - 1)) + 1;
+    uint32_t seen = 0;
+
+    for (int i = 0; i <= CAMPAIGN_DETECTION_WINDOW; i++) {
+        seen += histogram[i];
+        if (seen >= rank) return i;
+    }
+    return CAMPAIGN_DETECTION_WINDOW;
+}
+
+/*
+ * Run the campaign across worker threads and print per-fault statistics
+ *
+ * @return: 0 on success, 1 if the workers could not be started
+ */
+int run_fault_campaign(int instances, uint32_t seed, int threads) {
+    static campaign_worker_t workers[CAMPAIGN_MAX_THREADS];
+    campaign_stats_t total;
+    double cycle_s = CONTROL_CYCLE_US * 1e-6;
+
+#ifdef _WIN32
+    threads = 1;   // No worker threads: instances run in turn
+#else
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+#endif
+    if (threads > CAMPAIGN_MAX_THREADS) threads = CAMPAIGN_MAX_THREADS;
+    if (threads > instances) threads = instances;
+
+    printf("Fault campaign: %d instances x %d cycles (%.0f s simulated each), seed %u, %d thread%s\n",
+           instances, CAMPAIGN_CYCLES, CAMPAIGN_CYCLES * cycle_s, seed, threads, threads == 1 ? "" : "s");
+
+    double start = monotonic_seconds();
+    for (int t = 0; t < threads; t++) {
+        campaign_worker_t* worker = &workers[t];
+        memset(worker, 0, sizeof(*worker));
+        worker->first_instance = (int)((long)instances * t / threads);
+        worker->instance_count = (int)((long)instances * (t + 1) / threads) - worker->first_instance;
+        worker->seed = seed;
+#ifdef _WIN32
+        campaign_worker(worker);
+#else
+        if (pthread_create(&worker->thread, NULL, campaign_worker, worker) != 0) {
+            printf("Error: Cannot start campaign thread: %s\n", strerror(errno));
+            for (int started = 0; started < t; started++) {
+                pthread_join(workers[started].thread, NULL);
+            }
+            return 1;
+        }
+#endif
+    }
+
+    // Merge the workers' statistics
+    memset(&total, 0, sizeof(total));
+    for (int t = 0; t < threads; t++) {
+#ifndef _WIN32
+        pthread_join(workers[t].thread, NULL);
+#endif
+        const campaign_stats_t* stats = &workers[t].stats;
+        total.spurious += stats->spurious;
+        total.cycles += stats->cycles;
+        for (int f = FAULT_SENSOR_NOISE; f <= FAULT_MEMORY_LEAK; f++) {
+            campaign_fault_stats_t* out = &total.faults[f];
+            const campaign_fault_stats_t* in = &stats->faults[f];
+            out->injected += in->injected;
+            out->detected += in->detected;
+            out->missed += in->missed;
+            out->missed_warned += in->missed_warned;
+            out->recovered += in->recovered;
+            out->recovery_total_s += in->recovery_total_s;
+            if (in->recovery_max_s > out->recovery_max_s) out->recovery_max_s = in->recovery_max_s;
+            for (int i = 0; i <= CAMPAIGN_DETECTION_WINDOW; i++) {
+                out->detection_cycles[i] += in->detection_cycles[i];
+            }
+        }
+    }
+    double elapsed = monotonic_seconds() - start;
+
+    printf("%llu control cycles in %.2f s (%.2f M cycles/s)\n\n",
+           (unsigned long long)total.cycles, elapsed, total.cycles / elapsed / 1e6);
+    printf("%-14s %8s %8s %8s %8s  %-23s %s\n", "Fault", "Injected", "Detected", "Missed", "(warned)",
+           "Detect p50/p99/max (s)", "Recovery mean/max (s)");
+    for (int f = FAULT_SENSOR_NOISE; f <= FAULT_MEMORY_LEAK; f++) {
+        const campaign_fault_stats_t* stats = &total.faults[f];
+        char detect[32] = "-", recovery[32] = "-";
+
+        if (stats->detected > 0) {
+            int max_cycles = CAMPAIGN_DETECTION_WINDOW;
+            while (max_cycles > 0 && stats->detection_cycles[max_cycles] == 0) max_cycles--;
+            snprintf(detect, sizeof(detect), "%.1f / %.1f / %.1f",
+                     campaign_percentile(stats->detection_cycles, stats->detected, 0.50) * cycle_s,
+                     campaign_percentile(stats->detection_cycles, stats->detected, 0.99) * cycle_s,
+                     max_cycles * cycle_s);
+        }
+        if (stats->recovered > 0) {
+            snprintf(recovery, sizeof(recovery), "%.1f / %.1f",
+                     stats->recovery_total_s / stats->recovered, stats->recovery_max_s);
+        }
+        printf("%-14s %8u %8u %8u %8u  %-23s %s\n", fault_type_names[f], stats->injected,
+               stats->detected, stats->missed, stats->missed_warned, detect, recovery);
+    }
+    printf("\nMissed: not detected within %.0f s (warned: only a warning carried the fault's error code)\n",
+           CAMPAIGN_DETECTION_WINDOW * cycle_s);
+    printf("Sensor noise and power spike are detected by their warning; they need no recovery\n");
+    printf("Spurious fault states (no matching fault injected): %u\n", total.spurious);
+    return 0;
+}
@@ -0,0 +1,575 @@
+/*
+ * Fault Event Store
+ * =================
+ *
+ * Chunked event storage, type and status indexes, window queries and the
+ * append-only event file declared in fault_store.h.
+ */
+
+// Expose truncate() when building with -std=c99
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fault_store.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Block kinds of the event file
+#define FAULT_BLOCK_SESSION 1            // Starts a session; first_id: ID of its first event
+#define FAULT_BLOCK_EVENTS 2             // count fault_event_record_t, first_id: ID of the first
+#define FAULT_BLOCK_RESOLUTIONS 3        // count fault_resolution_t of this session's events
+
+#define FAULT_INDEX_INITIAL 1024         // First allocation of a type index
+
+// Block header of the event file
+typedef struct {
+    uint32_t magic;                      // FAULT_STORE_MAGIC
+    uint16_t kind;
+    uint16_t record_size;
+    uint32_t count;
+    uint32_t first_id;
+} fault_block_header_t;
+
+// An event as written to the file
+typedef struct {
+    uint64_t time_ns;
+    uint32_t detail;
+    uint8_t type;
+    uint8_t subsystem;
+    uint8_t error_code;
+    uint8_t tag;
+} fault_event_record_t;
+
+// Compile-time checks of the on-disk sizes and the chunk mask
+typedef char fault_block_header_is_16_bytes[sizeof(fault_block_header_t) == 16 ? 1 : -1];
+typedef char fault_event_record_is_16_bytes[sizeof(fault_event_record_t) == 16 ? 1 : -1];
+typedef char fault_resolution_is_16_bytes[sizeof(fault_resolution_t) == 16 ? 1 : -1];
+typedef char fault_chunk_is_pow2[(FAULT_STORE_CHUNK_EVENTS & (FAULT_STORE_CHUNK_EVENTS - 1)) == 0 ? 1 : -1];
+
+static uint32_t lowest_bit(uint32_t position) {
+    return position & (~position + 1);
+}
+
+/*
+ * Make room for one more position in a type index
+ *
+ * @return: 0 on success, -1 if out of memory
+ */
+static int fault_index_reserve(fault_index_t* index) {
+    if (index->count < index->capacity) {
+        return 0;
+    }
+
+    uint32_t capacity = index->capacity ? index->capacity * 2 : FAULT_INDEX_INITIAL;
+    uint32_t* ids = realloc(index->ids, capacity * sizeof(*ids));
+    if (ids == NULL) return -1;
+    index->ids = ids;
+    uint32_t* resolved_tree = realloc(index->resolved_tree, capacity * sizeof(*resolved_tree));
+    if (resolved_tree == NULL) return -1;
+    index->resolved_tree = resolved_tree;
+    uint64_t* repair_tree = realloc(index->repair_tree, capacity * sizeof(*repair_tree));
+    if (repair_tree == NULL) return -1;
+    index->repair_tree = repair_tree;
+
+    index->capacity = capacity;
+    return 0;
+}
+
+/*
+ * Add an unresolved event at the end of a type index. Its Fenwick nodes
+ * cover the positions below it, so they are summed from the nodes there.
+ */
+static void fault_index_push(fault_index_t* index, uint32_t id) {
+    uint32_t position = ++index->count;   // 1-based
+    uint32_t resolved = 0;
+    uint64_t repair = 0;
+
+    for (uint32_t child = position - 1; child > position - lowest_bit(position); child -= lowest_bit(child)) {
+        resolved += index->resolved_tree[child - 1];
+        repair += index->repair_tree[child - 1];
+    }
+    index->ids[position - 1] = id;
+    index->resolved_tree[position - 1] = resolved;
+    index->repair_tree[position - 1] = repair;
+}
+
+/*
+ * Record the resolution of the event at a 0-based position
+ */
+static void fault_index_resolve(fault_index_t* index, uint32_t position, uint64_t repair_ns) {
+    for (uint32_t node = position + 1; node <= index->count; node += lowest_bit(node)) {
+        index->resolved_tree[node - 1]++;
+        index->repair_tree[node - 1] += repair_ns;
+    }
+}
+
+/*
+ * Resolved events and their repair time at positions below end
+ */
+static void fault_index_prefix(const fault_index_t* index, uint32_t end, uint32_t* resolved, uint64_t* repair_ns) {
+    *resolved = 0;
+    *repair_ns = 0;
+    for (uint32_t node = end; node > 0; node -= lowest_bit(node)) {
+        *resolved += index->resolved_tree[node - 1];
+        *repair_ns += index->repair_tree[node - 1];
+    }
+}
+
+/*
+ * First position of a type index whose event was raised at or after time_ns
+ */
+static uint32_t fault_index_lower_bound(const fault_store_t* store, const fault_index_t* index, uint64_t time_ns) {
+    uint32_t low = 0, high = index->count;
+
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (fault_store_get(store, index->ids[middle])->time_ns < time_ns) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/*
+ * Open the event file for appending and start a session in it
+ *
+ * @return: 0 on success, -1 if the file cannot be opened or written
+ */
+int fault_store_open(fault_store_t* store, const char* path) {
+    fault_block_header_t header = {FAULT_STORE_MAGIC, FAULT_BLOCK_SESSION, 0, 0, 0};
+
+    memset(store, 0, sizeof(*store));
+    store->path = malloc(strlen(path) + 1);
+    if (store->path == NULL) {
+        return -1;
+    }
+    strcpy(store->path, path);
+    store->file = fopen(path, "ab");
+    long end = -1;
+    if (store->file != NULL && fwrite(&header, sizeof(header), 1, store->file) == 1 &&
+        fflush(store->file) == 0) {
+        end = ftell(store->file);
+    }
+    if (end < 0) {
+        if (store->file != NULL) {
+            fclose(store->file);
+        }
+        free(store->path);
+        memset(store, 0, sizeof(*store));
+        return -1;
+    }
+    store->file_size = (uint64_t)end;
+    return 0;
+}
+
+/*
+ * Flush the file, close it and free every event and index
+ */
+void fault_store_close(fault_store_t* store) {
+    if (store->file != NULL) {
+        fault_store_flush(store);
+    }
+    if (store->file != NULL) {
+        fclose(store->file);
+    }
+    free(store->path);
+    for (uint32_t c = 0; c < store->chunk_count; c++) {
+        free(store->chunks[c]);
+    }
+    free(store->chunks);
+    for (int t = 0; t <= FAULT_STORE_TYPES; t++) {
+        free(store->by_type[t].ids);
+        free(store->by_type[t].resolved_tree);
+        free(store->by_type[t].repair_tree);
+    }
+    free(store->pending);
+    memset(store, 0, sizeof(*store));
+}
+
+static int fault_store_write_block(fault_store_t* store, uint16_t kind, uint16_t record_size,
+                                   uint32_t count, uint32_t first_id, const void* records) {
+    fault_block_header_t header = {FAULT_STORE_MAGIC, kind, record_size, count, first_id};
+
+    if (fwrite(&header, sizeof(header), 1, store->file) != 1 ||
+        fwrite(records, record_size, count, store->file) != count) {
+        store->write_errors++;
+        return -1;
+    }
+    store->file_size += sizeof(header) + (uint64_t)record_size * count;
+    return 0;
+}
+
+/*
+ * Cut the event file back to size bytes after a failed write, so no torn
+ * block is left for the next flush to append after. The stream is reopened
+ * so nothing left in its buffer reaches the file later.
+ *
+ * @return: 0 if the file was cut, -1 if it is closed and the store is memory-only
+ */
+static int fault_store_rewind(fault_store_t* store, uint64_t size) {
+    int cut;
+
+    fclose(store->file);
+    store->file = NULL;
+#ifdef _WIN32
+    int fd = _open(store->path, _O_RDWR | _O_BINARY);
+    cut = fd >= 0 && _chsize_s(fd, (long long)size) == 0;
+    if (fd >= 0) {
+        _close(fd);
+    }
+#else
+    cut = truncate(store->path, (off_t)size) == 0;
+#endif
+    if (cut) {
+        store->file = fopen(store->path, "ab");
+    }
+    store->file_size = size;
+    return store->file != NULL ? 0 : -1;
+}
+
+/*
+ * Write blocks of the events not yet persisted and of the pending
+ * resolutions, and flush the stream
+ *
+ * @return: 0 on success, -1 on a write error
+ */
+static int fault_store_write_pending(fault_store_t* store) {
+    static fault_event_record_t records[FAULT_STORE_CHUNK_EVENTS];   // Event files are written from one thread
+
+    // One block per chunk (or part of one)
+    while (store->persisted < store->count) {
+        uint32_t first = store->persisted;
+        uint32_t count = FAULT_STORE_CHUNK_EVENTS - (first & (FAULT_STORE_CHUNK_EVENTS - 1));
+
+        if (count > store->count - first) {
+            count = store->count - first;
+        }
+        for (uint32_t k = 0; k < count; k++) {
+            const fault_event_t* event = fault_store_get(store, first + k);
+            records[k].time_ns = event->time_ns;
+            records[k].detail = event->detail;
+            records[k].type = event->type;
+            records[k].subsystem = event->subsystem;
+            records[k].error_code = event->error_code;
+            records[k].tag = event->tag;
+        }
+        if (fault_store_write_block(store, FAULT_BLOCK_EVENTS, sizeof(records[0]), count, first, records) != 0) {
+            return -1;
+        }
+        store->persisted += count;
+    }
+
+    if (store->pending_count > 0 &&
+        fault_store_write_block(store, FAULT_BLOCK_RESOLUTIONS, sizeof(fault_resolution_t),
+                                store->pending_count, 0, store->pending) != 0) {
+        return -1;
+    }
+
+    if (fflush(store->file) != 0) {
+        store->write_errors++;
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Append the events raised and the resolutions made since the last flush.
+ * A failed write cuts the file back to where the flush started, and the
+ * events and resolutions stay pending for the next flush.
+ *
+ * @return: 0 on success (or for a memory-only store), -1 on a write error
+ */
+int fault_store_flush(fault_store_t* store) {
+    uint32_t persisted = store->persisted;
+    uint64_t size = store->file_size;
+
+    if (store->file == NULL) {
+        return 0;
+    }
+    if (fault_store_write_pending(store) != 0) {
+        store->persisted = persisted;
+        fault_store_rewind(store, size);
+        return -1;
+    }
+    store->pending_count = 0;
+    return 0;
+}
+
+/*
+ * Replay every session of an event file into a memory-only store. A block
+ * cut short by a crash ends the replay; the blocks before it are kept.
+ *
+ * @return: 0 on success, -1 if the file cannot be read or is not an event file
+ */
+int fault_store_load(fault_store_t* store, const char* path) {
+    static fault_event_record_t records[FAULT_STORE_CHUNK_EVENTS];   // ... and read from one thread
+    fault_block_header_t header;
+    int64_t id_offset = 0;   // Store ID minus the session's ID for the same event
+    FILE* file;
+
+    if (store->file != NULL || (file = fopen(path, "rb")) == NULL) {
+        return -1;
+    }
+
+    while (fread(&header, sizeof(header), 1, file) == 1) {
+        if (header.magic != FAULT_STORE_MAGIC) {
+            fclose(file);
+            return -1;
+        }
+
+        if (header.kind == FAULT_BLOCK_SESSION) {
+            id_offset = (int64_t)store->count - header.first_id;
+        } else if (header.kind == FAULT_BLOCK_EVENTS && header.record_size == sizeof(records[0])) {
+            for (uint32_t done = 0; done < header.count; ) {
+                uint32_t count = header.count - done;
+                if (count > FAULT_STORE_CHUNK_EVENTS) count = FAULT_STORE_CHUNK_EVENTS;
+                if (fread(records, sizeof(records[0]), count, file) != count) {
+                    fclose(file);
+                    return 0;
+                }
+                for (uint32_t k = 0; k < count; k++) {
+                    fault_store_append(store, records[k].time_ns, records[k].type, records[k].subsystem,
+                                       records[k].error_code, records[k].detail, records[k].tag);
+                }
+                done += count;
+            }
+        } else if (header.kind == FAULT_BLOCK_RESOLUTIONS && header.record_size == sizeof(fault_resolution_t)) {
+            for (uint32_t k = 0; k < header.count; k++) {
+                fault_resolution_t resolution;
+                if (fread(&resolution, sizeof(resolution), 1, file) != 1) {
+                    fclose(file);
+                    return 0;
+                }
+                int64_t id = (int64_t)resolution.id + id_offset;
+                if (id >= 0 && id < (int64_t)store->count) {
+                    fault_store_resolve(store, (uint32_t)id, resolution.resolved_ns);
+                }
+            }
+        } else {
+            // Unknown block: skip its records
+            if (fseek(file, (long)header.record_size * header.count, SEEK_CUR) != 0) {
+                break;
+            }
+        }
+    }
+
+    fclose(file);
+    return 0;
+}
+
+/*
+ * Record a raised fault. Times earlier than the last event's are raised to
+ * it, which keeps every index in time order.
+ *
+ * @return: The event's ID, or FAULT_STORE_NONE if the type or subsystem is
+ *          out of range or memory ran out
+ */
+uint32_t fault_store_append(fault_store_t* store, uint64_t time_ns, int type, int subsystem,
+                            int error_code, uint32_t detail, uint8_t tag) {
+    fault_index_t* type_index;
+    fault_event_t* event;
+    uint32_t id = store->count;
+
+    if (type < 0 || type >= FAULT_STORE_TYPES || subsystem < 0 || subsystem >= FAULT_STORE_SUBSYSTEMS ||
+        id == FAULT_STORE_NONE) {
+        return FAULT_STORE_NONE;
+    }
+    type_index = &store->by_type[type];
+
+    // Reserve everything first so a failed allocation leaves the store unchanged
+    if (id / FAULT_STORE_CHUNK_EVENTS == store->chunk_count) {
+        if (store->chunk_count == store->chunk_capacity) {
+            uint32_t capacity = store->chunk_capacity ? store->chunk_capacity * 2 : 16;
+            fault_event_t** chunks = realloc(store->chunks, capacity * sizeof(*chunks));
+            if (chunks == NULL) {
+                store->dropped++;
+                return FAULT_STORE_NONE;
+            }
+            store->chunks = chunks;
+            store->chunk_capacity = capacity;
+        }
+        store->chunks[store->chunk_count] = malloc(FAULT_STORE_CHUNK_EVENTS * sizeof(fault_event_t));
+        if (store->chunks[store->chunk_count] == NULL) {
+            store->dropped++;
+            return FAULT_STORE_NONE;
+        }
+        store->chunk_count++;
+    }
+    if (fault_index_reserve(type_index) != 0 ||
+        fault_index_reserve(&store->by_type[FAULT_STORE_ALL_TYPES]) != 0) {
+        store->dropped++;
+        return FAULT_STORE_NONE;
+    }
+
+    if (time_ns < store->last_time_ns) {
+        time_ns = store->last_time_ns;
+    }
+    store->last_time_ns = time_ns;
+
+    event = fault_store_get(store, id);
+    memset(event, 0, sizeof(*event));
+    event->time_ns = time_ns;
+    event->type = (uint8_t)type;
+    event->subsystem = (uint8_t)subsystem;
+    event->error_code = (uint8_t)error_code;
+    event->detail = detail;
+    event->tag = tag;
+    event->type_position = type_index->count;
+    store->count++;
+
+    fault_index_push(type_index, id);
+    fault_index_push(&store->by_type[FAULT_STORE_ALL_TYPES], id);
+
+    // Newest at the tail of its subsystem's open list
+    event->open_next = FAULT_STORE_NONE;
+    if (store->open_count[subsystem] == 0) {
+        event->open_prev = FAULT_STORE_NONE;
+        store->open_head[subsystem] = id;
+    } else {
+        event->open_prev = store->open_tail[subsystem];
+        fault_store_get(store, event->open_prev)->open_next = id;
+    }
+    store->open_tail[subsystem] = id;
+    store->open_count[subsystem]++;
+    store->open_total++;
+    return id;
+}
+
+/*
+ * Mark an open event resolved (no earlier than it was raised)
+ *
+ * @return: 0 on success, -1 if the ID is unknown or already resolved
+ */
+int fault_store_resolve(fault_store_t* store, uint32_t id, uint64_t time_ns) {
+    fault_event_t* event;
+    int subsystem;
+
+    if (id >= store->count || (event = fault_store_get(store, id))->resolved) {
+        return -1;
+    }
+    if (time_ns < event->time_ns) {
+        time_ns = event->time_ns;
+    }
+    event->resolved = 1;
+    event->resolved_ns = time_ns;
+
+    // Off its subsystem's open list
+    subsystem = event->subsystem;
+    if (event->open_prev != FAULT_STORE_NONE) {
+        fault_store_get(store, event->open_prev)->open_next = event->open_next;
+    } else {
+        store->open_head[subsystem] = event->open_next;
+    }
+    if (event->open_next != FAULT_STORE_NONE) {
+        fault_store_get(store, event->open_next)->open_prev = event->open_prev;
+    } else {
+        store->open_tail[subsystem] = event->open_prev;
+    }
+    store->open_count[subsystem]--;
+    store->open_total--;
+
+    fault_index_resolve(&store->by_type[event->type], event->type_position, time_ns - event->time_ns);
+    fault_index_resolve(&store->by_type[FAULT_STORE_ALL_TYPES], id, time_ns - event->time_ns);
+
+    // Journal the resolution for the next flush
+    if (store->file != NULL) {
+        if (store->pending_count == store->pending_capacity) {
+            uint32_t capacity = store->pending_capacity ? store->pending_capacity * 2 : 64;
+            fault_resolution_t* pending = realloc(store->pending, capacity * sizeof(*pending));
+            if (pending == NULL) {
+                store->dropped++;
+                return 0;
+            }
+            store->pending = pending;
+            store->pending_capacity = capacity;
+        }
+        store->pending[store->pending_count].id = id;
+        store->pending[store->pending_count].reserved = 0;
+        store->pending[store->pending_count].resolved_ns = time_ns;
+        store->pending_count++;
+    }
+    return 0;
+}
+
+/*
+ * Resolve every open event of a subsystem
+ *
+ * @return: Number of events resolved
+ */
+uint32_t fault_store_resolve_subsystem(fault_store_t* store, int subsystem, uint64_t time_ns) {
+    uint32_t resolved = 0;
+
+    if (subsystem < 0 || subsystem >= FAULT_STORE_SUBSYSTEMS) {
+        return 0;
+    }
+    while (store->open_count[subsystem] > 0) {
+        fault_store_resolve(store, store->open_head[subsystem], time_ns);
+        resolved++;
+    }
+    return resolved;
+}
+
+/*
+ * Events of a type (or FAULT_STORE_ALL_TYPES) raised in [from_ns, to_ns)
+ */
+fault_range_t fault_store_range(const fault_store_t* store, int type, uint64_t from_ns, uint64_t to_ns) {
+    fault_range_t range = {type, 0, 0};
+
+    if (type < 0 || type > FAULT_STORE_ALL_TYPES || from_ns >= to_ns) {
+        return range;
+    }
+    range.first = fault_index_lower_bound(store, &store->by_type[type], from_ns);
+    range.count = fault_index_lower_bound(store, &store->by_type[type], to_ns) - range.first;
+    return range;
+}
+
+/*
+ * ID of the k-th event (0 = oldest) of a range
+ */
+uint32_t fault_range_id(const fault_store_t* store, const fault_range_t* range, uint32_t k) {
+    if (k >= range->count) {
+        return FAULT_STORE_NONE;
+    }
+    return store->by_type[range->type].ids[range->first + k];
+}
+
+/*
+ * Count, open count, MTBF and MTTR of the events of a type raised in
+ * [from_ns, to_ns): two binary searches and two Fenwick prefix sums
+ */
+void fault_store_stats(const fault_store_t* store, int type, uint64_t from_ns, uint64_t to_ns,
+                       fault_stats_t* stats) {
+    fault_range_t range = fault_store_range(store, type, from_ns, to_ns);
+    const fault_index_t* index;
+    uint32_t resolved_before, resolved_through;
+    uint64_t repair_before, repair_through;
+
+    memset(stats, 0, sizeof(*stats));
+    if (range.count == 0) {
+        return;
+    }
+    index = &store->by_type[type];
+    stats->count = range.count;
+
+    if (range.count > 1) {
+        uint64_t first_ns = fault_store_get(store, index->ids[range.first])->time_ns;
+        uint64_t last_ns = fault_store_get(store, index->ids[range.first + range.count - 1])->time_ns;
+        stats->mtbf_s = (double)(last_ns - first_ns) / 1e9 / (range.count - 1);
+    }
+
+    fault_index_prefix(index, range.first, &resolved_before, &repair_before);
+    fault_index_prefix(index, range.first + range.count, &resolved_through, &repair_through);
+    stats->open = range.count - (resolved_through - resolved_before);
+    if (resolved_through > resolved_before) {
+        stats->mttr_s = (double)(repair_through - repair_before) / 1e9 / (resolved_through - resolved_before);
+    }
+}
@@ -0,0 +1,133 @@
+/*
+ * Fault Event Store
+ * =================
+ *
+ * Unbounded, time-ordered history of raised faults with indexes for the
+ * queries the monitor and its reports need.
+ *
+ * Events are appended in time order (an event stamped earlier than the one
+ * before it is moved up to that time) into fixed-size chunks, so the store
+ * grows without moving old events and an event ID is its position.
+ *
+ * Indexes kept on every append and resolve:
+ * - by type: the IDs of each type's events in time order, so the events of
+ *   a type in a time window are found with a binary search. Each type index
+ *   also carries Fenwick trees of resolved counts and repair times, so
+ *   MTBF, MTTR and the open count over any window cost O(log n).
+ * - by status: each subsystem's open events are on a linked list, so
+ *   resolving a subsystem touches only its open events, and the open count
+ *   per subsystem is kept as a counter.
+ *
+ * Persistence is append-only: fault_store_flush() appends a block of the
+ * events raised and a block of the resolutions made since the last flush.
+ * Each fault_store_open() starts a new session block in the file, and
+ * fault_store_load() replays every session into one store.
+ *
+ * A zero-initialized fault_store_t is an empty, memory-only store.
+ */
+
+#ifndef FAULT_STORE_H
+#define FAULT_STORE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define FAULT_STORE_CHUNK_EVENTS 4096       // Events per allocation (power of two)
+#define FAULT_STORE_TYPES 8                 // Fault types 0..7
+#define FAULT_STORE_ALL_TYPES FAULT_STORE_TYPES   // Query every type
+#define FAULT_STORE_SUBSYSTEMS 8            // Subsystems 0..7
+#define FAULT_STORE_NONE UINT32_MAX         // No event
+#define FAULT_STORE_MAGIC 0x31564546u       // "FEV1": block header of fault event files
+
+// One raised fault
+typedef struct {
+    uint64_t time_ns;                // When it was raised
+    uint64_t resolved_ns;            // When it was resolved (if resolved)
+    uint32_t open_prev;              // Neighbours on its subsystem's open list
+    uint32_t open_next;
+    uint32_t type_position;          // Position in its type index
+    uint32_t detail;                 // Caller-defined (watchdog: microseconds late)
+    uint8_t type;                    // < FAULT_STORE_TYPES
+    uint8_t subsystem;               // < FAULT_STORE_SUBSYSTEMS
+    uint8_t error_code;
+    uint8_t tag;                     // Caller-defined (watchdog: task and resumed flag)
+    uint8_t resolved;
+} fault_event_t;
+
+// Event IDs of one type in time order, with Fenwick trees over the positions
+typedef struct {
+    uint32_t* ids;
+    uint32_t* resolved_tree;         // Resolved events
+    uint64_t* repair_tree;           // Repair time in ns of the resolved events
+    uint32_t count;
+    uint32_t capacity;
+} fault_index_t;
+
+// A resolution, waiting for the next flush
+typedef struct {
+    uint32_t id;
+    uint32_t reserved;
+    uint64_t resolved_ns;
+} fault_resolution_t;
+
+// Events of one type (or all types) raised in a time window
+typedef struct {
+    int type;                        // Or FAULT_STORE_ALL_TYPES
+    uint32_t first;                  // Position in the type index
+    uint32_t count;
+} fault_range_t;
+
+// Reliability of one type over a time window
+typedef struct {
+    uint32_t count;                  // Raised in the window
+    uint32_t open;                   // ... and not yet resolved
+    double mtbf_s;                   // Mean time between them; 0 with fewer than two
+    double mttr_s;                   // Mean time to resolve the resolved ones; 0 if none
+} fault_stats_t;
+
+typedef struct {
+    fault_event_t** chunks;
+    uint32_t chunk_count;
+    uint32_t chunk_capacity;
+    uint32_t count;                  // Events stored
+    uint64_t last_time_ns;
+
+    fault_index_t by_type[FAULT_STORE_TYPES + 1];   // [FAULT_STORE_ALL_TYPES]: every event
+    uint32_t open_head[FAULT_STORE_SUBSYSTEMS];     // Oldest open event (valid while open_count > 0)
+    uint32_t open_tail[FAULT_STORE_SUBSYSTEMS];     // Newest open event
+    uint32_t open_count[FAULT_STORE_SUBSYSTEMS];
+    uint32_t open_total;
+
+    // Persistence (file is NULL for a memory-only store)
+    FILE* file;
+    char* path;
+    uint64_t file_size;              // Bytes of complete blocks in the file
+    uint32_t persisted;              // Events already appended to the file
+    fault_resolution_t* pending;     // Resolutions made since the last flush
+    uint32_t pending_count;
+    uint32_t pending_capacity;
+    uint64_t write_errors;
+    uint64_t dropped;                // Events or resolutions lost to a failed allocation
+} fault_store_t;
+
+int fault_store_open(fault_store_t* store, const char* path);
+void fault_store_close(fault_store_t* store);
+int fault_store_flush(fault_store_t* store);
+int fault_store_load(fault_store_t* store, const char* path);
+uint32_t fault_store_append(fault_store_t* store, uint64_t time_ns, int type, int subsystem,
+                            int error_code, uint32_t detail, uint8_t tag);
+int fault_store_resolve(fault_store_t* store, uint32_t id, uint64_t time_ns);
+uint32_t fault_store_resolve_subsystem(fault_store_t* store, int subsystem, uint64_t time_ns);
+fault_range_t fault_store_range(const fault_store_t* store, int type, uint64_t from_ns, uint64_t to_ns);
+uint32_t fault_range_id(const fault_store_t* store, const fault_range_t* range, uint32_t k);
+void fault_store_stats(const fault_store_t* store, int type, uint64_t from_ns, uint64_t to_ns,
+                       fault_stats_t* stats);
+
+/*
+ * Event with a valid ID
+ */
+static inline fault_event_t* fault_store_get(const fault_store_t* store, uint32_t id) {
+    return &store->chunks[id / FAULT_STORE_CHUNK_EVENTS][id & (FAULT_STORE_CHUNK_EVENTS - 1)];
+}
+
+#endif // FAULT_STORE_H
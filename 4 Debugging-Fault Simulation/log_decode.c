@@ -0,0 +1,250 @@
+/*
+ * Binary Log Decoder
+ * ==================
+ *
+ * Turns the binary log written by debug_fault_sim (see log_format.h) back
+ * into the text view:
+ *
+ *   [2024-01-15 10:30:15.123] INFO: System initialization started (main:258)
+ *
+ * Usage: log_decode [log file]   (default: system_debug.bin)
+ *
+ * Each session is decoded in two passes: the first collects its call-site
+ * definitions, the second renders its records. Gaps in the record sequence
+ * (entries dropped while the writer queue was full) are reported inline.
+ */
+
+// Expose localtime_r() when building with -std=c99
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "log_format.h"
+
+#define DEFAULT_LOG_PATH "system_debug.bin"
+
+// Call site as read back from a definition entry
+typedef struct {
+    uint8_t defined;
+    uint8_t level;
+    uint32_t line;
+    const char* function;
+    const char* format;
+    uint8_t arg_kinds[LOG_SITE_MAX_ARGS];
+    int arg_count;
+} decoded_site_t;
+
+// Function Prototypes
+uint8_t* read_file(const char* path, size_t* size);
+size_t entry_length(const uint8_t* data, size_t offset, size_t size);
+size_t decode_session(const uint8_t* data, size_t offset, size_t size, decoded_site_t* sites);
+void print_timestamp(uint64_t timestamp_ns);
+
+int main(int argc, char* argv[]) {
+    const char* path = argc > 1 ? argv[1] : DEFAULT_LOG_PATH;
+    decoded_site_t* sites;
+    uint8_t* data;
+    size_t size;
+    size_t offset = 0;
+
+    if (argc > 2 || (argc == 2 && argv[1][0] == '-')) {
+        printf("Usage: %s [log file]\n", argv[0]);
+        return 1;
+    }
+
+    data = read_file(path, &size);
+    if (data == NULL) {
+        return 1;
+    }
+    sites = calloc(LOG_MAX_SITES + 1, sizeof(decoded_site_t));
+    if (sites == NULL) {
+        printf("Error: Out of memory\n");
+        free(data);
+        return 1;
+    }
+
+    while (offset < size) {
+        size_t next = decode_session(data, offset, size, sites);
+        if (next == offset) {
+            printf("Error: Corrupt entry at offset %zu\n", offset);
+            break;
+        }
+        offset = next;
+    }
+
+    free(sites);
+    free(data);
+    return offset < size ? 1 : 0;
+}
+
+/*
+ * Read a whole file into memory
+ *
+ * @return: Buffer to free(), or NULL on error
+ */
+uint8_t* read_file(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    uint8_t* data;
+    long length;
+
+    if (file == NULL) {
+        printf("Error: Cannot open %s\n", path);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    data = malloc(length > 0 ? (size_t)length : 1);
+    if (data == NULL || fread(data, 1, (size_t)length, file) != (size_t)length) {
+        printf("Error: Cannot read %s\n", path);
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    *size = (size_t)length;
+    return data;
+}
+
+/*
+ * Length of the entry at offset
+ *
+ * @return: Length in bytes, or 0 if the entry is truncated or corrupt
+ */
+size_t entry_length(const uint8_t* data, size_t offset, size_t size) {
+    uint16_t site_id;
+    log_meta_header_t header;
+
+    if (size - offset < sizeof(site_id)) return 0;
+    memcpy(&site_id, data + offset, sizeof(site_id));
+    if (site_id != 0) {
+        return size - offset >= sizeof(log_record_t) ? sizeof(log_record_t) : 0;
+    }
+
+    if (size - offset < sizeof(header)) return 0;
+    memcpy(&header, data + offset, sizeof(header));
+    if (header.length < sizeof(header) || header.length > size - offset) return 0;
+    return header.length;
+}
+
+/*
+ * Decode one session starting at offset: definitions first, then records.
+ * Data before the first session marker is decoded as a session of its own.
+ *
+ * @return: Offset just past the session
+ */
+size_t decode_session(const uint8_t* data, size_t offset, size_t size, decoded_site_t* sites) {
+    size_t end = offset;
+    size_t length;
+    uint32_t expected_sequence = 0;
+    int have_sequence = 0;
+
+    memset(sites, 0, (LOG_MAX_SITES + 1) * sizeof(decoded_site_t));
+
+    // Pass 1: find the session's extent and collect call-site definitions
+    while (end < size && (length = entry_length(data, end, size)) != 0) {
+        log_meta_header_t header;
+        memcpy(&header, data + end, sizeof(header));
+
+        if (header.zero == 0 && header.kind == LOG_META_SESSION_START && end != offset) {
+            break;  // Next session
+        }
+        if (header.zero == 0 && header.kind == LOG_META_SITE && length > sizeof(log_site_meta_t)) {
+            log_site_meta_t meta;
+            memcpy(&meta, data + end, sizeof(meta));
+            if (meta.site_id > 0 && meta.site_id <= LOG_MAX_SITES) {
+                decoded_site_t* site = &sites[meta.site_id];
+                const char* strings = (const char*)data + end + sizeof(meta);
+                size_t strings_length = length - sizeof(meta);
+
+                // Both strings must be NUL-terminated inside the entry
+                if (memchr(strings, '\0', strings_length) != NULL) {
+                    size_t function_length = strlen(strings) + 1;
+                    if (function_length < strings_length &&
+                        memchr(strings + function_length, '\0', strings_length - function_length) != NULL) {
+                        site->defined = 1;
+                        site->level = meta.level;
+                        site->line = meta.line;
+                        site->function = strings;
+                        site->format = strings + function_length;
+                        site->arg_count = log_format_parse(site->format, site->arg_kinds, LOG_SITE_MAX_ARGS);
+                    }
+                }
+            }
+        }
+        end += length;
+    }
+
+    // Pass 2: render records in file order
+    for (size_t pos = offset; pos < end; pos += entry_length(data, pos, size)) {
+        log_record_t record;
+        memcpy(&record, data + pos, sizeof(uint16_t));
+
+        if (record.site_id == 0) {
+            log_session_meta_t marker;
+            log_meta_header_t header;
+            memcpy(&header, data + pos, sizeof(header));
+            if (header.kind == LOG_META_SESSION_START && header.length >= sizeof(marker)) {
+                memcpy(&marker, data + pos, sizeof(marker));
+                if (marker.magic != LOG_FORMAT_MAGIC || marker.record_size != sizeof(log_record_t)) {
+                    printf("Error: Unsupported log format (version %u, %u-byte records)\n",
+                           marker.version, marker.record_size);
+                    return pos;
+                }
+                printf("\n=== Log Session Start ===\n");
+            } else if (header.kind == LOG_META_SESSION_END) {
+                printf("\n=== Log Session End ===\n");
+            }
+            continue;
+        }
+
+        memcpy(&record, data + pos, sizeof(record));
+        if (have_sequence && record.sequence != expected_sequence) {
+            printf("... %u entries lost ...\n", record.sequence - expected_sequence);
+        }
+        expected_sequence = record.sequence + 1;
+        have_sequence = 1;
+
+        print_timestamp(record.timestamp_ns);
+        const decoded_site_t* site = record.site_id <= LOG_MAX_SITES ? &sites[record.site_id] : NULL;
+        if (site == NULL || !site->defined || site->arg_count < 0) {
+            printf("?: <undefined call site %u>\n", record.site_id);
+            continue;
+        }
+
+        char message[512];
+        log_format_render(site->format, site->arg_kinds, site->arg_count,
+                          record.args, record.arg_length, message, sizeof(message));
+        if (record.error_code != 0) {
+            printf("%s: %s (error %u, %s:%u)\n", log_level_name(site->level), message,
+                   record.error_code, site->function, site->line);
+        } else {
+            printf("%s: %s (%s:%u)\n", log_level_name(site->level), message,
+                   site->function, site->line);
+        }
+    }
+
+    return end;
+}
+
+/*
+ * Print "[YYYY-MM-DD HH:MM:SS.mmm] " in local time
+ */
+void print_timestamp(uint64_t timestamp_ns) {
+    time_t seconds = (time_t)(timestamp_ns / 1000000000ull);
+    unsigned milliseconds = (unsigned)(timestamp_ns / 1000000ull % 1000ull);
+    char text[32];
+    struct tm local;
+
+#ifdef _WIN32
+    local = *localtime(&seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &local);
+    printf("[%s.%03u] ", text, milliseconds);
+}
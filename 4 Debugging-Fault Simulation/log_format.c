@@ -0,0 +1,309 @@
+/*
+ * Binary Log Format
+ * =================
+ *
+ * Call-site registry, argument packing and deferred rendering for the
+ * records declared in log_format.h.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "log_format.h"
+
+// Compile-time check of the on-disk record size
+typedef char log_record_is_32_bytes[sizeof(log_record_t) == 32 ? 1 : -1];
+
+static const log_site_t* log_sites[LOG_MAX_SITES + 1];   // Indexed by ID; 0 unused
+static uint16_t log_sites_registered;
+static uint8_t log_sites_lock;
+
+/*
+ * Assign an ID to a call site on its first use.
+ * Registration is rare (once per site), so a spinlock is enough; concurrent
+ * first calls of the same site get the same ID.
+ *
+ * @return: The site ID, or 0 if the registry is full
+ */
+uint16_t log_site_register(log_site_t* site) {
+    while (__atomic_test_and_set(&log_sites_lock, __ATOMIC_ACQUIRE)) {
+        // Spin: held only for a few instructions
+    }
+
+    if (site->id == 0 && log_sites_registered < LOG_MAX_SITES) {
+        int count = log_format_parse(site->format, site->arg_kinds, LOG_SITE_MAX_ARGS);
+        site->arg_count = (uint8_t)(count < 0 ? 0 : count);
+
+        uint16_t id = (uint16_t)(log_sites_registered + 1);
+        log_sites[id] = site;
+        __atomic_store_n(&site->id, id, __ATOMIC_RELEASE);
+        __atomic_store_n(&log_sites_registered, id, __ATOMIC_RELEASE);
+    }
+
+    __atomic_clear(&log_sites_lock, __ATOMIC_RELEASE);
+    return site->id;
+}
+
+const log_site_t* log_site_get(uint16_t id) {
+    if (id == 0 || id > __atomic_load_n(&log_sites_registered, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    return log_sites[id];
+}
+
+uint16_t log_site_count(void) {
+    return __atomic_load_n(&log_sites_registered, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Encode a site definition entry; long names and formats are truncated
+ *
+ * @return: Entry length in bytes
+ */
+size_t log_site_encode(const log_site_t* site, uint8_t* out, size_t size) {
+    log_site_meta_t meta;
+    size_t offset = sizeof(meta);
+    size_t function_length = strlen(site->function) + 1;
+    size_t format_length = strlen(site->format) + 1;
+
+    if (size < offset + 2) {
+        return 0;
+    }
+    if (function_length > (size - offset) / 2) function_length = (size - offset) / 2;
+    if (format_length > size - offset - function_length) format_length = size - offset - function_length;
+
+    memcpy(out + offset, site->function, function_length);
+    out[offset + function_length - 1] = '\0';
+    offset += function_length;
+    memcpy(out + offset, site->format, format_length);
+    out[offset + format_length - 1] = '\0';
+    offset += format_length;
+
+    memset(&meta, 0, sizeof(meta));
+    meta.header.kind = LOG_META_SITE;
+    meta.header.length = (uint32_t)offset;
+    meta.site_id = site->id;
+    meta.level = site->level;
+    meta.line = (uint32_t)site->line;
+    memcpy(out, &meta, sizeof(meta));
+    return offset;
+}
+
+/*
+ * Scan one conversion specification starting just after '%'.
+ * Fills spec with the flags, width and precision (length modifiers removed)
+ * and reports the argument kind.
+ *
+ * @return: Characters consumed, or -1 for an unsupported conversion
+ */
+static int log_format_scan_spec(const char* p, char* spec, size_t spec_size, int* kind, char* conversion) {
+    const char* start = p;
+    size_t n = 0;
+    int longs = 0, size_mod = 0;
+
+    spec[n++] = '%';
+    while (*p != '\0' && strchr("-+ #0123456789.", *p) != NULL) {
+        if (n < spec_size - 2) spec[n++] = *p;
+        p++;
+    }
+    while (*p != '\0' && strchr("hlzjt", *p) != NULL) {
+        if (*p == 'l') longs++;
+        if (*p == 'j') longs = 2;
+        if (*p == 'z' || *p == 't') size_mod = 1;
+        p++;
+    }
+
+    *conversion = *p;
+    switch (*p) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+            *kind = size_mod ? LOG_ARG_SIZE : longs >= 2 ? LOG_ARG_LONG_LONG :
+                    longs == 1 ? LOG_ARG_LONG : LOG_ARG_INT;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            *kind = LOG_ARG_DOUBLE;
+            break;
+        case 's':
+            *kind = LOG_ARG_STRING;
+            break;
+        case 'p':
+            *kind = LOG_ARG_POINTER;
+            break;
+        default:
+            return -1;  // '*' widths, %n and long double are not supported
+    }
+    spec[n] = '\0';
+    return (int)(p - start) + 1;
+}
+
+/*
+ * Derive the argument kinds of a printf format string.
+ *
+ * @return: Number of arguments, or -1 if the format is unsupported
+ */
+int log_format_parse(const char* format, uint8_t* kinds, int max_kinds) {
+    int count = 0;
+    char spec[32];
+    char conversion;
+    int kind;
+
+    for (const char* p = format; *p != '\0'; p++) {
+        if (*p != '%') continue;
+        if (p[1] == '%') {
+            p++;
+            continue;
+        }
+        int used = log_format_scan_spec(p + 1, spec, sizeof(spec), &kind, &conversion);
+        if (used < 0 || count >= max_kinds) {
+            return -1;
+        }
+        kinds[count++] = (uint8_t)kind;
+        p += used;
+    }
+    return count;
+}
+
+/*
+ * Copy the raw arguments into a record's argument area.
+ * Arguments that do not fit are left out (rendered as "?"); strings are
+ * truncated to the space that is left.
+ *
+ * @return: Bytes used
+ */
+size_t log_format_pack(const uint8_t* kinds, int count, va_list args, uint8_t* out, size_t size) {
+    size_t used = 0;
+
+    for (int i = 0; i < count; i++) {
+        int32_t i32 = 0;
+        int64_t i64 = 0;
+        double d = 0.0;
+        const char* s;
+        size_t width = kinds[i] == LOG_ARG_INT ? 4 : 8;
+
+        switch (kinds[i]) {
+            case LOG_ARG_INT: i32 = va_arg(args, int); break;
+            case LOG_ARG_LONG: i64 = va_arg(args, long); break;
+            case LOG_ARG_LONG_LONG: i64 = va_arg(args, long long); break;
+            case LOG_ARG_SIZE: i64 = (int64_t)va_arg(args, size_t); break;
+            case LOG_ARG_DOUBLE: d = va_arg(args, double); break;
+            case LOG_ARG_POINTER: i64 = (int64_t)(uintptr_t)va_arg(args, void*); break;
+            case LOG_ARG_STRING:
+                s = va_arg(args, const char*);
+                if (s == NULL) s = "(null)";
+                if (used < size) {
+                    size_t length = strlen(s);
+                    if (length > size - used - 1) length = size - used - 1;
+                    if (length > 255) length = 255;
+                    out[used] = (uint8_t)length;
+                    memcpy(out + used + 1, s, length);
+                    used += 1 + length;
+                }
+                continue;
+            default:
+                return used;
+        }
+
+        if (used + width > size) {
+            continue;  // Keep consuming arguments so later kinds stay aligned
+        }
+        if (kinds[i] == LOG_ARG_INT) memcpy(out + used, &i32, 4);
+        else if (kinds[i] == LOG_ARG_DOUBLE) memcpy(out + used, &d, 8);
+        else memcpy(out + used, &i64, 8);
+        used += width;
+    }
+    return used;
+}
+
+/*
+ * Render a format string with packed arguments into text.
+ *
+ * @return: Length of the rendered text (truncated to size - 1)
+ */
+int log_format_render(const char* format, const uint8_t* kinds, int count,
+                      const uint8_t* args, size_t length, char* out, size_t size) {
+    size_t n = 0;
+    size_t offset = 0;
+    int arg = 0;
+    char spec[40];
+    char conversion;
+    int kind;
+
+    if (size == 0) return 0;
+
+    for (const char* p = format; *p != '\0' && n < size - 1; p++) {
+        if (*p != '%') {
+            out[n++] = *p;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[n++] = '%';
+            p++;
+            continue;
+        }
+
+        int used = log_format_scan_spec(p + 1, spec, sizeof(spec) - 4, &kind, &conversion);
+        if (used < 0 || arg >= count) {
+            out[n++] = '%';
+            continue;
+        }
+        p += used;
+
+        size_t spec_length = strlen(spec);
+        size_t width = kinds[arg] == LOG_ARG_INT ? 4 : kinds[arg] == LOG_ARG_STRING ? 1 : 8;
+        int written;
+        arg++;
+
+        if (offset + width > length) {
+            written = snprintf(out + n, size - n, "?");
+        } else if (kind == LOG_ARG_INT) {
+            int32_t v;
+            memcpy(&v, args + offset, 4);
+            spec[spec_length] = conversion;
+            spec[spec_length + 1] = '\0';
+            written = snprintf(out + n, size - n, spec, (int)v);
+            offset += 4;
+        } else if (kind == LOG_ARG_DOUBLE) {
+            double v;
+            memcpy(&v, args + offset, 8);
+            spec[spec_length] = conversion;
+            spec[spec_length + 1] = '\0';
+            written = snprintf(out + n, size - n, spec, v);
+            offset += 8;
+        } else if (kind == LOG_ARG_STRING) {
+            char text[LOG_RECORD_ARG_BYTES + 256];
+            size_t text_length = args[offset];
+            if (offset + 1 + text_length > length) text_length = length - offset - 1;
+            memcpy(text, args + offset + 1, text_length);
+            text[text_length] = '\0';
+            spec[spec_length] = 's';
+            spec[spec_length + 1] = '\0';
+            written = snprintf(out + n, size - n, spec, text);
+            offset += 1 + text_length;
+        } else if (kind == LOG_ARG_POINTER) {
+            int64_t v;
+            memcpy(&v, args + offset, 8);
+            written = snprintf(out + n, size - n, "%p", (void*)(uintptr_t)v);
+            offset += 8;
+        } else {
+            long long v;
+            memcpy(&v, args + offset, 8);
+            spec[spec_length] = 'l';
+            spec[spec_length + 1] = 'l';
+            spec[spec_length + 2] = conversion;
+            spec[spec_length + 3] = '\0';
+            written = snprintf(out + n, size - n, spec, v);
+            offset += 8;
+        }
+
+        if (written > 0) {
+            n += (size_t)written < size - n ? (size_t)written : size - n - 1;
+        }
+    }
+
+    out[n] = '\0';
+    return (int)n;
+}
+
+// Level names, in log_level_t order
+const char* log_level_name(uint8_t level) {
+    static const char* names[] = {"DEBUG", "INFO", "WARN", "ERROR", "CRIT"};
+    return level < sizeof(names) / sizeof(names[0]) ? names[level] : "?";
+}
@@ -0,0 +1,110 @@
+/*
+ * Binary Log Format
+ * =================
+ *
+ * Deferred-formatting log records shared by the simulator and the offline
+ * decoder (log_decode). Each LOG_* call site owns a static log_site_t with its
+ * level, format string, function and line. The site is registered on first
+ * use and gets a small numeric ID. A log record then stores only a timestamp,
+ * the site ID and the raw printf arguments. Text is produced later, when a
+ * record is displayed or decoded.
+ *
+ * File layout: a stream of entries in native byte order.
+ * - site_id != 0: a fixed-size log_record_t
+ * - site_id == 0: a metadata entry (log_meta_header_t followed by its payload):
+ *   session start, call-site definition or session end
+ * Site IDs are assigned per process, so each session carries its own site
+ * definitions. A session's definitions always precede its first record.
+ */
+
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+#define LOG_FORMAT_MAGIC 0x474C4244u      // "DBLG"
+#define LOG_FORMAT_VERSION 1
+#define LOG_RECORD_ARG_BYTES 16           // Raw argument bytes per record
+#define LOG_SITE_MAX_ARGS 8               // Conversions per format string
+#define LOG_MAX_SITES 1024                // Call sites per process
+#define LOG_SITE_META_MAX 384             // Largest encoded site definition
+
+// Argument encodings, derived from the format string's conversions
+typedef enum {
+    LOG_ARG_INT = 0,       // int and smaller (%d %u %x %c ...), 4 bytes
+    LOG_ARG_LONG = 1,      // long (%ld ...), 8 bytes
+    LOG_ARG_LONG_LONG = 2, // long long / intmax_t (%lld %jd ...), 8 bytes
+    LOG_ARG_SIZE = 3,      // size_t / ptrdiff_t (%zu %td), 8 bytes
+    LOG_ARG_DOUBLE = 4,    // double (%f %e %g ...), 8 bytes
+    LOG_ARG_STRING = 5,    // %s: 1-byte length + bytes, truncated to fit
+    LOG_ARG_POINTER = 6    // %p, 8 bytes
+} log_arg_kind_t;
+
+// One log record (32 bytes)
+typedef struct {
+    uint16_t site_id;                     // Registered call site (never 0)
+    uint8_t error_code;
+    uint8_t arg_length;                   // Bytes of args[] in use
+    uint32_t sequence;                    // Per-session counter; gaps mean lost records
+    uint64_t timestamp_ns;                // Wall clock, ns since the Unix epoch
+    uint8_t args[LOG_RECORD_ARG_BYTES];
+} log_record_t;
+
+// Metadata entry kinds
+typedef enum {
+    LOG_META_SESSION_START = 1,
+    LOG_META_SITE = 2,
+    LOG_META_SESSION_END = 3
+} log_meta_kind_t;
+
+typedef struct {
+    uint16_t zero;                        // Always 0, distinguishes metadata from records
+    uint8_t kind;
+    uint8_t reserved;
+    uint32_t length;                      // Whole entry, header included
+} log_meta_header_t;
+
+typedef struct {
+    log_meta_header_t header;
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;                 // sizeof(log_record_t) of the writer
+    uint64_t timestamp_ns;
+} log_session_meta_t;
+
+// Followed by the function name and the format string, each NUL-terminated
+typedef struct {
+    log_meta_header_t header;
+    uint16_t site_id;
+    uint8_t level;
+    uint8_t reserved;
+    uint32_t line;
+} log_site_meta_t;
+
+// Static per-call-site description; id stays 0 until the first call
+typedef struct {
+    uint16_t id;
+    uint8_t level;
+    uint8_t arg_count;                    // Conversions in format
+    int line;
+    const char* function;
+    const char* format;
+    uint8_t arg_kinds[LOG_SITE_MAX_ARGS];
+} log_site_t;
+
+// Call-site registry (simulator side)
+uint16_t log_site_register(log_site_t* site);
+const log_site_t* log_site_get(uint16_t id);
+uint16_t log_site_count(void);
+size_t log_site_encode(const log_site_t* site, uint8_t* out, size_t size);
+
+// Argument packing and rendering (shared with the decoder)
+int log_format_parse(const char* format, uint8_t* kinds, int max_kinds);
+size_t log_format_pack(const uint8_t* kinds, int count, va_list args, uint8_t* out, size_t size);
+int log_format_render(const char* format, const uint8_t* kinds, int count,
+                      const uint8_t* args, size_t length, char* out, size_t size);
+const char* log_level_name(uint8_t level);
+
+#endif // LOG_FORMAT_H
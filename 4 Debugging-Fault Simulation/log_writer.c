@@ -0,0 +1,297 @@
+/*
+ * Asynchronous Log Writer
+ * =======================
+ *
+ * Lock-free MPSC queue and the batching writer thread declared in
+ * log_writer.h.
+ */
+
+// Expose writev(), fsync(), usleep() and sched_yield() when building with -std=c99
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include "log_writer.h"
+
+#ifdef _WIN32
+#include <io.h>
+#define fsync _commit
+#else
+#include <sched.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
+
+// Compile-time check that the ring index can be masked
+typedef char log_writer_capacity_is_pow2[(LOG_WRITER_CAPACITY & (LOG_WRITER_CAPACITY - 1)) == 0 ? 1 : -1];
+
+// Compile-time check that a slot fills one cache line
+typedef char log_writer_slot_is_64_bytes[sizeof(log_writer_slot_t) == 64 ? 1 : -1];
+
+/*
+ * Write a block directly, bypassing the queue (session header and trailer).
+ */
+static void log_writer_write_direct(log_writer_t* writer, const void* data, size_t length) {
+    if (length > 0 && write(writer->fd, data, length) != (long)length) {
+        __atomic_add_fetch(&writer->write_errors, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/*
+ * Queue an entry for the writer thread. An entry larger than a slot is
+ * written to the file here instead (one write() on an O_APPEND file, so
+ * it never interleaves with a batch).
+ *
+ * @return: 0 if queued or written, -1 if the queue was full or the write
+ *          failed and the entry was dropped
+ */
+int log_writer_submit(log_writer_t* writer, const void* data, size_t length) {
+    if (length > LOG_WRITER_ENTRY_MAX) {
+        if (write(writer->fd, data, length) != (long)length) {
+            __atomic_add_fetch(&writer->write_errors, 1, __ATOMIC_RELAXED);
+            __atomic_add_fetch(&writer->dropped, 1, __ATOMIC_RELAXED);
+            return -1;
+        }
+        __atomic_add_fetch(&writer->written, 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+
+#ifdef _WIN32
+    // No writer thread on Windows: write synchronously
+    if (write(writer->fd, data, length) != (int)length) {
+        writer->write_errors++;
+        return -1;
+    }
+    writer->written++;
+    return 0;
+#else
+    uint32_t pos = __atomic_load_n(&writer->enqueue_pos, __ATOMIC_RELAXED);
+    log_writer_slot_t* slot;
+
+    // Claim the slot at enqueue_pos once the writer has released it
+    for (;;) {
+        slot = &writer->slots[pos & (LOG_WRITER_CAPACITY - 1)];
+        int32_t diff = (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&writer->enqueue_pos, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+            // pos now holds the current enqueue_pos; retry
+        } else if (diff < 0) {
+            // Slot still holds an entry from the previous lap: queue is full
+            __atomic_add_fetch(&writer->dropped, 1, __ATOMIC_RELAXED);
+            return -1;
+        } else {
+            pos = __atomic_load_n(&writer->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->length = (uint16_t)length;
+    memcpy(slot->data, data, length);
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    return 0;
+#endif
+}
+
+/*
+ * Count an entry the caller gave up on without submitting it
+ */
+void log_writer_drop(log_writer_t* writer) {
+    __atomic_add_fetch(&writer->dropped, 1, __ATOMIC_RELAXED);
+}
+
+#ifndef _WIN32
+/*
+ * Write every iovec completely, resuming after partial writes.
+ *
+ * @return: 0 on success, -1 on a write error
+ */
+static int log_writer_writev_all(int fd, struct iovec* iov, int count) {
+    while (count > 0) {
+        ssize_t done = writev(fd, iov, count);
+
+        if (done < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        while (count > 0 && (size_t)done >= iov->iov_len) {
+            done -= (ssize_t)iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char*)iov->iov_base + done;
+            iov->iov_len -= (size_t)done;
+        }
+    }
+    return 0;
+}
+
+static double log_writer_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec * 1e-6;
+}
+
+/*
+ * Writer thread: drain up to LOG_WRITER_BATCH ready entries, write them
+ * straight from their slots with one writev(), hand the slots back and
+ * apply the fsync policy. Exits once stop is set and the queue is empty.
+ */
+static void* log_writer_thread(void* arg) {
+    log_writer_t* writer = arg;
+    struct iovec iov[LOG_WRITER_BATCH];
+    double last_sync_ms = log_writer_now_ms();
+    int unsynced = 0;
+
+    for (;;) {
+        int count = 0;
+
+        while (count < LOG_WRITER_BATCH) {
+            uint32_t pos = writer->dequeue_pos + (uint32_t)count;
+            log_writer_slot_t* slot = &writer->slots[pos & (LOG_WRITER_CAPACITY - 1)];
+
+            if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1) {
+                break;
+            }
+            iov[count].iov_base = slot->data;
+            iov[count].iov_len = slot->length;
+            count++;
+        }
+
+        if (count > 0) {
+            if (log_writer_writev_all(writer->fd, iov, count) != 0) {
+                __atomic_add_fetch(&writer->write_errors, 1, __ATOMIC_RELAXED);
+            } else {
+                __atomic_add_fetch(&writer->written, (uint64_t)count, __ATOMIC_RELAXED);
+            }
+            __atomic_add_fetch(&writer->batches, 1, __ATOMIC_RELAXED);
+
+            // Hand the slots back to producers for their next lap
+            for (int i = 0; i < count; i++) {
+                uint32_t pos = writer->dequeue_pos + (uint32_t)i;
+                __atomic_store_n(&writer->slots[pos & (LOG_WRITER_CAPACITY - 1)].seq,
+                                 pos + LOG_WRITER_CAPACITY, __ATOMIC_RELEASE);
+            }
+            writer->dequeue_pos += (uint32_t)count;
+            unsynced = 1;
+
+            if (writer->fsync_policy == LOG_FSYNC_BATCH) {
+                fsync(writer->fd);
+                unsynced = 0;
+            }
+        } else if (__atomic_load_n(&writer->enqueue_pos, __ATOMIC_ACQUIRE) != writer->dequeue_pos) {
+            sched_yield();   // A producer has claimed the next slot and is still filling it
+        } else if (__atomic_load_n(&writer->stop, __ATOMIC_ACQUIRE)) {
+            break;
+        } else {
+            usleep(LOG_WRITER_IDLE_US);
+        }
+
+        if (unsynced && writer->fsync_policy == LOG_FSYNC_PERIODIC &&
+            log_writer_now_ms() - last_sync_ms >= LOG_WRITER_FSYNC_INTERVAL_MS) {
+            fsync(writer->fd);
+            last_sync_ms = log_writer_now_ms();
+            unsynced = 0;
+        }
+    }
+    return NULL;
+}
+#endif
+
+/*
+ * Open (append to) the log file, write the session header and start the
+ * writer thread.
+ *
+ * @return: 0 on success, -1 on failure (errno describes the error)
+ */
+int log_writer_start(log_writer_t* writer, const char* path, log_fsync_t policy,
+                     const void* header, size_t header_length) {
+    memset(writer, 0, sizeof(*writer));
+    writer->fsync_policy = policy;
+
+    writer->fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (writer->fd < 0) {
+        return -1;
+    }
+
+#ifndef _WIN32
+    writer->slots = malloc(sizeof(log_writer_slot_t) * LOG_WRITER_CAPACITY);
+    if (writer->slots == NULL) {
+        close(writer->fd);
+        return -1;
+    }
+    for (uint32_t i = 0; i < LOG_WRITER_CAPACITY; i++) {
+        writer->slots[i].seq = i;
+    }
+
+    log_writer_write_direct(writer, header, header_length);
+    int err = pthread_create(&writer->thread, NULL, log_writer_thread, writer);
+    if (err != 0) {
+        free(writer->slots);
+        close(writer->fd);
+        errno = err;
+        return -1;
+    }
+#else
+    log_writer_write_direct(writer, header, header_length);
+#endif
+
+    writer->active = 1;
+    return 0;
+}
+
+/*
+ * Drain the queue, stop the writer thread, append the session trailer,
+ * sync and close the file.
+ */
+void log_writer_stop(log_writer_t* writer, const void* trailer, size_t trailer_length) {
+    if (!writer->active) {
+        return;
+    }
+
+#ifndef _WIN32
+    __atomic_store_n(&writer->stop, 1, __ATOMIC_RELEASE);
+    pthread_join(writer->thread, NULL);
+    free(writer->slots);
+    writer->slots = NULL;
+#endif
+
+    log_writer_write_direct(writer, trailer, trailer_length);
+    if (writer->fsync_policy != LOG_FSYNC_NONE) {
+        fsync(writer->fd);
+    }
+    close(writer->fd);
+    writer->fd = -1;
+    writer->active = 0;
+}
+
+/*
+ * Parse an fsync policy name ("none", "batch", "periodic").
+ *
+ * @return: 0 on success, -1 for an unknown name
+ */
+int log_writer_parse_fsync(const char* name, log_fsync_t* policy) {
+    for (int p = LOG_FSYNC_NONE; p <= LOG_FSYNC_PERIODIC; p++) {
+        if (strcmp(name, log_writer_fsync_name((log_fsync_t)p)) == 0) {
+            *policy = (log_fsync_t)p;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char* log_writer_fsync_name(log_fsync_t policy) {
+    switch (policy) {
+        case LOG_FSYNC_NONE: return "none";
+        case LOG_FSYNC_BATCH: return "batch";
+        case LOG_FSYNC_PERIODIC: return "periodic";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,86 @@
+/*
+ * Asynchronous Log Writer
+ * =======================
+ *
+ * Moves log file I/O off the control loop. Producers submit encoded log
+ * entries (see log_format.h) to a bounded lock-free multi-producer/single-
+ * consumer queue; a background thread drains the queue and writes whole
+ * batches with a single writev() call.
+ *
+ * Submitting never blocks: when the queue is full the entry is dropped and
+ * counted, so a slow disk can cost log entries but never control-loop time.
+ * Every entry that was queued is in the file once the writer has drained
+ * it; dropped records show as gaps in the record sequence numbers.
+ *
+ * Slots are sized for log records (32 bytes), one cache line each. The
+ * rare larger entry, such as a call-site definition, is written straight
+ * to the file by the caller, ahead of anything still queued.
+ *
+ * Queue: bounded MPSC ring with one sequence number per slot. A producer
+ * claims a slot with a CAS on enqueue_pos and publishes it by storing
+ * seq = pos + 1; the writer consumes it and hands it back to producers by
+ * storing seq = pos + capacity.
+ */
+
+#ifndef LOG_WRITER_H
+#define LOG_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#define LOG_WRITER_CAPACITY 16384        // Queue slots (power of two): 1 MB
+#define LOG_WRITER_BATCH 256             // Entries per writev() call
+#define LOG_WRITER_ENTRY_MAX 56          // Largest queued entry; a slot is 64 bytes
+#define LOG_WRITER_IDLE_US 1000          // Writer poll interval while the queue is empty
+#define LOG_WRITER_FSYNC_INTERVAL_MS 1000
+
+// When the writer forces data to stable storage
+typedef enum {
+    LOG_FSYNC_NONE = 0,        // Leave it to the OS (fastest, loses data on power failure)
+    LOG_FSYNC_BATCH = 1,       // After every writev() batch
+    LOG_FSYNC_PERIODIC = 2     // At most once per LOG_WRITER_FSYNC_INTERVAL_MS
+} log_fsync_t;
+
+// One queued entry
+typedef struct {
+    uint32_t seq;
+    uint16_t length;
+    uint8_t data[LOG_WRITER_ENTRY_MAX];
+} log_writer_slot_t;
+
+typedef struct {
+    // Producer side (shared); padded away from the writer's fields
+    uint32_t enqueue_pos;
+    char pad0[60];
+
+    // Writer thread side
+    log_writer_slot_t* slots;
+    uint32_t dequeue_pos;
+    int fd;
+    log_fsync_t fsync_policy;
+    uint32_t stop;                   // Set by log_writer_stop()
+    uint8_t active;
+#ifndef _WIN32
+    pthread_t thread;
+#endif
+
+    // Statistics (updated atomically)
+    uint64_t written;                // Entries written to the file
+    uint64_t dropped;                // Entries lost because the queue was full or a write failed
+    uint64_t batches;                // writev() calls
+    uint64_t write_errors;
+} log_writer_t;
+
+int log_writer_start(log_writer_t* writer, const char* path, log_fsync_t policy,
+                     const void* header, size_t header_length);
+int log_writer_submit(log_writer_t* writer, const void* data, size_t length);
+void log_writer_drop(log_writer_t* writer);
+void log_writer_stop(log_writer_t* writer, const void* trailer, size_t trailer_length);
+int log_writer_parse_fsync(const char* name, log_fsync_t* policy);
+const char* log_writer_fsync_name(log_fsync_t policy);
+
+#endif // LOG_WRITER_H
@@ -0,0 +1,125 @@
+/*
+ * Process Health Metrics
+ * ======================
+ *
+ * getrusage() and /proc sampling for the metrics declared in proc_metrics.h.
+ */
+
+// Expose pread(), sysconf() and clock_gettime() when building with -std=c99
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "proc_metrics.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+#ifndef _WIN32
+static double proc_metrics_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static double timeval_seconds(struct timeval tv) {
+    return (double)tv.tv_sec + (double)tv.tv_usec * 1e-6;
+}
+
+/*
+ * Open the cached descriptors and take the baseline CPU reading.
+ *
+ * @return: 0 on success, -1 if no metrics are available
+ */
+int proc_metrics_open(proc_metrics_t* metrics) {
+    struct rusage usage;
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGESIZE);
+
+    memset(metrics, 0, sizeof(*metrics));
+    metrics->page_kb = page_size > 0 ? page_size / 1024 : 4;
+    metrics->total_memory_kb = pages > 0 ? (uint64_t)pages * (uint64_t)metrics->page_kb : 0;
+    metrics->statm_fd = open("/proc/self/statm", O_RDONLY);  // Linux only; RSS stays 0 elsewhere
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        proc_metrics_close(metrics);
+        return -1;
+    }
+    metrics->last_cpu_s = timeval_seconds(usage.ru_utime) + timeval_seconds(usage.ru_stime);
+    metrics->last_wall_s = proc_metrics_now();
+    return 0;
+}
+
+void proc_metrics_close(proc_metrics_t* metrics) {
+    if (metrics->statm_fd >= 0) {
+        close(metrics->statm_fd);
+    }
+    metrics->statm_fd = -1;
+}
+
+/*
+ * Take one sample. CPU usage covers the interval since the previous call.
+ *
+ * @return: 0 on success, -1 on failure (sample left unchanged)
+ */
+int proc_metrics_sample(proc_metrics_t* metrics, proc_sample_t* sample) {
+    struct rusage usage;
+    double now = proc_metrics_now();
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+
+    // CPU time delta over wall time delta
+    double cpu_s = timeval_seconds(usage.ru_utime) + timeval_seconds(usage.ru_stime);
+    double wall_s = now - metrics->last_wall_s;
+    if (wall_s > 0.0) {
+        sample->cpu_percent = (float)((cpu_s - metrics->last_cpu_s) / wall_s * 100.0);
+    }
+    metrics->last_cpu_s = cpu_s;
+    metrics->last_wall_s = now;
+
+    sample->voluntary_switches = (uint64_t)usage.ru_nvcsw;
+    sample->involuntary_switches = (uint64_t)usage.ru_nivcsw;
+
+    // statm: "size resident shared text lib data dt", in pages
+    if (metrics->statm_fd >= 0) {
+        char buffer[128];
+        ssize_t length = pread(metrics->statm_fd, buffer, sizeof(buffer) - 1, 0);
+
+        if (length > 0) {
+            char* field;
+            buffer[length] = '\0';
+            strtoul(buffer, &field, 10);
+            unsigned long resident = strtoul(field, NULL, 10);
+
+            sample->rss_kb = (uint32_t)(resident * (unsigned long)metrics->page_kb);
+            if (metrics->total_memory_kb > 0) {
+                sample->memory_percent = (float)(100.0 * sample->rss_kb / (double)metrics->total_memory_kb);
+            }
+        }
+    }
+    return 0;
+}
+#else
+int proc_metrics_open(proc_metrics_t* metrics) {
+    memset(metrics, 0, sizeof(*metrics));
+    metrics->statm_fd = -1;
+    return -1;
+}
+
+void proc_metrics_close(proc_metrics_t* metrics) {
+    metrics->statm_fd = -1;
+}
+
+int proc_metrics_sample(proc_metrics_t* metrics, proc_sample_t* sample) {
+    (void)metrics;
+    (void)sample;
+    return -1;
+}
+#endif
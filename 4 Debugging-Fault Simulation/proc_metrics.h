@@ -0,0 +1,40 @@
+/*
+ * Process Health Metrics
+ * ======================
+ *
+ * Cheap sampling of the simulator's own resource usage for the health check:
+ * - CPU: user + system time from getrusage(), as a share of one CPU over the
+ *   wall time since the previous sample
+ * - Memory: resident set size from /proc/self/statm against physical memory
+ * - Context switches: voluntary and involuntary, from getrusage()
+ *
+ * /proc/self/statm is opened once and re-read with pread() at offset 0, so a
+ * sample costs two system calls and no path lookups or stdio buffering.
+ */
+
+#ifndef PROC_METRICS_H
+#define PROC_METRICS_H
+
+#include <stdint.h>
+
+typedef struct {
+    float cpu_percent;               // Of one CPU since the previous sample
+    float memory_percent;            // RSS as a share of physical memory
+    uint32_t rss_kb;
+    uint64_t voluntary_switches;     // Since process start
+    uint64_t involuntary_switches;
+} proc_sample_t;
+
+typedef struct {
+    int statm_fd;                    // Cached /proc/self/statm descriptor (-1 if unavailable)
+    long page_kb;
+    uint64_t total_memory_kb;
+    double last_wall_s;              // Monotonic time of the previous sample
+    double last_cpu_s;               // Process CPU time at the previous sample
+} proc_metrics_t;
+
+int proc_metrics_open(proc_metrics_t* metrics);
+void proc_metrics_close(proc_metrics_t* metrics);
+int proc_metrics_sample(proc_metrics_t* metrics, proc_sample_t* sample);
+
+#endif // PROC_METRICS_H
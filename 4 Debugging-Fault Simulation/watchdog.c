@@ -0,0 +1,274 @@
+/*
+ * Software Watchdog
+ * =================
+ *
+ * Heartbeat registry, monitor thread and miss queue declared in
+ * watchdog.h.
+ */
+
+// Expose clock_nanosleep() when building with -std=c99
+#define _DEFAULT_SOURCE
+
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "watchdog.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Compile-time check that the event index can be masked
+typedef char watchdog_events_are_pow2[(WATCHDOG_EVENT_CAPACITY & (WATCHDOG_EVENT_CAPACITY - 1)) == 0 ? 1 : -1];
+
+/*
+ * Read the monotonic clock in nanoseconds
+ */
+uint64_t watchdog_now_ns(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/*
+ * Feed a task's heartbeat, safe from any thread. The exchange returns the
+ * previous feed, so a feed that ends an overdue gap records exactly when
+ * the gap was due and when it ended (unless the monitor has yet to take the
+ * previous record); on time, it is one clock read and one atomic exchange.
+ */
+void watchdog_feed(watchdog_t* watchdog, int task) {
+    watchdog_task_t* t = &watchdog->tasks[task];
+    uint64_t now = watchdog_now_ns();
+    uint64_t previous = __atomic_exchange_n(&t->last_feed_ns, now, __ATOMIC_ACQ_REL);
+
+    if (now > previous + t->deadline_ns && __atomic_load_n(&t->late_due_ns, __ATOMIC_RELAXED) == 0) {
+        __atomic_store_n(&t->late_feed_ns, now, __ATOMIC_RELAXED);
+        __atomic_store_n(&t->late_due_ns, previous + t->deadline_ns, __ATOMIC_RELEASE);
+    }
+}
+
+/*
+ * Register a heartbeat; its deadline starts counting now.
+ * Call after watchdog_start(), from the thread that owns the watchdog.
+ *
+ * @return: Task index for watchdog_feed(), or -1 if the registry is full
+ */
+int watchdog_register(watchdog_t* watchdog, const char* name, uint32_t deadline_us) {
+    int index = watchdog->task_count;
+
+    if (index >= WATCHDOG_MAX_TASKS) {
+        return -1;
+    }
+
+    watchdog_task_t* task = &watchdog->tasks[index];
+    memset(task, 0, sizeof(*task));
+    task->name = name;
+    task->deadline_ns = (uint64_t)deadline_us * 1000ull;
+    task->last_feed_ns = watchdog_now_ns();
+    __atomic_store_n(&watchdog->task_count, index + 1, __ATOMIC_RELEASE);
+    return index;
+}
+
+/*
+ * Publish a miss to the control loop (monitor thread only)
+ */
+static void watchdog_publish(watchdog_t* watchdog, int task, uint64_t due_ns, uint64_t detection_ns,
+                             uint64_t lateness_ns, uint8_t resumed) {
+    watchdog_task_t* t = &watchdog->tasks[task];
+    uint32_t head = watchdog->event_head;
+
+    t->reported_due_ns = due_ns;
+    if (lateness_ns > __atomic_load_n(&t->worst_lateness_ns, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&t->worst_lateness_ns, lateness_ns, __ATOMIC_RELAXED);
+    }
+    if (detection_ns > __atomic_load_n(&watchdog->worst_detection_ns, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&watchdog->worst_detection_ns, detection_ns, __ATOMIC_RELAXED);
+    }
+
+    if (head - __atomic_load_n(&watchdog->event_tail, __ATOMIC_ACQUIRE) >= WATCHDOG_EVENT_CAPACITY) {
+        __atomic_add_fetch(&watchdog->events_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    watchdog_miss_t* event = &watchdog->events[head & (WATCHDOG_EVENT_CAPACITY - 1)];
+    event->task = task;
+    event->due_ns = due_ns;
+    event->detection_ns = detection_ns;
+    event->lateness_ns = lateness_ns;
+    event->resumed = resumed;
+    __atomic_store_n(&watchdog->event_head, head + 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * Flag a missed deadline (monitor thread only)
+ */
+static void watchdog_flag(watchdog_task_t* task, uint64_t due_ns, uint64_t now) {
+    task->missed_due_ns = due_ns;
+    task->missed_detection_ns = now - due_ns;
+    __atomic_add_fetch(&task->misses, 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * Check every heartbeat against its deadline (monitor thread only).
+ * Lowers *next_wake_ns to the earliest deadline still pending.
+ */
+static void watchdog_scan(watchdog_t* watchdog, uint64_t now, uint64_t* next_wake_ns) {
+    int count = __atomic_load_n(&watchdog->task_count, __ATOMIC_ACQUIRE);
+
+    for (int i = 0; i < count; i++) {
+        watchdog_task_t* task = &watchdog->tasks[i];
+        uint64_t feed = __atomic_load_n(&task->last_feed_ns, __ATOMIC_ACQUIRE);
+        uint64_t due = feed + task->deadline_ns;
+        uint64_t late_due = __atomic_load_n(&task->late_due_ns, __ATOMIC_ACQUIRE);
+        uint64_t late_feed = __atomic_load_n(&task->late_feed_ns, __ATOMIC_RELAXED);
+
+        if (late_due != 0 && late_due <= task->reported_due_ns) {
+            // Record of a miss already reported without it: free the slot
+            __atomic_store_n(&task->late_due_ns, 0, __ATOMIC_RELEASE);
+            late_due = 0;
+        }
+
+        if (task->missed_due_ns != 0) {
+            uint64_t missed_due = task->missed_due_ns;
+
+            if (due == missed_due) {
+                // Still missing: look again within one deadline so the resume
+                // is reported before another gap can replace its record
+                if (now + task->deadline_ns < *next_wake_ns) {
+                    *next_wake_ns = now + task->deadline_ns;
+                }
+                continue;
+            }
+
+            task->missed_due_ns = 0;
+            if (late_due == missed_due && late_feed > missed_due) {
+                // Heartbeat resumed: the resuming feed recorded when
+                watchdog_publish(watchdog, i, missed_due, task->missed_detection_ns,
+                                 late_feed - missed_due, 1);
+                __atomic_store_n(&task->late_due_ns, 0, __ATOMIC_RELEASE);
+            } else {
+                // No record: the feed was timestamped before the deadline and
+                // stored after the scan, so this was not a miss. (If the record
+                // is only late to appear, the branch below reports it.)
+                __atomic_sub_fetch(&task->misses, 1, __ATOMIC_RELAXED);
+            }
+        } else if (late_due != 0 && late_feed > late_due) {
+            // Missed and resumed between two scans (monitor thread held off the CPU)
+            watchdog_flag(task, late_due, now);
+            task->missed_due_ns = 0;
+            watchdog_publish(watchdog, i, late_due, now - late_due, late_feed - late_due, 1);
+            __atomic_store_n(&task->late_due_ns, 0, __ATOMIC_RELEASE);
+        }
+
+        if (now >= due) {
+            watchdog_flag(task, due, now);
+        } else if (due < *next_wake_ns) {
+            *next_wake_ns = due;
+        }
+    }
+}
+
+#ifndef _WIN32
+/*
+ * Monitor thread: sleep until the earliest deadline (or WATCHDOG_IDLE_US),
+ * then scan. Absolute sleeps keep the wake-up from drifting past a deadline.
+ */
+static void* watchdog_thread(void* arg) {
+    watchdog_t* watchdog = arg;
+
+    while (!__atomic_load_n(&watchdog->stop, __ATOMIC_ACQUIRE)) {
+        uint64_t now = watchdog_now_ns();
+        uint64_t next_wake = now + WATCHDOG_IDLE_US * 1000ull;
+        struct timespec ts;
+
+        watchdog_scan(watchdog, now, &next_wake);
+
+        ts.tv_sec = (time_t)(next_wake / 1000000000ull);
+        ts.tv_nsec = (long)(next_wake % 1000000000ull);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+            // Interrupted by a signal: keep sleeping until the deadline
+        }
+    }
+    return NULL;
+}
+#endif
+
+/*
+ * Reset the registry and start the monitor thread.
+ *
+ * @return: 0 on success, -1 on failure (errno describes the error)
+ */
+int watchdog_start(watchdog_t* watchdog) {
+    memset(watchdog, 0, sizeof(*watchdog));
+
+#ifndef _WIN32
+    int err = pthread_create(&watchdog->thread, NULL, watchdog_thread, watchdog);
+    if (err != 0) {
+        errno = err;
+        return -1;
+    }
+#endif
+
+    watchdog->active = 1;
+    return 0;
+}
+
+/*
+ * Stop the monitor thread and publish any miss that is still open, with
+ * its lateness up to now.
+ */
+void watchdog_stop(watchdog_t* watchdog) {
+    if (!watchdog->active) {
+        return;
+    }
+
+#ifndef _WIN32
+    __atomic_store_n(&watchdog->stop, 1, __ATOMIC_RELEASE);
+    pthread_join(watchdog->thread, NULL);
+#endif
+
+    uint64_t now = watchdog_now_ns();
+    uint64_t next_wake = UINT64_MAX;
+    watchdog_scan(watchdog, now, &next_wake);
+    for (int i = 0; i < watchdog->task_count; i++) {
+        watchdog_task_t* task = &watchdog->tasks[i];
+        if (task->missed_due_ns != 0) {
+            watchdog_publish(watchdog, i, task->missed_due_ns, task->missed_detection_ns,
+                             now - task->missed_due_ns, 0);
+            task->missed_due_ns = 0;
+        }
+    }
+    watchdog->active = 0;
+}
+
+/*
+ * Take the next published miss.
+ * Windows builds have no monitor thread and scan here instead, so misses
+ * are only as precise as the polling rate.
+ *
+ * @return: 1 if a miss was returned, 0 if none is pending
+ */
+int watchdog_poll(watchdog_t* watchdog, watchdog_miss_t* miss) {
+    uint32_t tail = watchdog->event_tail;
+
+#ifdef _WIN32
+    if (watchdog->active) {
+        uint64_t next_wake = UINT64_MAX;
+        watchdog_scan(watchdog, watchdog_now_ns(), &next_wake);
+    }
+#endif
+
+    if (tail == __atomic_load_n(&watchdog->event_head, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+    *miss = watchdog->events[tail & (WATCHDOG_EVENT_CAPACITY - 1)];
+    __atomic_store_n(&watchdog->event_tail, tail + 1, __ATOMIC_RELEASE);
+    return 1;
+}
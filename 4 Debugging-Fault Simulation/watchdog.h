@@ -0,0 +1,86 @@
+/*
+ * Software Watchdog
+ * =================
+ *
+ * Per-task heartbeats checked by a dedicated monitor thread. Each task
+ * registers a heartbeat with a deadline and feeds it with
+ * watchdog_feed(): an atomic exchange of the CLOCK_MONOTONIC time in
+ * nanoseconds, so feeding costs a clock read and never blocks. The feed
+ * that ends an overdue gap records when the gap was due and when it ended,
+ * which gives the exact lateness.
+ *
+ * The monitor thread sleeps until the earliest deadline (absolute
+ * clock_nanosleep(), so misses are flagged within microseconds) and flags
+ * a task whose heartbeat has not moved by then. When the heartbeat resumes,
+ * the miss is published with its lateness on a single-producer queue that
+ * the control loop drains with watchdog_poll(). Misses still open at
+ * watchdog_stop() are published with their lateness so far.
+ *
+ * Each task holds one overdue-gap record until the monitor takes it, so if
+ * the monitor thread is kept off the CPU for longer than a deadline, a
+ * second overdue gap in that window goes unreported.
+ */
+
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#define WATCHDOG_MAX_TASKS 8
+#define WATCHDOG_EVENT_CAPACITY 32      // Published misses awaiting watchdog_poll() (power of two)
+#define WATCHDOG_IDLE_US 10000          // Longest monitor sleep; bounds how soon a resumed heartbeat is reported
+
+// One registered heartbeat
+typedef struct {
+    const char* name;
+    uint64_t deadline_ns;            // Longest allowed gap between feeds
+    uint64_t last_feed_ns;           // Written by the task, read by the monitor thread
+    uint64_t missed_due_ns;          // Monitor thread only: deadline currently missed, 0 if none
+    uint64_t missed_detection_ns;    // Monitor thread only: how long after it the miss was flagged
+    uint64_t reported_due_ns;        // Monitor thread only: deadline of the last published miss
+    uint64_t late_due_ns;            // Set by the feed that ends an overdue gap: when the gap was due
+                                     // (cleared by the monitor once taken; 0 = free)
+    uint64_t late_feed_ns;           // ... and when that feed arrived
+    uint32_t misses;                 // Updated atomically
+    uint64_t worst_lateness_ns;      // Updated atomically
+} watchdog_task_t;
+
+// A missed deadline, as published to watchdog_poll()
+typedef struct {
+    int task;
+    uint64_t due_ns;                 // Monotonic time the heartbeat was due
+    uint64_t detection_ns;           // How long after due_ns the monitor flagged the miss
+    uint64_t lateness_ns;            // How long after due_ns it arrived
+    uint8_t resumed;                 // 0 if the task had still not fed at watchdog_stop()
+} watchdog_miss_t;
+
+typedef struct {
+    watchdog_task_t tasks[WATCHDOG_MAX_TASKS];
+    int task_count;                  // Published with release after the task is set up
+
+    // Miss queue: monitor thread produces, control loop consumes
+    watchdog_miss_t events[WATCHDOG_EVENT_CAPACITY];
+    uint32_t event_head;             // Next slot to publish
+    uint32_t event_tail;             // Next slot to consume
+    uint64_t events_dropped;
+
+    uint64_t worst_detection_ns;     // Longest delay between a deadline and its flag
+    uint32_t stop;
+    uint8_t active;
+#ifndef _WIN32
+    pthread_t thread;
+#endif
+} watchdog_t;
+
+int watchdog_start(watchdog_t* watchdog);
+void watchdog_stop(watchdog_t* watchdog);
+int watchdog_register(watchdog_t* watchdog, const char* name, uint32_t deadline_us);
+void watchdog_feed(watchdog_t* watchdog, int task);
+int watchdog_poll(watchdog_t* watchdog, watchdog_miss_t* miss);
+uint64_t watchdog_now_ns(void);
+
+#endif // WATCHDOG_H
@@ -0,0 +1,204 @@
+/*
+ * Atomic File Writer
+ * ==================
+ *
+ * Buffered temp-file writes, fsync and rename declared in atomic_file.h.
+ */
+
+// Expose fsync() when building with -std=c99
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "atomic_file.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#define fsync _commit
+#else
+#include <unistd.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+static void release(atomic_file_t* file) {
+    free(file->path);
+    free(file->temp_path);
+    free(file->buffer);
+    memset(file, 0, sizeof(*file));
+    file->fd = -1;
+}
+
+/*
+ * Write all of data, resuming after partial writes and interruptions
+ *
+ * @return: 0 on success, -1 on a write error
+ */
+static int write_all(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        long written = (long)write(fd, data, (unsigned)(length < ATOMIC_FILE_BUFFER ? length : ATOMIC_FILE_BUFFER));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+    return 0;
+}
+
+/*
+ * Write out the buffer
+ *
+ * @return: 0 on success, -1 if this or an earlier write failed
+ */
+static int flush(atomic_file_t* file) {
+    if (!file->failed && file->used > 0 && write_all(file->fd, file->buffer, file->used) != 0) {
+        file->failed = 1;
+    }
+    file->used = 0;
+    return file->failed ? -1 : 0;
+}
+
+/*
+ * Start replacing path: create (or truncate) its temp file
+ *
+ * @return: 0 on success, -1 if the temp file cannot be created
+ */
+int atomic_file_open(atomic_file_t* file, const char* path) {
+    size_t length = strlen(path);
+
+    memset(file, 0, sizeof(*file));
+    file->fd = -1;
+    file->path = malloc(length + 1);
+    file->temp_path = malloc(length + 5);
+    file->buffer = malloc(ATOMIC_FILE_BUFFER);
+    if (file->path == NULL || file->temp_path == NULL || file->buffer == NULL) {
+        release(file);
+        return -1;
+    }
+    memcpy(file->path, path, length + 1);
+    memcpy(file->temp_path, path, length);
+    memcpy(file->temp_path + length, ".tmp", 5);
+    file->capacity = ATOMIC_FILE_BUFFER;
+
+    file->fd = open(file->temp_path, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+    if (file->fd < 0) {
+        release(file);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Make room for length bytes in the buffer, writing it out first if needed.
+ * Fill some or all of the space, then call atomic_file_advance().
+ *
+ * @return: Where to put the bytes, or NULL if memory is exhausted
+ */
+char* atomic_file_reserve(atomic_file_t* file, size_t length) {
+    if (file->used + length > file->capacity) {
+        flush(file);
+    }
+    if (length > file->capacity) {
+        char* buffer = realloc(file->buffer, length);
+        if (buffer == NULL) {
+            file->failed = 1;
+            return NULL;
+        }
+        file->buffer = buffer;
+        file->capacity = length;
+    }
+    return file->buffer + file->used;
+}
+
+/*
+ * Keep length bytes written at the pointer atomic_file_reserve() returned
+ */
+void atomic_file_advance(atomic_file_t* file, size_t length) {
+    file->used += length;
+}
+
+/*
+ * @return: 0 on success, -1 if memory is exhausted
+ */
+int atomic_file_write(atomic_file_t* file, const void* data, size_t length) {
+    char* dest = atomic_file_reserve(file, length);
+
+    if (dest == NULL) {
+        return -1;
+    }
+    memcpy(dest, data, length);
+    atomic_file_advance(file, length);
+    return 0;
+}
+
+/*
+ * Finish the temp file, make it durable and rename it over the original.
+ * The file is closed either way.
+ *
+ * @return: 0 if path now holds the new contents, -1 if it is unchanged
+ */
+int atomic_file_commit(atomic_file_t* file) {
+    int result = flush(file);
+
+    if (result == 0 && fsync(file->fd) != 0) {
+        result = -1;
+    }
+    if (close(file->fd) != 0) {
+        result = -1;
+    }
+    file->fd = -1;
+
+#ifdef _WIN32
+    if (result == 0 && !MoveFileExA(file->temp_path, file->path,
+                                    MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        result = -1;
+    }
+#else
+    if (result == 0 && rename(file->temp_path, file->path) != 0) {
+        result = -1;
+    }
+    if (result == 0) {
+        // Make the rename durable: sync the directory holding path
+        char* slash = strrchr(file->path, '/');
+        int dir;
+        if (slash == NULL) {
+            dir = open(".", O_RDONLY);
+        } else {
+            *slash = '\0';
+            dir = open(slash == file->path ? "/" : file->path, O_RDONLY);
+            *slash = '/';
+        }
+        if (dir >= 0) {
+            fsync(dir);
+            close(dir);
+        }
+    }
+#endif
+
+    if (result != 0) {
+        remove(file->temp_path);
+    }
+    release(file);
+    return result;
+}
+
+/*
+ * Give up: remove the temp file and leave the original untouched
+ */
+void atomic_file_abort(atomic_file_t* file) {
+    if (file->fd >= 0) {
+        close(file->fd);
+        remove(file->temp_path);
+    }
+    release(file);
+}
@@ -0,0 +1,48 @@
+/*
+ * Atomic File Writer
+ * ==================
+ *
+ * Replaces a file so that a crash at any point leaves either the old file
+ * or the complete new one, never a mix or a truncated file:
+ *
+ *   1. The new contents go to "<path>.tmp", through a large user-space
+ *      buffer that is written out with one write() call per
+ *      ATOMIC_FILE_BUFFER bytes.
+ *   2. atomic_file_commit() writes the rest, fsync()s the temp file and
+ *      renames it over path. rename() replaces the name in one step.
+ *   3. The directory is fsync()ed so the rename itself survives a power
+ *      failure (POSIX only).
+ *
+ * If anything fails, or atomic_file_abort() is called, the temp file is
+ * removed and path is left untouched. A temp file left by a crash is
+ * overwritten by the next save.
+ *
+ * Two processes saving the same path at once share the temp file, so saves
+ * must not run concurrently.
+ */
+
+#ifndef ATOMIC_FILE_H
+#define ATOMIC_FILE_H
+
+#include <stddef.h>
+
+#define ATOMIC_FILE_BUFFER (1u << 20)    // Bytes buffered per write() call
+
+typedef struct {
+    char* path;                          // Final name
+    char* temp_path;                     // "<path>.tmp"
+    int fd;
+    char* buffer;
+    size_t used;
+    size_t capacity;
+    int failed;                          // A write failed; commit will not replace path
+} atomic_file_t;
+
+int atomic_file_open(atomic_file_t* file, const char* path);
+char* atomic_file_reserve(atomic_file_t* file, size_t length);
+void atomic_file_advance(atomic_file_t* file, size_t length);
+int atomic_file_write(atomic_file_t* file, const void* data, size_t length);
+int atomic_file_commit(atomic_file_t* file);
+void atomic_file_abort(atomic_file_t* file);
+
+#endif // ATOMIC_FILE_H
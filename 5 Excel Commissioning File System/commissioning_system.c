@@ -15,283 +15,2223 @@
  * - Modular programming principles
  */
 
+// Expose clock_gettime() when building with -std=c99
+#define _DEFAULT_SOURCE
+
 #include <stdio.h>      // Standard I/O functions (printf, scanf, fopen, etc.)
 #include <stdlib.h>     // Memory allocation and utility functions
 #include <string.h>     // String manipulation functions
 #include <stdbool.h>    // Boolean data type support
+#include <stdint.h>     // Fixed-width integer types
+#include <time.h>       // Benchmark timing
+#include "profiler.h"   // Hot-path profiler shared by all projects (../common)
+#include "csv_map.h"    // Memory-mapped CSV reader
+#include "param_store.h" // Hash-indexed parameter table
+#include "param_value.h" // Typed parameter values
+#include "schema.h"      // Parameter rules and constraints
+#include "parallel_load.h" // Multi-threaded file loading
+#include "atomic_file.h"   // Crash-safe file replacement
+#include "journal.h"       // Delta saves
+#include "config_image.h"  // Compiled start-up image
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>         // Batch mode: _dup() and _dup2() on stdout
+#define dup _dup
+#define dup2 _dup2
+#define close _close
+#define fileno _fileno
+#else
+#include <signal.h>     // Crash test: kill() a saving process
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// System configuration constants
+#define MAX_LINE_LENGTH 256      // Maximum length of a CSV line
+#define MAX_NAME_LENGTH 32       // Maximum length for parameter names and values
+#define COMMISSIONING_FILE "system_config.csv"  // Default commissioning file name
+#define SCHEMA_FILE "parameter_schema.csv"      // Parameter types, limits and constraints
+#define IMAGE_FILE "system_config.img"          // Commissioning file compiled for fast start-up
+#define MAX_LISTED_VIOLATIONS 20 // Violations printed in full; the rest are counted
+#define MAX_LISTED_DIFFERENCES 50 // Differences printed in full; the rest are counted
+#define STDIN_SCRIPT "-"         // --batch reads the script from standard input
+
+/*
+ * Main structure representing the commissioning system
+ * Contains all parameters and system state information
+ */
+typedef struct {
+    param_store_t store;                           // Parameters, indexed by name (param_store.h)
+    schema_t schema;                               // Rules for the parameters (schema.h)
+    journal_t journal;                             // Changes saved since the file was written (journal.h)
+    char system_name[MAX_NAME_LENGTH];             // Name of the control system
+    bool is_loaded;                               // Loaded from (or saved to) file: the file and journal hold the store
+} commissioning_system_t;
+
+/*
+ * Types and safe operating ranges of the known parameters, used when there
+ * is no schema file
+ * Critical for embedded systems to prevent hardware damage or unsafe operation
+ * Parameters not listed take any value (extensible design)
+ */
+static const param_rule_t parameter_rules[] = {
+    {"motor_speed_rpm", PARAM_TYPE_INT, 0, 3000, NULL, 0, NULL},       // Realistic motor limits (RPM)
+    {"temperature_limit", PARAM_TYPE_INT, 0, 100, NULL, 0, NULL},      // Safe operating temperatures (°C)
+    {"pressure_setpoint", PARAM_TYPE_FLOAT, 0.0, 10.0, NULL, 0, NULL}, // Typical system limits (bar)
+};
+
+/*
+ * Load the schema file, or fall back to the built-in rules
+ */
+static void load_schema(commissioning_system_t* system) {
+    memset(&system->schema, 0, sizeof(system->schema));
+    if (schema_load(&system->schema, SCHEMA_FILE) == 0) {
+        printf("Schema: %u rules, %u constraints from %s\n", system->schema.rule_count,
+               system->schema.constraint_count, SCHEMA_FILE);
+        return;
+    }
+
+    printf("Schema file not found. Using built-in limits.\n");
+    for (size_t r = 0; r < sizeof(parameter_rules) / sizeof(parameter_rules[0]); r++) {
+        schema_add_rule(&system->schema, &parameter_rules[r]);
+    }
+}
+
+/*
+ * @return: The rule for a parameter, or NULL if it has none
+ */
+static const param_rule_t* find_rule(const commissioning_system_t* system, const char* name) {
+    return schema_find(&system->schema, name, strlen(name));
+}
+
+/*
+ * Parse and check a parameter's value text once, keeping the text for
+ * display and saving and the typed value for everything else
+ *
+ * @return: true if the value is valid for the parameter
+ */
+static bool set_parameter_value(system_parameter_t* parameter, const char* text) {
+    snprintf(parameter->value, sizeof(parameter->value), "%s", text);
+    parameter->is_valid = param_value_parse(parameter->rule, parameter->value, &parameter->typed);
+    return parameter->is_valid;
+}
+
+/*
+ * Add a parameter with all its fields, or return NULL if the name is taken
+ * The pointer is valid until the next parameter is added
+ */
+static system_parameter_t* store_parameter(commissioning_system_t* system, const char* name,
+                                           const char* value, const char* unit,
+                                           const char* description) {
+    bool added;
+    uint32_t id = param_store_insert(&system->store, name, strlen(name), &added);
+    if (!added) {
+        return NULL;
+    }
+
+    system_parameter_t* parameter = &system->store.parameters[id];
+    snprintf(parameter->value, sizeof(parameter->value), "%s", value);
+    schema_resolve(&system->schema, parameter);   // Finds its rule and parses the value
+    parameter->is_valid = param_value_check(parameter->rule, &parameter->typed);
+    snprintf(parameter->unit, sizeof(parameter->unit), "%s", unit);
+    snprintf(parameter->description, sizeof(parameter->description), "%s", description);
+    return parameter;
+}
+
+/*
+ * Initialize the commissioning system with default values
+ * This function sets up the system with some sample parameters for demonstration
+ * In a real embedded system, these might be loaded from EEPROM or flash memory
+ */
+void init_commissioning_system(commissioning_system_t* system, const char* name) {
+    // Reset system state
+    memset(&system->store, 0, sizeof(system->store));   // Start with no parameters
+    system->is_loaded = false;          // Not loaded from file yet
+    journal_init(&system->journal, COMMISSIONING_FILE);
+    strcpy(system->system_name, name);  // Set the system name
+    load_schema(system);                // Rules the parameters are checked against
+
+    // Add some default parameters for demonstration
+    // Parameter 1: Motor speed control
+    store_parameter(system, "motor_speed_rpm", "1500", "RPM", "Motor operating speed");
+
+    // Parameter 2: Temperature safety limit
+    store_parameter(system, "temperature_limit", "85", "Celsius", "Maximum temperature limit");
+
+    // Parameter 3: Pressure control setpoint
+    store_parameter(system, "pressure_setpoint", "2.5", "bar", "Pressure control setpoint");
+}
+
+/*
+ * Write every parameter to a commissioning CSV file, replacing it
+ * atomically: rows are formatted into a large buffer, written to a temp
+ * file, synced and renamed over path (atomic_file.h)
+ *
+ * @return: 0 on success, -1 if the file could not be written (the old one is kept)
+ */
+static int write_commissioning_csv(const param_store_t* store, const char* path) {
+    static const char header[] = "Parameter,Value,Unit,Description,Valid\n";
+    atomic_file_t file;
+
+    if (atomic_file_open(&file, path) != 0) {
+        return -1;
+    }
+    atomic_file_write(&file, header, sizeof(header) - 1);
+
+    // Write each parameter (fields with commas or quotes are quoted)
+    for (uint32_t i = 0; i < store->count; i++) {
+        const system_parameter_t* parameter = &store->parameters[i];
+        size_t longest = CSV_FIELD_MAX(strlen(parameter->name)) + 3 * CSV_FIELD_MAX(PARAM_TEXT_LENGTH) + 16;
+        char* row = atomic_file_reserve(&file, longest);
+        if (row == NULL) {
+            atomic_file_abort(&file);
+            return -1;
+        }
+
+        const char* fields[] = {parameter->name, parameter->value, parameter->unit,
+                                parameter->description, parameter->is_valid ? "true" : "false"};
+        atomic_file_advance(&file, csv_format_row(row, fields, 5));
+    }
+
+    return atomic_file_commit(&file);
+}
+
+/*
+ * Save the commissioning parameters to a CSV file
+ * A file that was loaded (or saved) gets only the changes since then,
+ * appended to its journal; otherwise the whole file is written. A crash
+ * during either leaves the previous state intact.
+ */
+bool save_commissioning_file(commissioning_system_t* system) {
+    PROFILE_SCOPE("save_commissioning_file");
+    param_store_t* store = &system->store;
+
+    if (system->is_loaded) {
+        if (store->change_count == 0) {
+            printf("No changes to save\n");
+            return true;
+        }
+        if (journal_append(&system->journal, store) != 0) {
+            printf("Error: Cannot write %s; changes are not saved\n", system->journal.path);
+            return false;
+        }
+        printf("Saved %u changed parameters to %s\n", store->change_count, system->journal.path);
+        param_store_clear_changes(store);
+        if (journal_maybe_compact(&system->journal)) {
+            printf("Compacting the journal into %s in the background\n", system->journal.file_path);
+        }
+        return true;
+    }
+
+    // Any journal belongs to a file this store was not loaded from
+    journal_discard(&system->journal);
+    if (write_commissioning_csv(store, COMMISSIONING_FILE) != 0) {
+        printf("Error: Cannot write commissioning file; the previous file is unchanged\n");
+        return false;
+    }
+    param_store_clear_changes(store);
+    system->is_loaded = true;
+    printf("Commissioning file saved successfully: %s\n", COMMISSIONING_FILE);
+    return true;
+}
+
+/*
+ * Print one constraint that does not hold
+ */
+static void print_constraint_violation(const commissioning_system_t* system, uint32_t index,
+                                       const char* prefix) {
+    const schema_constraint_t* constraint = &system->schema.constraints[index];
+    double left, right;
+
+    if (schema_evaluate(&system->schema, index, &system->store, &left, &right) < 0) {
+        printf("%sConstraint '%s' (schema line %u) names an undefined parameter\n",
+               prefix, constraint->text, constraint->line);
+    } else {
+        printf("%sConstraint '%s' (schema line %u) violated: %g vs %g\n",
+               prefix, constraint->text, constraint->line, left, right);
+    }
+}
+
+/*
+ * Check every parameter and constraint against the schema in one pass and
+ * report all violations together
+ *
+ * @return: Number of violations
+ */
+uint32_t validate_all_parameters(commissioning_system_t* system) {
+    PROFILE_SCOPE("validate_all_parameters");
+    schema_report_t report = {0};
+
+    schema_validate(&system->schema, &system->store, &report);
+
+    uint32_t total = 0;
+    for (int kind = 0; kind < SCHEMA_VIOLATION_KINDS; kind++) {
+        total += report.by_kind[kind];
+    }
+    printf("Validation: %u parameters checked against the schema, %u constraints, %u violations\n",
+           report.checked, system->schema.constraint_count, total);
+    if (total > 0) {
+        printf("  Type: %u  Range: %u  Unit: %u  Constraint: %u  Undefined parameter: %u\n",
+               report.by_kind[SCHEMA_VIOLATION_TYPE], report.by_kind[SCHEMA_VIOLATION_RANGE],
+               report.by_kind[SCHEMA_VIOLATION_UNIT], report.by_kind[SCHEMA_VIOLATION_CONSTRAINT],
+               report.by_kind[SCHEMA_VIOLATION_MISSING]);
+    }
+
+    for (uint32_t k = 0; k < report.count && k < MAX_LISTED_VIOLATIONS; k++) {
+        const schema_violation_t* violation = &report.items[k];
+        if (violation->kind == SCHEMA_VIOLATION_CONSTRAINT || violation->kind == SCHEMA_VIOLATION_MISSING) {
+            print_constraint_violation(system, violation->id, "  ");
+            continue;
+        }
+
+        const system_parameter_t* parameter = &system->store.parameters[violation->id];
+        const param_rule_t* rule = parameter->rule;
+        if (violation->kind == SCHEMA_VIOLATION_UNIT) {
+            printf("  %s: unit '%s' should be '%s'\n", parameter->name, parameter->unit, rule->unit);
+        } else if (violation->kind == SCHEMA_VIOLATION_RANGE) {
+            printf("  %s = %s: outside %g..%g\n", parameter->name, parameter->value, rule->min, rule->max);
+        } else if (rule->type == PARAM_TYPE_ENUM) {
+            printf("  %s = '%s': not one of", parameter->name, parameter->value);
+            for (uint32_t e = 0; e < rule->enum_count; e++) {
+                printf("%s%s", e ? "|" : " ", rule->enum_names[e]);
+            }
+            printf("\n");
+        } else {
+            printf("  %s = '%s': not a valid %s\n", parameter->name, parameter->value,
+                   rule->type == PARAM_TYPE_INT ? "integer" : rule->type == PARAM_TYPE_FLOAT ? "number" : "bool");
+        }
+    }
+    if (report.count > MAX_LISTED_VIOLATIONS) {
+        printf("  ... and %u more\n", report.count - MAX_LISTED_VIOLATIONS);
+    }
+
+    schema_report_free(&report);
+    return total;
+}
+
+/*
+ * Warn about constraints a change has broken
+ */
+static void check_constraints(const commissioning_system_t* system) {
+    for (uint32_t c = 0; c < system->schema.constraint_count; c++) {
+        double left, right;
+        if (schema_evaluate(&system->schema, c, &system->store, &left, &right) == 0) {
+            print_constraint_violation(system, c, "Warning: ");
+        }
+    }
+}
+
+/*
+ * Copy one CSV field into a fixed-size parameter field, warning if it is cut
+ */
+static void copy_field(char* dest, const csv_row_t* row, uint32_t column, const char* column_name) {
+    if (column >= row->field_count || column >= CSV_MAP_MAX_FIELDS) {
+        dest[0] = '\0';   // Short row: leave the column empty
+        return;
+    }
+    if (csv_field_copy(&row->fields[column], dest, PARAM_TEXT_LENGTH) >= PARAM_TEXT_LENGTH) {
+        printf("Warning: Line %u: %s truncated to %d characters\n",
+               row->line, column_name, PARAM_TEXT_LENGTH - 1);
+    }
+}
+
+/*
+ * Read a commissioning file and then its journal into the store. The store
+ * is emptied only once the file has opened, so a missing file leaves the
+ * parameters it already holds.
+ *
+ * @return: Changes applied from the journal, or -1 if the file cannot be read
+ */
+static long read_commissioning_file(const char* path, const schema_t* schema, journal_t* journal,
+                                    param_store_t* store, parallel_load_stats_t* stats) {
+    csv_map_t map;
+    csv_row_t row;
+    uint32_t applied = 0;
+
+    if (csv_map_open(&map, path) != 0) {
+        return -1;
+    }
+
+    // Skip header line
+    if (!csv_map_next_row(&map, &row)) {
+        csv_map_close(&map);
+        return -1;
+    }
+
+    // Read parameter lines
+    param_store_clear(store);
+    parallel_load(&map, schema, store, parallel_load_threads(), stats);
+    csv_map_close(&map);
+
+    if (journal_replay(journal, schema, store, &applied) != 0) {
+        printf("Error: Out of memory applying %s\n", journal->path);
+    }
+    return (long)applied;
+}
+
+/*
+ * Stamp the files an image of the commissioning file is compiled from: the
+ * file, its journals and the schema
+ */
+static void stamp_image_sources(const journal_t* journal, config_image_stamp_t stamps[CONFIG_IMAGE_SOURCES]) {
+    config_image_stamp(journal->file_path, &stamps[0]);
+    config_image_stamp(journal->path, &stamps[1]);
+    config_image_stamp(journal->rotated_path, &stamps[2]);
+    config_image_stamp(SCHEMA_FILE, &stamps[3]);
+}
+
+/*
+ * Open the compiled image, saying why when it cannot be used
+ *
+ * @return: true if it is open and up to date
+ */
+static bool open_image(const journal_t* journal, config_image_t* image) {
+    config_image_stamp_t stamps[CONFIG_IMAGE_SOURCES];
+
+    stamp_image_sources(journal, stamps);
+    config_image_status_t status = config_image_open(image, IMAGE_FILE, stamps, CONFIG_IMAGE_SOURCES);
+    if (status == CONFIG_IMAGE_STALE) {
+        printf("Warning: %s is out of date; reading %s\n", IMAGE_FILE, COMMISSIONING_FILE);
+    } else if (status == CONFIG_IMAGE_INVALID) {
+        printf("Warning: %s is not a valid image; reading %s\n", IMAGE_FILE, COMMISSIONING_FILE);
+    }
+    return status == CONFIG_IMAGE_OK;
+}
+
+/*
+ * Load commissioning parameters from a CSV file
+ * The file is mapped (csv_map.h) and large files are split, parsed and
+ * checked on several threads (parallel_load.h); only the fields kept in a
+ * parameter are copied out of the mapping. Changes saved to the journal
+ * since the file was written are applied on top. The compiled image is not
+ * used here: copying it into a store is no faster than parsing the file
+ * (--bench image), so it only serves readers that look up in place.
+ */
+bool load_commissioning_file(commissioning_system_t* system) {
+    PROFILE_SCOPE("load_commissioning_file");
+    parallel_load_stats_t stats = {0};
+
+    journal_wait(&system->journal);   // A compaction may be rewriting the file
+    long applied = read_commissioning_file(COMMISSIONING_FILE, &system->schema, &system->journal,
+                                           &system->store, &stats);
+    if (applied < 0) {
+        printf("Commissioning file not found. Using default parameters.\n");
+        return false;
+    }
+
+    system->is_loaded = true;
+    if (stats.threads > 1) {
+        printf("Loaded %u parameters from commissioning file (%u threads)\n", stats.added, stats.threads);
+    } else {
+        printf("Loaded %u parameters from commissioning file\n", stats.added);
+    }
+    if (applied > 0) {
+        printf("Applied %ld saved changes from %s\n", applied, system->journal.path);
+    }
+    validate_all_parameters(system);
+    return true;
+}
+
+/*
+ * Compile the parameters into IMAGE_FILE for fast start-up. They must be
+ * exactly what the commissioning file and journal hold (loaded or saved,
+ * with no unsaved changes) and pass validation.
+ *
+ * @return: true if the image was written
+ */
+bool compile_commissioning_image(commissioning_system_t* system) {
+    PROFILE_SCOPE("compile_commissioning_image");
+    config_image_stamp_t stamps[CONFIG_IMAGE_SOURCES];
+    schema_report_t report = {0};
+
+    if (!system->is_loaded || system->store.change_count > 0) {
+        printf("Error: Save the parameters before compiling %s\n", IMAGE_FILE);
+        return false;
+    }
+    journal_wait(&system->journal);   // The image is stamped with the compacted file
+    stamp_image_sources(&system->journal, stamps);
+
+    schema_validate(&system->schema, &system->store, &report);
+    uint32_t violations = 0;
+    for (int kind = 0; kind < SCHEMA_VIOLATION_KINDS; kind++) {
+        violations += report.by_kind[kind];
+    }
+    schema_report_free(&report);
+    if (violations > 0) {
+        printf("Error: %u violations; %s not compiled\n", violations, IMAGE_FILE);
+        return false;
+    }
+
+    if (config_image_write(&system->store, IMAGE_FILE, stamps, CONFIG_IMAGE_SOURCES) != 0) {
+        printf("Error: Cannot write %s; the previous image is unchanged\n", IMAGE_FILE);
+        return false;
+    }
+    printf("Compiled %u parameters into %s\n", system->store.count, IMAGE_FILE);
+    return true;
+}
+
+/*
+ * Print "name = value unit" for a script; the unit is left out when empty
+ */
+static void print_parameter_line(const char* name, const char* value, const char* unit) {
+    if (unit[0] != '\0') {
+        printf("%s = %s %s\n", name, value, unit);
+    } else {
+        printf("%s = %s\n", name, value);
+    }
+}
+
+/*
+ * Print parameters for scripts, looked up in place in the compiled image
+ * when it is up to date and read from the commissioning file otherwise
+ *
+ * @return: Process exit code: 0 if every name was found, 1 if not
+ */
+int get_parameters(char* const* names, int count) {
+    journal_t journal;
+    config_image_t image;
+    int missing = 0;
+
+    if (journal_init(&journal, COMMISSIONING_FILE) != 0) {
+        return 1;
+    }
+    if (open_image(&journal, &image)) {
+        for (int n = 0; n < count; n++) {
+            uint32_t id = config_image_find(&image, names[n], strlen(names[n]));
+            if (id == CONFIG_IMAGE_NONE) {
+                printf("Error: Parameter '%s' not found\n", names[n]);
+                missing++;
+                continue;
+            }
+            const config_image_record_t* record = &image.records[id];
+            print_parameter_line(names[n], config_image_text(&image, record->value),
+                                 config_image_text(&image, record->unit));
+        }
+        config_image_close(&image);
+    } else {
+        param_store_t store = {0};
+        schema_t schema = {0};   // Values as saved
+        parallel_load_stats_t stats;
+
+        if (read_commissioning_file(COMMISSIONING_FILE, &schema, &journal, &store, &stats) < 0) {
+            printf("Error: Cannot read %s\n", COMMISSIONING_FILE);
+            missing = count;
+        }
+        for (int n = 0; missing < count && n < count; n++) {
+            uint32_t id = param_store_find(&store, names[n], strlen(names[n]));
+            if (id == PARAM_STORE_NONE) {
+                printf("Error: Parameter '%s' not found\n", names[n]);
+                missing++;
+                continue;
+            }
+            print_parameter_line(names[n], store.parameters[id].value, store.parameters[id].unit);
+        }
+        param_store_free(&store);
+    }
+    journal_free(&journal);
+    return missing > 0 ? 1 : 0;
+}
+
+/*
+ * Print the differences from one set of parameters to another: parameters
+ * added, removed, and changed in value, unit or description
+ *
+ * @return: Number of differences
+ */
+static uint32_t diff_parameters(const param_store_t* from, const param_store_t* to) {
+    uint32_t added = 0, removed = 0, changed = 0;
+
+    for (uint32_t id = 0; id < to->count; id++) {
+        const system_parameter_t* after = &to->parameters[id];
+        uint32_t old_id = param_store_find(from, after->name, strlen(after->name));
+        bool listed = added + removed + changed < MAX_LISTED_DIFFERENCES;
+
+        if (old_id == PARAM_STORE_NONE) {
+            if (listed) {
+                printf("+ %s = %s %s\n", after->name, after->value, after->unit);
+            }
+            added++;
+            continue;
+        }
+
+        const system_parameter_t* before = &from->parameters[old_id];
+        bool value = strcmp(before->value, after->value) != 0;
+        bool unit = strcmp(before->unit, after->unit) != 0;
+        bool description = strcmp(before->description, after->description) != 0;
+        if (!value && !unit && !description) {
+            continue;
+        }
+        if (listed) {
+            printf("~ %s:", after->name);
+            if (value) printf(" value '%s' -> '%s'", before->value, after->value);
+            if (unit) printf(" unit '%s' -> '%s'", before->unit, after->unit);
+            if (description) printf(" description '%s' -> '%s'", before->description, after->description);
+            printf("\n");
+        }
+        changed++;
+    }
+
+    for (uint32_t id = 0; id < from->count; id++) {
+        const system_parameter_t* before = &from->parameters[id];
+        if (param_store_find(to, before->name, strlen(before->name)) == PARAM_STORE_NONE) {
+            if (added + removed + changed < MAX_LISTED_DIFFERENCES) {
+                printf("- %s = %s %s\n", before->name, before->value, before->unit);
+            }
+            removed++;
+        }
+    }
+
+    uint32_t total = added + removed + changed;
+    if (total > MAX_LISTED_DIFFERENCES) {
+        printf("  ... and %u more\n", total - MAX_LISTED_DIFFERENCES);
+    }
+    printf("Diff: %u added, %u removed, %u changed\n", added, removed, changed);
+    return total;
+}
+
+/*
+ * Read a commissioning file (with its journal) for comparing
+ *
+ * @return: true if it was read
+ */
+static bool read_snapshot(const char* path, const schema_t* schema, param_store_t* store) {
+    parallel_load_stats_t stats;
+    journal_t journal;
+
+    if (journal_init(&journal, path) != 0) {
+        return false;
+    }
+    long applied = read_commissioning_file(path, schema, &journal, store, &stats);
+    journal_free(&journal);
+    if (applied < 0) {
+        printf("Error: Cannot read %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Compare the parameters in memory with a commissioning file: what would
+ * change if the file were loaded
+ */
+void diff_with_file(commissioning_system_t* system, const char* path) {
+    param_store_t snapshot = {0};
+
+    journal_wait(&system->journal);
+    if (read_snapshot(path, &system->schema, &snapshot)) {
+        printf("Changes from the parameters in memory to %s:\n", path);
+        diff_parameters(&system->store, &snapshot);
+    }
+    param_store_free(&snapshot);
+}
+
+/*
+ * Compare two commissioning files, each with its journal
+ *
+ * @return: Process exit code: 0 if they hold the same parameters, 1 if they
+ *          differ, 2 if one cannot be read
+ */
+int diff_files(const char* old_path, const char* new_path) {
+    param_store_t from = {0}, to = {0};
+    schema_t schema = {0};   // Compare the text as saved
+    int result = 2;
+
+    if (read_snapshot(old_path, &schema, &from) && read_snapshot(new_path, &schema, &to)) {
+        result = diff_parameters(&from, &to) == 0 ? 0 : 1;
+    }
+    param_store_free(&from);
+    param_store_free(&to);
+    return result;
+}
+
+/*
+ * Display all commissioning parameters
+ */
+void display_parameters(commissioning_system_t* system) {
+    printf("\n=== %s Commissioning Parameters ===\n", system->system_name);
+    printf("%-20s %-15s %-10s %-25s %s\n", "Parameter", "Value", "Unit", "Description", "Status");
+    printf("--------------------------------------------------------------------------------\n");
+
+    for (uint32_t i = 0; i < system->store.count; i++) {
+        const system_parameter_t* parameter = &system->store.parameters[i];
+        printf("%-20s %-15s %-10s %-25s %s\n",
+               parameter->name,
+               parameter->value,
+               parameter->unit,
+               parameter->description,
+               parameter->is_valid ? "VALID" : "INVALID");
+    }
+    printf("================================================================================\n");
+}
+
+// Outcome of changing a parameter, shared by the menu and batch mode
+typedef enum {
+    EDIT_OK = 0,
+    EDIT_NOT_FOUND,
+    EDIT_EXISTS,
+    EDIT_INVALID_VALUE,
+    EDIT_NO_MEMORY
+} edit_status_t;
+
+static const char* const edit_status_names[] = {"ok", "not found", "already exists", "invalid value", "out of memory"};
+
+/*
+ * Set a parameter's value if it is valid for the parameter's rule, and mark
+ * it for the next save
+ */
+static edit_status_t apply_update(commissioning_system_t* system, const char* name, const char* new_value) {
+    uint32_t id = param_store_find(&system->store, name, strlen(name));
+    if (id == PARAM_STORE_NONE) {
+        return EDIT_NOT_FOUND;
+    }
+
+    // Validate the new value
+    system_parameter_t* parameter = &system->store.parameters[id];
+    param_value_t typed;
+    if (!param_value_parse(parameter->rule, new_value, &typed)) {
+        return EDIT_INVALID_VALUE;
+    }
+
+    snprintf(parameter->value, sizeof(parameter->value), "%s", new_value);
+    parameter->typed = typed;
+    parameter->is_valid = true;
+    param_store_mark_changed(&system->store, id);   // Saved by the next save
+    return EDIT_OK;
+}
+
+/*
+ * Add a parameter whose value is valid for its rule, and mark it for the
+ * next save
+ */
+static edit_status_t apply_add(commissioning_system_t* system, const char* name, const char* value,
+                               const char* unit, const char* description) {
+    // Check if parameter already exists
+    if (param_store_find(&system->store, name, strlen(name)) != PARAM_STORE_NONE) {
+        return EDIT_EXISTS;
+    }
+
+    // Validate the value
+    param_value_t typed;
+    if (!param_value_parse(find_rule(system, name), value, &typed)) {
+        return EDIT_INVALID_VALUE;
+    }
+
+    // Add the new parameter
+    system_parameter_t* parameter = store_parameter(system, name, value, unit, description);
+    if (parameter == NULL) {
+        return EDIT_NO_MEMORY;
+    }
+    param_store_mark_changed(&system->store, (uint32_t)(parameter - system->store.parameters));
+    return EDIT_OK;
+}
+
+/*
+ * Update a parameter value with validation
+ */
+bool update_parameter(commissioning_system_t* system, const char* name, const char* new_value) {
+    edit_status_t status = apply_update(system, name, new_value);
+    if (status == EDIT_NOT_FOUND) {
+        printf("Error: Parameter '%s' not found\n", name);
+        return false;
+    }
+    if (status != EDIT_OK) {
+        printf("Error: Invalid value '%s' for parameter '%s'\n", new_value, name);
+        return false;
+    }
+
+    printf("Parameter '%s' updated to '%s'\n", name, new_value);
+    check_constraints(system);
+    return true;
+}
+
+/*
+ * Add a new parameter to the system
+ */
+bool add_parameter(commissioning_system_t* system, const char* name, const char* value,
+                  const char* unit, const char* description) {
+    edit_status_t status = apply_add(system, name, value, unit, description);
+    if (status == EDIT_EXISTS) {
+        printf("Error: Parameter '%s' already exists\n", name);
+        return false;
+    }
+    if (status == EDIT_INVALID_VALUE) {
+        printf("Error: Invalid value '%s' for parameter '%s'\n", value, name);
+        return false;
+    }
+    if (status == EDIT_NO_MEMORY) {
+        printf("Error: Out of memory adding parameter '%s'\n", name);
+        return false;
+    }
+
+    printf("Parameter '%s' added successfully\n", name);
+    check_constraints(system);
+    return true;
+}
+
+/*
+ * Main menu system for user interaction
+ */
+void show_menu() {
+    printf("\n=== Commissioning File System Menu ===\n");
+    printf("1. Display all parameters\n");
+    printf("2. Update parameter value\n");
+    printf("3. Add new parameter\n");
+    printf("4. Save to file\n");
+    printf("5. Load from file\n");
+    printf("6. Validate all parameters\n");
+    printf("7. Compare with a file\n");
+    printf("8. Compile start-up image\n");
+    printf("0. Exit\n");
+    printf("Choice: ");
+}
+
+/*
+ * Read a monotonic clock in seconds for benchmarking.
+ */
+double monotonic_seconds(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+// An operation in a batch script that failed
+typedef struct {
+    uint32_t line;                       // Script line (1-based)
+    const char* operation;               // "set", "add", ... or the unknown text's kind
+    char name[MAX_LINE_LENGTH];          // Parameter it named, if any
+    const char* error;
+} batch_error_t;
+
+// What a batch script did
+typedef struct {
+    uint32_t operations;                 // Rows that were not comments
+    uint32_t set;                        // Successful operations of each kind
+    uint32_t added;
+    uint32_t validations;
+    uint32_t saves;
+    uint32_t failed;
+    long violations;                     // At the last validate (-1 if none ran)
+    batch_error_t* errors;               // Every failure, in script order
+    uint32_t error_capacity;
+} batch_result_t;
+
+/*
+ * Record a failed operation
+ */
+static void batch_fail(batch_result_t* result, uint32_t line, const char* operation,
+                       const char* name, const char* error) {
+    if (result->failed == result->error_capacity) {
+        uint32_t capacity = result->error_capacity ? 2 * result->error_capacity : 16;
+        batch_error_t* errors = realloc(result->errors, capacity * sizeof(*errors));
+        if (errors == NULL) {
+            result->failed++;   // Counted but not listed
+            return;
+        }
+        result->errors = errors;
+        result->error_capacity = capacity;
+    }
+    batch_error_t* failure = &result->errors[result->failed++];
+    failure->line = line;
+    failure->operation = operation;
+    snprintf(failure->name, sizeof(failure->name), "%s", name);
+    failure->error = error;
+}
+
+/*
+ * Apply the operations of a batch script in order, one per row:
+ *
+ *   set,NAME,VALUE
+ *   add,NAME,VALUE[,UNIT[,DESCRIPTION]]
+ *   validate
+ *   save
+ *
+ * Rows are CSV, so values may be quoted. Rows whose first field starts with
+ * '#' are comments. A failed operation is recorded and the script goes on,
+ * but a save after a failure is refused, so a partly applied batch is never
+ * saved. Parameter changes print nothing; they are checked against the
+ * constraints by validate, not one at a time as in the menu.
+ */
+static void run_batch(commissioning_system_t* system, csv_map_t* script, batch_result_t* result) {
+    PROFILE_SCOPE("run_batch");
+    char name[MAX_LINE_LENGTH];
+    char value[PARAM_TEXT_LENGTH];
+    char unit[PARAM_TEXT_LENGTH];
+    char description[PARAM_TEXT_LENGTH];
+    csv_row_t row;
+
+    memset(result, 0, sizeof(*result));
+    result->violations = -1;
+    while (csv_map_next_row(script, &row)) {
+        const csv_field_t* fields = row.fields;
+        uint32_t count = row.field_count < CSV_MAP_MAX_FIELDS ? row.field_count : CSV_MAP_MAX_FIELDS;
+
+        if (fields[0].length > 0 && fields[0].data[0] == '#') {
+            continue;
+        }
+        result->operations++;
+        name[0] = '\0';
+        if (count > 1 && csv_field_copy(&fields[1], name, sizeof(name)) >= sizeof(name)) {
+            batch_fail(result, row.line, "", name, "name too long");
+            continue;
+        }
+
+        if (csv_field_equals(&fields[0], "set") || csv_field_equals(&fields[0], "add")) {
+            bool add = fields[0].data[0] == 'a';
+            const char* operation = add ? "add" : "set";
+            if (count < 3 || name[0] == '\0') {
+                batch_fail(result, row.line, operation, name, "missing field");
+                continue;
+            }
+            if (csv_field_copy(&fields[2], value, sizeof(value)) >= sizeof(value)) {
+                batch_fail(result, row.line, operation, name, "value too long");
+                continue;
+            }
+            edit_status_t status;
+            if (add) {
+                unit[0] = description[0] = '\0';
+                if (count > 3) {
+                    csv_field_copy(&fields[3], unit, sizeof(unit));   // Cut to fit, as when loading
+                }
+                if (count > 4) {
+                    csv_field_copy(&fields[4], description, sizeof(description));
+                }
+                status = apply_add(system, name, value, unit, description);
+            } else {
+                status = apply_update(system, name, value);
+            }
+            if (status != EDIT_OK) {
+                batch_fail(result, row.line, operation, name, edit_status_names[status]);
+            } else if (add) {
+                result->added++;
+            } else {
+                result->set++;
+            }
+        } else if (csv_field_equals(&fields[0], "validate")) {
+            result->violations = (long)validate_all_parameters(system);
+            result->validations++;
+        } else if (csv_field_equals(&fields[0], "save")) {
+            if (result->failed > 0) {
+                batch_fail(result, row.line, "save", "", "earlier operation failed");
+            } else if (!save_commissioning_file(system)) {
+                batch_fail(result, row.line, "save", "", "cannot write");
+            } else {
+                result->saves++;
+            }
+        } else {
+            csv_field_copy(&fields[0], name, sizeof(name));   // Report what was written
+            batch_fail(result, row.line, "", name, "unknown operation");
+        }
+    }
+}
+
+/*
+ * Print text as a JSON string
+ */
+static void print_json_string(const char* text) {
+    putchar('"');
+    for (const unsigned char* c = (const unsigned char*)text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            printf("\\%c", *c);
+        } else if (*c < 0x20) {
+            printf("\\u%04x", *c);
+        } else {
+            putchar(*c);
+        }
+    }
+    putchar('"');
+}
+
+/*
+ * Print what a batch did as one line of JSON
+ */
+static void print_batch_summary(const commissioning_system_t* system, const batch_result_t* result,
+                                double elapsed) {
+    printf("{\"operations\":%u,\"succeeded\":%u,\"failed\":%u,\"set\":%u,\"added\":%u,"
+           "\"validations\":%u,\"violations\":%ld,\"saves\":%u,\"unsaved_changes\":%u,"
+           "\"parameters\":%u,\"elapsed_ms\":%.3f,\"errors\":[",
+           result->operations, result->operations - result->failed, result->failed, result->set,
+           result->added, result->validations, result->violations, result->saves,
+           system->store.change_count, system->store.count, elapsed * 1e3);
+    uint32_t listed = result->failed < result->error_capacity ? result->failed : result->error_capacity;
+    for (uint32_t k = 0; k < listed; k++) {
+        const batch_error_t* failure = &result->errors[k];
+        printf("%s{\"line\":%u,\"operation\":", k ? "," : "", failure->line);
+        print_json_string(failure->operation);
+        printf(",\"name\":");
+        print_json_string(failure->name);
+        printf(",\"error\":");
+        print_json_string(failure->error);
+        printf("}");
+    }
+    printf("]}\n");
+}
+
+/*
+ * Read all of a stream into memory
+ *
+ * @return: The text (to free), or NULL if memory is exhausted
+ */
+static char* read_stream(FILE* stream, size_t* size) {
+    size_t capacity = 1 << 16, used = 0;
+    char* text = malloc(capacity);
+
+    while (text != NULL) {
+        used += fread(text + used, 1, capacity - used, stream);
+        if (used < capacity) {
+            break;   // End of input or an error
+        }
+        char* grown = realloc(text, 2 * capacity);
+        if (grown == NULL) {
+            free(text);
+            return NULL;
+        }
+        text = grown;
+        capacity *= 2;
+    }
+    *size = used;
+    return text;
+}
+
+/*
+ * Point stdout at another descriptor
+ *
+ * @return: A copy of the old stdout for restore_stdout(), or -1
+ */
+static int redirect_stdout(int fd) {
+    fflush(stdout);
+    int saved = dup(fileno(stdout));
+    if (saved >= 0) {
+        dup2(fd, fileno(stdout));
+    }
+    return saved;
+}
+
+static void restore_stdout(int saved) {
+    if (saved >= 0) {
+        fflush(stdout);
+        dup2(saved, fileno(stdout));
+        close(saved);
+    }
+}
+
+/*
+ * Run a batch script against the commissioning file, from a file or from
+ * standard input ("-"), with no menu. The usual messages go to stderr, so
+ * stdout holds only the JSON summary.
+ *
+ * @return: Process exit code: 0 if every operation succeeded, 1 if one
+ *          failed, 2 if the script cannot be read
+ */
+int run_batch_script(const char* path) {
+    commissioning_system_t system;
+    batch_result_t result;
+    csv_map_t script;
+    char* text = NULL;
+    size_t size = 0;
+
+    int saved_stdout = redirect_stdout(fileno(stderr));
+    if (strcmp(path, STDIN_SCRIPT) == 0) {
+        text = read_stream(stdin, &size);
+        if (text == NULL) {
+            printf("Error: Out of memory reading the script\n");
+            restore_stdout(saved_stdout);
+            return 2;
+        }
+        csv_map_buffer(&script, text, size);
+    } else if (csv_map_open(&script, path) != 0) {
+        printf("Error: Cannot read script %s\n", path);
+        restore_stdout(saved_stdout);
+        return 2;
+    }
+
+    init_commissioning_system(&system, "Industrial Control System");
+    load_commissioning_file(&system);
+    double start = monotonic_seconds();
+    run_batch(&system, &script, &result);
+    double elapsed = monotonic_seconds() - start;
+    restore_stdout(saved_stdout);
+    print_batch_summary(&system, &result, elapsed);
+
+    if (text != NULL) {
+        free(text);
+    } else {
+        csv_map_close(&script);
+    }
+    free(result.errors);
+    journal_free(&system.journal);   // Lets a compaction finish
+    param_store_free(&system.store);
+    schema_free(&system.schema);
+    return result.failed > 0 ? 1 : 0;
+}
+
+/*
+ * Write a commissioning file of generated parameters. Every 64th row has a
+ * quoted description with an embedded comma.
+ *
+ * @return: File size in bytes, or 0 if it cannot be written
+ */
+static long write_generated_file(const char* path, uint32_t rows) {
+    FILE* file = fopen(path, "w");
+    long size;
+
+    if (file == NULL) {
+        return 0;
+    }
+    fprintf(file, "Parameter,Value,Unit,Description,Valid\n");
+    for (uint32_t k = 0; k < rows; k++) {
+        if (k % 64 == 0) {
+            fprintf(file, "gain_%07u,%u.%02u,,\"Gain, stage %u\",true\n", k, k % 100, k % 97, k);
+        } else {
+            fprintf(file, "sensor_%07u,%u,mV,Generated sensor %u,true\n", k, k % 5000, k);
+        }
+    }
+    size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+// Original validation, re-parsing the text on every call, kept only so the
+// benchmarks can compare it against parse-once typed values
+static bool validate_parameter(const char* name, const char* value) {
+    // Motor speed validation - prevent overspeed conditions
+    if (strcmp(name, "motor_speed_rpm") == 0) {
+        int speed = atoi(value);  // Convert string to integer
+        return (speed >= 0 && speed <= 3000); // 0-3000 RPM range (realistic motor limits)
+    }
+    // Temperature safety validation - prevent overheating
+    else if (strcmp(name, "temperature_limit") == 0) {
+        int temp = atoi(value);   // Convert string to integer
+        return (temp >= 0 && temp <= 100); // 0-100°C range (safe operating temperatures)
+    }
+    // Pressure control validation - prevent overpressure
+    else if (strcmp(name, "pressure_setpoint") == 0) {
+        float pressure = atof(value);  // Convert string to float for decimal precision
+        return (pressure >= 0.0f && pressure <= 10.0f); // 0-10 bar range (typical system limits)
+    }
+
+    // For unknown parameters, assume they are valid (extensible design)
+    return true; // Default validation passes - allows for custom parameters
+}
+
+// Original fixed-size parameter record and fgets()/strtok() loop, kept only
+// so the benchmark can compare them against the mapped reader. Each row is
+// parsed into one scratch record instead of the old 50-entry table.
+typedef struct {
+    char name[MAX_NAME_LENGTH];
+    char value[MAX_NAME_LENGTH];
+    char unit[MAX_NAME_LENGTH];
+    char description[MAX_NAME_LENGTH];
+} text_parameter_t;
+
+static uint32_t bench_load_fgets(const char* path, uint32_t* valid) {
+    text_parameter_t parameter;
+    char line[MAX_LINE_LENGTH];
+    uint32_t rows = 0;
+    FILE* file = fopen(path, "r");
+
+    if (file == NULL || fgets(line, sizeof(line), file) == NULL) {
+        if (file != NULL) {
+            fclose(file);
+        }
+        return 0;
+    }
+    while (fgets(line, sizeof(line), file)) {
+        char* token = strtok(line, ",");
+        if (token == NULL) continue;
+        token[strcspn(token, "\n")] = 0;
+        strcpy(parameter.name, token);
+        token = strtok(NULL, ",");
+        if (token) strcpy(parameter.value, token);
+        token = strtok(NULL, ",");
+        if (token) strcpy(parameter.unit, token);
+        token = strtok(NULL, ",");
+        if (token) strcpy(parameter.description, token);
+        *valid += validate_parameter(parameter.name, parameter.value);
+        rows++;
+    }
+    fclose(file);
+    return rows;
+}
+
+// The single-threaded row loop load_commissioning_file() used before
+// parallel_load.c, parsing into the same scratch record
+static uint32_t bench_load_mapped(const char* path, const schema_t* schema, uint32_t* valid,
+                                  uint32_t* quoted) {
+    text_parameter_t parameter;
+    csv_map_t map;
+    csv_row_t row;
+    uint32_t rows = 0;
+
+    if (csv_map_open(&map, path) != 0 || !csv_map_next_row(&map, &row)) {
+        csv_map_close(&map);
+        return 0;
+    }
+    while (csv_map_next_row(&map, &row)) {
+        if (row.fields[0].length == 0) continue;
+        copy_field(parameter.name, &row, 0, "name");
+        copy_field(parameter.value, &row, 1, "value");
+        copy_field(parameter.unit, &row, 2, "unit");
+        copy_field(parameter.description, &row, 3, "description");
+        param_value_t typed;
+        const char* name = parameter.name;
+        *valid += param_value_parse(schema_find(schema, name, strlen(name)), parameter.value, &typed);
+        *quoted += row.field_count == 5 && strchr(parameter.description, ',') != NULL;
+        rows++;
+    }
+    csv_map_close(&map);
+    return rows;
+}
+
+/*
+ * Benchmark loading a 1M-row commissioning file: the original fgets() and
+ * strtok() loop against the mapped reader. Both parse, copy and validate
+ * every row; the best of three runs is reported (the file is in the page
+ * cache after the first).
+ */
+void benchmark_load(void) {
+    const uint32_t generated = 1000000;
+    const char* path = "commissioning_bench.csv";
+    double best_fgets = 1e9, best_mapped = 1e9;
+    uint32_t rows_fgets = 0, rows_mapped = 0, valid = 0, quoted = 0;
+    schema_t schema = {0};
+
+    long size = write_generated_file(path, generated);
+    if (size <= 0) {
+        printf("Error: Cannot create %s\n", path);
+        return;
+    }
+    for (size_t r = 0; r < sizeof(parameter_rules) / sizeof(parameter_rules[0]); r++) {
+        schema_add_rule(&schema, &parameter_rules[r]);
+    }
+
+    for (int run = 0; run < 3; run++) {
+        double start = monotonic_seconds();
+        valid = 0;
+        rows_fgets = bench_load_fgets(path, &valid);
+        double elapsed = monotonic_seconds() - start;
+        if (elapsed < best_fgets) best_fgets = elapsed;
+
+        start = monotonic_seconds();
+        valid = quoted = 0;
+        rows_mapped = bench_load_mapped(path, &schema, &valid, &quoted);
+        elapsed = monotonic_seconds() - start;
+        if (elapsed < best_mapped) best_mapped = elapsed;
+    }
+    remove(path);
+    schema_free(&schema);
+
+    printf("\n=== Load Benchmark: %u rows, %.1f MB ===\n", generated, size / 1e6);
+    printf("%-18s %10s %12s %14s\n", "Loader", "Time (ms)", "MB/s", "Rows/s");
+    printf("%-18s %10.1f %12.1f %14.0f\n", "fgets + strtok", best_fgets * 1e3,
+           size / 1e6 / best_fgets, rows_fgets / best_fgets);
+    printf("%-18s %10.1f %12.1f %14.0f\n", "mmap + memchr", best_mapped * 1e3,
+           size / 1e6 / best_mapped, rows_mapped / best_mapped);
+    printf("Speedup: %.1fx\n", best_fgets / best_mapped);
+    printf("Rows read: %u and %u; quoted descriptions kept whole by the mapped reader: %u of %u\n",
+           rows_fgets, rows_mapped, quoted, (generated + 63) / 64);
+}
+
+// Original lookup of update_parameter() and add_parameter(), kept only so
+// the benchmark can compare it against the hash index
+static int bench_linear_find(const text_parameter_t* parameters, int count, const char* name) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(parameters[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * @return: The q-quantile of samples (sorted in place)
+ */
+static double percentile(double* samples, uint32_t count, double q) {
+    qsort(samples, count, sizeof(double), compare_doubles);
+    return samples[(uint32_t)(q * (count - 1))];
+}
+
+/*
+ * Benchmark finding parameters by name at 50, 10k and 1M entries: the
+ * original strcmp() scan against the parameter store's hash index. Each
+ * lookup is timed on its own (timer overhead included) for percentiles.
+ * Also reports the cost of inserting and of rejecting a duplicate.
+ */
+void benchmark_lookup(void) {
+    const uint32_t sizes[] = {50, 10000, 1000000};
+    const uint32_t lookups = 200000;
+    static char keys[200000][MAX_NAME_LENGTH];
+    double* samples = malloc(sizeof(double) * lookups);
+    uint32_t rng = 12345;
+    volatile uint32_t sink = 0;
+
+    if (samples == NULL) {
+        printf("Error: Out of memory\n");
+        return;
+    }
+
+    printf("\n=== Lookup Benchmark: strcmp() scan vs hash index ===\n");
+    printf("%-9s %12s %12s %10s %10s %10s %10s %10s\n", "Entries", "Scan mean", "Scan p99",
+           "Hash mean", "Hash p50", "Hash p99", "Insert", "Duplicate");
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        uint32_t n = sizes[s];
+        text_parameter_t* table = malloc(sizeof(text_parameter_t) * n);
+        param_store_t store = {0};
+        bool added;
 
-// System configuration constants
-#define MAX_LINE_LENGTH 256      // Maximum length of a CSV line
-#define MAX_PARAMETERS 50        // Maximum number of parameters the system can handle
-#define MAX_NAME_LENGTH 32       // Maximum length for parameter names and values
-#define COMMISSIONING_FILE "system_config.csv"  // Default commissioning file name
+        if (table == NULL) {
+            printf("Error: Out of memory\n");
+            break;
+        }
+        for (uint32_t k = 0; k < n; k++) {
+            snprintf(table[k].name, sizeof(table[k].name), "param_%07u", k);
+        }
+        for (uint32_t q = 0; q < lookups; q++) {
+            rng = rng * 1664525u + 1013904223u;
+            snprintf(keys[q], sizeof(keys[q]), "param_%07u", (rng >> 8) % n);
+        }
+
+        // Insert every name
+        double start = monotonic_seconds();
+        for (uint32_t k = 0; k < n; k++) {
+            param_store_insert(&store, table[k].name, strlen(table[k].name), &added);
+        }
+        double insert_ns = (monotonic_seconds() - start) * 1e9 / n;
+
+        // Reject every name again as a duplicate
+        start = monotonic_seconds();
+        for (uint32_t k = 0; k < n; k++) {
+            sink += param_store_insert(&store, table[k].name, strlen(table[k].name), &added);
+        }
+        double duplicate_ns = (monotonic_seconds() - start) * 1e9 / n;
+
+        // Scan: as many lookups as fit in about 0.5 s
+        uint32_t scans = (uint32_t)(100000000ull / n);
+        if (scans > lookups) scans = lookups;
+        double scan_total = 0;
+        for (uint32_t q = 0; q < scans; q++) {
+            double t0 = monotonic_seconds();
+            sink += (uint32_t)bench_linear_find(table, (int)n, keys[q]);
+            samples[q] = monotonic_seconds() - t0;
+            scan_total += samples[q];
+        }
+        double scan_mean = scan_total / scans, scan_p99 = percentile(samples, scans, 0.99);
+
+        double hash_total = 0;
+        for (uint32_t q = 0; q < lookups; q++) {
+            double t0 = monotonic_seconds();
+            sink += param_store_find(&store, keys[q], strlen(keys[q]));
+            samples[q] = monotonic_seconds() - t0;
+            hash_total += samples[q];
+        }
+        double hash_mean = hash_total / lookups;
+        double hash_p50 = percentile(samples, lookups, 0.50);
+        double hash_p99 = percentile(samples, lookups, 0.99);
+
+        printf("%-9u %9.0f ns %9.0f ns %7.0f ns %7.0f ns %7.0f ns %7.0f ns %7.0f ns\n", n,
+               scan_mean * 1e9, scan_p99 * 1e9, hash_mean * 1e9, hash_p50 * 1e9, hash_p99 * 1e9,
+               insert_ns, duplicate_ns);
+
+        param_store_free(&store);
+        free(table);
+    }
+    free(samples);
+}
 
 /*
- * Structure representing a single system parameter
- * This is the core data structure for storing parameter information
+ * Benchmark validating 1M parameters: the original validate_parameter(),
+ * which re-parses every value's text, against checking the typed values
+ * parsed once at load. Values cycle through the built-in rules, about 1 in
+ * 20 out of range. The one-time parse is timed too.
  */
-typedef struct {
-    char name[MAX_NAME_LENGTH];         // Parameter identifier (e.g., "motor_speed_rpm")
-    char value[MAX_NAME_LENGTH];        // Parameter value as string (e.g., "1500")
-    char unit[MAX_NAME_LENGTH];         // Unit of measurement (e.g., "RPM", "Celsius")
-    char description[MAX_NAME_LENGTH];  // Human-readable description
-    bool is_valid;                      // Flag indicating if parameter value is valid
-} system_parameter_t;
+void benchmark_validate(void) {
+    const uint32_t count = 1000000;
+    const size_t rule_count = sizeof(parameter_rules) / sizeof(parameter_rules[0]);
+    text_parameter_t* text = malloc(sizeof(text_parameter_t) * count);
+    param_store_t store = {0};
+    double best_text = 1e9, best_typed = 1e9;
+    uint32_t invalid_text = 0, invalid_typed = 0;
+    char name[MAX_NAME_LENGTH];
+    bool added;
+
+    if (text == NULL) {
+        printf("Error: Out of memory\n");
+        return;
+    }
+
+    // The same values as text records (named after their rule, as the old
+    // validation needs) and as stored parameters
+    for (uint32_t k = 0; k < count; k++) {
+        const param_rule_t* rule = &parameter_rules[k % rule_count];
+        snprintf(text[k].name, sizeof(text[k].name), "%s", rule->name);
+        if (rule->type == PARAM_TYPE_FLOAT) {
+            snprintf(text[k].value, sizeof(text[k].value), "%.2f", (k % 1051) / 100.0);
+        } else {
+            snprintf(text[k].value, sizeof(text[k].value), "%u", k % ((uint32_t)rule->max * 21 / 20 + 1));
+        }
+        snprintf(name, sizeof(name), "param_%07u", k);
+        param_store_insert(&store, name, strlen(name), &added);
+        store.parameters[k].rule = rule;
+    }
+
+    double start = monotonic_seconds();
+    for (uint32_t k = 0; k < count; k++) {
+        set_parameter_value(&store.parameters[k], text[k].value);
+    }
+    double parse_s = monotonic_seconds() - start;
+
+    for (int run = 0; run < 5; run++) {
+        start = monotonic_seconds();
+        invalid_text = 0;
+        for (uint32_t k = 0; k < count; k++) {
+            invalid_text += !validate_parameter(text[k].name, text[k].value);
+        }
+        double elapsed = monotonic_seconds() - start;
+        if (elapsed < best_text) best_text = elapsed;
+
+        start = monotonic_seconds();
+        invalid_typed = 0;
+        for (uint32_t k = 0; k < count; k++) {
+            const system_parameter_t* parameter = &store.parameters[k];
+            invalid_typed += !param_value_check(parameter->rule, &parameter->typed);
+        }
+        elapsed = monotonic_seconds() - start;
+        if (elapsed < best_typed) best_typed = elapsed;
+    }
+
+    printf("\n=== Validation Benchmark: %u parameters ===\n", count);
+    printf("%-30s %10s %12s %10s\n", "Method", "Time (ms)", "ns/param", "Invalid");
+    printf("%-30s %10.1f %12.1f %10u\n", "Re-parse text (old)", best_text * 1e3,
+           best_text * 1e9 / count, invalid_text);
+    printf("%-30s %10.1f %12.1f %10u\n", "Check typed values", best_typed * 1e3,
+           best_typed * 1e9 / count, invalid_typed);
+    printf("Speedup: %.1fx; one-time parse at load: %.1f ms (%.1f ns/param)\n",
+           best_text / best_typed, parse_s * 1e3, parse_s * 1e9 / count);
+
+    param_store_free(&store);
+    free(text);
+}
 
 /*
- * Main structure representing the commissioning system
- * Contains all parameters and system state information
+ * Benchmark compiling a schema of 1M rules plus 1000 constraints and
+ * validating 1M parameters against it. The first pass also finds each
+ * parameter's rule and parses its value; later passes only check.
  */
-typedef struct {
-    system_parameter_t parameters[MAX_PARAMETERS];  // Array of system parameters
-    int parameter_count;                           // Current number of parameters
-    char system_name[MAX_NAME_LENGTH];             // Name of the control system
-    bool is_loaded;                               // Flag indicating if config was loaded from file
-} commissioning_system_t;
+void benchmark_schema(void) {
+    const uint32_t count = 1000000;
+    const uint32_t constraints = 1000;
+    static const char* const modes[] = {"manual", "auto", "cascade"};
+    schema_t schema = {0};
+    param_store_t store = {0};
+    schema_report_t report = {0};
+    char name[MAX_NAME_LENGTH], text[128];
+    bool added;
+
+    // Rules cycle through int, float, bool and enum; about 1 value in 20
+    // breaks its rule
+    double start = monotonic_seconds();
+    for (uint32_t k = 0; k < count; k++) {
+        param_rule_t rule = {0};
+        snprintf(name, sizeof(name), "param_%07u", k);
+        rule.name = name;
+        rule.type = (param_type_t)(PARAM_TYPE_INT + k % 4);
+        rule.min = 0;
+        rule.max = rule.type == PARAM_TYPE_INT ? 1000 : 10;
+        rule.unit = rule.type == PARAM_TYPE_FLOAT ? "V" : NULL;
+        if (rule.type == PARAM_TYPE_ENUM) {
+            rule.enum_names = modes;
+            rule.enum_count = 3;
+        }
+        schema_add_rule(&schema, &rule);
+    }
+    for (uint32_t c = 0; c < constraints; c++) {
+        snprintf(text, sizeof(text), "param_%07u + param_%07u <= 1500", c * 8, c * 8 + 4);
+        schema_add_constraint(&schema, text, c + 2);
+    }
+    double compile_s = monotonic_seconds() - start;
+
+    for (uint32_t k = 0; k < count; k++) {
+        snprintf(name, sizeof(name), "param_%07u", k);
+        uint32_t id = param_store_insert(&store, name, strlen(name), &added);
+        system_parameter_t* parameter = &store.parameters[id];
+        switch (k % 4) {
+            case 0:  snprintf(parameter->value, sizeof(parameter->value), "%u", k % 1050); break;
+            case 1:  snprintf(parameter->value, sizeof(parameter->value), "%.2f", (k % 1001) / 100.0); break;
+            case 2:  snprintf(parameter->value, sizeof(parameter->value), "%s", k % 40 == 2 ? "maybe" : "true"); break;
+            default: snprintf(parameter->value, sizeof(parameter->value), "%s", k % 40 == 3 ? "turbo" : modes[k % 3]); break;
+        }
+        snprintf(parameter->unit, sizeof(parameter->unit), "%s", k % 40 == 1 ? "mV" : "V");
+    }
+
+    start = monotonic_seconds();
+    schema_validate(&schema, &store, &report);
+    double first_s = monotonic_seconds() - start;
+
+    double best_s = 1e9;
+    for (int run = 0; run < 3; run++) {
+        start = monotonic_seconds();
+        schema_validate(&schema, &store, &report);
+        double elapsed = monotonic_seconds() - start;
+        if (elapsed < best_s) best_s = elapsed;
+    }
+
+    printf("\n=== Schema Benchmark: %u rules, %u constraints, %u parameters ===\n",
+           schema.rule_count, schema.constraint_count, count);
+    printf("Compile schema:            %8.1f ms\n", compile_s * 1e3);
+    printf("First pass (resolve+parse):%8.1f ms (%.0f ns/parameter)\n", first_s * 1e3, first_s * 1e9 / count);
+    printf("Validation pass:           %8.1f ms (%.0f ns/parameter)\n", best_s * 1e3, best_s * 1e9 / count);
+    printf("Violations: type %u, range %u, unit %u, constraint %u, undefined %u\n",
+           report.by_kind[SCHEMA_VIOLATION_TYPE], report.by_kind[SCHEMA_VIOLATION_RANGE],
+           report.by_kind[SCHEMA_VIOLATION_UNIT], report.by_kind[SCHEMA_VIOLATION_CONSTRAINT],
+           report.by_kind[SCHEMA_VIOLATION_MISSING]);
+
+    schema_report_free(&report);
+    schema_free(&schema);
+    param_store_free(&store);
+}
 
 /*
- * Initialize the commissioning system with default values
- * This function sets up the system with some sample parameters for demonstration
- * In a real embedded system, these might be loaded from EEPROM or flash memory
+ * Load a file into an empty store on the given number of threads
+ *
+ * @return: Seconds taken, or a negative value if the file cannot be read
  */
-void init_commissioning_system(commissioning_system_t* system, const char* name) {
-    // Reset system state
-    system->parameter_count = 0;        // Start with no parameters
-    system->is_loaded = false;          // Not loaded from file yet
-    strcpy(system->system_name, name);  // Set the system name
+static double bench_parallel_load(const char* path, const schema_t* schema, param_store_t* store,
+                                  uint32_t threads, parallel_load_stats_t* stats) {
+    csv_map_t map;
+    csv_row_t row;
+    double start = monotonic_seconds();
 
-    // Add some default parameters for demonstration
-    // Parameter 1: Motor speed control
-    strcpy(system->parameters[0].name, "motor_speed_rpm");
-    strcpy(system->parameters[0].value, "1500");
-    strcpy(system->parameters[0].unit, "RPM");
-    strcpy(system->parameters[0].description, "Motor operating speed");
-    system->parameters[0].is_valid = true;  // Mark as valid
-    system->parameter_count++;               // Increment parameter count
+    if (csv_map_open(&map, path) != 0 || !csv_map_next_row(&map, &row)) {
+        csv_map_close(&map);
+        return -1.0;
+    }
+    parallel_load(&map, schema, store, threads, stats);
+    csv_map_close(&map);
+    return monotonic_seconds() - start;
+}
 
-    // Parameter 2: Temperature safety limit
-    strcpy(system->parameters[1].name, "temperature_limit");
-    strcpy(system->parameters[1].value, "85");
-    strcpy(system->parameters[1].unit, "Celsius");
-    strcpy(system->parameters[1].description, "Maximum temperature limit");
-    system->parameters[1].is_valid = true;
-    system->parameter_count++;
+/*
+ * @return: A checksum of every parameter's name, value, unit, validity and
+ *          position, to compare loads
+ */
+static uint32_t store_fingerprint(const param_store_t* store) {
+    uint32_t sum = store->count;
 
-    // Parameter 3: Pressure control setpoint
-    strcpy(system->parameters[2].name, "pressure_setpoint");
-    strcpy(system->parameters[2].value, "2.5");
-    strcpy(system->parameters[2].unit, "bar");
-    strcpy(system->parameters[2].description, "Pressure control setpoint");
-    system->parameters[2].is_valid = true;
-    system->parameter_count++;
+    for (uint32_t k = 0; k < store->count; k++) {
+        const system_parameter_t* parameter = &store->parameters[k];
+        uint32_t hash = param_store_hash(parameter->name, strlen(parameter->name));
+        hash ^= param_store_hash(parameter->value, strlen(parameter->value)) * 31u;
+        hash ^= param_store_hash(parameter->unit, strlen(parameter->unit)) * 131u;
+        sum = sum * 1000003u + (hash ^ (parameter->is_valid ? k : ~k));
+    }
+    return sum;
 }
 
 /*
- * Validate a parameter value based on its type and constraints
- * This function ensures parameter values are within safe operating ranges
- * Critical for embedded systems to prevent hardware damage or unsafe operation
+ * Benchmark load_commissioning_file()'s parallel loader on a generated
+ * 4M-row file with 1 to 32 threads. Each load goes into an empty store; the
+ * best of two runs is reported, and every load must match the one-thread
+ * result exactly.
  */
-bool validate_parameter(const char* name, const char* value) {
-    // Motor speed validation - prevent overspeed conditions
-    if (strcmp(name, "motor_speed_rpm") == 0) {
-        int speed = atoi(value);  // Convert string to integer
-        return (speed >= 0 && speed <= 3000); // 0-3000 RPM range (realistic motor limits)
+void benchmark_parallel(void) {
+    const uint32_t generated = 4000000;
+    const char* path = "commissioning_bench.csv";
+    static const uint32_t thread_counts[] = {1, 2, 4, 8, 16, 32};
+    schema_t schema = {0};
+    double single_s = 0.0;
+    uint32_t expected = 0;
+
+    long size = write_generated_file(path, generated);
+    if (size <= 0) {
+        printf("Error: Cannot create %s\n", path);
+        return;
     }
-    // Temperature safety validation - prevent overheating
-    else if (strcmp(name, "temperature_limit") == 0) {
-        int temp = atoi(value);   // Convert string to integer
-        return (temp >= 0 && temp <= 100); // 0-100°C range (safe operating temperatures)
+    for (size_t r = 0; r < sizeof(parameter_rules) / sizeof(parameter_rules[0]); r++) {
+        schema_add_rule(&schema, &parameter_rules[r]);
     }
-    // Pressure control validation - prevent overpressure
-    else if (strcmp(name, "pressure_setpoint") == 0) {
-        float pressure = atof(value);  // Convert string to float for decimal precision
-        return (pressure >= 0.0f && pressure <= 10.0f); // 0-10 bar range (typical system limits)
+
+    printf("\n=== Parallel Load Benchmark: %u rows, %.1f MB, %u CPUs online ===\n",
+           generated, size / 1e6, parallel_load_threads());
+    printf("%-8s %10s %10s %12s %9s %11s %s\n", "Threads", "Time (ms)", "MB/s", "Rows/s",
+           "Speedup", "Efficiency", "Result");
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        parallel_load_stats_t stats = {0};
+        double best = 1e9;
+        uint32_t fingerprint = 0;
+
+        for (int run = 0; run < 2; run++) {
+            param_store_t store = {0};
+            double elapsed = bench_parallel_load(path, &schema, &store, thread_counts[t], &stats);
+            if (elapsed >= 0.0 && elapsed < best) best = elapsed;
+            fingerprint = store_fingerprint(&store);
+            param_store_free(&store);
+        }
+        if (t == 0) {
+            single_s = best;
+            expected = fingerprint;
+        }
+        double speedup = single_s / best;
+        printf("%-8u %10.1f %10.1f %12.0f %8.2fx %10.0f%% %s\n", stats.threads, best * 1e3,
+               size / 1e6 / best, stats.rows / best, speedup, speedup / stats.threads * 100.0,
+               fingerprint == expected ? "same" : "DIFFERENT");
     }
+    remove(path);
+    schema_free(&schema);
+}
 
-    // For unknown parameters, assume they are valid (extensible design)
-    return true; // Default validation passes - allows for custom parameters
+// Original save_commissioning_file(), truncating the file in place and
+// writing one field at a time, kept only so the benchmarks can compare it
+static int bench_save_fprintf(const param_store_t* store, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        return -1;
+    }
+    fprintf(file, "Parameter,Value,Unit,Description,Valid\n");
+    for (uint32_t i = 0; i < store->count; i++) {
+        const system_parameter_t* parameter = &store->parameters[i];
+        csv_write_field(file, parameter->name);
+        fputc(',', file);
+        csv_write_field(file, parameter->value);
+        fputc(',', file);
+        csv_write_field(file, parameter->unit);
+        fputc(',', file);
+        csv_write_field(file, parameter->description);
+        fprintf(file, ",%s\n", parameter->is_valid ? "true" : "false");
+    }
+    fclose(file);
+    return 0;
 }
 
 /*
- * Save the commissioning parameters to a CSV file
+ * Fill a store with generated parameters, every value set to text
  */
-bool save_commissioning_file(commissioning_system_t* system) {
-    FILE* file = fopen(COMMISSIONING_FILE, "w");
-    if (file == NULL) {
-        printf("Error: Cannot create commissioning file\n");
-        return false;
+static void fill_bench_store(param_store_t* store, uint32_t count, const char* text) {
+    char name[MAX_NAME_LENGTH];
+    bool added;
+
+    for (uint32_t k = 0; k < count; k++) {
+        snprintf(name, sizeof(name), "sensor_%07u", k);
+        uint32_t id = param_store_insert(store, name, strlen(name), &added);
+        system_parameter_t* parameter = &store->parameters[id];
+        snprintf(parameter->value, sizeof(parameter->value), "%s", text);
+        snprintf(parameter->unit, sizeof(parameter->unit), "mV");
+        snprintf(parameter->description, sizeof(parameter->description),
+                 k % 64 == 0 ? "Gain, stage %u" : "Generated sensor %u", k);
+        parameter->is_valid = true;
     }
+}
 
-    // Write CSV header
-    fprintf(file, "Parameter,Value,Unit,Description,Valid\n");
+/*
+ * Benchmark saving 1M parameters: the original fprintf() per field into
+ * the live file against buffered writes to a temp file, fsync and rename.
+ * The best of three runs is reported.
+ */
+void benchmark_save(void) {
+    const uint32_t count = 1000000;
+    const char* path = "commissioning_bench.csv";
+    param_store_t store = {0};
+    double best_fprintf = 1e9, best_atomic = 1e9;
 
-    // Write each parameter
-    for (int i = 0; i < system->parameter_count; i++) {
-        fprintf(file, "%s,%s,%s,%s,%s\n",
-                system->parameters[i].name,
-                system->parameters[i].value,
-                system->parameters[i].unit,
-                system->parameters[i].description,
-                system->parameters[i].is_valid ? "true" : "false");
+    fill_bench_store(&store, count, "1500");
+    for (int run = 0; run < 3; run++) {
+        double start = monotonic_seconds();
+        bench_save_fprintf(&store, path);
+        double elapsed = monotonic_seconds() - start;
+        if (elapsed < best_fprintf) best_fprintf = elapsed;
+
+        start = monotonic_seconds();
+        if (write_commissioning_csv(&store, path) != 0) {
+            printf("Error: Cannot write %s\n", path);
+            break;
+        }
+        elapsed = monotonic_seconds() - start;
+        if (elapsed < best_atomic) best_atomic = elapsed;
     }
 
-    fclose(file);
-    printf("Commissioning file saved successfully: %s\n", COMMISSIONING_FILE);
-    return true;
+    csv_map_t map;
+    csv_row_t row;
+    uint32_t rows = 0;
+    double size = 0.0;
+    if (csv_map_open(&map, path) == 0) {
+        size = (double)map.size;
+        while (csv_map_next_row(&map, &row)) {
+            rows++;
+        }
+        csv_map_close(&map);
+    }
+    remove(path);
+    param_store_free(&store);
+
+    printf("\n=== Save Benchmark: %u parameters, %.1f MB ===\n", count, size / 1e6);
+    printf("%-34s %10s %10s\n", "Writer", "Time (ms)", "MB/s");
+    printf("%-34s %10.1f %10.1f\n", "fprintf per field, in place", best_fprintf * 1e3, size / 1e6 / best_fprintf);
+    printf("%-34s %10.1f %10.1f\n", "buffered, temp + fsync + rename", best_atomic * 1e3, size / 1e6 / best_atomic);
+    printf("Speedup: %.1fx (rows read back: %u including header)\n", best_fprintf / best_atomic, rows);
 }
 
 /*
- * Load commissioning parameters from a CSV file
+ * Change count parameters spread over the store and save them to the
+ * journal
+ *
+ * @return: Seconds taken, or a negative value if the append failed
  */
-bool load_commissioning_file(commissioning_system_t* system) {
-    FILE* file = fopen(COMMISSIONING_FILE, "r");
-    if (file == NULL) {
-        printf("Commissioning file not found. Using default parameters.\n");
-        return false;
+static double bench_journal_save(journal_t* journal, param_store_t* store, uint32_t count, uint32_t round) {
+    for (uint32_t k = 0; k < count; k++) {
+        uint32_t id = (uint32_t)(((uint64_t)k * 2654435761u + round) % store->count);
+        snprintf(store->parameters[id].value, sizeof(store->parameters[id].value), "%u", 1500 + round);
+        param_store_mark_changed(store, id);
     }
 
-    char line[MAX_LINE_LENGTH];
-    int line_count = 0;
-    system->parameter_count = 0;
+    double start = monotonic_seconds();
+    int result = journal_append(journal, store);
+    double elapsed = monotonic_seconds() - start;
+    param_store_clear_changes(store);
+    return result == 0 ? elapsed : -1.0;
+}
 
-    // Skip header line
-    if (fgets(line, sizeof(line), file) == NULL) {
-        fclose(file);
-        return false;
+/*
+ * Benchmark delta saves on 1M parameters: rewriting the whole file against
+ * appending 1 and 1000 changed parameters to the journal, and compacting
+ * the journal back into the file. The file and journal are then reloaded
+ * and must match the parameters in memory.
+ */
+void benchmark_delta(void) {
+    const uint32_t count = 1000000;
+    const char* path = "commissioning_bench.csv";
+    static const uint32_t batch_sizes[] = {1, 1000};
+    param_store_t store = {0};
+    journal_t journal;
+    double best_full = 1e9;
+    uint32_t round = 0;
+
+    fill_bench_store(&store, count, "1500");
+    for (int run = 0; run < 3; run++) {
+        double start = monotonic_seconds();
+        if (write_commissioning_csv(&store, path) != 0) {
+            printf("Error: Cannot write %s\n", path);
+            param_store_free(&store);
+            return;
+        }
+        double elapsed = monotonic_seconds() - start;
+        if (elapsed < best_full) best_full = elapsed;
     }
+    if (journal_init(&journal, path) != 0) {
+        printf("Error: Out of memory\n");
+        param_store_free(&store);
+        return;
+    }
+    journal_discard(&journal);
 
-    // Read parameter lines
-    while (fgets(line, sizeof(line), file) && system->parameter_count < MAX_PARAMETERS) {
-        line_count++;
+    printf("\n=== Delta Save Benchmark: %u parameters ===\n", count);
+    printf("%-34s %10s %10s\n", "Save", "Time (ms)", "Speedup");
+    printf("%-34s %10.2f %10s\n", "whole file, temp + fsync + rename", best_full * 1e3, "1.0x");
+    for (size_t b = 0; b < sizeof(batch_sizes) / sizeof(batch_sizes[0]); b++) {
+        double best = 1e9;
+        for (int run = 0; run < 5; run++) {
+            double elapsed = bench_journal_save(&journal, &store, batch_sizes[b], ++round);
+            if (elapsed >= 0.0 && elapsed < best) best = elapsed;
+        }
+        char label[64];
+        snprintf(label, sizeof(label), "journal, %u changed + fsync", batch_sizes[b]);
+        printf("%-34s %10.2f %9.0fx\n", label, best * 1e3, best_full / best);
+    }
 
-        // Parse CSV line (simple parsing - assumes no commas in values)
-        char* token = strtok(line, ",");
-        if (token == NULL) continue;
+    // New parameters go to the journal too
+    bool added;
+    uint32_t id = param_store_insert(&store, "bench_new_parameter", strlen("bench_new_parameter"), &added);
+    snprintf(store.parameters[id].value, sizeof(store.parameters[id].value), "42");
+    store.parameters[id].is_valid = true;
+    param_store_mark_changed(&store, id);
+    journal_append(&journal, &store);
+    param_store_clear_changes(&store);
 
-        // Remove newline character
-        token[strcspn(token, "\n")] = 0;
+    uint64_t journal_size = journal.size;
+    double start = monotonic_seconds();
+    int compacted = journal_compact(&journal, true);
+    double compact_s = monotonic_seconds() - start;
+    printf("Compaction of a %.1f KB journal:  %8.1f ms (%s, in the background)\n",
+           journal_size / 1e3, compact_s * 1e3, compacted == 0 ? "ok" : "FAILED");
 
-        strcpy(system->parameters[system->parameter_count].name, token);
+    // Changes after the compaction stay in the journal
+    bench_journal_save(&journal, &store, 10, ++round);
 
-        token = strtok(NULL, ",");
-        if (token) strcpy(system->parameters[system->parameter_count].value, token);
+    param_store_t reloaded = {0};
+    schema_t schema = {0};
+    parallel_load_stats_t stats;
+    read_commissioning_file(path, &schema, &journal, &reloaded, &stats);
+    printf("Reloaded file + journal: %u parameters, %s\n", reloaded.count,
+           store_fingerprint(&reloaded) == store_fingerprint(&store) ? "same as in memory" : "DIFFERENT");
 
-        token = strtok(NULL, ",");
-        if (token) strcpy(system->parameters[system->parameter_count].unit, token);
+    journal_discard(&journal);
+    journal_free(&journal);
+    remove(path);
+    param_store_free(&reloaded);
+    param_store_free(&store);
+}
 
-        token = strtok(NULL, ",");
-        if (token) strcpy(system->parameters[system->parameter_count].description, token);
+/*
+ * Benchmark start-up from a compiled image of 1M parameters against
+ * loading the CSV file: opening the image and finding one parameter in
+ * place, lookups in the image and in a store, and checking its body
+ * checksum. Every value found in the image must match the CSV load. The
+ * CSV file is then rewritten and the image must be refused as stale.
+ */
+void benchmark_image(void) {
+    const uint32_t count = 1000000;
+    const uint32_t lookups = 1000000;
+    const char* path = "commissioning_bench.csv";
+    const char* image_path = "commissioning_bench.img";
+    param_store_t store = {0};
+    schema_t schema = {0};
+    parallel_load_stats_t stats = {0};
+    config_image_stamp_t stamp, image_stamp;
+    config_image_t image;
 
-        token = strtok(NULL, ",");
-        if (token) {
-            system->parameters[system->parameter_count].is_valid = (strcmp(token, "true") == 0);
+    fill_bench_store(&store, count, "1500");
+    if (write_commissioning_csv(&store, path) != 0) {
+        printf("Error: Cannot write %s\n", path);
+        param_store_free(&store);
+        return;
+    }
+    param_store_free(&store);
+
+    // Start-up without an image: best of three loads, each into a new store
+    double csv_s = 1e9;
+    for (int run = 0; run < 3; run++) {
+        param_store_free(&store);
+        memset(&store, 0, sizeof(store));
+        double elapsed = bench_parallel_load(path, &schema, &store, parallel_load_threads(), &stats);
+        if (elapsed >= 0.0 && elapsed < csv_s) csv_s = elapsed;
+    }
+
+    config_image_stamp(path, &stamp);
+    double start = monotonic_seconds();
+    int written = config_image_write(&store, image_path, &stamp, 1);
+    double compile_s = monotonic_seconds() - start;
+    config_image_stamp(image_path, &image_stamp);
+    if (written != 0 || config_image_open(&image, image_path, &stamp, 1) != CONFIG_IMAGE_OK) {
+        printf("Error: Cannot compile %s\n", image_path);
+        remove(path);
+        remove(image_path);
+        param_store_free(&store);
+        return;
+    }
+    config_image_close(&image);
+
+    // Start-up with an image: open it and find one parameter, best of 1000
+    double open_s = 1e9;
+    uint32_t found = 0;
+    for (int run = 0; run < 1000; run++) {
+        start = monotonic_seconds();
+        if (config_image_open(&image, image_path, &stamp, 1) == CONFIG_IMAGE_OK) {
+            found += config_image_find(&image, "sensor_0500000", strlen("sensor_0500000")) != CONFIG_IMAGE_NONE;
+            config_image_close(&image);
         }
+        double elapsed = monotonic_seconds() - start;
+        if (elapsed < open_s) open_s = elapsed;
+    }
+
+    // Lookups in random order: in place in the image against the store
+    config_image_open(&image, image_path, &stamp, 1);
+    uint32_t hits = 0;
+    start = monotonic_seconds();
+    for (uint32_t k = 0; k < lookups; k++) {
+        const char* name = store.parameters[(uint32_t)((k * 2654435761u) % count)].name;
+        hits += config_image_find(&image, name, strlen(name)) != CONFIG_IMAGE_NONE;
+    }
+    double image_lookup_s = monotonic_seconds() - start;
+    start = monotonic_seconds();
+    for (uint32_t k = 0; k < lookups; k++) {
+        const char* name = store.parameters[(uint32_t)((k * 2654435761u) % count)].name;
+        hits += param_store_find(&store, name, strlen(name)) != PARAM_STORE_NONE;
+    }
+    double store_lookup_s = monotonic_seconds() - start;
 
-        // Validate the loaded parameter
-        system->parameters[system->parameter_count].is_valid =
-            validate_parameter(system->parameters[system->parameter_count].name,
-                             system->parameters[system->parameter_count].value);
+    start = monotonic_seconds();
+    int verified = config_image_verify(&image);
+    double verify_s = monotonic_seconds() - start;
 
-        system->parameter_count++;
+    // Every parameter of the CSV load, looked up in place
+    uint32_t matching = 0;
+    for (uint32_t id = 0; id < store.count; id++) {
+        const system_parameter_t* parameter = &store.parameters[id];
+        uint32_t record = config_image_find(&image, parameter->name, strlen(parameter->name));
+        if (record != CONFIG_IMAGE_NONE &&
+            strcmp(config_image_text(&image, image.records[record].value), parameter->value) == 0 &&
+            strcmp(config_image_text(&image, image.records[record].unit), parameter->unit) == 0) {
+            matching++;
+        }
     }
+    config_image_close(&image);
 
-    fclose(file);
-    system->is_loaded = true;
-    printf("Loaded %d parameters from commissioning file\n", system->parameter_count);
-    return true;
+    // Any change to the CSV file makes the image stale
+    config_image_stamp_t changed;
+    write_commissioning_csv(&store, path);
+    config_image_stamp(path, &changed);
+    config_image_status_t stale = config_image_open(&image, image_path, &changed, 1);
+    if (stale == CONFIG_IMAGE_OK) {
+        config_image_close(&image);
+    }
+
+    printf("\n=== Image Benchmark: %u parameters, CSV %.1f MB, image %.1f MB ===\n",
+           count, stamp.size / 1e6, image_stamp.size / 1e6);
+    printf("%-40s %12s\n", "Start-up", "Time");
+    printf("%-40s %9.1f ms\n", "load CSV file", csv_s * 1e3);
+    printf("%-40s %9.1f us\n", "open image + find 1 parameter in place", open_s * 1e6);
+    printf("%-40s %9.1f ms (%s)\n", "check body checksum", verify_s * 1e3, verified == 0 ? "ok" : "DAMAGED");
+    printf("%-40s %9.1f ms\n", "compile image", compile_s * 1e3);
+    printf("Lookup: %.0f ns in the image, %.0f ns in the store (%u of %u found)\n",
+           image_lookup_s * 1e9 / lookups, store_lookup_s * 1e9 / lookups, hits, 2 * lookups);
+    printf("Image values: %u of %u match the CSV load; found in %u of 1000 opens\n",
+           matching, store.count, found);
+    printf("After the CSV file changed: %s\n", stale == CONFIG_IMAGE_STALE ? "image refused as stale" : "STALE IMAGE USED");
+
+    remove(path);
+    remove(image_path);
+    param_store_free(&store);
 }
 
+#ifndef _WIN32
 /*
- * Display all commissioning parameters
+ * Check a saved crash-test file: a header and count rows, all holding the
+ * same value
+ *
+ * @return: The value's first character, or 0 if the file is missing, short or mixed
  */
-void display_parameters(commissioning_system_t* system) {
-    printf("\n=== %s Commissioning Parameters ===\n", system->system_name);
-    printf("%-20s %-15s %-10s %-25s %s\n", "Parameter", "Value", "Unit", "Description", "Status");
-    printf("--------------------------------------------------------------------------------\n");
+static char check_saved_file(const char* path, uint32_t count) {
+    csv_map_t map;
+    csv_row_t row;
+    uint32_t rows = 0;
+    char value = 0;
 
-    for (int i = 0; i < system->parameter_count; i++) {
-        printf("%-20s %-15s %-10s %-25s %s\n",
-               system->parameters[i].name,
-               system->parameters[i].value,
-               system->parameters[i].unit,
-               system->parameters[i].description,
-               system->parameters[i].is_valid ? "VALID" : "INVALID");
+    if (csv_map_open(&map, path) != 0) {
+        return 0;
     }
-    printf("================================================================================\n");
+    if (!csv_map_next_row(&map, &row) || !csv_field_equals(&row.fields[0], "Parameter")) {
+        csv_map_close(&map);
+        return 0;
+    }
+    while (csv_map_next_row(&map, &row)) {
+        if (row.field_count != 5 || row.fields[1].length != 1 || (rows > 0 && row.fields[1].data[0] != value)) {
+            value = 0;
+            break;
+        }
+        value = row.fields[1].data[0];
+        rows++;
+    }
+    csv_map_close(&map);
+    return rows == count ? value : 0;
 }
 
 /*
- * Update a parameter value with validation
+ * Kill a process while it saves, over and over, and check what is left on
+ * disk. The child saves the same parameters with every value "1", then
+ * every value "2", and so on; after each kill the file must hold one
+ * complete version. Run for the original in-place save and the atomic one.
  */
-bool update_parameter(commissioning_system_t* system, const char* name, const char* new_value) {
-    for (int i = 0; i < system->parameter_count; i++) {
-        if (strcmp(system->parameters[i].name, name) == 0) {
-            // Validate the new value
-            if (!validate_parameter(name, new_value)) {
-                printf("Error: Invalid value '%s' for parameter '%s'\n", new_value, name);
-                return false;
+void benchmark_crash(void) {
+    const uint32_t count = 200000;
+    const int trials = 40;
+    const char* path = "commissioning_bench.csv";
+    static const char* const writers[] = {"fprintf per field, in place", "buffered, temp + fsync + rename"};
+    param_store_t store = {0};
+
+    fill_bench_store(&store, count, "1");
+    double start = monotonic_seconds();
+    write_commissioning_csv(&store, path);
+    double save_s = monotonic_seconds() - start;
+
+    printf("\n=== Crash Test: %u parameters, %d kills per writer, one save takes %.1f ms ===\n",
+           count, trials, save_s * 1e3);
+    printf("%-34s %8s %8s %8s\n", "Writer", "Old", "New", "Corrupt");
+    for (int w = 0; w < 2; w++) {
+        int old_kept = 0, new_kept = 0, corrupt = 0;
+
+        write_commissioning_csv(&store, path);
+        for (int trial = 0; trial < trials; trial++) {
+            char before = check_saved_file(path, count);
+            pid_t child = fork();
+            if (child < 0) {
+                printf("Error: fork() failed\n");
+                break;
+            }
+            if (child == 0) {
+                // Save new versions until killed
+                for (char value = before == '1' ? '2' : '1';; value = value == '1' ? '2' : '1') {
+                    for (uint32_t k = 0; k < count; k++) {
+                        store.parameters[k].value[0] = value;
+                        store.parameters[k].value[1] = '\0';
+                    }
+                    if (w == 0) {
+                        bench_save_fprintf(&store, path);
+                    } else {
+                        write_commissioning_csv(&store, path);
+                    }
+                }
             }
 
-            strcpy(system->parameters[i].value, new_value);
-            system->parameters[i].is_valid = true;
-            printf("Parameter '%s' updated to '%s'\n", name, new_value);
-            return true;
+            // Kill it at a different point of a save each time
+            usleep((useconds_t)((0.2 + (trial % 10) * 0.13) * save_s * 1e6));
+            kill(child, SIGKILL);
+            waitpid(child, NULL, 0);
+
+            char after = check_saved_file(path, count);
+            if (after == 0) {
+                corrupt++;
+                write_commissioning_csv(&store, path);   // Start the next trial from a good file
+            } else if (after == before) {
+                old_kept++;
+            } else {
+                new_kept++;
+            }
         }
+        printf("%-34s %8d %8d %8d\n", writers[w], old_kept, new_kept, corrupt);
     }
 
-    printf("Error: Parameter '%s' not found\n", name);
-    return false;
+    remove(path);
+    remove("commissioning_bench.csv.tmp");   // Left by a killed atomic save
+    param_store_free(&store);
 }
+#endif
+
+// Bench output for messages nobody reads
+#ifdef _WIN32
+#define NULL_DEVICE "NUL"
+#else
+#define NULL_DEVICE "/dev/null"
+#endif
 
 /*
- * Add a new parameter to the system
+ * Append one line to a generated script
+ *
+ * @return: 0 on success, -1 if memory is exhausted
  */
-bool add_parameter(commissioning_system_t* system, const char* name, const char* value,
-                  const char* unit, const char* description) {
-    if (system->parameter_count >= MAX_PARAMETERS) {
-        printf("Error: Maximum number of parameters reached\n");
-        return false;
+static int append_script_line(char** text, size_t* size, size_t* capacity, const char* line) {
+    size_t length = strlen(line);
+
+    if (*size + length + 1 > *capacity) {
+        size_t grown_capacity = 2 * *capacity + length + 1;
+        char* grown = realloc(*text, grown_capacity);
+        if (grown == NULL) {
+            return -1;
+        }
+        *text = grown;
+        *capacity = grown_capacity;
     }
+    memcpy(*text + *size, line, length + 1);
+    *size += length;
+    return 0;
+}
 
-    // Check if parameter already exists
-    for (int i = 0; i < system->parameter_count; i++) {
-        if (strcmp(system->parameters[i].name, name) == 0) {
-            printf("Error: Parameter '%s' already exists\n", name);
-            return false;
+/*
+ * Time one batch script
+ *
+ * @return: Seconds taken
+ */
+static double bench_run_batch(commissioning_system_t* system, const char* text, size_t size,
+                              batch_result_t* result) {
+    csv_map_t script;
+
+    csv_map_buffer(&script, text, size);
+    double start = monotonic_seconds();
+    run_batch(system, &script, result);
+    return monotonic_seconds() - start;
+}
+
+static void print_batch_row(const char* label, uint32_t operations, double elapsed) {
+    printf("%-40s %8u %10.2f %12.0f\n", label, operations, elapsed * 1e3, operations / elapsed);
+}
+
+/*
+ * Benchmark batch mode on 100k parameters: 10k updates through the menu's
+ * update_parameter() (messages discarded) against the same updates as a
+ * script, then scripts of 100k updates, 10k additions, and a validate and
+ * save of all those changes to the journal. The file and journal are then
+ * reloaded and must match the parameters in memory.
+ */
+void benchmark_batch(void) {
+    const uint32_t count = 100000;
+    const uint32_t small = 10000;
+    const uint32_t bad = 100;             // Rows naming unknown parameters in the small script
+    const char* path = "commissioning_bench.csv";
+    commissioning_system_t system;
+    batch_result_t result;
+    char line[MAX_LINE_LENGTH];
+    char* text = NULL;
+    size_t size = 0, capacity = 0;
+    int failed = 0;
+
+    memset(&system, 0, sizeof(system));
+    strcpy(system.system_name, "Batch Benchmark");
+    load_schema(&system);
+    fill_bench_store(&system.store, count, "1500");
+    if (write_commissioning_csv(&system.store, path) != 0 || journal_init(&system.journal, path) != 0) {
+        printf("Error: Cannot write %s\n", path);
+        param_store_free(&system.store);
+        schema_free(&system.schema);
+        return;
+    }
+    journal_discard(&system.journal);
+    system.is_loaded = true;
+
+    printf("\n=== Batch Benchmark: %u parameters ===\n", count);
+    printf("%-40s %8s %10s %12s\n", "Operations", "Ops", "Time (ms)", "Ops/s");
+
+    // The menu's update path, one call and its messages per parameter
+    FILE* null_output = fopen(NULL_DEVICE, "w");
+    if (null_output != NULL) {
+        int saved_stdout = redirect_stdout(fileno(null_output));
+        double start = monotonic_seconds();
+        for (uint32_t k = 0; k < small; k++) {
+            char name[MAX_NAME_LENGTH];
+            snprintf(name, sizeof(name), "sensor_%07u", (uint32_t)(((uint64_t)k * 2654435761u) % count));
+            snprintf(line, sizeof(line), "%u", 1000 + k % 1000);
+            update_parameter(&system, name, line);
         }
+        double elapsed = monotonic_seconds() - start;
+        restore_stdout(saved_stdout);
+        fclose(null_output);
+        print_batch_row("menu update_parameter(), set", small, elapsed);
     }
 
-    // Validate the value
-    if (!validate_parameter(name, value)) {
-        printf("Error: Invalid value '%s' for parameter '%s'\n", value, name);
-        return false;
+    // The same updates as a script, plus rows that must fail
+    for (uint32_t k = 0; k < small + bad; k++) {
+        if (k < small) {
+            snprintf(line, sizeof(line), "set,sensor_%07u,%u\n",
+                     (uint32_t)(((uint64_t)k * 2654435761u) % count), 2000 + k % 1000);
+        } else {
+            snprintf(line, sizeof(line), "set,missing_%u,1\n", k);
+        }
+        failed |= append_script_line(&text, &size, &capacity, line);
     }
+    double elapsed = bench_run_batch(&system, text, size, &result);
+    print_batch_row("batch, set", result.operations, elapsed);
+    uint32_t small_failed = result.failed;
+    free(result.errors);
 
-    // Add the new parameter
-    strcpy(system->parameters[system->parameter_count].name, name);
-    strcpy(system->parameters[system->parameter_count].value, value);
-    strcpy(system->parameters[system->parameter_count].unit, unit);
-    strcpy(system->parameters[system->parameter_count].description, description);
-    system->parameters[system->parameter_count].is_valid = true;
-    system->parameter_count++;
+    // Every parameter once
+    size = 0;
+    for (uint32_t k = 0; k < count; k++) {
+        snprintf(line, sizeof(line), "set,sensor_%07u,%u\n", k, 7 + k % 1000);
+        failed |= append_script_line(&text, &size, &capacity, line);
+    }
+    elapsed = bench_run_batch(&system, text, size, &result);
+    print_batch_row("batch, set", result.operations, elapsed);
+    uint32_t mismatched = result.failed;
+    free(result.errors);
+    for (uint32_t k = 0; k < count; k++) {
+        snprintf(line, sizeof(line), "%u", 7 + k % 1000);
+        mismatched += strcmp(system.store.parameters[k].value, line) != 0;
+    }
 
-    printf("Parameter '%s' added successfully\n", name);
-    return true;
+    size = 0;
+    for (uint32_t k = 0; k < small; k++) {
+        snprintf(line, sizeof(line), "add,batch_new_%07u,%u,mV,\"Added, by script\"\n", k, k);
+        failed |= append_script_line(&text, &size, &capacity, line);
+    }
+    elapsed = bench_run_batch(&system, text, size, &result);
+    print_batch_row("batch, add", result.operations, elapsed);
+    mismatched += result.failed;
+    free(result.errors);
+
+    // One validation and one journal save for all of it
+    size = 0;
+    failed |= append_script_line(&text, &size, &capacity, "# Check, then save\nvalidate\nsave\n");
+    uint32_t changes = system.store.change_count;
+    elapsed = bench_run_batch(&system, text, size, &result);
+    print_batch_row("batch, validate + save (ops = changes)", changes, elapsed);
+    mismatched += result.failed;
+    free(result.errors);
+    free(text);
+
+    journal_wait(&system.journal);
+    param_store_t reloaded = {0};
+    schema_t schema = {0};
+    parallel_load_stats_t stats;
+    read_commissioning_file(path, &schema, &system.journal, &reloaded, &stats);
+    printf("Bad rows reported: %u of %u; values wrong: %u; reloaded file + journal: %s\n",
+           small_failed, bad, mismatched,
+           store_fingerprint(&reloaded) == store_fingerprint(&system.store) ? "same as in memory" : "DIFFERENT");
+    if (failed) {
+        printf("Error: Out of memory generating scripts\n");
+    }
+
+    journal_discard(&system.journal);
+    journal_free(&system.journal);
+    remove(path);
+    param_store_free(&reloaded);
+    param_store_free(&system.store);
+    schema_free(&system.schema);
 }
 
 /*
- * Main menu system for user interaction
+ * Run a named benchmark and return the process exit code.
  */
-void show_menu() {
-    printf("\n=== Commissioning File System Menu ===\n");
-    printf("1. Display all parameters\n");
-    printf("2. Update parameter value\n");
-    printf("3. Add new parameter\n");
-    printf("4. Save to file\n");
-    printf("5. Load from file\n");
-    printf("6. Validate all parameters\n");
-    printf("0. Exit\n");
-    printf("Choice: ");
+int run_benchmark(const char* name) {
+    int all = strcmp(name, "all") == 0;
+    int found = 0;
+
+    if (all || strcmp(name, "load") == 0) {
+        benchmark_load();
+        found = 1;
+    }
+    if (all || strcmp(name, "lookup") == 0) {
+        benchmark_lookup();
+        found = 1;
+    }
+    if (all || strcmp(name, "validate") == 0) {
+        benchmark_validate();
+        found = 1;
+    }
+    if (all || strcmp(name, "schema") == 0) {
+        benchmark_schema();
+        found = 1;
+    }
+    if (all || strcmp(name, "parallel") == 0) {
+        benchmark_parallel();
+        found = 1;
+    }
+    if (all || strcmp(name, "save") == 0) {
+        benchmark_save();
+        found = 1;
+    }
+    if (all || strcmp(name, "delta") == 0) {
+        benchmark_delta();
+        found = 1;
+    }
+    if (all || strcmp(name, "image") == 0) {
+        benchmark_image();
+        found = 1;
+    }
+#ifndef _WIN32
+    if (all || strcmp(name, "crash") == 0) {
+        benchmark_crash();
+        found = 1;
+    }
+#endif
+    if (all || strcmp(name, "batch") == 0) {
+        benchmark_batch();
+        found = 1;
+    }
+
+    if (!found) {
+        printf("Unknown benchmark '%s' (available: load, lookup, validate, schema, parallel, save, delta, image, crash, batch, all)\n", name);
+        return 1;
+    }
+    return 0;
 }
 
 /*
@@ -299,15 +2239,42 @@ void show_menu() {
  * This function implements the main program loop and user interface
  * Demonstrates typical embedded system startup sequence and menu-driven interface
  */
-int main() {
+int main(int argc, char* argv[]) {
     // Declare system structure and user input variables
     commissioning_system_t system;                    // Main system structure
     char choice;                                      // User menu choice
-    char param_name[MAX_NAME_LENGTH];                 // Parameter name input buffer
+    char param_name[MAX_LINE_LENGTH];                 // Parameter name input buffer (names may be long)
     char param_value[MAX_NAME_LENGTH];                // Parameter value input buffer
     char param_unit[MAX_NAME_LENGTH];                 // Parameter unit input buffer
     char param_desc[MAX_NAME_LENGTH];                 // Parameter description input buffer
 
+    // Command-line options: benchmarks run headless and exit
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            return run_benchmark(argv[++i]);
+        } else if (strcmp(argv[i], "--diff") == 0 && i + 2 < argc) {
+            return diff_files(argv[i + 1], argv[i + 2]);
+        } else if (strcmp(argv[i], "--get") == 0 && i + 1 < argc) {
+            return get_parameters(argv + i + 1, argc - i - 1);
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            return run_batch_script(argv[i + 1]);
+        } else if (strcmp(argv[i], "--compile") == 0) {
+            init_commissioning_system(&system, "Industrial Control System");
+            bool compiled = load_commissioning_file(&system) && compile_commissioning_image(&system);
+            journal_free(&system.journal);
+            param_store_free(&system.store);
+            schema_free(&system.schema);
+            return compiled ? 0 : 1;
+        } else {
+            printf("Usage: %s [--bench load|lookup|validate|schema|parallel|save|delta|image|crash|batch|all |\n"
+                   "        --diff OLD NEW | --compile | --get NAME... | --batch SCRIPT|-]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Time file loading when PROFILE_OUTPUT names a trace file
+    profiler_start_from_env();
+
     // System initialization - first step in embedded system startup
     init_commissioning_system(&system, "Industrial Control System");
     printf("Commissioning File Simulation System Started\n");
@@ -330,21 +2297,21 @@ int main() {
 
             case '2':  // Update existing parameter
                 printf("Enter parameter name: ");
-                scanf("%s", param_name);
+                scanf("%255s", param_name);
                 printf("Enter new value: ");
-                scanf("%s", param_value);
+                scanf("%31s", param_value);
                 update_parameter(&system, param_name, param_value);
                 break;
 
             case '3':  // Add new parameter
                 printf("Enter parameter name: ");
-                scanf("%s", param_name);
+                scanf("%255s", param_name);
                 printf("Enter value: ");
-                scanf("%s", param_value);
+                scanf("%31s", param_value);
                 printf("Enter unit: ");
-                scanf("%s", param_unit);
+                scanf("%31s", param_unit);
                 printf("Enter description: ");
-                scanf("%s", param_desc);
+                scanf("%31s", param_desc);
                 add_parameter(&system, param_name, param_value, param_unit, param_desc);
                 break;
 
@@ -359,15 +2326,26 @@ int main() {
             case '6':  // Validate all parameters
                 printf("Validating all parameters...\n");
                 // Re-validate all parameters - demonstrates safety checking
-                for (int i = 0; i < system.parameter_count; i++) {
-                    system.parameters[i].is_valid =
-                        validate_parameter(system.parameters[i].name, system.parameters[i].value);
-                }
+                // One pass over the parameters, then the schema's constraints
+                validate_all_parameters(&system);
                 printf("Validation complete\n");
                 break;
 
+            case '7':  // Compare with a saved file
+                printf("Enter file name (%s for the last save): ", COMMISSIONING_FILE);
+                scanf("%255s", param_name);
+                diff_with_file(&system, param_name);
+                break;
+
+            case '8':  // Compile the saved parameters for fast start-up
+                compile_commissioning_image(&system);
+                break;
+
             case '0':  // Exit program
                 printf("Exiting Commissioning System\n");
+                journal_free(&system.journal);   // Lets a compaction finish
+                param_store_free(&system.store);
+                schema_free(&system.schema);
                 return 0;  // Clean exit with success code
 
             default:  // Handle invalid input
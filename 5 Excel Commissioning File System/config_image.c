@@ -0,0 +1,281 @@
+/*
+ * Compiled Configuration Image
+ * ============================
+ *
+ * Compiling, opening and in-place lookups declared in config_image.h.
+ */
+
+// Expose st_mtim and madvise() when building with -std=c99
+#define _DEFAULT_SOURCE
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "atomic_file.h"
+#include "config_image.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+#define IMAGE_ALIGN 8                    // Sections start on 8-byte boundaries
+
+static uint64_t align_up(uint64_t offset) {
+    return (offset + IMAGE_ALIGN - 1) & ~(uint64_t)(IMAGE_ALIGN - 1);
+}
+
+/*
+ * FNV-1a over 8-byte words, then the remaining bytes: one multiply per
+ * word, so a 100 MB image is checked in a few tens of milliseconds
+ */
+static uint64_t checksum(const void* data, size_t length) {
+    const unsigned char* bytes = data;
+    uint64_t sum = 0xcbf29ce484222325ull;
+    size_t k = 0;
+
+    for (; k + 8 <= length; k += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + k, 8);
+        sum = (sum ^ word) * 0x100000001b3ull;
+    }
+    for (; k < length; k++) {
+        sum = (sum ^ bytes[k]) * 0x100000001b3ull;
+    }
+    return sum;
+}
+
+/*
+ * Stamp a file with its size and modification time
+ */
+void config_image_stamp(const char* path, config_image_stamp_t* stamp) {
+    struct stat info;
+
+    if (stat(path, &info) != 0) {
+        stamp->size = -1;
+        stamp->mtime_ns = 0;
+        return;
+    }
+    stamp->size = (int64_t)info.st_size;
+#ifdef _WIN32
+    stamp->mtime_ns = (int64_t)info.st_mtime * 1000000000;
+#else
+    stamp->mtime_ns = (int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+}
+
+/*
+ * Append text and its '\0' to the strings section
+ *
+ * @return: The text's offset in the section
+ */
+static uint32_t put_string(char* strings, uint64_t* used, const char* text, size_t length) {
+    uint32_t offset = (uint32_t)*used;
+
+    memcpy(strings + offset, text, length);
+    strings[offset + length] = '\0';
+    *used += length + 1;
+    return offset;
+}
+
+/*
+ * Compile a store into an image at path, stamped with its source files.
+ * The image is built in memory and saved atomically.
+ *
+ * @return: 0 on success, -1 if it is too large, memory is exhausted or the
+ *          file cannot be written (the old image is kept)
+ */
+int config_image_write(const param_store_t* store, const char* path,
+                       const config_image_stamp_t* sources, uint32_t source_count) {
+    uint64_t strings_size = 0;
+    uint32_t slot_count = 16;
+
+    for (uint32_t id = 0; id < store->count; id++) {
+        const system_parameter_t* parameter = &store->parameters[id];
+        strings_size += strlen(parameter->name) + strlen(parameter->value) + strlen(parameter->unit) +
+                        strlen(parameter->description) + 4;
+    }
+    if (strings_size >= UINT32_MAX || source_count > CONFIG_IMAGE_SOURCES) {
+        return -1;
+    }
+    while (slot_count < 2 * (uint64_t)store->count) {
+        slot_count *= 2;
+    }
+
+    // Lay out the sections
+    config_image_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = CONFIG_IMAGE_MAGIC;
+    header.version = CONFIG_IMAGE_VERSION;
+    header.record_size = sizeof(config_image_record_t);
+    header.count = store->count;
+    header.slot_count = slot_count;
+    header.slots_offset = align_up(sizeof(header));
+    header.records_offset = align_up(header.slots_offset + (uint64_t)slot_count * sizeof(config_image_slot_t));
+    header.strings_offset = align_up(header.records_offset + (uint64_t)store->count * sizeof(config_image_record_t));
+    header.size = align_up(header.strings_offset + strings_size + 1);   // Ends in '\0' even when empty
+    memcpy(header.sources, sources, source_count * sizeof(config_image_stamp_t));
+
+    char* image = calloc(1, header.size);
+    if (image == NULL) {
+        return -1;
+    }
+    config_image_slot_t* slots = (config_image_slot_t*)(image + header.slots_offset);
+    config_image_record_t* records = (config_image_record_t*)(image + header.records_offset);
+    char* strings = image + header.strings_offset;
+    uint64_t used = 0;
+
+    memset(slots, 0xFF, (size_t)slot_count * sizeof(config_image_slot_t));
+    for (uint32_t id = 0; id < store->count; id++) {
+        const system_parameter_t* parameter = &store->parameters[id];
+        config_image_record_t* record = &records[id];
+        size_t length = strlen(parameter->name);
+
+        record->hash = param_store_hash(parameter->name, length);
+        record->name = put_string(strings, &used, parameter->name, length);
+        record->name_length = (uint32_t)length;
+        record->value = put_string(strings, &used, parameter->value, strlen(parameter->value));
+        record->unit = put_string(strings, &used, parameter->unit, strlen(parameter->unit));
+        record->description = put_string(strings, &used, parameter->description, strlen(parameter->description));
+        memcpy(&record->as, &parameter->typed.as, sizeof(record->as));
+        record->type = parameter->typed.type;
+        record->parsed = parameter->typed.parsed;
+        record->is_valid = parameter->is_valid;
+
+        uint32_t slot = record->hash & (slot_count - 1);
+        while (slots[slot].record != CONFIG_IMAGE_NONE) {
+            slot = (slot + 1) & (slot_count - 1);
+        }
+        slots[slot].hash = record->hash;
+        slots[slot].record = id;
+    }
+
+    header.body_checksum = checksum(image + sizeof(header), header.size - sizeof(header));
+    header.header_checksum = checksum(&header, offsetof(config_image_header_t, header_checksum));
+    memcpy(image, &header, sizeof(header));
+
+    atomic_file_t file;
+    int result = -1;
+    if (atomic_file_open(&file, path) == 0) {
+        if (atomic_file_write(&file, image, header.size) == 0) {
+            result = atomic_file_commit(&file);
+        } else {
+            atomic_file_abort(&file);
+        }
+    }
+    free(image);
+    return result;
+}
+
+/*
+ * Map an image and check that it is whole and compiled from the given
+ * source files as they are now. The body checksum is not checked
+ * (config_image_verify()).
+ *
+ * @return: CONFIG_IMAGE_OK if the image can be used; otherwise it is closed
+ */
+config_image_status_t config_image_open(config_image_t* image, const char* path,
+                                        const config_image_stamp_t* sources, uint32_t source_count) {
+    memset(image, 0, sizeof(*image));
+    if (csv_map_open(&image->map, path) != 0) {
+        return CONFIG_IMAGE_MISSING;
+    }
+#ifndef _WIN32
+    if (image->map.data != NULL) {
+        madvise((void*)image->map.data, image->map.size, MADV_NORMAL);   // Lookups jump around
+    }
+#endif
+
+    const config_image_header_t* header = (const config_image_header_t*)image->map.data;
+    uint64_t size = image->map.size;
+    if (size < sizeof(*header) || header->magic != CONFIG_IMAGE_MAGIC ||
+        header->version != CONFIG_IMAGE_VERSION || header->record_size != sizeof(config_image_record_t) ||
+        header->header_checksum != checksum(header, offsetof(config_image_header_t, header_checksum)) ||
+        header->size != size || header->slot_count == 0 || (header->slot_count & (header->slot_count - 1)) != 0 ||
+        header->slots_offset < sizeof(*header) || header->slots_offset % IMAGE_ALIGN != 0 ||
+        header->records_offset % IMAGE_ALIGN != 0 ||
+        header->slots_offset + (uint64_t)header->slot_count * sizeof(config_image_slot_t) > header->records_offset ||
+        header->records_offset + (uint64_t)header->count * sizeof(config_image_record_t) > header->strings_offset ||
+        header->strings_offset >= size || image->map.data[size - 1] != '\0') {
+        config_image_close(image);
+        return CONFIG_IMAGE_INVALID;
+    }
+    if (source_count > CONFIG_IMAGE_SOURCES ||
+        memcmp(header->sources, sources, source_count * sizeof(config_image_stamp_t)) != 0) {
+        config_image_close(image);
+        return CONFIG_IMAGE_STALE;
+    }
+
+    image->header = header;
+    image->slots = (const config_image_slot_t*)(image->map.data + header->slots_offset);
+    image->records = (const config_image_record_t*)(image->map.data + header->records_offset);
+    image->strings = image->map.data + header->strings_offset;
+    image->strings_size = size - header->strings_offset;
+    return CONFIG_IMAGE_OK;
+}
+
+void config_image_close(config_image_t* image) {
+    csv_map_close(&image->map);
+    memset(image, 0, sizeof(*image));
+}
+
+/*
+ * Check the body checksum, reading the whole image
+ *
+ * @return: 0 if it matches, -1 if the image is damaged
+ */
+int config_image_verify(const config_image_t* image) {
+    const config_image_header_t* header = image->header;
+
+    return checksum(image->map.data + sizeof(*header), header->size - sizeof(*header)) ==
+           header->body_checksum ? 0 : -1;
+}
+
+/*
+ * Look a name up in place. The body is not checksummed on open, so a
+ * damaged index or record cannot send the probe past the table or a name
+ * past the strings section.
+ *
+ * @return: The record holding a name, or CONFIG_IMAGE_NONE
+ */
+uint32_t config_image_find(const config_image_t* image, const char* name, size_t length) {
+    uint32_t hash = param_store_hash(name, length);
+    uint32_t mask = image->header->slot_count - 1;
+    uint32_t slot = hash & mask;
+
+    for (uint32_t probe = 0; probe < image->header->slot_count; probe++, slot = (slot + 1) & mask) {
+        const config_image_slot_t* entry = &image->slots[slot];
+        if (entry->record == CONFIG_IMAGE_NONE) {
+            return CONFIG_IMAGE_NONE;
+        }
+        if (entry->hash != hash || entry->record >= image->header->count) {
+            continue;
+        }
+        const config_image_record_t* record = &image->records[entry->record];
+        if (record->name_length == length && record->name < image->strings_size &&
+            length <= image->strings_size - record->name &&
+            memcmp(image->strings + record->name, name, length) == 0) {
+            return entry->record;
+        }
+    }
+    return CONFIG_IMAGE_NONE;
+}
+
+/*
+ * @return: A text in the strings section ("" if the offset is out of range)
+ */
+const char* config_image_text(const config_image_t* image, uint32_t offset) {
+    return offset < image->strings_size ? image->strings + offset : "";
+}
+
+/*
+ * Unpack a record's typed value
+ */
+void config_image_value(const config_image_t* image, uint32_t id, param_value_t* value) {
+    const config_image_record_t* record = &image->records[id];
+
+    memset(value, 0, sizeof(*value));
+    memcpy(&value->as, &record->as, sizeof(record->as));
+    value->type = record->type;
+    value->parsed = record->parsed;
+}
@@ -0,0 +1,117 @@
+/*
+ * Compiled Configuration Image
+ * ============================
+ *
+ * A binary copy of a validated parameter store that programs map and read
+ * in place, with nothing to parse at start-up:
+ *
+ *   header    fixed size: magic, version, section offsets, the stamps of
+ *             the files it was compiled from and two checksums
+ *   slots     open-addressing hash index on the name (param_store_hash()),
+ *             a power of two at most half full
+ *   records   one per parameter, in store order: its typed value (packed,
+ *             param_value.h), validity and the offsets of its texts
+ *   strings   name, value, unit and description of every parameter,
+ *             each ending in '\0'
+ *
+ * Opening checks the header, its checksum and the section bounds, then
+ * compares the stamps (size and modification time) of the source files -
+ * the commissioning file, its journals and the schema - with the current
+ * ones. Any difference makes the image stale and the caller falls back to
+ * the CSV file. All of this is O(1), so opening takes microseconds however
+ * many parameters the image holds. The body checksum covers every byte
+ * after the header; config_image_verify() checks it in one pass.
+ *
+ * The image is written through atomic_file.h, so readers see the old image
+ * or the new one. Its layout is that of the machine that compiled it: an
+ * image from a different byte order or layout fails the magic or record
+ * size check and is treated as invalid.
+ */
+
+#ifndef CONFIG_IMAGE_H
+#define CONFIG_IMAGE_H
+
+#include <stdint.h>
+#include "csv_map.h"
+#include "param_store.h"
+#include "param_value.h"
+
+#define CONFIG_IMAGE_MAGIC 0x474D4943u   // "CIMG" read as a little-endian word
+#define CONFIG_IMAGE_VERSION 1
+#define CONFIG_IMAGE_SOURCES 4           // Stamps kept in the header
+#define CONFIG_IMAGE_NONE UINT32_MAX     // No record
+
+typedef enum {
+    CONFIG_IMAGE_OK = 0,
+    CONFIG_IMAGE_MISSING,                // No image file
+    CONFIG_IMAGE_INVALID,                // Not an image, other version, or damaged header
+    CONFIG_IMAGE_STALE                   // A source file changed since it was compiled
+} config_image_status_t;
+
+// Size and modification time of a file; size -1 if it does not exist
+typedef struct {
+    int64_t size;
+    int64_t mtime_ns;
+} config_image_stamp_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;                // sizeof(config_image_record_t)
+    uint32_t count;                      // Records
+    uint32_t slot_count;                 // Power of two
+    uint64_t size;                       // Bytes in the image
+    uint64_t slots_offset;
+    uint64_t records_offset;
+    uint64_t strings_offset;
+    config_image_stamp_t sources[CONFIG_IMAGE_SOURCES];
+    uint64_t body_checksum;              // Bytes after the header
+    uint64_t header_checksum;            // Bytes above
+} config_image_header_t;
+
+// Index slot: empty when record is CONFIG_IMAGE_NONE
+typedef struct {
+    uint32_t hash;
+    uint32_t record;
+} config_image_slot_t;
+
+typedef struct {
+    union {
+        int64_t i;
+        double f;
+        uint32_t e;
+        uint8_t b;
+    } as;                                // param_value_t's value
+    uint32_t hash;                       // param_store_hash() of the name
+    uint32_t name;                       // Offsets into the strings section
+    uint32_t name_length;
+    uint32_t value;
+    uint32_t unit;
+    uint32_t description;
+    uint8_t type;                        // param_type_t
+    uint8_t parsed;
+    uint8_t is_valid;
+    uint8_t reserved[5];
+} config_image_record_t;
+
+typedef struct {
+    csv_map_t map;                       // The mapped file
+    const config_image_header_t* header;
+    const config_image_slot_t* slots;
+    const config_image_record_t* records;
+    const char* strings;
+    uint64_t strings_size;
+} config_image_t;
+
+void config_image_stamp(const char* path, config_image_stamp_t* stamp);
+int config_image_write(const param_store_t* store, const char* path,
+                       const config_image_stamp_t* sources, uint32_t source_count);
+config_image_status_t config_image_open(config_image_t* image, const char* path,
+                                        const config_image_stamp_t* sources, uint32_t source_count);
+void config_image_close(config_image_t* image);
+int config_image_verify(const config_image_t* image);
+uint32_t config_image_find(const config_image_t* image, const char* name, size_t length);
+const char* config_image_text(const config_image_t* image, uint32_t offset);
+void config_image_value(const config_image_t* image, uint32_t id, param_value_t* value);
+
+#endif // CONFIG_IMAGE_H
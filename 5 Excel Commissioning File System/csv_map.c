@@ -0,0 +1,372 @@
+/*
+ * Memory-Mapped CSV Reader
+ * ========================
+ *
+ * Mapping and memchr()-based row splitting declared in csv_map.h.
+ */
+
+// Expose madvise() when building with -std=c99
+#define _DEFAULT_SOURCE
+
+#include <string.h>
+#include "csv_map.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Map a file for reading. An empty file maps to no rows.
+ *
+ * @return: 0 on success, -1 if the file cannot be opened or mapped
+ */
+int csv_map_open(csv_map_t* map, const char* path) {
+    memset(map, 0, sizeof(*map));
+    map->line = 1;
+
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return -1;
+    }
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return -1;
+    }
+    map->file_handle = file;
+    if (size.QuadPart == 0) {
+        return 0;
+    }
+
+    map->mapping_handle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (map->mapping_handle == NULL) {
+        csv_map_close(map);
+        return -1;
+    }
+    map->data = MapViewOfFile(map->mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if (map->data == NULL) {
+        csv_map_close(map);
+        return -1;
+    }
+    map->size = (size_t)size.QuadPart;
+#else
+    struct stat info;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return -1;
+    }
+    if (info.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);   // The mapping keeps the file open
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+    madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+    map->data = data;
+    map->size = (size_t)info.st_size;
+#endif
+    map->end = map->size;
+    return 0;
+}
+
+/*
+ * Unmap the file. Views returned by csv_map_next_row() are invalid after this.
+ */
+void csv_map_close(csv_map_t* map) {
+#ifdef _WIN32
+    if (map->data != NULL) {
+        UnmapViewOfFile(map->data);
+    }
+    if (map->mapping_handle != NULL) {
+        CloseHandle(map->mapping_handle);
+    }
+    if (map->file_handle != NULL) {
+        CloseHandle(map->file_handle);
+    }
+#else
+    if (map->data != NULL) {
+        munmap((void*)map->data, map->size);
+    }
+#endif
+    memset(map, 0, sizeof(*map));
+}
+
+/*
+ * Make a reader for the rows of an open file that start in [start, end).
+ * Its line numbers count from 1 at start. The range shares the file's
+ * mapping: it must not be closed, and is invalid once the file is closed.
+ */
+void csv_map_range(const csv_map_t* file, size_t start, size_t end, csv_map_t* range) {
+    memset(range, 0, sizeof(*range));
+    range->data = file->data;
+    range->size = file->size;
+    range->offset = start < file->size ? start : file->size;
+    range->end = end < file->size ? end : file->size;
+    range->line = 1;
+}
+
+/*
+ * Make a reader for text already in memory, such as a script read from a
+ * pipe. The caller owns the text: the reader must not be closed, and is
+ * invalid once the text is freed.
+ */
+void csv_map_buffer(csv_map_t* map, const char* data, size_t size) {
+    memset(map, 0, sizeof(*map));
+    map->data = size > 0 ? data : NULL;
+    map->size = size;
+    map->end = size;
+    map->line = 1;
+}
+
+/*
+ * @return: Line breaks in [from, to)
+ */
+static uint32_t count_line_breaks(const char* from, const char* to) {
+    uint32_t count = 0;
+
+    while (from < to && (from = memchr(from, '\n', (size_t)(to - from))) != NULL) {
+        count++;
+        from++;
+    }
+    return count;
+}
+
+/*
+ * Split the next non-blank row into fields.
+ *
+ * @return: 1 if a row was read, 0 at the end of the file
+ */
+int csv_map_next_row(csv_map_t* map, csv_row_t* row) {
+    const char* end = map->data + map->size;
+    const char* p;
+    const char* line_end;
+
+    // Skip blank lines
+    for (;;) {
+        if (map->offset >= map->end) {
+            return 0;
+        }
+        p = map->data + map->offset;
+        if (p[0] == '\n') {
+            map->offset++;
+        } else if (p[0] == '\r' && p + 1 < end && p[1] == '\n') {
+            map->offset += 2;
+        } else {
+            break;
+        }
+        map->line++;
+    }
+
+    row->field_count = 0;
+    row->line = map->line;
+    line_end = memchr(p, '\n', (size_t)(end - p));
+    if (line_end == NULL) {
+        line_end = end;
+    }
+
+    // One field per pass; p is at the field's first character
+    for (;;) {
+        csv_field_t field;
+        const char* next;   // Comma after the field, or line_end
+
+        field.escaped = 0;
+        if (p < line_end && p[0] == '"') {
+            const char* quote = p + 1;
+
+            // Closing quote: the next '"' that is not part of a "" pair
+            for (;;) {
+                quote = memchr(quote, '"', (size_t)(end - quote));
+                if (quote == NULL) {
+                    quote = end;   // Unterminated: the field runs to the end of the file
+                    break;
+                }
+                if (quote + 1 < end && quote[1] == '"') {
+                    field.escaped = 1;
+                    quote += 2;
+                    continue;
+                }
+                break;
+            }
+            field.data = p + 1;
+            field.length = (uint32_t)(quote - field.data);
+
+            // Line breaks inside the quotes belong to this row
+            if (quote > line_end) {
+                map->line += count_line_breaks(line_end, quote);
+                line_end = quote < end ? memchr(quote, '\n', (size_t)(end - quote)) : NULL;
+                if (line_end == NULL) {
+                    line_end = end;
+                }
+            }
+
+            // Anything between the closing quote and the comma is dropped
+            p = quote < end ? quote + 1 : end;
+            next = memchr(p, ',', (size_t)(line_end - p));
+            if (next == NULL) {
+                next = line_end;
+            }
+        } else {
+            next = memchr(p, ',', (size_t)(line_end - p));
+            if (next == NULL) {
+                next = line_end;
+            }
+            field.data = p;
+            field.length = (uint32_t)(next - p);
+            if (next == line_end && field.length > 0 && p[field.length - 1] == '\r') {
+                field.length--;
+            }
+        }
+
+        if (row->field_count < CSV_MAP_MAX_FIELDS) {
+            row->fields[row->field_count] = field;
+        }
+        row->field_count++;
+
+        if (next == line_end) {
+            break;
+        }
+        p = next + 1;
+    }
+
+    map->offset = line_end < end ? (size_t)(line_end - map->data) + 1 : map->size;
+    map->line++;
+    return 1;
+}
+
+/*
+ * Copy a field into dest as a C string, undoing "" escapes. Like snprintf(),
+ * the copy is cut to fit and the full length is returned, so a result
+ * >= size means the field was truncated.
+ *
+ * @return: Length of the whole field
+ */
+size_t csv_field_copy(const csv_field_t* field, char* dest, size_t size) {
+    size_t length = 0;
+
+    if (!field->escaped) {
+        length = field->length;
+        if (size > 0) {
+            size_t n = length < size - 1 ? length : size - 1;
+            memcpy(dest, field->data, n);
+            dest[n] = '\0';
+        }
+        return length;
+    }
+
+    for (uint32_t i = 0; i < field->length; i++) {
+        if (field->data[i] == '"') {
+            i++;   // First of a "" pair: keep the second
+        }
+        if (length + 1 < size) {
+            dest[length] = field->data[i];
+        }
+        length++;
+    }
+    if (size > 0) {
+        dest[length < size ? length : size - 1] = '\0';
+    }
+    return length;
+}
+
+/*
+ * @return: 1 if the field's text (after unescaping) is exactly text
+ */
+int csv_field_equals(const csv_field_t* field, const char* text) {
+    size_t length = strlen(text);
+
+    if (!field->escaped) {
+        return field->length == length && memcmp(field->data, text, length) == 0;
+    }
+
+    size_t k = 0;
+    for (uint32_t i = 0; i < field->length; i++, k++) {
+        if (field->data[i] == '"') {
+            i++;
+        }
+        if (k >= length || field->data[i] != text[k]) {
+            return 0;
+        }
+    }
+    return k == length;
+}
+
+/*
+ * Format one field into dest, quoted if it contains a comma, quote or line
+ * break so that csv_map_next_row() reads it back unchanged. dest needs
+ * CSV_FIELD_MAX(strlen(text)) bytes; no terminator is written.
+ *
+ * @return: Bytes written
+ */
+size_t csv_format_field(char* dest, const char* text) {
+    size_t length = strlen(text);
+
+    if (strpbrk(text, ",\"\r\n") == NULL) {
+        memcpy(dest, text, length);
+        return length;
+    }
+
+    char* out = dest;
+    *out++ = '"';
+    for (const char* c = text; *c != '\0'; c++) {
+        if (*c == '"') {
+            *out++ = '"';
+        }
+        *out++ = *c;
+    }
+    *out++ = '"';
+    return (size_t)(out - dest);
+}
+
+/*
+ * Format a row of fields, separated by commas and ended by '\n'. dest
+ * needs the sum of CSV_FIELD_MAX() over the fields plus count bytes.
+ *
+ * @return: Bytes written
+ */
+size_t csv_format_row(char* dest, const char* const* fields, uint32_t count) {
+    char* end = dest;
+
+    for (uint32_t f = 0; f < count; f++) {
+        if (f > 0) {
+            *end++ = ',';
+        }
+        end += csv_format_field(end, fields[f]);
+    }
+    *end++ = '\n';
+    return (size_t)(end - dest);
+}
+
+/*
+ * Write one field, quoted if it contains a comma, quote or line break so
+ * that csv_map_next_row() reads it back unchanged
+ */
+void csv_write_field(FILE* file, const char* text) {
+    if (strpbrk(text, ",\"\r\n") == NULL) {
+        fputs(text, file);
+        return;
+    }
+
+    fputc('"', file);
+    for (const char* c = text; *c != '\0'; c++) {
+        if (*c == '"') {
+            fputc('"', file);
+        }
+        fputc(*c, file);
+    }
+    fputc('"', file);
+}
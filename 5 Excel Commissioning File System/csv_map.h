@@ -0,0 +1,77 @@
+/*
+ * Memory-Mapped CSV Reader
+ * ========================
+ *
+ * Reads a commissioning file in place: the file is mapped read-only and
+ * each row is returned as views (pointer and length) into the mapping, so
+ * nothing is copied until the caller decides what to keep.
+ *
+ * Rows and fields are found with memchr(), which the C library vectorizes
+ * (SSE2/AVX2 on x86-64), instead of walking the text byte by byte:
+ * - the end of a row is the next '\n'
+ * - the end of an unquoted field is the next ',' before the row end
+ * - the end of a quoted field is the next '"' not followed by another '"'
+ *
+ * Quoted fields may contain commas, doubled quotes ("") and line breaks.
+ * Their views exclude the surrounding quotes. Views with doubled quotes are
+ * flagged as escaped, and csv_field_copy() undoes the escaping while
+ * copying. A '\r' before the line break is dropped, and blank lines are
+ * skipped.
+ *
+ * The mapping stays valid until csv_map_close(), so the views can be kept
+ * for as long as the reader is open.
+ *
+ * csv_map_range() makes a second reader over part of an open file, so
+ * several threads can split different parts of it at once. A range returns
+ * the rows that start inside it; the last one may run past its end when a
+ * quoted field holds a line break. csv_map_buffer() reads text that is
+ * already in memory the same way.
+ */
+
+#ifndef CSV_MAP_H
+#define CSV_MAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define CSV_MAP_MAX_FIELDS 8             // Fields kept per row; later ones are counted but dropped
+#define CSV_FIELD_MAX(length) (2 * (length) + 2) // Bytes csv_format_field() may write for a field
+
+// Part of the mapped file
+typedef struct {
+    const char* data;
+    uint32_t length;
+    uint8_t escaped;                     // Quoted field containing "" pairs
+} csv_field_t;
+
+typedef struct {
+    csv_field_t fields[CSV_MAP_MAX_FIELDS];
+    uint32_t field_count;                // Fields in the row (may exceed CSV_MAP_MAX_FIELDS)
+    uint32_t line;                       // Line number of the row's first line (1-based)
+} csv_row_t;
+
+typedef struct {
+    const char* data;                    // Mapped file (NULL when empty)
+    size_t size;
+    size_t offset;                       // Start of the next row
+    size_t end;                          // Rows start before this (size, or the end of a range)
+    uint32_t line;                       // Line number at offset
+#ifdef _WIN32
+    void* file_handle;
+    void* mapping_handle;
+#endif
+} csv_map_t;
+
+int csv_map_open(csv_map_t* map, const char* path);
+void csv_map_close(csv_map_t* map);
+void csv_map_range(const csv_map_t* file, size_t start, size_t end, csv_map_t* range);
+void csv_map_buffer(csv_map_t* map, const char* data, size_t size);
+int csv_map_next_row(csv_map_t* map, csv_row_t* row);
+size_t csv_field_copy(const csv_field_t* field, char* dest, size_t size);
+int csv_field_equals(const csv_field_t* field, const char* text);
+size_t csv_format_field(char* dest, const char* text);
+size_t csv_format_row(char* dest, const char* const* fields, uint32_t count);
+void csv_write_field(FILE* file, const char* text);
+
+#endif // CSV_MAP_H
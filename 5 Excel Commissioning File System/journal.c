@@ -0,0 +1,516 @@
+/*
+ * Delta Journal
+ * =============
+ *
+ * Appending, replaying and background compaction declared in journal.h.
+ */
+
+// Expose fsync() and truncate() when building with -std=c99
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "atomic_file.h"
+#include "csv_map.h"
+#include "journal.h"
+
+#ifdef _WIN32
+#include <io.h>
+#define fsync _commit
+#else
+#include <unistd.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+static const char journal_header[] = "Parameter,Value,Unit,Description,Valid\n";
+
+/*
+ * @return: A malloc'd copy of path followed by suffix, or NULL
+ */
+static char* path_with(const char* path, const char* suffix) {
+    size_t length = strlen(path), extra = strlen(suffix);
+    char* copy = malloc(length + extra + 1);
+
+    if (copy != NULL) {
+        memcpy(copy, path, length);
+        memcpy(copy + length, suffix, extra + 1);
+    }
+    return copy;
+}
+
+/*
+ * @return: Size of the file at path, or 0 if there is none
+ */
+static uint64_t file_size(const char* path) {
+    struct stat info;
+    return stat(path, &info) == 0 ? (uint64_t)info.st_size : 0;
+}
+
+/*
+ * Cut a file to size bytes
+ */
+static void truncate_file(const char* path, uint64_t size) {
+#ifdef _WIN32
+    int fd = _open(path, _O_RDWR | _O_BINARY);
+    if (fd >= 0) {
+        _chsize_s(fd, (long long)size);
+        _commit(fd);
+        _close(fd);
+    }
+#else
+    if (truncate(path, (off_t)size) == 0) {
+        int fd = open(path, O_WRONLY);
+        if (fd >= 0) {
+            fsync(fd);
+            close(fd);
+        }
+    }
+#endif
+}
+
+/*
+ * Set up a journal for a commissioning file. Nothing is read or written
+ * until the journal is replayed or appended to.
+ *
+ * @return: 0 on success, -1 if memory is exhausted
+ */
+int journal_init(journal_t* journal, const char* file_path) {
+    memset(journal, 0, sizeof(*journal));
+    journal->file_path = path_with(file_path, "");
+    journal->path = path_with(file_path, ".journal");
+    journal->rotated_path = path_with(file_path, ".journal.1");
+    if (journal->file_path == NULL || journal->path == NULL || journal->rotated_path == NULL) {
+        journal_free(journal);
+        return -1;
+    }
+    journal->size = file_size(journal->path);
+    return 0;
+}
+
+/*
+ * Wait for any compaction and release the journal (its files stay)
+ */
+void journal_free(journal_t* journal) {
+    journal_wait(journal);
+    free(journal->file_path);
+    free(journal->path);
+    free(journal->rotated_path);
+    memset(journal, 0, sizeof(*journal));
+}
+
+/*
+ * Append the store's changed parameters as one committed batch and sync
+ * the journal. The caller clears the change list afterwards.
+ *
+ * @return: 0 on success, -1 if the journal could not be written
+ */
+int journal_append(journal_t* journal, const param_store_t* store) {
+    size_t capacity = sizeof(journal_header) + 32;
+    int created = journal->size == 0;
+
+    for (uint32_t c = 0; c < store->change_count; c++) {
+        const system_parameter_t* parameter = &store->parameters[store->changes[c]];
+        capacity += CSV_FIELD_MAX(strlen(parameter->name)) + 3 * CSV_FIELD_MAX(PARAM_TEXT_LENGTH) + 16;
+    }
+    char* buffer = malloc(capacity);
+    if (buffer == NULL) {
+        return -1;
+    }
+
+    // Header when the journal is new, then the rows and the commit line
+    size_t used = 0;
+    if (created) {
+        memcpy(buffer, journal_header, sizeof(journal_header) - 1);
+        used = sizeof(journal_header) - 1;
+    }
+    for (uint32_t c = 0; c < store->change_count; c++) {
+        const system_parameter_t* parameter = &store->parameters[store->changes[c]];
+        const char* fields[] = {parameter->name, parameter->value, parameter->unit,
+                                parameter->description, parameter->is_valid ? "true" : "false"};
+        used += csv_format_row(buffer + used, fields, 5);
+    }
+    used += (size_t)sprintf(buffer + used, "#commit,%u\n", store->change_count);
+
+    int result = -1;
+    int fd = open(journal->path, O_WRONLY | O_APPEND | O_CREAT | O_BINARY, 0644);
+    if (fd >= 0) {
+        const char* data = buffer;
+        size_t left = used;
+        while (left > 0) {
+            long written = (long)write(fd, data, (unsigned)left);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                break;
+            }
+            data += written;
+            left -= (size_t)written;
+        }
+        if (left == 0 && fsync(fd) == 0) {
+            result = 0;
+        }
+        close(fd);
+    }
+    free(buffer);
+
+    if (result != 0) {
+        // Drop whatever part of the batch was written
+        truncate_file(journal->path, journal->size);
+        return -1;
+    }
+#ifndef _WIN32
+    if (created) {
+        // Make the new journal's directory entry durable
+        char* slash = strrchr(journal->path, '/');
+        int dir;
+        if (slash == NULL) {
+            dir = open(".", O_RDONLY);
+        } else {
+            *slash = '\0';
+            dir = open(slash == journal->path ? "/" : journal->path, O_RDONLY);
+            *slash = '/';
+        }
+        if (dir >= 0) {
+            fsync(dir);
+            close(dir);
+        }
+    }
+#endif
+    journal->size += used;
+    return 0;
+}
+
+/*
+ * Set a parameter from a journal row, adding it if new. With a schema the
+ * value is parsed and checked; without one (compaction) the row's Valid
+ * column is kept.
+ *
+ * @return: 0 on success, -1 if memory is exhausted
+ */
+static int apply_row(const csv_row_t* row, const schema_t* schema, param_store_t* store) {
+    const csv_field_t* name = &row->fields[0];
+    bool added;
+    uint32_t id;
+
+    if (name->escaped) {
+        char* copy = malloc(name->length + 1);
+        if (copy == NULL) {
+            return -1;
+        }
+        size_t length = csv_field_copy(name, copy, name->length + 1);
+        id = param_store_insert(store, copy, length, &added);
+        free(copy);
+    } else {
+        id = param_store_insert(store, name->data, name->length, &added);
+    }
+    if (id == PARAM_STORE_NONE) {
+        return -1;
+    }
+
+    system_parameter_t* parameter = &store->parameters[id];
+    char* texts[] = {parameter->value, parameter->unit, parameter->description};
+    for (uint32_t f = 0; f < 3; f++) {
+        if (f + 1 < row->field_count) {
+            csv_field_copy(&row->fields[f + 1], texts[f], PARAM_TEXT_LENGTH);
+        } else {
+            texts[f][0] = '\0';
+        }
+    }
+
+    if (schema != NULL) {
+        parameter->rule_generation = 0;   // The value changed: parse it again
+        schema_resolve(schema, parameter);
+        parameter->is_valid = param_value_check(parameter->rule, &parameter->typed);
+    } else {
+        parameter->is_valid = row->field_count > 4 && csv_field_equals(&row->fields[4], "true");
+    }
+    return 0;
+}
+
+/*
+ * Apply every committed batch of one journal file
+ *
+ * @return: Bytes up to the end of the last committed batch (0 if the file
+ *          is missing or not a journal), or -1 if memory is exhausted
+ */
+static long long replay_file(const char* path, const schema_t* schema, param_store_t* store,
+                             uint32_t* applied) {
+    csv_map_t map;
+    csv_row_t row;
+    csv_row_t* pending = NULL;
+    uint32_t pending_count = 0, pending_capacity = 0;
+    long long committed = 0;
+
+    if (csv_map_open(&map, path) != 0) {
+        return 0;
+    }
+    if (!csv_map_next_row(&map, &row) || !csv_field_equals(&row.fields[0], "Parameter")) {
+        csv_map_close(&map);
+        return 0;
+    }
+    committed = (long long)map.offset;
+
+    while (csv_map_next_row(&map, &row)) {
+        if (csv_field_equals(&row.fields[0], "#commit")) {
+            char count[16] = "";
+            if (row.field_count > 1) {
+                csv_field_copy(&row.fields[1], count, sizeof(count));
+            }
+            if (strtoul(count, NULL, 10) != pending_count) {
+                pending_count = 0;   // Damaged batch: skip it
+                continue;
+            }
+            for (uint32_t p = 0; p < pending_count; p++) {
+                if (apply_row(&pending[p], schema, store) != 0) {
+                    free(pending);
+                    csv_map_close(&map);
+                    return -1;
+                }
+            }
+            *applied += pending_count;
+            pending_count = 0;
+            committed = (long long)map.offset;
+            continue;
+        }
+        if (row.fields[0].length == 0) {
+            continue;
+        }
+        if (pending_count == pending_capacity) {
+            uint32_t capacity = pending_capacity ? pending_capacity * 2 : 64;
+            csv_row_t* rows = realloc(pending, sizeof(csv_row_t) * capacity);
+            if (rows == NULL) {
+                free(pending);
+                csv_map_close(&map);
+                return -1;
+            }
+            pending = rows;
+            pending_capacity = capacity;
+        }
+        pending[pending_count++] = row;
+    }
+
+    free(pending);
+    csv_map_close(&map);
+    return committed;
+}
+
+/*
+ * Apply the journals to a store just loaded from the commissioning file:
+ * journal.1 (if a compaction did not finish), then the journal. An
+ * uncommitted batch at the end of the journal is cut off, so the next
+ * append starts clean.
+ *
+ * @return: 0 on success, -1 if memory is exhausted
+ */
+int journal_replay(journal_t* journal, const schema_t* schema, param_store_t* store, uint32_t* applied) {
+    *applied = 0;
+    journal_wait(journal);
+
+    if (replay_file(journal->rotated_path, schema, store, applied) < 0) {
+        return -1;
+    }
+    long long committed = replay_file(journal->path, schema, store, applied);
+    if (committed < 0) {
+        return -1;
+    }
+
+    uint64_t size = file_size(journal->path);
+    if ((uint64_t)committed < size) {
+        truncate_file(journal->path, (uint64_t)committed);
+    }
+    journal->size = (uint64_t)committed;
+    return 0;
+}
+
+/*
+ * Remove both journal files, before the commissioning file is rewritten
+ * from a store that did not come from it
+ */
+void journal_discard(journal_t* journal) {
+    journal_wait(journal);
+    remove(journal->rotated_path);
+    remove(journal->path);
+    journal->size = 0;
+}
+
+/*
+ * Write the commissioning file again with journal.1's rows in place of
+ * (or after) its own. Unchanged rows are copied byte for byte.
+ *
+ * @return: 0 on success, -1 on failure (the file is unchanged)
+ */
+static int merge_journal(const char* file_path, const char* journal_path) {
+    param_store_t changes = {0};
+    uint32_t applied = 0;
+    csv_map_t map;
+    csv_row_t row;
+    atomic_file_t file;
+    int result = 0;
+
+    if (replay_file(journal_path, NULL, &changes, &applied) < 0 ||
+        csv_map_open(&map, file_path) != 0) {
+        param_store_free(&changes);
+        return -1;
+    }
+    if (atomic_file_open(&file, file_path) != 0) {
+        csv_map_close(&map);
+        param_store_free(&changes);
+        return -1;
+    }
+
+    // Header and rows of the file, with changed rows replaced
+    for (uint32_t line = 0;; line++) {
+        size_t start = map.offset;
+        if (!csv_map_next_row(&map, &row)) {
+            break;
+        }
+        while (start < map.size && (map.data[start] == '\n' || map.data[start] == '\r')) {
+            start++;   // Blank lines skipped by csv_map_next_row()
+        }
+
+        uint32_t id = PARAM_STORE_NONE;
+        if (line > 0 && row.fields[0].length > 0) {
+            if (row.fields[0].escaped) {
+                char* name = malloc(row.fields[0].length + 1);
+                if (name != NULL) {
+                    size_t length = csv_field_copy(&row.fields[0], name, row.fields[0].length + 1);
+                    id = param_store_find(&changes, name, length);
+                    free(name);
+                }
+            } else {
+                id = param_store_find(&changes, row.fields[0].data, row.fields[0].length);
+            }
+        }
+
+        if (id != PARAM_STORE_NONE && !changes.parameters[id].is_changed) {
+            // is_changed marks journal rows already written
+            system_parameter_t* parameter = &changes.parameters[id];
+            const char* fields[] = {parameter->name, parameter->value, parameter->unit,
+                                    parameter->description, parameter->is_valid ? "true" : "false"};
+            char* dest = atomic_file_reserve(&file, CSV_FIELD_MAX(strlen(parameter->name)) +
+                                                    3 * CSV_FIELD_MAX(PARAM_TEXT_LENGTH) + 16);
+            if (dest == NULL) {
+                result = -1;
+                break;
+            }
+            atomic_file_advance(&file, csv_format_row(dest, fields, 5));
+            parameter->is_changed = true;
+        } else {
+            atomic_file_write(&file, map.data + start, map.offset - start);
+            if (map.data[map.offset - 1] != '\n') {
+                atomic_file_write(&file, "\n", 1);
+            }
+        }
+    }
+
+    // Parameters the journal added, in the order it added them
+    for (uint32_t id = 0; result == 0 && id < changes.count; id++) {
+        system_parameter_t* parameter = &changes.parameters[id];
+        if (parameter->is_changed) {
+            continue;
+        }
+        const char* fields[] = {parameter->name, parameter->value, parameter->unit,
+                                parameter->description, parameter->is_valid ? "true" : "false"};
+        char* dest = atomic_file_reserve(&file, CSV_FIELD_MAX(strlen(parameter->name)) +
+                                                3 * CSV_FIELD_MAX(PARAM_TEXT_LENGTH) + 16);
+        if (dest == NULL) {
+            result = -1;
+            break;
+        }
+        atomic_file_advance(&file, csv_format_row(dest, fields, 5));
+    }
+
+    csv_map_close(&map);
+    param_store_free(&changes);
+    if (result != 0) {
+        atomic_file_abort(&file);
+        return -1;
+    }
+    return atomic_file_commit(&file);
+}
+
+static void* compact_thread(void* argument) {
+    journal_t* journal = argument;
+
+    journal->compact_result = merge_journal(journal->file_path, journal->rotated_path);
+    if (journal->compact_result == 0) {
+        remove(journal->rotated_path);
+    }
+    journal->compactions++;
+    __atomic_store_n(&journal->compacting, 0, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/*
+ * Fold the journal into the commissioning file: rename it to journal.1
+ * (unless a journal.1 is left from an interrupted compaction, which is
+ * folded in first) and merge it on a background thread
+ *
+ * @return: 0 if a compaction was started (and, with wait, finished),
+ *          -1 if one is already running or there is nothing to compact
+ */
+int journal_compact(journal_t* journal, bool wait) {
+    if (__atomic_load_n(&journal->compacting, __ATOMIC_ACQUIRE)) {
+        return -1;
+    }
+    journal_wait(journal);
+
+    if (file_size(journal->rotated_path) == 0) {
+        if (journal->size == 0 || rename(journal->path, journal->rotated_path) != 0) {
+            return -1;
+        }
+        journal->size = 0;
+    }
+
+    __atomic_store_n(&journal->compacting, 1, __ATOMIC_RELEASE);
+#ifdef _WIN32
+    compact_thread(journal);
+    (void)wait;
+#else
+    if (pthread_create(&journal->thread, NULL, compact_thread, journal) != 0) {
+        compact_thread(journal);
+        return journal->compact_result;
+    }
+    journal->started = 1;
+    if (wait) {
+        journal_wait(journal);
+    }
+#endif
+    return 0;
+}
+
+/*
+ * Start a compaction if the journal has grown past JOURNAL_COMPACT_MIN
+ * and 1/JOURNAL_COMPACT_RATIO of the commissioning file
+ *
+ * @return: true if one was started
+ */
+bool journal_maybe_compact(journal_t* journal) {
+    if (journal->size < JOURNAL_COMPACT_MIN ||
+        journal->size * JOURNAL_COMPACT_RATIO < file_size(journal->file_path)) {
+        return false;
+    }
+    return journal_compact(journal, false) == 0;
+}
+
+/*
+ * Wait for a running compaction to finish
+ */
+void journal_wait(journal_t* journal) {
+#ifndef _WIN32
+    if (journal->started) {
+        pthread_join(journal->thread, NULL);
+        journal->started = 0;
+    }
+#else
+    (void)journal;
+#endif
+}
@@ -0,0 +1,68 @@
+/*
+ * Delta Journal
+ * =============
+ *
+ * Saves only what changed. Each save appends the rows of the parameters in
+ * the store's change list (param_store.h) to "<file>.journal", followed by
+ * a commit line, and fsync()s it:
+ *
+ *   Parameter,Value,Unit,Description,Valid      (once, when it is created)
+ *   motor_speed_rpm,1750,RPM,Motor operating speed,true
+ *   #commit,1
+ *
+ * so a save costs O(changes) however large the commissioning file is.
+ * Loading applies the journal on top of the file. A batch without its
+ * commit line (a crash during the append) is dropped and cut off the
+ * journal.
+ *
+ * Compaction folds the journal back into the commissioning file on a
+ * background thread. The journal is first renamed to "<file>.journal.1",
+ * so saves go on appending to a new journal meanwhile. The compactor
+ * writes the file with journal.1's rows in place (atomic_file.h), then
+ * removes journal.1. Rows hold whole values, so applying journal.1 again
+ * after a crash between those two steps does no harm. On Windows the
+ * compaction runs in the calling thread.
+ *
+ * Only the compactor writes the commissioning file while a compaction
+ * runs: call journal_wait() before loading or rewriting it.
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "param_store.h"
+#include "schema.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#define JOURNAL_COMPACT_MIN 65536        // Journal bytes before compaction is considered
+#define JOURNAL_COMPACT_RATIO 4          // Compact once the journal is 1/RATIO of the file
+
+typedef struct {
+    char* file_path;                     // The commissioning file
+    char* path;                          // "<file>.journal"
+    char* rotated_path;                  // "<file>.journal.1", being compacted
+    uint64_t size;                       // Bytes in the journal
+    uint32_t compacting;                 // Set while a compaction runs (atomic)
+    uint8_t started;                     // A compaction thread has not been joined
+    int compact_result;                  // 0 if the last compaction succeeded
+    uint32_t compactions;                // Compactions finished
+#ifndef _WIN32
+    pthread_t thread;
+#endif
+} journal_t;
+
+int journal_init(journal_t* journal, const char* file_path);
+void journal_free(journal_t* journal);
+int journal_append(journal_t* journal, const param_store_t* store);
+int journal_replay(journal_t* journal, const schema_t* schema, param_store_t* store, uint32_t* applied);
+void journal_discard(journal_t* journal);
+int journal_compact(journal_t* journal, bool wait);
+bool journal_maybe_compact(journal_t* journal);
+void journal_wait(journal_t* journal);
+
+#endif // JOURNAL_H
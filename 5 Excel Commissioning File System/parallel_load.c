@@ -0,0 +1,376 @@
+/*
+ * Parallel Commissioning Loader
+ * =============================
+ *
+ * Chunking, split/merge/fill steps and worker threads declared in
+ * parallel_load.h.
+ */
+
+// Expose sysconf(_SC_NPROCESSORS_ONLN) when building with -std=c99
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parallel_load.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#define PREFETCH_DISTANCE 8              // Rows ahead whose index slot is prefetched during the merge
+
+enum { FIELD_NAME = 0, FIELD_VALUE, FIELD_UNIT, FIELD_DESCRIPTION, FIELD_COUNT };
+
+// One row of a chunk, as views into the mapping
+typedef struct {
+    csv_field_t fields[FIELD_COUNT];     // Missing fields are empty
+    uint32_t hash;                       // Of the name
+    uint32_t line;                       // Within the chunk (1-based)
+    uint32_t id;                         // Parameter, or PARAM_STORE_NONE if not added
+} load_row_t;
+
+typedef struct {
+    const csv_map_t* file;
+    const schema_t* schema;
+    param_store_t* store;
+    size_t start;                        // Rows starting in [start, end) belong to the chunk
+    size_t end;
+    size_t stop;                         // Where the chunk's last row ended (>= end)
+    uint32_t first_id;                   // The chunk's rows take IDs from here on
+    uint32_t lines;                      // Line breaks from start to stop
+    load_row_t* rows;
+    uint32_t row_count;
+    uint32_t row_capacity;
+    char** names;                        // Unescaped copies of names with "" escapes
+    uint32_t name_count;
+    uint32_t name_capacity;
+    int failed;                          // Out of memory
+} load_chunk_t;
+
+static const char* const field_names[FIELD_COUNT] = {"name", "value", "unit", "description"};
+
+/*
+ * @return: Threads worth using on this machine (online CPUs, at most
+ *          PARALLEL_LOAD_MAX_THREADS)
+ */
+uint32_t parallel_load_threads(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    long cpus = (long)info.dwNumberOfProcessors;
+#else
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (cpus < 1) {
+        return 1;
+    }
+    return cpus > PARALLEL_LOAD_MAX_THREADS ? PARALLEL_LOAD_MAX_THREADS : (uint32_t)cpus;
+}
+
+static void free_names(load_chunk_t* chunk) {
+    for (uint32_t n = 0; n < chunk->name_count; n++) {
+        free(chunk->names[n]);
+    }
+    chunk->name_count = 0;
+}
+
+/*
+ * Keep an unescaped copy of a name that holds "" escapes and point the
+ * field at it
+ *
+ * @return: 0 on success, -1 if memory is exhausted
+ */
+static int unescape_name(load_chunk_t* chunk, csv_field_t* field) {
+    if (chunk->name_count == chunk->name_capacity) {
+        uint32_t capacity = chunk->name_capacity ? chunk->name_capacity * 2 : 16;
+        char** names = realloc(chunk->names, sizeof(char*) * capacity);
+        if (names == NULL) {
+            return -1;
+        }
+        chunk->names = names;
+        chunk->name_capacity = capacity;
+    }
+
+    char* name = malloc(field->length + 1);
+    if (name == NULL) {
+        return -1;
+    }
+    field->length = (uint32_t)csv_field_copy(field, name, field->length + 1);
+    field->data = name;
+    field->escaped = 0;
+    chunk->names[chunk->name_count++] = name;
+    return 0;
+}
+
+/*
+ * Step 1: split a chunk into rows. May be called again for the same chunk
+ * after its start moves.
+ */
+static void* split_chunk(void* argument) {
+    load_chunk_t* chunk = argument;
+    csv_map_t range;
+    csv_row_t row;
+
+    chunk->row_count = 0;
+    free_names(chunk);
+    csv_map_range(chunk->file, chunk->start, chunk->end, &range);
+
+    while (csv_map_next_row(&range, &row)) {
+        if (row.fields[0].length == 0) {
+            continue;   // No parameter name
+        }
+        if (chunk->row_count == chunk->row_capacity) {
+            uint32_t capacity = chunk->row_capacity ? chunk->row_capacity * 2 : 1024;
+            load_row_t* rows = realloc(chunk->rows, sizeof(load_row_t) * capacity);
+            if (rows == NULL) {
+                chunk->failed = 1;
+                break;
+            }
+            chunk->rows = rows;
+            chunk->row_capacity = capacity;
+        }
+
+        load_row_t* entry = &chunk->rows[chunk->row_count++];
+        for (uint32_t f = 0; f < FIELD_COUNT; f++) {
+            if (f < row.field_count) {
+                entry->fields[f] = row.fields[f];
+            } else {
+                entry->fields[f].data = "";
+                entry->fields[f].length = 0;
+                entry->fields[f].escaped = 0;
+            }
+        }
+        if (entry->fields[FIELD_NAME].escaped && unescape_name(chunk, &entry->fields[FIELD_NAME]) != 0) {
+            chunk->failed = 1;
+            break;
+        }
+        entry->hash = param_store_hash(entry->fields[FIELD_NAME].data, entry->fields[FIELD_NAME].length);
+        entry->line = row.line;
+        entry->id = PARAM_STORE_NONE;
+    }
+
+    chunk->stop = range.offset;
+    chunk->lines = range.line - 1;
+    return NULL;
+}
+
+/*
+ * Touch the parameter records the chunk's rows will take, so that the
+ * serial merge does not stop at each new page
+ */
+static void* prepare_chunk(void* argument) {
+    load_chunk_t* chunk = argument;
+    uint32_t capacity = chunk->store->capacity;
+
+    if (chunk->first_id < capacity) {
+        uint32_t count = chunk->row_count < capacity - chunk->first_id ? chunk->row_count
+                                                                      : capacity - chunk->first_id;
+        memset(&chunk->store->parameters[chunk->first_id], 0, sizeof(system_parameter_t) * count);
+    }
+    return NULL;
+}
+
+/*
+ * Step 3: copy each added row's fields into its parameter and parse its
+ * value. Chunks write to different parameters, so they need no locking.
+ */
+static void* fill_chunk(void* argument) {
+    load_chunk_t* chunk = argument;
+
+    for (uint32_t r = 0; r < chunk->row_count; r++) {
+        const load_row_t* entry = &chunk->rows[r];
+        if (entry->id == PARAM_STORE_NONE) {
+            continue;
+        }
+        system_parameter_t* parameter = &chunk->store->parameters[entry->id];
+        csv_field_copy(&entry->fields[FIELD_VALUE], parameter->value, PARAM_TEXT_LENGTH);
+        csv_field_copy(&entry->fields[FIELD_UNIT], parameter->unit, PARAM_TEXT_LENGTH);
+        csv_field_copy(&entry->fields[FIELD_DESCRIPTION], parameter->description, PARAM_TEXT_LENGTH);
+
+        // Parse the value once; the Valid column is recomputed rather than trusted
+        schema_resolve(chunk->schema, parameter);
+        parameter->is_valid = param_value_check(parameter->rule, &parameter->typed);
+    }
+    return NULL;
+}
+
+/*
+ * Run work on every chunk, one thread each; the calling thread takes the
+ * first chunk, and any chunk whose thread cannot be started
+ */
+static void run_chunks(load_chunk_t* chunks, uint32_t count, void* (*work)(void*)) {
+#ifdef _WIN32
+    for (uint32_t c = 0; c < count; c++) {
+        work(&chunks[c]);
+    }
+#else
+    pthread_t threads[PARALLEL_LOAD_MAX_THREADS];
+    int started[PARALLEL_LOAD_MAX_THREADS] = {0};
+
+    for (uint32_t c = 1; c < count; c++) {
+        started[c] = pthread_create(&threads[c], NULL, work, &chunks[c]) == 0;
+    }
+    work(&chunks[0]);
+    for (uint32_t c = 1; c < count; c++) {
+        if (started[c]) {
+            pthread_join(threads[c], NULL);
+        } else {
+            work(&chunks[c]);
+        }
+    }
+#endif
+}
+
+/*
+ * Warn about each field of a row that does not fit its parameter field
+ */
+static void warn_truncated(const load_row_t* entry, uint32_t line) {
+    for (uint32_t f = FIELD_VALUE; f < FIELD_COUNT; f++) {
+        const csv_field_t* field = &entry->fields[f];
+        if (field->length >= PARAM_TEXT_LENGTH && csv_field_copy(field, NULL, 0) >= PARAM_TEXT_LENGTH) {
+            printf("Warning: Line %u: %s truncated to %d characters\n",
+                   line, field_names[f], PARAM_TEXT_LENGTH - 1);
+        }
+    }
+}
+
+/*
+ * Step 2: add the names to the store in file order and report duplicates
+ * and truncated fields with their line in the file
+ *
+ * @return: 0 on success, -1 if memory is exhausted
+ */
+static int merge_chunks(load_chunk_t* chunks, uint32_t count, uint32_t first_line,
+                        param_store_t* store, parallel_load_stats_t* stats) {
+    uint32_t base = first_line;   // Line number of the chunk's start
+
+    for (uint32_t c = 0; c < count; c++) {
+        load_chunk_t* chunk = &chunks[c];
+        for (uint32_t r = 0; r < chunk->row_count; r++) {
+            load_row_t* entry = &chunk->rows[r];
+            uint32_t line = base + entry->line - 1;
+            bool added;
+
+            if (r + PREFETCH_DISTANCE < chunk->row_count) {
+                param_store_prefetch(store, chunk->rows[r + PREFETCH_DISTANCE].hash);
+            }
+            entry->id = param_store_insert_hashed(store, entry->fields[FIELD_NAME].data,
+                                                  entry->fields[FIELD_NAME].length, entry->hash, &added);
+            if (entry->id == PARAM_STORE_NONE) {
+                printf("Error: Out of memory at line %u\n", line);
+                return -1;
+            }
+            if (!added) {
+                printf("Warning: Line %u: duplicate parameter '%s' ignored\n",
+                       line, store->parameters[entry->id].name);
+                entry->id = PARAM_STORE_NONE;
+                stats->duplicates++;
+                continue;
+            }
+            warn_truncated(entry, line);
+            stats->added++;
+        }
+        base += chunk->lines;
+    }
+    return 0;
+}
+
+/*
+ * Load every row after the map's current position (the caller has read
+ * the header) into the store, on up to threads threads. Messages name the
+ * line in the file, as the map counts them.
+ *
+ * @return: 0 on success, -1 if memory is exhausted (rows merged before
+ *          that are kept)
+ */
+int parallel_load(const csv_map_t* map, const schema_t* schema, param_store_t* store,
+                  uint32_t threads, parallel_load_stats_t* stats) {
+    load_chunk_t chunks[PARALLEL_LOAD_MAX_THREADS];
+    size_t begin = map->offset < map->size ? map->offset : map->size;
+    size_t length = map->size - begin;
+    int result = 0;
+
+    memset(stats, 0, sizeof(*stats));
+    if (threads > PARALLEL_LOAD_MAX_THREADS) {
+        threads = PARALLEL_LOAD_MAX_THREADS;
+    }
+    if (threads > length / PARALLEL_LOAD_MIN_CHUNK) {
+        threads = (uint32_t)(length / PARALLEL_LOAD_MIN_CHUNK);
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+    stats->threads = threads;
+
+    // Cut the file into equal chunks, moving each start past the next line break
+    memset(chunks, 0, sizeof(chunks));
+    for (uint32_t c = 0; c < threads; c++) {
+        load_chunk_t* chunk = &chunks[c];
+        chunk->file = map;
+        chunk->schema = schema;
+        chunk->store = store;
+        chunk->start = begin;
+        if (c > 0) {
+            size_t from = begin + length / threads * c - 1;
+            const char* line_break = memchr(map->data + from, '\n', map->size - from);
+            chunk->start = line_break != NULL ? (size_t)(line_break - map->data) + 1 : map->size;
+            if (chunk->start < chunks[c - 1].start) {
+                chunk->start = chunks[c - 1].start;
+            }
+            chunks[c - 1].end = chunk->start;
+        }
+    }
+    chunks[threads - 1].end = map->size;
+
+    run_chunks(chunks, threads, split_chunk);
+
+    // A chunk must start where the one before it stopped; split it again if
+    // a quoted field carried that one past the boundary
+    for (uint32_t c = 1; c < threads; c++) {
+        if (chunks[c].start != chunks[c - 1].stop) {
+            chunks[c].start = chunks[c - 1].stop;
+            if (chunks[c].end < chunks[c].start) {
+                chunks[c].end = chunks[c].start;
+            }
+            split_chunk(&chunks[c]);
+            stats->realigned++;
+        }
+    }
+
+    uint32_t rows = 0;
+    for (uint32_t c = 0; c < threads; c++) {
+        if (chunks[c].failed) {
+            printf("Error: Out of memory splitting the commissioning file\n");
+            result = -1;
+        }
+        rows += chunks[c].row_count;
+    }
+    stats->rows = rows;
+
+    if (result == 0) {
+        // Best effort: if this fails the store grows while merging instead
+        if (param_store_reserve(store, store->count + rows) == 0) {
+            uint32_t first_id = store->count;
+            for (uint32_t c = 0; c < threads; c++) {
+                chunks[c].first_id = first_id;
+                first_id += chunks[c].row_count;
+            }
+            run_chunks(chunks, threads, prepare_chunk);
+        }
+        if (merge_chunks(chunks, threads, map->line, store, stats) != 0) {
+            result = -1;
+        }
+        run_chunks(chunks, threads, fill_chunk);
+    }
+
+    for (uint32_t c = 0; c < threads; c++) {
+        free_names(&chunks[c]);
+        free(chunks[c].names);
+        free(chunks[c].rows);
+    }
+    return result;
+}
@@ -0,0 +1,53 @@
+/*
+ * Parallel Commissioning Loader
+ * =============================
+ *
+ * Loads the rows of a mapped commissioning file (csv_map.h) into a
+ * parameter store, using several threads for large files.
+ *
+ * The file is cut into one chunk per thread, each starting just after a
+ * line break. Loading takes three steps:
+ *
+ *   1. Split (threads): each thread splits its chunk into rows, keeping
+ *      views of the name, value, unit and description fields and hashing
+ *      the name.
+ *   2. Merge (one thread): the names are inserted into the store in file
+ *      order, so duplicates are found and reported exactly as in a single
+ *      pass, with their line numbers in the file. The threads first touch
+ *      the parameter records the merge will fill, so it does not stop for
+ *      page faults.
+ *   3. Fill (threads): each thread copies its rows' fields into their
+ *      parameters, finds their rules and parses and checks the values.
+ *
+ * A chunk boundary can fall inside a quoted field that spans lines. The
+ * chunk before it then ends past the boundary, and the chunk after it is
+ * split again from where that one ended.
+ *
+ * Only the merge is serial; it is a prefetched hash insert per row. On
+ * Windows the chunks are processed one after another.
+ */
+
+#ifndef PARALLEL_LOAD_H
+#define PARALLEL_LOAD_H
+
+#include <stdint.h>
+#include "csv_map.h"
+#include "param_store.h"
+#include "schema.h"
+
+#define PARALLEL_LOAD_MAX_THREADS 32
+#define PARALLEL_LOAD_MIN_CHUNK (1u << 20)   // Bytes per thread; smaller files use fewer threads
+
+typedef struct {
+    uint32_t rows;                       // Rows with a name
+    uint32_t added;                      // Parameters added to the store
+    uint32_t duplicates;                 // Rows ignored because the name was taken
+    uint32_t threads;                    // Threads used
+    uint32_t realigned;                  // Chunks split again after a quoted line break
+} parallel_load_stats_t;
+
+int parallel_load(const csv_map_t* map, const schema_t* schema, param_store_t* store,
+                  uint32_t threads, parallel_load_stats_t* stats);
+uint32_t parallel_load_threads(void);
+
+#endif // PARALLEL_LOAD_H
@@ -0,0 +1,343 @@
+/*
+ * Parameter Store
+ * ===============
+ *
+ * Parameter array, string arena and hash index declared in param_store.h.
+ */
+
+// Expose madvise() when building with -std=c99
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include "param_store.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#define HUGE_PAGE_SIZE (2u << 20)
+#define HUGE_PAGE_MIN (4u << 20)         // Arrays from this size are backed by huge pages where possible
+
+/*
+ * Ask for transparent huge pages behind a large array. A million-entry
+ * table is hundreds of 4 KB pages per MB: faulting them in dominates
+ * filling it, and random probes miss the TLB on nearly every access.
+ */
+static void advise_huge_pages(void* data, size_t size) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    uintptr_t start = ((uintptr_t)data + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+    uintptr_t end = ((uintptr_t)data + size) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+    if (size >= HUGE_PAGE_MIN && end > start) {
+        madvise((void*)start, end - start, MADV_HUGEPAGE);
+    }
+#else
+    (void)data;
+    (void)size;
+#endif
+}
+
+/*
+ * Hash a name: 64-bit FNV-1a, then a final mix so that names differing
+ * only in their last characters still spread over the low bits used to
+ * pick a slot.
+ */
+uint32_t param_store_hash(const char* name, size_t length) {
+    uint64_t hash = 14695981039346656037ull;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 1099511628211ull;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return (uint32_t)hash;
+}
+
+/*
+ * Release everything the store holds and leave it empty
+ */
+void param_store_free(param_store_t* store) {
+    for (uint32_t b = 0; b < store->block_count; b++) {
+        free(store->blocks[b]);
+    }
+    free(store->blocks);
+    free(store->parameters);
+    free(store->slots);
+    free(store->changes);
+    memset(store, 0, sizeof(*store));
+}
+
+/*
+ * Remove every parameter. The parameter array and index keep their size.
+ */
+void param_store_clear(param_store_t* store) {
+    for (uint32_t b = 0; b < store->block_count; b++) {
+        free(store->blocks[b]);
+    }
+    store->block_count = 0;
+    store->block_used = 0;
+    store->count = 0;
+    store->change_count = 0;
+    if (store->slots != NULL) {
+        memset(store->slots, 0xFF, sizeof(param_slot_t) * store->slot_count);
+    }
+}
+
+/*
+ * @return: 1 if the slot's name equals name[0..length)
+ */
+static int slot_matches(const param_store_t* store, const param_slot_t* entry,
+                        const char* name, size_t length) {
+    if (length < PARAM_SLOT_PREFIX) {
+        return memcmp(entry->prefix, name, length) == 0 && entry->prefix[length] == '\0';
+    }
+    if (memcmp(entry->prefix, name, PARAM_SLOT_PREFIX) != 0) {
+        return 0;
+    }
+
+    // Long name: compare the rest with the interned copy
+    const char* interned = store->parameters[entry->id].name;
+    for (size_t i = PARAM_SLOT_PREFIX; i < length; i++) {
+        if (interned[i] != name[i] || interned[i] == '\0') {
+            return 0;
+        }
+    }
+    return interned[length] == '\0';
+}
+
+/*
+ * @return: Slot holding the name, or the empty slot where it would go
+ */
+static uint32_t find_slot(const param_store_t* store, const char* name, size_t length,
+                          uint32_t hash) {
+    uint32_t mask = store->slot_count - 1;
+
+    for (uint32_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        const param_slot_t* entry = &store->slots[slot];
+        if (entry->id == PARAM_STORE_NONE) {
+            return slot;
+        }
+        if (entry->hash == hash && slot_matches(store, entry, name, length)) {
+            return slot;
+        }
+    }
+}
+
+/*
+ * Look up a parameter by name (name need not be terminated)
+ *
+ * @return: Parameter ID, or PARAM_STORE_NONE if there is none by that name
+ */
+uint32_t param_store_find(const param_store_t* store, const char* name, size_t length) {
+    if (store->count == 0) {
+        return PARAM_STORE_NONE;
+    }
+    return store->slots[find_slot(store, name, length, param_store_hash(name, length))].id;
+}
+
+/*
+ * Resize the index to new_count slots (a power of two), placing every
+ * entry again by its stored hash
+ *
+ * @return: 0 on success, -1 if memory is exhausted
+ */
+static int resize_index(param_store_t* store, uint32_t new_count) {
+    uint32_t mask = new_count - 1;
+    param_slot_t* slots = malloc(sizeof(param_slot_t) * new_count);
+
+    if (slots == NULL || new_count < store->slot_count) {
+        free(slots);
+        return -1;
+    }
+    advise_huge_pages(slots, sizeof(param_slot_t) * new_count);
+    memset(slots, 0xFF, sizeof(param_slot_t) * new_count);
+
+    for (uint32_t s = 0; s < store->slot_count; s++) {
+        param_slot_t entry = store->slots[s];
+        if (entry.id == PARAM_STORE_NONE) {
+            continue;
+        }
+        uint32_t slot = entry.hash & mask;
+        while (slots[slot].id != PARAM_STORE_NONE) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = entry;
+    }
+
+    free(store->slots);
+    store->slots = slots;
+    store->slot_count = new_count;
+    return 0;
+}
+
+/*
+ * Double the index (or create it)
+ *
+ * @return: 0 on success, -1 if memory is exhausted
+ */
+static int grow_index(param_store_t* store) {
+    return resize_index(store, store->slot_count ? store->slot_count * 2 : 64);
+}
+
+/*
+ * Make room for count parameters in all, so that inserting up to that many
+ * neither moves the parameter array nor grows the index
+ *
+ * @return: 0 on success, -1 if memory is exhausted
+ */
+int param_store_reserve(param_store_t* store, uint32_t count) {
+    if (count > store->capacity) {
+        system_parameter_t* parameters = realloc(store->parameters, sizeof(system_parameter_t) * count);
+        if (parameters == NULL) {
+            return -1;
+        }
+        store->parameters = parameters;
+        store->capacity = count;
+        advise_huge_pages(parameters, sizeof(system_parameter_t) * count);
+    }
+
+    uint32_t slot_count = store->slot_count ? store->slot_count : 64;
+    while ((uint64_t)(count + 1) * 10 > (uint64_t)slot_count * 7) {
+        if (slot_count > UINT32_MAX / 2) {
+            return -1;
+        }
+        slot_count *= 2;
+    }
+    if (slot_count != store->slot_count) {
+        return resize_index(store, slot_count);
+    }
+    return 0;
+}
+
+/*
+ * Copy a name into the string arena
+ *
+ * @return: The terminated copy, or NULL if memory is exhausted
+ */
+static const char* intern_name(param_store_t* store, const char* name, size_t length) {
+    char* copy;
+
+    // Names longer than a block get a block of their own
+    if (store->block_count == 0 || store->block_used + length + 1 > PARAM_STORE_ARENA_BLOCK) {
+        size_t size = length + 1 > PARAM_STORE_ARENA_BLOCK ? length + 1 : PARAM_STORE_ARENA_BLOCK;
+
+        if (store->block_count == store->block_capacity) {
+            uint32_t capacity = store->block_capacity ? store->block_capacity * 2 : 16;
+            char** blocks = realloc(store->blocks, sizeof(char*) * capacity);
+            if (blocks == NULL) {
+                return NULL;
+            }
+            store->blocks = blocks;
+            store->block_capacity = capacity;
+        }
+        copy = malloc(size);
+        if (copy == NULL) {
+            return NULL;
+        }
+        store->blocks[store->block_count++] = copy;
+        store->block_used = 0;
+    }
+
+    copy = store->blocks[store->block_count - 1] + store->block_used;
+    memcpy(copy, name, length);
+    copy[length] = '\0';
+    store->block_used += length + 1;
+    return copy;
+}
+
+/*
+ * Find a parameter by name, adding it (with empty value, unit and
+ * description) if there is none. Checking for a duplicate and inserting
+ * take one probe sequence.
+ *
+ * @return: Parameter ID (*added tells whether it is new), or
+ *          PARAM_STORE_NONE if memory is exhausted
+ */
+uint32_t param_store_insert(param_store_t* store, const char* name, size_t length, bool* added) {
+    return param_store_insert_hashed(store, name, length, param_store_hash(name, length), added);
+}
+
+/*
+ * param_store_insert() for a name whose param_store_hash() is already known
+ */
+uint32_t param_store_insert_hashed(param_store_t* store, const char* name, size_t length,
+                                   uint32_t hash, bool* added) {
+    *added = false;
+
+    // Keep the index under 70% full
+    if ((uint64_t)(store->count + 1) * 10 > (uint64_t)store->slot_count * 7 && grow_index(store) != 0) {
+        return PARAM_STORE_NONE;
+    }
+
+    uint32_t slot = find_slot(store, name, length, hash);
+    if (store->slots[slot].id != PARAM_STORE_NONE) {
+        return store->slots[slot].id;
+    }
+
+    if (store->count == store->capacity) {
+        uint32_t capacity = store->capacity ? store->capacity * 2 : 64;
+        system_parameter_t* parameters = realloc(store->parameters, sizeof(system_parameter_t) * capacity);
+        if (parameters == NULL) {
+            return PARAM_STORE_NONE;
+        }
+        store->parameters = parameters;
+        store->capacity = capacity;
+        advise_huge_pages(parameters, sizeof(system_parameter_t) * capacity);
+    }
+
+    const char* interned = intern_name(store, name, length);
+    if (interned == NULL) {
+        return PARAM_STORE_NONE;
+    }
+
+    uint32_t id = store->count++;
+    system_parameter_t* parameter = &store->parameters[id];
+    memset(parameter, 0, sizeof(*parameter));
+    parameter->name = interned;
+
+    param_slot_t* entry = &store->slots[slot];
+    entry->hash = hash;
+    entry->id = id;
+    memset(entry->prefix, 0, sizeof(entry->prefix));
+    memcpy(entry->prefix, name, length < PARAM_SLOT_PREFIX ? length : PARAM_SLOT_PREFIX);
+    *added = true;
+    return id;
+}
+
+/*
+ * Record that a parameter changed; a parameter is listed once however
+ * often it changes
+ *
+ * @return: 0 on success, -1 if memory is exhausted
+ */
+int param_store_mark_changed(param_store_t* store, uint32_t id) {
+    system_parameter_t* parameter = &store->parameters[id];
+
+    if (parameter->is_changed) {
+        return 0;
+    }
+    if (store->change_count == store->change_capacity) {
+        uint32_t capacity = store->change_capacity ? store->change_capacity * 2 : 64;
+        uint32_t* changes = realloc(store->changes, sizeof(uint32_t) * capacity);
+        if (changes == NULL) {
+            return -1;
+        }
+        store->changes = changes;
+        store->change_capacity = capacity;
+    }
+    store->changes[store->change_count++] = id;
+    parameter->is_changed = true;
+    return 0;
+}
+
+/*
+ * Forget the recorded changes (after they have been saved)
+ */
+void param_store_clear_changes(param_store_t* store) {
+    for (uint32_t c = 0; c < store->change_count; c++) {
+        store->parameters[store->changes[c]].is_changed = false;
+    }
+    store->change_count = 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * Parameter Store
+ * ===============
+ *
+ * Growable table of commissioning parameters with a hash index on the
+ * parameter name.
+ *
+ * Parameters live in one array, in the order they were added, and a
+ * parameter's ID is its position. The array doubles when full, so pointers
+ * to parameters are only valid until the next insert; IDs stay valid.
+ *
+ * Names are interned: each is copied once into a block of the store's
+ * string arena and every parameter refers to its copy, so names have no
+ * length limit and are never moved.
+ *
+ * The index is an open-addressing table with linear probing. Each 32-byte
+ * slot holds a parameter ID, the name's 32-bit hash and the name's first
+ * PARAM_SLOT_PREFIX bytes. A probe compares names only when the hashes
+ * match, and names shorter than the prefix are compared without leaving
+ * the slot, so a lookup usually costs one cache miss. The table is kept
+ * under 70% full and doubled beyond that, which keeps lookup, insert and
+ * duplicate detection O(1) on average. On Linux, arrays of several MB
+ * ask for transparent huge pages, which cuts page faults and TLB misses.
+ *
+ * A loader that knows how many names are coming can reserve room first and
+ * pass hashes it computed itself (param_store_insert_hashed()), e.g. on
+ * other threads, leaving only the probe for the inserting thread.
+ *
+ * Changes are tracked: param_store_mark_changed() records a parameter
+ * once in a change list, so a save can write only what changed since the
+ * last one (param_store_clear_changes()). Inserting does not mark.
+ *
+ * Names must not contain '\0'.
+ *
+ * A zero-initialized param_store_t is an empty store.
+ */
+
+#ifndef PARAM_STORE_H
+#define PARAM_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "param_value.h"
+
+#define PARAM_TEXT_LENGTH 32             // Value, unit and description buffers
+#define PARAM_STORE_NONE UINT32_MAX      // No parameter
+#define PARAM_STORE_ARENA_BLOCK 65536    // Bytes per string arena block
+#define PARAM_SLOT_PREFIX 24             // Name bytes kept in each index slot
+
+/*
+ * Structure representing a single system parameter
+ * This is the core data structure for storing parameter information
+ */
+typedef struct {
+    const char* name;                   // Parameter identifier, interned (e.g., "motor_speed_rpm")
+    char value[PARAM_TEXT_LENGTH];      // Parameter value as string (e.g., "1500")
+    param_value_t typed;                // The value parsed (param_value.h)
+    const param_rule_t* rule;           // Type and limits, or NULL for any value
+    uint32_t rule_generation;           // Schema generation the rule was found in (0 = not yet)
+    char unit[PARAM_TEXT_LENGTH];       // Unit of measurement (e.g., "RPM", "Celsius")
+    char description[PARAM_TEXT_LENGTH];// Human-readable description
+    bool is_valid;                      // Flag indicating if parameter value is valid
+    bool is_changed;                    // In the store's change list
+} system_parameter_t;
+
+// Index slot: empty when id is PARAM_STORE_NONE
+typedef struct {
+    uint32_t hash;
+    uint32_t id;
+    char prefix[PARAM_SLOT_PREFIX];      // Start of the name, '\0'-padded
+} param_slot_t;
+
+typedef struct {
+    system_parameter_t* parameters;
+    uint32_t count;
+    uint32_t capacity;
+
+    param_slot_t* slots;
+    uint32_t slot_count;                 // Power of two (0 before the first insert)
+
+    // String arena: names are never moved once interned
+    char** blocks;
+    uint32_t block_count;
+    uint32_t block_capacity;
+    size_t block_used;                   // Bytes used in the last block
+
+    // Parameters changed since the last param_store_clear_changes(), in order
+    uint32_t* changes;
+    uint32_t change_count;
+    uint32_t change_capacity;
+} param_store_t;
+
+void param_store_free(param_store_t* store);
+void param_store_clear(param_store_t* store);
+uint32_t param_store_find(const param_store_t* store, const char* name, size_t length);
+uint32_t param_store_insert(param_store_t* store, const char* name, size_t length, bool* added);
+uint32_t param_store_insert_hashed(param_store_t* store, const char* name, size_t length,
+                                   uint32_t hash, bool* added);
+int param_store_reserve(param_store_t* store, uint32_t count);
+int param_store_mark_changed(param_store_t* store, uint32_t id);
+void param_store_clear_changes(param_store_t* store);
+uint32_t param_store_hash(const char* name, size_t length);
+
+/*
+ * Start loading the index slot a hash probes first, ahead of an insert
+ */
+static inline void param_store_prefetch(const param_store_t* store, uint32_t hash) {
+#if defined(__GNUC__)
+    if (store->slot_count > 0) {
+        __builtin_prefetch(&store->slots[hash & (store->slot_count - 1)], 1);
+    }
+#else
+    (void)store;
+    (void)hash;
+#endif
+}
+
+#endif // PARAM_STORE_H
@@ -0,0 +1,135 @@
+/*
+ * Typed Parameter Values
+ * ======================
+ *
+ * Parsing and range checks declared in param_value.h.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "param_value.h"
+
+/*
+ * @return: true if only spaces remain at end
+ */
+static bool only_spaces(const char* end) {
+    while (*end == ' ' || *end == '\t') {
+        end++;
+    }
+    return *end == '\0';
+}
+
+static bool parse_int(const char* text, int64_t* result) {
+    char* end;
+
+    errno = 0;
+    long long number = strtoll(text, &end, 10);
+    if (end == text || errno == ERANGE || !only_spaces(end)) {
+        return false;
+    }
+    *result = (int64_t)number;
+    return true;
+}
+
+static bool parse_float(const char* text, double* result) {
+    char* end;
+
+    errno = 0;
+    double number = strtod(text, &end);
+    if (end == text || errno == ERANGE || !only_spaces(end) || !isfinite(number)) {
+        return false;
+    }
+    *result = number;
+    return true;
+}
+
+static bool parse_bool(const char* text, bool* result) {
+    if (strcmp(text, "true") == 0 || strcmp(text, "1") == 0) {
+        *result = true;
+        return true;
+    }
+    if (strcmp(text, "false") == 0 || strcmp(text, "0") == 0) {
+        *result = false;
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Parse a value's text. With a rule, the text must parse as the rule's type
+ * and pass its checks. Without one, the type is the first of int, float and
+ * bool ("true"/"false") the text parses as, or string.
+ *
+ * @return: true if the value is valid
+ */
+bool param_value_parse(const param_rule_t* rule, const char* text, param_value_t* value) {
+    memset(value, 0, sizeof(*value));
+
+    if (rule == NULL) {
+        value->parsed = 1;
+        if (parse_int(text, &value->as.i)) {
+            value->type = PARAM_TYPE_INT;
+        } else if (parse_float(text, &value->as.f)) {
+            value->type = PARAM_TYPE_FLOAT;
+        } else if (strcmp(text, "true") == 0 || strcmp(text, "false") == 0) {
+            value->type = PARAM_TYPE_BOOL;
+            value->as.b = text[0] == 't';
+        } else {
+            value->type = PARAM_TYPE_STRING;
+        }
+        return true;
+    }
+
+    value->type = (uint8_t)rule->type;
+    switch (rule->type) {
+        case PARAM_TYPE_INT:
+            value->parsed = parse_int(text, &value->as.i);
+            break;
+        case PARAM_TYPE_FLOAT:
+            value->parsed = parse_float(text, &value->as.f);
+            break;
+        case PARAM_TYPE_BOOL:
+            value->parsed = parse_bool(text, &value->as.b);
+            break;
+        case PARAM_TYPE_ENUM:
+            for (uint32_t k = 0; k < rule->enum_count; k++) {
+                if (strcmp(text, rule->enum_names[k]) == 0) {
+                    value->as.e = k;
+                    value->parsed = 1;
+                    break;
+                }
+            }
+            break;
+        default:
+            value->parsed = 1;
+            break;
+    }
+    return param_value_check(rule, value);
+}
+
+/*
+ * Check an already parsed value against a rule, without touching its text
+ *
+ * @return: true if the value has the rule's type and is within its limits
+ */
+bool param_value_check(const param_rule_t* rule, const param_value_t* value) {
+    if (rule == NULL) {
+        return true;
+    }
+    if (!value->parsed || value->type != rule->type) {
+        return false;
+    }
+
+    switch (rule->type) {
+        case PARAM_TYPE_INT:
+            return (double)value->as.i >= rule->min && (double)value->as.i <= rule->max;
+        case PARAM_TYPE_FLOAT:
+            return value->as.f >= rule->min && value->as.f <= rule->max;
+        case PARAM_TYPE_ENUM:
+            return value->as.e < rule->enum_count;
+        default:
+            return true;
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ * Typed Parameter Values
+ * ======================
+ *
+ * A parameter's value is parsed once, when it is loaded or changed, into a
+ * tagged value: an integer, a float, a bool, an index into an enum's names
+ * or a plain string. Range checks then compare numbers, and programs that
+ * use the configuration read numbers directly with no string conversion.
+ *
+ * A param_rule_t says what a parameter must hold: its type, limits for
+ * numbers, the names of an enum and its unit. Parameters without a rule take the
+ * type their text looks like and are always valid.
+ */
+
+#ifndef PARAM_VALUE_H
+#define PARAM_VALUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    PARAM_TYPE_STRING = 0,
+    PARAM_TYPE_INT,
+    PARAM_TYPE_FLOAT,
+    PARAM_TYPE_BOOL,
+    PARAM_TYPE_ENUM
+} param_type_t;
+
+// Tagged value; a string's text is the parameter's value text
+typedef struct {
+    union {
+        int64_t i;                     // PARAM_TYPE_INT
+        double f;                      // PARAM_TYPE_FLOAT
+        bool b;                        // PARAM_TYPE_BOOL
+        uint32_t e;                    // PARAM_TYPE_ENUM: index into the rule's names
+    } as;
+    uint8_t type;                      // param_type_t
+    uint8_t parsed;                    // The text parsed as the rule's type
+} param_value_t;
+
+// What a parameter must hold
+typedef struct {
+    const char* name;
+    param_type_t type;
+    double min;                        // Inclusive limits for PARAM_TYPE_INT and PARAM_TYPE_FLOAT
+    double max;
+    const char* const* enum_names;     // PARAM_TYPE_ENUM
+    uint32_t enum_count;
+    const char* unit;                  // Required unit, or NULL for any
+} param_rule_t;
+
+bool param_value_parse(const param_rule_t* rule, const char* text, param_value_t* value);
+bool param_value_check(const param_rule_t* rule, const param_value_t* value);
+
+/*
+ * Numeric view of a value: ints and floats as themselves, bools as 0/1,
+ * enums as their index, strings as 0
+ */
+static inline double param_value_number(const param_value_t* value) {
+    switch (value->type) {
+        case PARAM_TYPE_INT:   return (double)value->as.i;
+        case PARAM_TYPE_FLOAT: return value->as.f;
+        case PARAM_TYPE_BOOL:  return value->as.b ? 1.0 : 0.0;
+        case PARAM_TYPE_ENUM:  return (double)value->as.e;
+        default:               return 0.0;
+    }
+}
+
+#endif // PARAM_VALUE_H
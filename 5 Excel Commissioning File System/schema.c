@@ -0,0 +1,642 @@
+/*
+ * Parameter Schema
+ * ================
+ *
+ * Schema file loading, rule table, constraint compiler and validation
+ * pass declared in schema.h.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "csv_map.h"
+#include "schema.h"
+
+static uint32_t schema_generations;       // Last generation handed out
+
+/*
+ * @return: A malloc'd, terminated copy of text[0..length), or NULL
+ */
+static char* copy_text(const char* text, size_t length) {
+    char* copy = malloc(length + 1);
+
+    if (copy != NULL) {
+        memcpy(copy, text, length);
+        copy[length] = '\0';
+    }
+    return copy;
+}
+
+static void free_rule(param_rule_t* rule) {
+    free((void*)rule->name);
+    free((void*)rule->unit);
+    for (uint32_t k = 0; k < rule->enum_count; k++) {
+        free((void*)rule->enum_names[k]);
+    }
+    free((void*)rule->enum_names);
+}
+
+void schema_free(schema_t* schema) {
+    for (uint32_t r = 0; r < schema->rule_count; r++) {
+        free_rule(&schema->rules[r]);
+    }
+    for (uint32_t c = 0; c < schema->constraint_count; c++) {
+        schema_constraint_t* constraint = &schema->constraints[c];
+        for (uint32_t n = 0; n < constraint->name_count; n++) {
+            free(constraint->names[n]);
+        }
+        free(constraint->names);
+        free(constraint->text);
+    }
+    free(schema->rules);
+    free(schema->slots);
+    free(schema->constraints);
+    memset(schema, 0, sizeof(*schema));
+}
+
+/*
+ * @return: Slot holding the name's rule, or the empty slot where it would go
+ */
+static uint32_t find_slot(const schema_t* schema, const char* name, size_t length, uint32_t hash) {
+    uint32_t mask = schema->slot_count - 1;
+
+    for (uint32_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        const schema_slot_t* entry = &schema->slots[slot];
+        if (entry->rule == SCHEMA_NONE) {
+            return slot;
+        }
+        if (entry->hash == hash) {
+            const char* rule_name = schema->rules[entry->rule].name;
+            if (strncmp(rule_name, name, length) == 0 && rule_name[length] == '\0') {
+                return slot;
+            }
+        }
+    }
+}
+
+/*
+ * @return: The rule for a parameter, or NULL if the schema has none
+ */
+const param_rule_t* schema_find(const schema_t* schema, const char* name, size_t length) {
+    if (schema->rule_count == 0) {
+        return NULL;
+    }
+    uint32_t rule = schema->slots[find_slot(schema, name, length, param_store_hash(name, length))].rule;
+    return rule == SCHEMA_NONE ? NULL : &schema->rules[rule];
+}
+
+/*
+ * Give a parameter its rule if the schema changed since it was last given
+ * one, parsing its value again when it is new or its rule changed
+ */
+void schema_resolve(const schema_t* schema, system_parameter_t* parameter) {
+    if (parameter->rule_generation == schema->generation && parameter->rule_generation != 0) {
+        return;
+    }
+
+    const param_rule_t* rule = schema_find(schema, parameter->name, strlen(parameter->name));
+    if (rule != parameter->rule || parameter->rule_generation == 0) {
+        parameter->rule = rule;
+        param_value_parse(rule, parameter->value, &parameter->typed);
+    }
+    parameter->rule_generation = schema->generation;
+}
+
+/*
+ * Double the rule table, placing every rule again by its stored hash
+ *
+ * @return: 0 on success, -1 if memory is exhausted
+ */
+static int grow_slots(schema_t* schema) {
+    uint32_t count = schema->slot_count ? schema->slot_count * 2 : 64;
+    schema_slot_t* slots = malloc(sizeof(schema_slot_t) * count);
+
+    if (slots == NULL) {
+        return -1;
+    }
+    memset(slots, 0xFF, sizeof(schema_slot_t) * count);
+    for (uint32_t s = 0; s < schema->slot_count; s++) {
+        if (schema->slots[s].rule != SCHEMA_NONE) {
+            uint32_t slot = schema->slots[s].hash & (count - 1);
+            while (slots[slot].rule != SCHEMA_NONE) {
+                slot = (slot + 1) & (count - 1);
+            }
+            slots[slot] = schema->slots[s];
+        }
+    }
+    free(schema->slots);
+    schema->slots = slots;
+    schema->slot_count = count;
+    return 0;
+}
+
+/*
+ * Add a rule, copying its name, unit and enum names. Rule pointers handed
+ * out earlier are invalid afterwards.
+ *
+ * @return: 0 on success, -1 if the name already has a rule or memory is exhausted
+ */
+int schema_add_rule(schema_t* schema, const param_rule_t* rule) {
+    size_t length = strlen(rule->name);
+
+    if ((uint64_t)(schema->rule_count + 1) * 10 > (uint64_t)schema->slot_count * 7 && grow_slots(schema) != 0) {
+        return -1;
+    }
+    uint32_t hash = param_store_hash(rule->name, length);
+    uint32_t slot = find_slot(schema, rule->name, length, hash);
+    if (schema->slots[slot].rule != SCHEMA_NONE) {
+        return -1;
+    }
+
+    if (schema->rule_count == schema->rule_capacity) {
+        uint32_t capacity = schema->rule_capacity ? schema->rule_capacity * 2 : 16;
+        param_rule_t* rules = realloc(schema->rules, sizeof(param_rule_t) * capacity);
+        if (rules == NULL) {
+            return -1;
+        }
+        schema->rules = rules;
+        schema->rule_capacity = capacity;
+    }
+
+    param_rule_t copy = *rule;
+    char** names = NULL;
+    copy.name = copy_text(rule->name, length);
+    copy.unit = rule->unit != NULL ? copy_text(rule->unit, strlen(rule->unit)) : NULL;
+    if (rule->enum_count > 0) {
+        names = calloc(rule->enum_count, sizeof(char*));
+        for (uint32_t k = 0; names != NULL && k < rule->enum_count; k++) {
+            names[k] = copy_text(rule->enum_names[k], strlen(rule->enum_names[k]));
+            if (names[k] == NULL) {
+                copy.enum_count = k;
+                break;
+            }
+        }
+    }
+    copy.enum_names = (const char* const*)names;
+    if (copy.name == NULL || (rule->unit != NULL && copy.unit == NULL) ||
+        (rule->enum_count > 0 && (names == NULL || copy.enum_count < rule->enum_count))) {
+        if (names == NULL) {
+            copy.enum_count = 0;
+        }
+        free_rule(&copy);
+        return -1;
+    }
+
+    schema->rules[schema->rule_count] = copy;
+    schema->slots[slot].hash = hash;
+    schema->slots[slot].rule = schema->rule_count++;
+    schema->generation = ++schema_generations;
+    return 0;
+}
+
+// Constraint compiler: recursive descent over the text, emitting postfix
+typedef struct {
+    const char* p;
+    schema_constraint_t* constraint;
+    schema_step_t* out;
+    uint8_t* length;
+    const char* error;
+} expression_parser_t;
+
+static void skip_spaces(expression_parser_t* parser) {
+    while (*parser->p == ' ' || *parser->p == '\t') {
+        parser->p++;
+    }
+}
+
+static void emit(expression_parser_t* parser, schema_step_t step) {
+    if (*parser->length >= SCHEMA_MAX_PROGRAM) {
+        parser->error = "expression too long";
+        return;
+    }
+    parser->out[(*parser->length)++] = step;
+}
+
+/*
+ * @return: Index of the name in the constraint's list, adding it if new
+ */
+static uint32_t name_index(expression_parser_t* parser, const char* name, size_t length) {
+    schema_constraint_t* constraint = parser->constraint;
+
+    for (uint32_t n = 0; n < constraint->name_count; n++) {
+        if (strncmp(constraint->names[n], name, length) == 0 && constraint->names[n][length] == '\0') {
+            return n;
+        }
+    }
+    char** names = realloc(constraint->names, sizeof(char*) * (constraint->name_count + 1));
+    if (names == NULL) {
+        parser->error = "out of memory";
+        return 0;
+    }
+    constraint->names = names;
+    names[constraint->name_count] = copy_text(name, length);
+    if (names[constraint->name_count] == NULL) {
+        parser->error = "out of memory";
+        return 0;
+    }
+    return constraint->name_count++;
+}
+
+static void parse_sum(expression_parser_t* parser);
+
+static void parse_factor(expression_parser_t* parser) {
+    schema_step_t step = {0};
+
+    skip_spaces(parser);
+    const char* start = parser->p;
+    if (*start == '(') {
+        parser->p++;
+        parse_sum(parser);
+        skip_spaces(parser);
+        if (*parser->p != ')') {
+            parser->error = "missing ')'";
+            return;
+        }
+        parser->p++;
+    } else if (*start == '-') {
+        parser->p++;
+        parse_factor(parser);
+        step.op = 'u';
+        emit(parser, step);
+    } else if (isalpha((unsigned char)*start) || *start == '_') {
+        while (isalnum((unsigned char)*parser->p) || *parser->p == '_') {
+            parser->p++;
+        }
+        step.op = 'p';
+        step.name = name_index(parser, start, (size_t)(parser->p - start));
+        emit(parser, step);
+    } else {
+        char* end;
+        step.number = strtod(start, &end);
+        if (end == start) {
+            parser->error = "expected a parameter, number or '('";
+            return;
+        }
+        parser->p = end;
+        step.op = 'n';
+        emit(parser, step);
+    }
+}
+
+static void parse_product(expression_parser_t* parser) {
+    parse_factor(parser);
+    for (;;) {
+        skip_spaces(parser);
+        char op = *parser->p;
+        if (parser->error != NULL || (op != '*' && op != '/')) {
+            return;
+        }
+        parser->p++;
+        parse_factor(parser);
+        schema_step_t step = {.op = (uint8_t)op};
+        emit(parser, step);
+    }
+}
+
+static void parse_sum(expression_parser_t* parser) {
+    parse_product(parser);
+    for (;;) {
+        skip_spaces(parser);
+        char op = *parser->p;
+        if (parser->error != NULL || (op != '+' && op != '-')) {
+            return;
+        }
+        parser->p++;
+        parse_product(parser);
+        schema_step_t step = {.op = (uint8_t)op};
+        emit(parser, step);
+    }
+}
+
+/*
+ * Compile a constraint such as "current_limit * voltage_limit <= power_rating"
+ *
+ * @return: 0 on success, -1 if it does not compile (a warning is printed)
+ */
+int schema_add_constraint(schema_t* schema, const char* text, uint32_t line) {
+    static const struct { const char* symbol; uint8_t code; } comparisons[] = {
+        {"<=", 'l'}, {">=", 'g'}, {"==", '='}, {"!=", '!'}, {"<", '<'}, {">", '>'}
+    };
+    schema_constraint_t constraint;
+    expression_parser_t parser;
+
+    memset(&constraint, 0, sizeof(constraint));
+    constraint.line = line;
+    memset(&parser, 0, sizeof(parser));
+    parser.p = text;
+    parser.constraint = &constraint;
+
+    parser.out = constraint.left;
+    parser.length = &constraint.left_length;
+    parse_sum(&parser);
+
+    if (parser.error == NULL) {
+        skip_spaces(&parser);
+        for (size_t k = 0; k < sizeof(comparisons) / sizeof(comparisons[0]); k++) {
+            size_t length = strlen(comparisons[k].symbol);
+            if (strncmp(parser.p, comparisons[k].symbol, length) == 0) {
+                constraint.compare = comparisons[k].code;
+                parser.p += length;
+                break;
+            }
+        }
+        if (constraint.compare == 0) {
+            parser.error = "expected <=, <, >=, >, == or !=";
+        }
+    }
+    if (parser.error == NULL) {
+        parser.out = constraint.right;
+        parser.length = &constraint.right_length;
+        parse_sum(&parser);
+        skip_spaces(&parser);
+        if (parser.error == NULL && *parser.p != '\0') {
+            parser.error = "unexpected text after the expression";
+        }
+    }
+
+    if (parser.error == NULL && schema->constraint_count == schema->constraint_capacity) {
+        uint32_t capacity = schema->constraint_capacity ? schema->constraint_capacity * 2 : 8;
+        schema_constraint_t* constraints = realloc(schema->constraints, sizeof(schema_constraint_t) * capacity);
+        if (constraints == NULL) {
+            parser.error = "out of memory";
+        } else {
+            schema->constraints = constraints;
+            schema->constraint_capacity = capacity;
+        }
+    }
+    if (parser.error == NULL && (constraint.text = copy_text(text, strlen(text))) == NULL) {
+        parser.error = "out of memory";
+    }
+
+    if (parser.error != NULL) {
+        printf("Warning: Schema line %u: constraint '%s': %s at '%s'\n", line, text, parser.error, parser.p);
+        for (uint32_t n = 0; n < constraint.name_count; n++) {
+            free(constraint.names[n]);
+        }
+        free(constraint.names);
+        return -1;
+    }
+    schema->constraints[schema->constraint_count++] = constraint;
+    return 0;
+}
+
+/*
+ * Run one side of a constraint
+ *
+ * @return: 0 on success, -1 if a parameter is missing from the store
+ */
+static int run_program(const schema_constraint_t* constraint, const schema_step_t* program,
+                       uint8_t length, const param_store_t* store, double* result) {
+    double stack[SCHEMA_MAX_PROGRAM];
+    int top = 0;
+
+    for (uint8_t k = 0; k < length; k++) {
+        const schema_step_t* step = &program[k];
+        switch (step->op) {
+            case 'n':
+                stack[top++] = step->number;
+                break;
+            case 'p': {
+                const char* name = constraint->names[step->name];
+                uint32_t id = param_store_find(store, name, strlen(name));
+                if (id == PARAM_STORE_NONE) {
+                    return -1;
+                }
+                stack[top++] = param_value_number(&store->parameters[id].typed);
+                break;
+            }
+            case 'u':
+                stack[top - 1] = -stack[top - 1];
+                break;
+            default: {
+                double b = stack[--top];
+                double a = stack[top - 1];
+                stack[top - 1] = step->op == '+' ? a + b : step->op == '-' ? a - b :
+                                 step->op == '*' ? a * b : a / b;
+                break;
+            }
+        }
+    }
+    *result = stack[0];
+    return 0;
+}
+
+/*
+ * Evaluate a constraint against the store, giving both sides' values
+ *
+ * @return: 1 if it holds, 0 if it is violated, -1 if a parameter is missing
+ */
+int schema_evaluate(const schema_t* schema, uint32_t index, const param_store_t* store,
+                    double* left, double* right) {
+    const schema_constraint_t* constraint = &schema->constraints[index];
+
+    if (run_program(constraint, constraint->left, constraint->left_length, store, left) != 0 ||
+        run_program(constraint, constraint->right, constraint->right_length, store, right) != 0) {
+        return -1;
+    }
+
+    switch (constraint->compare) {
+        case 'l': return *left <= *right;
+        case 'g': return *left >= *right;
+        case '<': return *left < *right;
+        case '>': return *left > *right;
+        case '=': return *left == *right;
+        default:  return *left != *right;
+    }
+}
+
+static void report_add(schema_report_t* report, schema_violation_kind_t kind, uint32_t id) {
+    report->by_kind[kind]++;
+    if (report->count == report->capacity) {
+        uint32_t capacity = report->capacity ? report->capacity * 2 : 64;
+        schema_violation_t* items = realloc(report->items, sizeof(schema_violation_t) * capacity);
+        if (items == NULL) {
+            return;   // Counted, but not listed
+        }
+        report->items = items;
+        report->capacity = capacity;
+    }
+    report->items[report->count].kind = (uint8_t)kind;
+    report->items[report->count].id = id;
+    report->count++;
+}
+
+void schema_report_free(schema_report_t* report) {
+    free(report->items);
+    memset(report, 0, sizeof(*report));
+}
+
+/*
+ * Check every parameter in one pass, then every constraint. Parameters
+ * whose rule may have changed are resolved again first (schema_resolve()).
+ * is_valid is updated and every violation is added to the report, which
+ * is emptied first.
+ */
+void schema_validate(const schema_t* schema, param_store_t* store, schema_report_t* report) {
+    report->count = 0;
+    report->checked = 0;
+    memset(report->by_kind, 0, sizeof(report->by_kind));
+
+    for (uint32_t id = 0; id < store->count; id++) {
+        system_parameter_t* parameter = &store->parameters[id];
+
+        schema_resolve(schema, parameter);
+        const param_rule_t* rule = parameter->rule;
+        if (rule == NULL) {
+            parameter->is_valid = true;
+            continue;
+        }
+
+        report->checked++;
+        parameter->is_valid = false;
+        if (!parameter->typed.parsed || parameter->typed.type != rule->type) {
+            report_add(report, SCHEMA_VIOLATION_TYPE, id);
+        } else if (!param_value_check(rule, &parameter->typed)) {
+            report_add(report, SCHEMA_VIOLATION_RANGE, id);
+        } else if (rule->unit != NULL && strcmp(rule->unit, parameter->unit) != 0) {
+            report_add(report, SCHEMA_VIOLATION_UNIT, id);
+        } else {
+            parameter->is_valid = true;
+        }
+    }
+
+    for (uint32_t c = 0; c < schema->constraint_count; c++) {
+        double left, right;
+        int result = schema_evaluate(schema, c, store, &left, &right);
+        if (result < 0) {
+            report_add(report, SCHEMA_VIOLATION_MISSING, c);
+        } else if (result == 0) {
+            report_add(report, SCHEMA_VIOLATION_CONSTRAINT, c);
+        }
+    }
+}
+
+/*
+ * @return: The type named by text, or -1
+ */
+static int parse_type(const csv_field_t* field) {
+    static const char* const names[] = {"string", "int", "float", "bool", "enum"};
+
+    for (int t = 0; t < 5; t++) {
+        if (csv_field_equals(field, names[t])) {
+            return t;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Read an optional limit
+ *
+ * @return: 0 if the field is empty or a number, -1 otherwise
+ */
+static int parse_limit(const csv_row_t* row, uint32_t column, double* limit) {
+    char text[64];
+    char* end;
+
+    if (column >= row->field_count || row->fields[column].length == 0) {
+        return 0;
+    }
+    csv_field_copy(&row->fields[column], text, sizeof(text));
+    double value = strtod(text, &end);
+    if (end == text || *end != '\0') {
+        return -1;
+    }
+    *limit = value;
+    return 0;
+}
+
+/*
+ * Load rules and constraints from a schema file, adding to any already
+ * in the schema. Rows with errors are skipped with a warning.
+ *
+ * @return: 0 on success, -1 if the file cannot be read
+ */
+int schema_load(schema_t* schema, const char* path) {
+    csv_map_t map;
+    csv_row_t row;
+
+    if (csv_map_open(&map, path) != 0) {
+        return -1;
+    }
+
+    // Skip header line
+    if (!csv_map_next_row(&map, &row)) {
+        csv_map_close(&map);
+        return 0;
+    }
+
+    while (csv_map_next_row(&map, &row)) {
+        char name[256];
+        param_rule_t rule;
+
+        if (row.fields[0].length == 0 || row.fields[0].data[0] == '#') {
+            continue;   // Blank name or comment
+        }
+
+        if (csv_field_equals(&row.fields[0], "Constraint")) {
+            char* text;
+            if (row.field_count < 2 || (text = malloc(row.fields[1].length + 1)) == NULL) {
+                printf("Warning: Schema line %u: constraint has no expression\n", row.line);
+                continue;
+            }
+            csv_field_copy(&row.fields[1], text, row.fields[1].length + 1);
+            schema_add_constraint(schema, text, row.line);
+            free(text);
+            continue;
+        }
+
+        if (csv_field_copy(&row.fields[0], name, sizeof(name)) >= sizeof(name)) {
+            printf("Warning: Schema line %u: parameter name too long\n", row.line);
+            continue;
+        }
+
+        memset(&rule, 0, sizeof(rule));
+        rule.name = name;
+        rule.min = -1e300;
+        rule.max = 1e300;
+        int type = row.field_count > 1 ? parse_type(&row.fields[1]) : -1;
+        if (type < 0) {
+            printf("Warning: Schema line %u: '%s' needs a type (int, float, bool, enum or string)\n",
+                   row.line, name);
+            continue;
+        }
+        rule.type = (param_type_t)type;
+        if (parse_limit(&row, 2, &rule.min) != 0 || parse_limit(&row, 3, &rule.max) != 0) {
+            printf("Warning: Schema line %u: '%s' has a limit that is not a number\n", row.line, name);
+            continue;
+        }
+
+        char unit[PARAM_TEXT_LENGTH];
+        if (row.field_count > 4 && row.fields[4].length > 0) {
+            csv_field_copy(&row.fields[4], unit, sizeof(unit));
+            rule.unit = unit;
+        }
+
+        // Enum names: "a|b|c"
+        char values[1024];
+        const char* enum_names[64];
+        if (rule.type == PARAM_TYPE_ENUM) {
+            if (row.field_count > 5) {
+                csv_field_copy(&row.fields[5], values, sizeof(values));
+                for (char* value = strtok(values, "|"); value != NULL && rule.enum_count < 64;
+                     value = strtok(NULL, "|")) {
+                    enum_names[rule.enum_count++] = value;
+                }
+            }
+            if (rule.enum_count == 0) {
+                printf("Warning: Schema line %u: enum '%s' lists no values\n", row.line, name);
+                continue;
+            }
+            rule.enum_names = enum_names;
+        }
+
+        if (schema_add_rule(schema, &rule) != 0) {
+            printf("Warning: Schema line %u: duplicate rule for '%s' ignored\n", row.line, name);
+        }
+    }
+
+    csv_map_close(&map);
+    return 0;
+}
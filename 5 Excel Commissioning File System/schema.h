@@ -0,0 +1,111 @@
+/*
+ * Parameter Schema
+ * ================
+ *
+ * Rules for the parameters of a commissioning file, loaded from a schema
+ * file (CSV, read with csv_map.h):
+ *
+ *   Parameter,Type,Min,Max,Unit,Values
+ *   motor_speed_rpm,int,0,3000,RPM,
+ *   control_mode,enum,,,,manual|auto|cascade
+ *   Constraint,current_limit * voltage_limit <= power_rating
+ *
+ * Type is int, float, bool, enum or string. Min and Max bound ints and
+ * floats (either may be empty). Unit, if given, must match the parameter's
+ * unit. Values lists an enum's names separated by '|'.
+ *
+ * A "Constraint" row relates parameters: two arithmetic expressions (+ - * /
+ * and parentheses over parameter names and numbers) joined by <=, <, >=,
+ * >, == or !=. Constraints are compiled to postfix programs when the schema
+ * is loaded.
+ *
+ * The rules are compiled into an open-addressing table keyed by the hash
+ * of the parameter name (param_store_hash()), so finding a parameter's rule
+ * costs one probe. Each parameter remembers the rule it was given and the
+ * schema generation it came from, so the lookup is repeated only after the
+ * rules change. schema_validate() checks a whole parameter store in one
+ * pass, then evaluates every constraint, and collects all violations into
+ * a report instead of stopping at the first.
+ */
+
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "param_store.h"
+#include "param_value.h"
+
+#define SCHEMA_NONE UINT32_MAX
+#define SCHEMA_MAX_PROGRAM 64            // Postfix steps per side of a constraint
+
+typedef enum {
+    SCHEMA_VIOLATION_TYPE = 0,           // Value does not parse as the rule's type (or enum)
+    SCHEMA_VIOLATION_RANGE,              // Number outside min..max
+    SCHEMA_VIOLATION_UNIT,               // Unit differs from the schema's
+    SCHEMA_VIOLATION_CONSTRAINT,         // Constraint evaluates false
+    SCHEMA_VIOLATION_MISSING,            // Constraint names a parameter the store lacks
+    SCHEMA_VIOLATION_KINDS
+} schema_violation_kind_t;
+
+// One postfix step: push a number, push a parameter's value, or apply an operator
+typedef struct {
+    uint8_t op;                          // 'n' number, 'p' parameter, or + - * /, 'u' negate
+    uint32_t name;                       // 'p': index into the constraint's names
+    double number;                       // 'n'
+} schema_step_t;
+
+typedef struct {
+    char* text;                          // As written, for reports
+    char** names;                        // Parameters referenced
+    uint32_t name_count;
+    schema_step_t left[SCHEMA_MAX_PROGRAM];
+    schema_step_t right[SCHEMA_MAX_PROGRAM];
+    uint8_t left_length;
+    uint8_t right_length;
+    uint8_t compare;                     // '<' '>' 'l' (<=) 'g' (>=) '=' '!'
+    uint32_t line;                       // In the schema file
+} schema_constraint_t;
+
+typedef struct {
+    uint32_t hash;
+    uint32_t rule;                       // Index into rules, or SCHEMA_NONE when empty
+} schema_slot_t;
+
+typedef struct {
+    param_rule_t* rules;
+    uint32_t rule_count;
+    uint32_t rule_capacity;
+    schema_slot_t* slots;
+    uint32_t slot_count;                 // Power of two (0 while there are no rules)
+    schema_constraint_t* constraints;
+    uint32_t constraint_count;
+    uint32_t constraint_capacity;
+    uint32_t generation;                 // Changes with every rule added, unique across schemas
+} schema_t;
+
+typedef struct {
+    uint8_t kind;                        // schema_violation_kind_t
+    uint32_t id;                         // Parameter ID, or constraint index
+} schema_violation_t;
+
+typedef struct {
+    schema_violation_t* items;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t by_kind[SCHEMA_VIOLATION_KINDS];
+    uint32_t checked;                    // Parameters checked against a rule
+} schema_report_t;
+
+int schema_load(schema_t* schema, const char* path);
+int schema_add_rule(schema_t* schema, const param_rule_t* rule);
+int schema_add_constraint(schema_t* schema, const char* text, uint32_t line);
+void schema_free(schema_t* schema);
+const param_rule_t* schema_find(const schema_t* schema, const char* name, size_t length);
+void schema_resolve(const schema_t* schema, system_parameter_t* parameter);
+int schema_evaluate(const schema_t* schema, uint32_t constraint, const param_store_t* store,
+                    double* left, double* right);
+void schema_validate(const schema_t* schema, param_store_t* store, schema_report_t* report);
+void schema_report_free(schema_report_t* report);
+
+#endif // SCHEMA_H
@@ -0,0 +1,545 @@
+/*
+ * Configuration Runtime
+ * =====================
+ *
+ * File reading, snapshot publishing and the watcher thread declared in
+ * config_runtime.h.
+ */
+
+// Expose poll(), pipe() and struct stat's st_mtim when building with -std=c99
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "config_runtime.h"
+
+#ifndef _WIN32
+#include <poll.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+#define NAME_FIELD_MAX 128               // Longer names cannot be one of the keys
+#define VALUE_FIELD_MAX 64
+
+static char* join(const char* path, const char* suffix) {
+    size_t length = strlen(path), extra = strlen(suffix);
+    char* joined = malloc(length + extra + 1);
+
+    if (joined != NULL) {
+        memcpy(joined, path, length);
+        memcpy(joined + length, suffix, extra + 1);
+    }
+    return joined;
+}
+
+/*
+ * Read a whole file into a buffer
+ *
+ * @return: The contents (to free), or NULL if the file cannot be read
+ */
+static char* read_file(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    char* data = NULL;
+    long length;
+
+    if (file == NULL) {
+        return NULL;
+    }
+    if (fseek(file, 0, SEEK_END) == 0 && (length = ftell(file)) >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+        data = malloc((size_t)length + 1);
+        if (data != NULL) {
+            *size = fread(data, 1, (size_t)length, file);
+        }
+    }
+    fclose(file);
+    return data;
+}
+
+/*
+ * Copy one CSV field, undoing quotes and doubled quotes. Longer fields are
+ * cut to size - 1 bytes.
+ *
+ * @return: Where the field ends: at its ',', the row's '\n', or end
+ */
+static const char* read_field(const char* p, const char* end, char* out, size_t size) {
+    size_t length = 0;
+
+    if (p < end && *p == '"') {
+        for (p++; p < end; p++) {
+            char c = *p;
+            if (c == '"') {
+                if (p + 1 < end && p[1] == '"') {
+                    p++;
+                } else {
+                    p++;
+                    break;
+                }
+            }
+            if (length + 1 < size) {
+                out[length++] = c;
+            }
+        }
+    }
+    for (; p < end && *p != ',' && *p != '\n'; p++) {
+        if (*p != '\r' && length + 1 < size) {
+            out[length++] = *p;
+        }
+    }
+    out[length] = '\0';
+    return p;
+}
+
+/*
+ * Parse a value as a number ("true" and "false" are 1 and 0)
+ *
+ * @return: 0 on success, -1 if it is not a finite number
+ */
+static int parse_value(const char* text, double* value) {
+    char* end;
+
+    if (strcmp(text, "true") == 0 || strcmp(text, "false") == 0) {
+        *value = text[0] == 't' ? 1.0 : 0.0;
+        return 0;
+    }
+    *value = strtod(text, &end);
+    while (*end == ' ') {
+        end++;
+    }
+    return (end == text || *end != '\0' || !isfinite(*value)) ? -1 : 0;
+}
+
+/*
+ * Give a key the value from a row, or keep its previous value if the row's
+ * value is not valid for it
+ */
+static void set_value(const config_runtime_t* config, uint32_t key, const char* text,
+                      const double* previous, double* values) {
+    const config_key_t* spec = &config->keys[key];
+    double value;
+
+    if (parse_value(text, &value) != 0) {
+        printf("Warning: Config %s = '%s' is not a number; keeping %g\n", spec->name, text, previous[key]);
+        values[key] = previous[key];
+    } else if (value < spec->min || value > spec->max) {
+        printf("Warning: Config %s = %g is outside %g..%g; keeping %g\n", spec->name, value,
+               spec->min, spec->max, previous[key]);
+        values[key] = previous[key];
+    } else {
+        values[key] = value;
+    }
+}
+
+/*
+ * Apply the rows of a commissioning file, or the committed batches of a
+ * journal, for the program's keys
+ *
+ * @return: 0 on success, -1 if the file cannot be read
+ */
+static int apply_file(const config_runtime_t* config, const char* path, int journal,
+                      const double* previous, double* values) {
+    char name[NAME_FIELD_MAX], value[VALUE_FIELD_MAX], skipped[VALUE_FIELD_MAX];
+    char pending[CONFIG_RUNTIME_MAX_KEYS][VALUE_FIELD_MAX];
+    uint8_t is_pending[CONFIG_RUNTIME_MAX_KEYS] = {0};
+    size_t size = 0;
+    char* data = read_file(path, &size);
+
+    if (data == NULL) {
+        return -1;
+    }
+
+    const char* p = data;
+    const char* end = data + size;
+    int header = 1;
+    while (p < end) {
+        if (*p == '\n' || *p == '\r') {
+            p++;   // Blank line
+            continue;
+        }
+        p = read_field(p, end, name, sizeof(name));
+        value[0] = '\0';
+        if (p < end && *p == ',') {
+            p = read_field(p + 1, end, value, sizeof(value));
+        }
+        while (p < end && *p == ',') {
+            p = read_field(p + 1, end, skipped, sizeof(skipped));
+        }
+        if (p < end) {
+            p++;   // '\n'
+        }
+
+        if (header) {
+            header = 0;
+            continue;
+        }
+        if (journal && strcmp(name, "#commit") == 0) {
+            for (uint32_t k = 0; k < config->key_count; k++) {
+                if (is_pending[k]) {
+                    set_value(config, k, pending[k], previous, values);
+                    is_pending[k] = 0;
+                }
+            }
+            continue;
+        }
+        for (uint32_t k = 0; k < config->key_count; k++) {
+            if (strcmp(name, config->keys[k].name) == 0) {
+                if (journal) {
+                    memcpy(pending[k], value, sizeof(value));   // Applied at the batch's commit line
+                    is_pending[k] = 1;
+                } else {
+                    set_value(config, k, value, previous, values);
+                }
+                break;
+            }
+        }
+    }
+
+    free(data);
+    return 0;
+}
+
+/*
+ * Free replaced snapshots that no registered reader can still hold
+ */
+static void reclaim(config_runtime_t* config) {
+    uint64_t oldest = __atomic_load_n(&config->epoch, __ATOMIC_SEQ_CST);
+
+    for (uint32_t r = 0; r < CONFIG_RUNTIME_MAX_READERS; r++) {
+        config_reader_t* reader = __atomic_load_n(&config->readers[r], __ATOMIC_SEQ_CST);
+        if (reader != NULL) {
+            uint64_t seen = __atomic_load_n(&reader->seen, __ATOMIC_ACQUIRE);
+            if (seen < oldest) {
+                oldest = seen;
+            }
+        }
+    }
+
+    config_snapshot_t** link = &config->retired;
+    while (*link != NULL) {
+        config_snapshot_t* snapshot = *link;
+        if (snapshot->retired_epoch <= oldest) {
+            *link = snapshot->retired_next;
+            free(snapshot);
+        } else {
+            link = &snapshot->retired_next;
+        }
+    }
+}
+
+/*
+ * Read the file and journals and publish a new snapshot if a value changed
+ *
+ * @return: 1 if a new snapshot was published, 0 if nothing changed,
+ *          -1 if memory is exhausted
+ */
+static int load(config_runtime_t* config) {
+    const config_snapshot_t* current = config->current;
+    double previous[CONFIG_RUNTIME_MAX_KEYS];
+    config_snapshot_t* snapshot = calloc(1, sizeof(*snapshot));
+
+    if (snapshot == NULL) {
+        return -1;
+    }
+    for (uint32_t k = 0; k < config->key_count; k++) {
+        previous[k] = current != NULL ? current->values[k] : config->keys[k].default_value;
+        snapshot->values[k] = config->keys[k].default_value;
+    }
+
+    int found = apply_file(config, config->path, 0, previous, snapshot->values) == 0;
+    if (current == NULL && !found) {
+        printf("Warning: Config %s not found; using built-in values\n", config->path);
+    }
+    apply_file(config, config->rotated_path, 1, previous, snapshot->values);
+    apply_file(config, config->journal_path, 1, previous, snapshot->values);
+
+    if (current != NULL) {
+        int changed = 0;
+        for (uint32_t k = 0; k < config->key_count; k++) {
+            if (snapshot->values[k] != current->values[k] && config->quiet) {
+                changed = 1;
+            } else if (snapshot->values[k] != current->values[k]) {
+                printf("%s%s %g -> %g", changed ? ", " : "Config: ", config->keys[k].name,
+                       current->values[k], snapshot->values[k]);
+                changed = 1;
+            }
+        }
+        if (!changed) {
+            free(snapshot);
+            return 0;
+        }
+        if (!config->quiet) {
+            printf(" (version %llu)\n", (unsigned long long)current->version + 1);
+        }
+    } else if (found) {
+        printf("Config: %u parameters from %s\n", config->key_count, config->path);
+    }
+    snapshot->version = current != NULL ? current->version + 1 : 1;
+
+    // Swap, then start the epoch readers must reach before the old one goes
+    config_snapshot_t* old = __atomic_exchange_n(&config->current, snapshot, __ATOMIC_SEQ_CST);
+    uint64_t epoch = __atomic_add_fetch(&config->epoch, 1, __ATOMIC_SEQ_CST);
+    if (old != NULL) {
+        old->retired_epoch = epoch;
+        old->retired_next = config->retired;
+        config->retired = old;
+        config->reloads++;
+    }
+    reclaim(config);
+    return 1;
+}
+
+/*
+ * Read the commissioning file again now
+ *
+ * @return: 1 if a value changed, 0 if not, -1 if memory is exhausted
+ */
+int config_runtime_reload(config_runtime_t* config) {
+#ifndef _WIN32
+    pthread_mutex_lock(&config->write_lock);
+    int result = load(config);
+    pthread_mutex_unlock(&config->write_lock);
+    return result;
+#else
+    return load(config);
+#endif
+}
+
+#ifndef _WIN32
+/*
+ * Size and modification time of the file and its journals, to notice
+ * changes without inotify
+ */
+static void stamp_files(const config_runtime_t* config, int64_t stamps[6]) {
+    const char* paths[] = {config->path, config->journal_path, config->rotated_path};
+    struct stat info;
+
+    for (int f = 0; f < 3; f++) {
+        if (stat(paths[f], &info) != 0) {
+            stamps[2 * f] = -1;
+            stamps[2 * f + 1] = 0;
+            continue;
+        }
+        stamps[2 * f] = (int64_t)info.st_size;
+#ifdef __APPLE__
+        stamps[2 * f + 1] = (int64_t)info.st_mtimespec.tv_sec * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+        stamps[2 * f + 1] = (int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+    }
+}
+
+/*
+ * Wait for the stop pipe
+ *
+ * @return: true if the watcher should stop
+ */
+static int stop_requested(const config_runtime_t* config, int timeout_ms) {
+    struct pollfd stop = {config->stop_pipe[0], POLLIN, 0};
+
+    return poll(&stop, 1, timeout_ms) > 0;
+}
+
+static void watch_by_polling(config_runtime_t* config) {
+    int64_t last[6], now[6];
+
+    stamp_files(config, last);
+    while (!stop_requested(config, CONFIG_RUNTIME_POLL_MS)) {
+        stamp_files(config, now);
+        if (memcmp(now, last, sizeof(now)) != 0) {
+            memcpy(last, now, sizeof(now));
+            config_runtime_reload(config);
+        }
+    }
+}
+
+#ifdef __linux__
+/*
+ * @return: true if an inotify event names the file or one of its journals
+ */
+static int names_config_file(const config_runtime_t* config, const char* name) {
+    const char* base = strrchr(config->path, '/');
+    size_t length;
+
+    base = base != NULL ? base + 1 : config->path;
+    length = strlen(base);
+    return strncmp(name, base, length) == 0 &&
+           (name[length] == '\0' || strcmp(name + length, ".journal") == 0 ||
+            strcmp(name + length, ".journal.1") == 0);
+}
+
+/*
+ * Reload after changes to the file's directory that name the file or its
+ * journals. A file renamed into place or closed after writing is complete
+ * and reloads at once; other changes, such as journal appends, reload once
+ * they have been quiet for CONFIG_RUNTIME_SETTLE_MS.
+ *
+ * @return: 0 when stopped, -1 if inotify cannot watch the directory
+ */
+static int watch_by_inotify(config_runtime_t* config) {
+    char directory[4096];
+    const char* slash = strrchr(config->path, '/');
+    int fd = inotify_init1(IN_CLOEXEC);
+
+    if (slash == NULL) {
+        strcpy(directory, ".");
+    } else {
+        snprintf(directory, sizeof(directory), "%.*s", (int)(slash - config->path), config->path);
+    }
+    if (fd < 0 || inotify_add_watch(fd, slash == config->path ? "/" : directory,
+                                    IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE | IN_DELETE) < 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+
+    char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int changed = 0, complete = 0;
+    for (;;) {
+        struct pollfd fds[2] = {{fd, POLLIN, 0}, {config->stop_pipe[0], POLLIN, 0}};
+        int ready = poll(fds, 2, complete ? 0 : changed ? CONFIG_RUNTIME_SETTLE_MS : -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents != 0) {
+            break;
+        }
+        if (ready == 0) {
+            changed = complete = 0;
+            config_runtime_reload(config);
+            continue;
+        }
+
+        long length = (long)read(fd, events, sizeof(events));
+        for (long offset = 0; offset < length;) {
+            const struct inotify_event* event = (const struct inotify_event*)(events + offset);
+            if (event->len > 0 && names_config_file(config, event->name)) {
+                changed = 1;
+                complete |= (event->mask & (IN_MOVED_TO | IN_CLOSE_WRITE)) != 0;
+            }
+            offset += (long)sizeof(*event) + event->len;
+        }
+    }
+    close(fd);
+    return 0;
+}
+#endif
+
+static void* watch_thread(void* argument) {
+    config_runtime_t* config = argument;
+
+#ifdef __linux__
+    if (watch_by_inotify(config) == 0) {
+        return NULL;
+    }
+#endif
+    watch_by_polling(config);
+    return NULL;
+}
+#endif
+
+/*
+ * Load the program's parameters from a commissioning file and start
+ * watching it. A missing file leaves the defaults in place until it
+ * appears.
+ *
+ * @return: 0 on success, -1 if there are too many keys or memory is exhausted
+ */
+int config_runtime_open(config_runtime_t* config, const char* path, const config_key_t* keys, uint32_t key_count) {
+    memset(config, 0, sizeof(*config));
+    if (key_count > CONFIG_RUNTIME_MAX_KEYS) {
+        return -1;
+    }
+    config->keys = keys;
+    config->key_count = key_count;
+#ifndef _WIN32
+    pthread_mutex_init(&config->write_lock, NULL);
+#endif
+    config->path = join(path, "");
+    config->journal_path = join(path, ".journal");
+    config->rotated_path = join(path, ".journal.1");
+    if (config->path == NULL || config->journal_path == NULL || config->rotated_path == NULL ||
+        load(config) < 0) {
+        config_runtime_close(config);
+        return -1;
+    }
+
+#ifndef _WIN32
+    if (pipe(config->stop_pipe) == 0) {
+        config->watching = pthread_create(&config->watcher, NULL, watch_thread, config) == 0;
+        if (!config->watching) {
+            close(config->stop_pipe[0]);
+            close(config->stop_pipe[1]);
+            printf("Warning: Config %s will not be reloaded\n", path);
+        }
+    }
+#endif
+    return 0;
+}
+
+/*
+ * Stop watching and free every snapshot. No reader may use one afterwards.
+ */
+void config_runtime_close(config_runtime_t* config) {
+#ifndef _WIN32
+    if (config->watching) {
+        if (write(config->stop_pipe[1], "", 1) != 1) {
+            pthread_cancel(config->watcher);
+        }
+        pthread_join(config->watcher, NULL);
+        close(config->stop_pipe[0]);
+        close(config->stop_pipe[1]);
+        config->watching = 0;
+    }
+    if (config->keys != NULL) {
+        pthread_mutex_destroy(&config->write_lock);
+    }
+#endif
+    while (config->retired != NULL) {
+        config_snapshot_t* next = config->retired->retired_next;
+        free(config->retired);
+        config->retired = next;
+    }
+    free(config->current);
+    free(config->path);
+    free(config->journal_path);
+    free(config->rotated_path);
+    memset(config, 0, sizeof(*config));
+}
+
+/*
+ * Register a thread that reads snapshots, before its first read
+ *
+ * @return: 0 on success, -1 if CONFIG_RUNTIME_MAX_READERS are registered
+ */
+int config_runtime_register(config_runtime_t* config, config_reader_t* reader) {
+    __atomic_store_n(&reader->seen, __atomic_load_n(&config->epoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+    for (uint32_t r = 0; r < CONFIG_RUNTIME_MAX_READERS; r++) {
+        config_reader_t* empty = NULL;
+        if (__atomic_compare_exchange_n(&config->readers[r], &empty, reader, 0,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Stop holding back the freeing of snapshots for a reader that is done
+ */
+void config_runtime_unregister(config_runtime_t* config, config_reader_t* reader) {
+    for (uint32_t r = 0; r < CONFIG_RUNTIME_MAX_READERS; r++) {
+        config_reader_t* expected = reader;
+        __atomic_compare_exchange_n(&config->readers[r], &expected, NULL, 0,
+                                    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    }
+}
@@ -0,0 +1,112 @@
+/*
+ * Configuration Runtime
+ * =====================
+ *
+ * Live commissioning parameters for the simulators, shared by the PID, VFD
+ * and sensor projects.
+ *
+ * A program lists the parameters it uses, each with a default and a valid
+ * range, and opens the commissioning file written by project 5. The values
+ * are read from the file and then from the committed batches of its
+ * journals ("<file>.journal.1", "<file>.journal"), so saves made by the
+ * commissioning system show up however they were written. Values that do
+ * not parse or are out of range keep their previous value, with a warning.
+ *
+ * Each load produces an immutable snapshot, published by swapping one
+ * pointer (RCU style). A control loop reads it with no locks and no system
+ * calls:
+ *
+ *   config_runtime_register(&config, &reader);
+ *   while (running) {
+ *       const config_snapshot_t* cfg = config_runtime_read(&config, &reader);
+ *       kp = cfg->values[CONFIG_P_GAIN];
+ *       ...
+ *   }
+ *
+ * A snapshot stays valid until the same reader's next config_runtime_read().
+ * That call is also the reader's quiescent state: a replaced snapshot is
+ * freed once every registered reader has read again since the swap.
+ *
+ * A watcher thread reloads the file when it changes. On Linux it waits on
+ * inotify for the file's directory, which also sees the file being renamed
+ * into place by an atomic save; that reloads at once, while journal appends
+ * wait CONFIG_RUNTIME_SETTLE_MS for the batch to finish. Other POSIX systems check the file's size
+ * and modification time every CONFIG_RUNTIME_POLL_MS. On Windows the file is
+ * read at start-up and by config_runtime_reload() only.
+ */
+
+#ifndef CONFIG_RUNTIME_H
+#define CONFIG_RUNTIME_H
+
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#define CONFIG_RUNTIME_MAX_KEYS 16       // Parameters per program
+#define CONFIG_RUNTIME_MAX_READERS 8     // Registered reader threads
+#define CONFIG_RUNTIME_POLL_MS 500       // Change check period without inotify
+#define CONFIG_RUNTIME_SETTLE_MS 20      // Quiet time after a change before reloading
+#define CONFIG_RUNTIME_DEFAULT_PATH "../5 Excel Commissioning File System/system_config.csv"
+
+// A parameter a program uses
+typedef struct {
+    const char* name;                    // Parameter name in the commissioning file
+    double default_value;                // Used until the file sets it
+    double min;                          // Inclusive valid range
+    double max;
+} config_key_t;
+
+// Immutable set of values, one per key
+typedef struct config_snapshot {
+    uint64_t version;                    // 1 for the first load, then one more per change
+    double values[CONFIG_RUNTIME_MAX_KEYS];
+    // Writer only
+    struct config_snapshot* retired_next;
+    uint64_t retired_epoch;              // Freed when every reader has seen this epoch
+} config_snapshot_t;
+
+// A thread that reads snapshots
+typedef struct {
+    uint64_t seen;                       // Epoch at its last read (atomic)
+} config_reader_t;
+
+typedef struct {
+    const config_key_t* keys;
+    uint32_t key_count;
+    char* path;
+    char* journal_path;                  // "<path>.journal"
+    char* rotated_path;                  // "<path>.journal.1"
+
+    config_snapshot_t* current;          // Published snapshot (atomic)
+    uint64_t epoch;                      // Swaps so far (atomic)
+    config_snapshot_t* retired;          // Replaced, not yet freed
+    config_reader_t* readers[CONFIG_RUNTIME_MAX_READERS];   // (atomic)
+    uint32_t reloads;                    // Loads that changed a value
+    int quiet;                           // Do not print changed values
+
+#ifndef _WIN32
+    pthread_mutex_t write_lock;          // One writer at a time
+    pthread_t watcher;
+    int watching;
+    int stop_pipe[2];                    // Written to stop the watcher
+#endif
+} config_runtime_t;
+
+int config_runtime_open(config_runtime_t* config, const char* path, const config_key_t* keys, uint32_t key_count);
+void config_runtime_close(config_runtime_t* config);
+int config_runtime_reload(config_runtime_t* config);
+int config_runtime_register(config_runtime_t* config, config_reader_t* reader);
+void config_runtime_unregister(config_runtime_t* config, config_reader_t* reader);
+
+/*
+ * The current snapshot. The one this reader got last time may be freed
+ * after this call.
+ */
+static inline const config_snapshot_t* config_runtime_read(config_runtime_t* config, config_reader_t* reader) {
+    __atomic_store_n(&reader->seen, __atomic_load_n(&config->epoch, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+    return __atomic_load_n(&config->current, __ATOMIC_ACQUIRE);
+}
+
+#endif // CONFIG_RUNTIME_H
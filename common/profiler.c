@@ -0,0 +1,331 @@
+/*
+ * Hot-Path Profiler
+ * =================
+ *
+ * Site registry, per-thread recording and the trace and histogram exports
+ * declared in profiler.h.
+ */
+
+// Expose clock_gettime() and CLOCK_MONOTONIC_RAW when building with -std=c99
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "profiler.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#ifdef __GNUC__
+#define PROFILE_THREAD_LOCAL __thread
+#else
+#define PROFILE_THREAD_LOCAL __declspec(thread)
+#endif
+
+int profiler_enabled;
+
+static profile_site_t* profile_sites[PROFILE_MAX_SITES + 1];   // Indexed by ID; 0 unused
+static uint16_t profile_site_count;
+static profile_buffer_t* profile_buffers;                     // All thread buffers
+static uint32_t profile_thread_count;
+static PROFILE_THREAD_LOCAL profile_buffer_t* profile_thread_buffer;
+static const char* profile_output_path;
+
+// Tick rate calibration: tick and clock readings taken when profiling starts
+static uint64_t profile_base_ticks;
+static uint64_t profile_base_ns;
+
+/*
+ * CLOCK_MONOTONIC_RAW in nanoseconds (not slewed by NTP)
+ */
+uint64_t profile_clock_ticks(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+#ifdef CLOCK_MONOTONIC_RAW
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+void profiler_enable(int enabled) {
+    if (enabled && profile_base_ns == 0) {
+        profile_base_ticks = profile_ticks();
+        profile_base_ns = profile_clock_ticks();
+    }
+    __atomic_store_n(&profiler_enabled, enabled, __ATOMIC_RELEASE);
+}
+
+/*
+ * Nanoseconds per tick: 1 when ticks come from the clock, otherwise the
+ * TSC rate measured against CLOCK_MONOTONIC_RAW since profiling started
+ * (extended to at least 10 ms for a stable ratio).
+ */
+double profiler_ns_per_tick(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    uint64_t start_ticks = profile_base_ticks, start_ns = profile_base_ns;
+    uint64_t ticks, ns;
+
+    if (start_ns == 0) {
+        start_ticks = profile_ticks();
+        start_ns = profile_clock_ticks();
+    }
+    do {
+        ticks = profile_ticks();
+        ns = profile_clock_ticks();
+    } while (ns - start_ns < 10000000ull);
+    return (double)(ns - start_ns) / (double)(ticks - start_ticks);
+#else
+    return 1.0;
+#endif
+}
+
+/*
+ * Assign an ID to a scope on its first use, without locking: the ID is
+ * reserved with an atomic increment and claimed with a CAS, and the loser
+ * of a race for the same site leaves its reserved slot empty.
+ *
+ * @return: The site ID, or 0 if the registry is full
+ */
+static uint16_t profile_site_register(profile_site_t* site) {
+    uint16_t id = __atomic_add_fetch(&profile_site_count, 1, __ATOMIC_RELAXED);
+    uint16_t expected = 0;
+
+    if (id > PROFILE_MAX_SITES) {
+        __atomic_store_n(&profile_site_count, PROFILE_MAX_SITES, __ATOMIC_RELAXED);
+        return 0;
+    }
+    if (!__atomic_compare_exchange_n(&site->id, &expected, id, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return expected;  // Registered by another thread
+    }
+    __atomic_store_n(&profile_sites[id], site, __ATOMIC_RELEASE);
+    return id;
+}
+
+/*
+ * Create the calling thread's buffer and link it into the global list
+ */
+static profile_buffer_t* profile_thread_init(void) {
+    profile_buffer_t* buffer = calloc(1, sizeof(profile_buffer_t));
+
+    if (buffer == NULL) {
+        return NULL;
+    }
+    buffer->thread_index = __atomic_add_fetch(&profile_thread_count, 1, __ATOMIC_RELAXED);
+    buffer->next = __atomic_load_n(&profile_buffers, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&profile_buffers, &buffer->next, buffer, 1,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        // buffer->next now holds the current head; retry
+    }
+    profile_thread_buffer = buffer;
+    return buffer;
+}
+
+/*
+ * Record one completed scope in the calling thread's buffer
+ */
+void profile_record(profile_site_t* site, uint64_t start, uint64_t end) {
+    profile_buffer_t* buffer = profile_thread_buffer;
+    uint16_t id = __atomic_load_n(&site->id, __ATOMIC_ACQUIRE);
+    uint64_t duration = end > start ? end - start : 0;
+
+    if (id == 0 && (id = profile_site_register(site)) == 0) {
+        return;
+    }
+    if (buffer == NULL && (buffer = profile_thread_init()) == NULL) {
+        return;
+    }
+
+    profile_stats_t* stats = &buffer->stats[id];
+    int bucket = duration > 0 ? 63 - __builtin_clzll(duration) : 0;
+    if (bucket >= PROFILE_HISTOGRAM_BUCKETS) bucket = PROFILE_HISTOGRAM_BUCKETS - 1;
+    if (stats->count == 0 || duration < stats->min) stats->min = duration;
+    if (duration > stats->max) stats->max = duration;
+    stats->count++;
+    stats->total += duration;
+    stats->buckets[bucket]++;
+
+    if (buffer->event_count < PROFILE_EVENTS_PER_THREAD) {
+        profile_event_t* event = &buffer->events[buffer->event_count];
+        event->site_id = id;
+        event->start = start;
+        event->end = end;
+        __atomic_store_n(&buffer->event_count, buffer->event_count + 1, __ATOMIC_RELEASE);
+    } else {
+        stats->dropped++;
+    }
+}
+
+/*
+ * Write every recorded event in Chrome trace-event JSON ("X" complete
+ * events, microsecond timestamps from the start of profiling).
+ * Call once the profiled threads are idle.
+ *
+ * @return: Number of events written, or -1 if the file cannot be written
+ */
+int profiler_write_chrome_trace(const char* path) {
+    FILE* file = fopen(path, "w");
+    double us_per_tick = profiler_ns_per_tick() / 1000.0;
+    int written = 0;
+
+    if (file == NULL) {
+        printf("Error: Cannot write profile trace %s\n", path);
+        return -1;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    for (profile_buffer_t* buffer = __atomic_load_n(&profile_buffers, __ATOMIC_ACQUIRE);
+         buffer != NULL; buffer = buffer->next) {
+        uint32_t count = __atomic_load_n(&buffer->event_count, __ATOMIC_ACQUIRE);
+
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                "\"args\":{\"name\":\"thread %u\"}}",
+                written > 0 ? ",\n" : "", buffer->thread_index, buffer->thread_index);
+        written++;
+
+        for (uint32_t i = 0; i < count; i++) {
+            const profile_event_t* event = &buffer->events[i];
+            const profile_site_t* site = profile_sites[event->site_id];
+
+            fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"sim\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                    "\"ts\":%.3f,\"dur\":%.3f}",
+                    site != NULL ? site->name : "?", buffer->thread_index,
+                    (double)(int64_t)(event->start - profile_base_ticks) * us_per_tick,
+                    (double)(event->end - event->start) * us_per_tick);
+            written++;
+        }
+    }
+    fprintf(file, "\n]}\n");
+
+    if (fclose(file) != 0) {
+        printf("Error: Cannot write profile trace %s\n", path);
+        return -1;
+    }
+    return written;
+}
+
+/*
+ * Print "1.23 us"-style durations
+ */
+static void profile_format_ns(double ns, char* out, size_t size) {
+    if (ns < 1e3) snprintf(out, size, "%.1f ns", ns);
+    else if (ns < 1e6) snprintf(out, size, "%.2f us", ns / 1e3);
+    else snprintf(out, size, "%.2f ms", ns / 1e6);
+}
+
+/*
+ * Print each scope's duration statistics and log2 histogram, merged over
+ * all threads. Percentiles are bucket upper bounds.
+ */
+void profiler_print_histograms(FILE* out) {
+    double ns_per_tick = profiler_ns_per_tick();
+    uint16_t sites = __atomic_load_n(&profile_site_count, __ATOMIC_ACQUIRE);
+
+    fprintf(out, "\n=== Profile: scope durations ===\n");
+    for (uint16_t id = 1; id <= sites && id <= PROFILE_MAX_SITES; id++) {
+        const profile_site_t* site = __atomic_load_n(&profile_sites[id], __ATOMIC_ACQUIRE);
+        profile_stats_t total;
+        char mean[16], min[16], max[16], p50[16], p99[16];
+
+        if (site == NULL) {
+            continue;
+        }
+
+        memset(&total, 0, sizeof(total));
+        for (profile_buffer_t* buffer = __atomic_load_n(&profile_buffers, __ATOMIC_ACQUIRE);
+             buffer != NULL; buffer = buffer->next) {
+            const profile_stats_t* stats = &buffer->stats[id];
+            if (stats->count == 0) continue;
+            if (total.count == 0 || stats->min < total.min) total.min = stats->min;
+            if (stats->max > total.max) total.max = stats->max;
+            total.count += stats->count;
+            total.total += stats->total;
+            for (int b = 0; b < PROFILE_HISTOGRAM_BUCKETS; b++) {
+                total.buckets[b] += stats->buckets[b];
+            }
+            total.dropped += stats->dropped;
+        }
+        if (total.count == 0) {
+            continue;
+        }
+
+        // Bucket upper bounds at the 50th and 99th percentile
+        uint64_t seen = 0;
+        double p50_ns = 0.0, p99_ns = 0.0;
+        uint32_t peak = 0;
+        for (int b = 0; b < PROFILE_HISTOGRAM_BUCKETS; b++) {
+            double upper = (double)(2ull << b) * ns_per_tick;
+            if (seen < (total.count + 1) / 2 && seen + total.buckets[b] >= (total.count + 1) / 2) p50_ns = upper;
+            if (seen < total.count - total.count / 100 &&
+                seen + total.buckets[b] >= total.count - total.count / 100) p99_ns = upper;
+            seen += total.buckets[b];
+            if (total.buckets[b] > peak) peak = total.buckets[b];
+        }
+
+        profile_format_ns((double)total.total * ns_per_tick / (double)total.count, mean, sizeof(mean));
+        profile_format_ns((double)total.min * ns_per_tick, min, sizeof(min));
+        profile_format_ns((double)total.max * ns_per_tick, max, sizeof(max));
+        profile_format_ns(p50_ns, p50, sizeof(p50));
+        profile_format_ns(p99_ns, p99, sizeof(p99));
+        fprintf(out, "\n%s: %llu calls, mean %s, min %s, max %s, p50 < %s, p99 < %s\n",
+                site->name, (unsigned long long)total.count, mean, min, max, p50, p99);
+
+        for (int b = 0; b < PROFILE_HISTOGRAM_BUCKETS; b++) {
+            char lower_text[16], upper_text[16];
+            int bar;
+
+            if (total.buckets[b] == 0) continue;
+            bar = (int)((uint64_t)total.buckets[b] * 40 / peak);
+            profile_format_ns((double)(1ull << b) * ns_per_tick, lower_text, sizeof(lower_text));
+            profile_format_ns((double)(2ull << b) * ns_per_tick, upper_text, sizeof(upper_text));
+            fprintf(out, "  %10s - %-10s |%-40.*s| %u\n", lower_text, upper_text, bar,
+                    "########################################", total.buckets[b]);
+        }
+        if (total.dropped > 0) {
+            fprintf(out, "  (%llu scopes past the trace buffer are in the histogram only)\n",
+                    (unsigned long long)total.dropped);
+        }
+    }
+}
+
+/*
+ * Exit handler installed by profiler_start_from_env()
+ */
+static void profiler_finish(void) {
+    profiler_enable(0);
+    int events = profiler_write_chrome_trace(profile_output_path);
+    if (events >= 0) {
+        printf("\nProfile trace: %s (%d events; open in chrome://tracing or Perfetto)\n",
+               profile_output_path, events);
+    }
+    profiler_print_histograms(stdout);
+}
+
+/*
+ * Enable profiling if PROFILE_OUTPUT names a trace file; the trace is
+ * written and the histograms printed when the program exits.
+ *
+ * @return: 1 if profiling was enabled, 0 otherwise
+ */
+int profiler_start_from_env(void) {
+    const char* path = getenv("PROFILE_OUTPUT");
+
+    if (path == NULL || path[0] == '\0') {
+        return 0;
+    }
+    profile_output_path = path;
+    profiler_enable(1);
+    atexit(profiler_finish);
+    printf("Profiling enabled; trace will be written to %s at exit\n", path);
+    return 1;
+}
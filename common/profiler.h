@@ -0,0 +1,127 @@
+/*
+ * Hot-Path Profiler
+ * =================
+ *
+ * Scoped timers for the simulators' hot paths, shared by all five projects.
+ *
+ *   double calculatePID(...) {
+ *       PROFILE_SCOPE("calculatePID");
+ *       ...
+ *   }
+ *
+ * The scope ends when the enclosing block exits, on any path (GCC/Clang
+ * cleanup attribute; other compilers compile scopes out). Timestamps are
+ * rdtsc on x86 and CLOCK_MONOTONIC_RAW elsewhere.
+ *
+ * Each thread records into its own buffer, created on its first scope and
+ * linked into a global list with a CAS, so recording takes no locks:
+ * - every scope is added to a per-function log2 histogram of its duration
+ * - the first PROFILE_EVENTS_PER_THREAD scopes are also kept as events
+ *   for the Chrome trace export (chrome://tracing, Perfetto)
+ *
+ * Profiling is compiled in but disabled by default: a disabled scope costs
+ * one load and one predictable branch. Set PROFILE_OUTPUT=<trace.json> to
+ * enable it for a run; the trace is written and the histograms printed at
+ * exit. Build with -DPROFILE_COMPILED_OUT to remove every scope.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define PROFILE_MAX_SITES 64              // Distinct scope names per program
+#define PROFILE_EVENTS_PER_THREAD 65536   // Trace events kept per thread
+#define PROFILE_HISTOGRAM_BUCKETS 40      // log2 buckets of scope duration in ticks
+
+// Static descriptor of one named scope
+typedef struct {
+    const char* name;
+    uint16_t id;                     // Assigned on first use; 0 = unregistered
+} profile_site_t;
+
+// One completed scope
+typedef struct {
+    uint16_t site_id;
+    uint64_t start;                  // Ticks
+    uint64_t end;
+} profile_event_t;
+
+// Duration statistics of one scope name on one thread
+typedef struct {
+    uint64_t count;
+    uint64_t total;                  // Ticks
+    uint64_t min;
+    uint64_t max;
+    uint64_t dropped;                // Scopes past PROFILE_EVENTS_PER_THREAD (still in the histogram)
+    uint32_t buckets[PROFILE_HISTOGRAM_BUCKETS];   // buckets[b]: duration in [2^b, 2^(b+1)) ticks
+} profile_stats_t;
+
+// Per-thread recording buffer
+typedef struct profile_buffer {
+    struct profile_buffer* next;     // Global list, newest first
+    uint32_t thread_index;
+    uint32_t event_count;
+    profile_stats_t stats[PROFILE_MAX_SITES + 1];   // Indexed by site ID
+    profile_event_t events[PROFILE_EVENTS_PER_THREAD];
+} profile_buffer_t;
+
+// Open scope, closed by profile_scope_end()
+typedef struct {
+    profile_site_t* site;
+    uint64_t start;                  // 0 while profiling is disabled
+} profile_scope_t;
+
+extern int profiler_enabled;
+
+void profiler_enable(int enabled);
+int profiler_start_from_env(void);
+int profiler_write_chrome_trace(const char* path);
+void profiler_print_histograms(FILE* out);
+double profiler_ns_per_tick(void);
+uint64_t profile_clock_ticks(void);
+void profile_record(profile_site_t* site, uint64_t start, uint64_t end);
+
+#ifdef __GNUC__
+#define PROFILE_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define PROFILE_UNLIKELY(x) (x)
+#endif
+
+// Current time in ticks
+static inline uint64_t profile_ticks(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_ia32_rdtsc();
+#else
+    return profile_clock_ticks();
+#endif
+}
+
+static inline profile_scope_t profile_scope_begin(profile_site_t* site) {
+    profile_scope_t scope;
+    scope.site = site;
+    scope.start = PROFILE_UNLIKELY(profiler_enabled) ? profile_ticks() : 0;
+    return scope;
+}
+
+static inline void profile_scope_end(profile_scope_t* scope) {
+    if (PROFILE_UNLIKELY(scope->start != 0)) {
+        profile_record(scope->site, scope->start, profile_ticks());
+    }
+}
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#if defined(__GNUC__) && !defined(PROFILE_COMPILED_OUT)
+#define PROFILE_SCOPE(name) \
+    static profile_site_t PROFILE_CONCAT(profile_site_, __LINE__) = {name, 0}; \
+    profile_scope_t PROFILE_CONCAT(profile_scope_, __LINE__) \
+        __attribute__((cleanup(profile_scope_end))) = \
+        profile_scope_begin(&PROFILE_CONCAT(profile_site_, __LINE__))
+#else
+#define PROFILE_SCOPE(name) do { } while (0)
+#endif
+
+#endif // PROFILER_H
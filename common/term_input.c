@@ -0,0 +1,299 @@
+/*
+ * Terminal Input
+ * ==============
+ *
+ * Terminal mode handling, key buffer and loop timer declared in
+ * term_input.h.
+ */
+
+// Expose clock_gettime(), clock_nanosleep() and sigaction() when building with -std=c99
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "term_input.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <conio.h>
+#else
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+uint64_t term_input_now_ns(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/*
+ * Start a ticker whose first tick is one period from now
+ */
+void term_ticker_start(term_ticker_t* ticker, uint32_t period_us) {
+    ticker->period_us = period_us;
+    ticker->next_tick_ns = term_input_now_ns() + (uint64_t)period_us * 1000ull;
+}
+
+/*
+ * Schedule the tick after the one just reached, skipping any missed
+ */
+static void term_ticker_advance(term_ticker_t* ticker, uint64_t now) {
+    uint64_t period_ns = (uint64_t)ticker->period_us * 1000ull;
+
+    ticker->next_tick_ns += period_ns;
+    if (ticker->next_tick_ns <= now) {
+        ticker->next_tick_ns = now + period_ns;
+    }
+}
+
+#ifndef _WIN32
+static struct termios term_saved;          // Mode to restore
+static int term_raw;                       // Saved mode is valid and raw mode is set
+static int term_handlers_set;              // atexit() and signal handlers installed
+static int term_eof;                       // stdin closed: stop polling it
+static unsigned char term_keys[64];        // Read but not yet taken
+static size_t term_key_head;
+static size_t term_key_count;
+
+static void term_restore_on_signal(int sig) {
+    if (term_raw) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &term_saved);
+    }
+    raise(sig);   // Handler was reset (SA_RESETHAND): terminate as usual
+}
+
+/*
+ * Switch the terminal to unbuffered, no-echo input. Signals still work, so
+ * Ctrl+C stops the program. If stdin is not a terminal (input piped in),
+ * its mode is left alone and keys are still read without blocking.
+ *
+ * @return: 0 on success, -1 if the terminal mode cannot be set
+ */
+int term_input_open(void) {
+    struct termios raw;
+    struct sigaction action;
+
+    if (term_raw || !isatty(STDIN_FILENO)) {
+        return 0;
+    }
+    if (tcgetattr(STDIN_FILENO, &term_saved) != 0) {
+        return -1;
+    }
+
+    raw = term_saved;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    if (tcsetattr(STDIN_FILENO, TCSANOW, &raw) != 0) {
+        return -1;
+    }
+    term_raw = 1;
+
+    // Restore the terminal however the program ends
+    if (term_handlers_set) {
+        return 0;
+    }
+    term_handlers_set = 1;
+    atexit(term_input_close);
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = term_restore_on_signal;
+    action.sa_flags = SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    return 0;
+}
+
+/*
+ * Restore the terminal mode saved by term_input_open()
+ */
+void term_input_close(void) {
+    if (term_raw) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &term_saved);
+        term_raw = 0;
+    }
+}
+
+/*
+ * Wait up to timeout_ms (0 = just check, -1 = forever) for input and buffer
+ * what is there.
+ *
+ * @return: 1 if keys are buffered
+ */
+static int term_fill(int timeout_ms) {
+    struct pollfd fd = {STDIN_FILENO, POLLIN, 0};
+    ssize_t length;
+
+    if (term_key_count > 0) {
+        return 1;
+    }
+    if (term_eof) {
+        return 0;
+    }
+    if (poll(&fd, 1, timeout_ms) <= 0) {
+        return 0;   // Timed out or interrupted by a signal
+    }
+
+    length = read(STDIN_FILENO, term_keys, sizeof(term_keys));
+    if (length == 0 || (length < 0 && errno != EAGAIN && errno != EINTR)) {
+        term_eof = 1;
+        return 0;
+    }
+    if (length < 0) {
+        return 0;
+    }
+    term_key_head = 0;
+    term_key_count = (size_t)length;
+    return 1;
+}
+
+static int term_take(void) {
+    int key = term_keys[term_key_head++];
+    term_key_count--;
+    return key;
+}
+
+/*
+ * @return: 1 if a key is waiting (one poll() when none is buffered)
+ */
+int term_input_kbhit(void) {
+    return term_fill(0);
+}
+
+/*
+ * @return: The next key, or TERM_INPUT_NONE if none is waiting
+ */
+int term_input_getch(void) {
+    return term_fill(0) ? term_take() : TERM_INPUT_NONE;
+}
+
+/*
+ * Read a line with the terminal's usual editing and echo, for prompts.
+ * Keys already buffered start the line. The newline is not stored.
+ *
+ * @return: Length of the line, or -1 at end of input
+ */
+int term_input_read_line(char* line, size_t size) {
+    size_t length = 0;
+    int got_input = 0;
+
+    if (term_raw) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &term_saved);
+    }
+    fflush(stdout);
+
+    while (term_fill(-1)) {
+        int key = term_take();
+        got_input = 1;
+        if (key == '\n' || key == '\r') {
+            break;
+        }
+        if (length + 1 < size) {
+            line[length++] = (char)key;
+        }
+    }
+    if (size > 0) {
+        line[length] = '\0';
+    }
+
+    if (term_raw) {
+        struct termios raw = term_saved;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+    }
+    return got_input ? (int)length : -1;
+}
+
+/*
+ * Sleep until the ticker's next tick, returning early with a key if one
+ * arrives. One poll() per wait, plus a read() when a key arrives and a
+ * sub-millisecond sleep to land on the tick.
+ *
+ * @return: The key, or TERM_INPUT_TICK once the tick is reached
+ */
+int term_input_wait(term_ticker_t* ticker) {
+    for (;;) {
+        uint64_t now;
+
+        if (term_key_count > 0) {
+            return term_take();
+        }
+
+        now = term_input_now_ns();
+        if (now >= ticker->next_tick_ns) {
+            term_ticker_advance(ticker, now);
+            return TERM_INPUT_TICK;
+        }
+
+        // poll() counts whole milliseconds: wait for input in those, then
+        // sleep the last fraction exactly so the tick is not overshot
+        uint64_t remaining_ms = (ticker->next_tick_ns - now) / 1000000ull;
+        if (term_eof || remaining_ms == 0) {
+            struct timespec ts;
+            ts.tv_sec = (time_t)(ticker->next_tick_ns / 1000000000ull);
+            ts.tv_nsec = (long)(ticker->next_tick_ns % 1000000000ull);
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        } else {
+            term_fill((int)remaining_ms);
+        }
+    }
+}
+#else
+int term_input_open(void) {
+    return 0;   // conio reads keys unbuffered already
+}
+
+void term_input_close(void) {
+}
+
+int term_input_kbhit(void) {
+    return _kbhit() != 0;
+}
+
+int term_input_getch(void) {
+    return _kbhit() ? _getch() : TERM_INPUT_NONE;
+}
+
+int term_input_read_line(char* line, size_t size) {
+    size_t length;
+
+    fflush(stdout);
+    if (fgets(line, (int)size, stdin) == NULL) {
+        return -1;
+    }
+    length = strcspn(line, "\r\n");
+    line[length] = '\0';
+    return (int)length;
+}
+
+int term_input_wait(term_ticker_t* ticker) {
+    for (;;) {
+        uint64_t now;
+
+        if (_kbhit()) {
+            return _getch();
+        }
+        now = term_input_now_ns();
+        if (now >= ticker->next_tick_ns) {
+            term_ticker_advance(ticker, now);
+            return TERM_INPUT_TICK;
+        }
+        Sleep(1);
+    }
+}
+#endif
@@ -0,0 +1,54 @@
+/*
+ * Terminal Input
+ * ==============
+ *
+ * Non-blocking keyboard input for the interactive simulators, shared by the
+ * VFD, sensor and debugging projects.
+ *
+ * term_input_open() puts the terminal into unbuffered, no-echo mode once.
+ * The saved mode is restored by term_input_close(), which also runs at exit
+ * and on SIGINT/SIGTERM. Keys are then read with poll() and read(), so
+ * checking for a key costs one system call. The old per-poll kbhit() saved,
+ * changed and restored the terminal mode and file flags on every call.
+ *
+ * term_input_wait() doubles as the control loop's timer. It sleeps until the
+ * next tick of a term_ticker_t, but returns a key as soon as one arrives:
+ *
+ *   term_ticker_start(&ticker, CYCLE_US);
+ *   while (running) {
+ *       run_cycle();
+ *       while ((key = term_input_wait(&ticker)) != TERM_INPUT_TICK) {
+ *           handle_key(key);
+ *       }
+ *   }
+ *
+ * Ticks are absolute, so the loop keeps its period however long a cycle
+ * or a key takes; ticks missed by a stall are skipped, not replayed.
+ * Windows builds use conio.h.
+ */
+
+#ifndef TERM_INPUT_H
+#define TERM_INPUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TERM_INPUT_TICK (-1)            // term_input_wait(): the tick came before a key
+#define TERM_INPUT_NONE (-1)            // term_input_getch(): no key waiting
+
+// Fixed-period loop timer
+typedef struct {
+    uint64_t next_tick_ns;              // Monotonic time of the next tick
+    uint32_t period_us;
+} term_ticker_t;
+
+int term_input_open(void);
+void term_input_close(void);
+int term_input_kbhit(void);
+int term_input_getch(void);
+int term_input_read_line(char* line, size_t size);
+void term_ticker_start(term_ticker_t* ticker, uint32_t period_us);
+int term_input_wait(term_ticker_t* ticker);
+uint64_t term_input_now_ns(void);
+
+#endif // TERM_INPUT_H